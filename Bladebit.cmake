@@ -39,6 +39,13 @@ set(src_uint128
 set(src_chacha8
     src/pos/chacha8.cpp
     src/pos/chacha8.h
+    src/pos/chacha8_impl.h
+
+    $<${is_x86}:
+        src/pos/chacha8_sse2.cpp
+        src/pos/chacha8_avx2.cpp
+        src/pos/chacha8_avx512.cpp
+    >
 )
 
 set(src_fse
@@ -66,6 +73,8 @@ set(src_blake3
     src/b3/blake3_portable.c
     
     $<${is_x86}:
+        src/b3/blake3_small_avx2.c
+        src/b3/blake3_small_avx512.c
 
         $<$<PLATFORM_ID:Windows>:
             src/b3/blake3_sse41.c
@@ -138,15 +147,21 @@ set(src_bladebit
     src/algorithm/YSort.cpp
     src/algorithm/YSort.h
     src/algorithm/RadixSort.h
+    src/algorithm/HybridRadixSort.h
 
+    src/io/BitPackTransform.cpp
+    src/io/BitPackTransform.h
     src/io/BucketStream.cpp
     src/io/BucketStream.h
     src/io/FileStream.cpp
     src/io/FileStream.h
+    src/io/FileIOBatch.cpp
+    src/io/FileIOBatch.h
     src/io/HybridStream.cpp
     src/io/HybridStream.h
     src/io/IOUtil.cpp
     src/io/IOUtil.h
+    src/io/IIOTransform.h
     src/io/IStream.h
     src/io/MemoryStream.h
 
@@ -237,6 +252,21 @@ set(src_bladebit
     
     src/plotting/matching/GroupScan.cpp
     src/plotting/matching/GroupScan.h
+    src/plotting/matching/KBCMatch.cpp
+    src/plotting/matching/KBCMatch.h
+
+    $<${is_x86}:
+        src/plotting/matching/KBCMatch_avx2.cpp
+    >
+
+    src/plotting/LinePointBatch.cpp
+    src/plotting/LinePointBatch.h
+
+    $<${is_x86}:
+        src/plotting/LinePointBatch_avx2.cpp
+        src/plotting/LinePointBatch_avx512.cpp
+    >
+
     src/plotting/WorkHeap.h
 
     src/threading/AutoResetSignal.h
@@ -254,11 +284,14 @@ set(src_bladebit
 
     # src/tools/FSETableGenerator.cpp
     src/tools/MemTester.cpp
+    src/tools/Benchmarks.cpp
     src/tools/IOTester.cpp
     src/tools/PlotComparer.cpp
     src/tools/PlotFile.cpp
     src/tools/PlotReader.cpp
     src/tools/PlotReader.h
+    src/tools/PlotCheckpointCache.cpp
+    src/tools/PlotCheckpointCache.h
     src/tools/PlotValidator.cpp
     src/tools/PlotChecker.cpp
 
@@ -281,6 +314,8 @@ set(src_bladebit
     src/util/StackAllocator.h
     src/util/Util.cpp
     src/util/Util.h
+    src/util/CpuFeatures.cpp
+    src/util/CpuFeatures.h
     src/util/VirtualAllocator.h
 
     src/commands/Commands.h
@@ -318,3 +353,14 @@ target_sources(bladebit_core PUBLIC ${src_bladebit})
         /wd4244
     )
  endif()
+
+ # Enable instruction sets for the SIMD ChaCha8, batched BLAKE3, kBC matching and line point kernels. They are only called after runtime detection.
+ if(NOT "${CMAKE_CXX_COMPILER_ID}" MATCHES "MSVC")
+    set_source_files_properties(src/pos/chacha8_avx2.cpp       PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/pos/chacha8_avx512.cpp     PROPERTIES COMPILE_OPTIONS -mavx512f)
+    set_source_files_properties(src/plotting/matching/KBCMatch_avx2.cpp PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/plotting/LinePointBatch_avx2.cpp    PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/plotting/LinePointBatch_avx512.cpp  PROPERTIES COMPILE_OPTIONS -mavx512f)
+    set_source_files_properties(src/b3/blake3_small_avx2.c     PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/b3/blake3_small_avx512.c   PROPERTIES COMPILE_OPTIONS -mavx512f)
+ endif()
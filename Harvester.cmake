@@ -20,6 +20,13 @@ target_sources(bladebit_harvester PRIVATE
 
     src/pos/chacha8.cpp
     src/pos/chacha8.h
+    src/pos/chacha8_impl.h
+
+    $<${is_x86}:
+        src/pos/chacha8_sse2.cpp
+        src/pos/chacha8_avx2.cpp
+        src/pos/chacha8_avx512.cpp
+    >
 
     src/fse/bitstream.h
     src/fse/compiler.h
@@ -43,6 +50,9 @@ target_sources(bladebit_harvester PRIVATE
     src/b3/blake3_portable.c
 
     $<${is_x86}:
+        src/b3/blake3_small_avx2.c
+        src/b3/blake3_small_avx512.c
+
         $<$<PLATFORM_ID:Windows>:
             src/b3/blake3_sse41.c
             src/b3/blake3_avx2.c
@@ -58,6 +68,7 @@ target_sources(bladebit_harvester PRIVATE
 
     src/util/Log.cpp
     src/util/Util.cpp
+    src/util/CpuFeatures.cpp
     src/PlotContext.cpp
     src/io/HybridStream.cpp
     src/threading/AutoResetSignal.cpp
@@ -68,7 +79,19 @@ target_sources(bladebit_harvester PRIVATE
     src/plotting/PlotWriter.cpp
     src/plotting/Compression.cpp
     src/plotting/matching/GroupScan.cpp
+    src/plotting/matching/KBCMatch.cpp
+
+    $<${is_x86}:
+        src/plotting/matching/KBCMatch_avx2.cpp
+    >
+    src/plotting/LinePointBatch.cpp
+
+    $<${is_x86}:
+        src/plotting/LinePointBatch_avx2.cpp
+        src/plotting/LinePointBatch_avx512.cpp
+    >
     src/plotdisk/DiskBufferQueue.cpp
+    src/io/FileIOBatch.cpp
     src/plotting/WorkHeap.cpp
     src/plotdisk/jobs/IOJob.cpp
     src/harvesting/GreenReaper.cpp
@@ -180,3 +203,13 @@ endif()
     )
  endif()
 
+ # Enable instruction sets for the SIMD ChaCha8, batched BLAKE3, kBC matching and line point kernels. They are only called after runtime detection.
+ if(NOT "${CMAKE_CXX_COMPILER_ID}" MATCHES "MSVC")
+    set_source_files_properties(src/pos/chacha8_avx2.cpp       PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/pos/chacha8_avx512.cpp     PROPERTIES COMPILE_OPTIONS -mavx512f)
+    set_source_files_properties(src/plotting/matching/KBCMatch_avx2.cpp PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/plotting/LinePointBatch_avx2.cpp    PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/plotting/LinePointBatch_avx512.cpp  PROPERTIES COMPILE_OPTIONS -mavx512f)
+    set_source_files_properties(src/b3/blake3_small_avx2.c     PROPERTIES COMPILE_OPTIONS -mavx2)
+    set_source_files_properties(src/b3/blake3_small_avx512.c   PROPERTIES COMPILE_OPTIONS -mavx512f)
+ endif()
@@ -4,6 +4,12 @@ add_executable(tests ${src_bladebit}
     cuda/harvesting/CudaThresherDummy.cpp
     tests/TestUtil.h
     tests/TestDiskQueue.cpp
+    tests/TestDiskBufferQueue.cpp
+    tests/TestLinePointBatch.cpp
+    tests/TestKBCMatch.cpp
+    tests/TestSmallKPlot.cpp
+    tests/TestQualitiesFastPath.cpp
+    tests/TestBitPackTransform.cpp
 )
 
 target_compile_definitions(tests PRIVATE
@@ -77,6 +77,10 @@ GPU-based (CUDA) plotter
                          NOTE: If only one of -t1 or -t2 is specified, both will be
                                set to the same directory.
 
+ --io-depth <n>       : Maximum number of temp file reads and writes kept in flight
+                         when io_uring is available (Linux only). (default=64)
+                         Specify 0 to use blocking I/O instead.
+
  --check <n>          : Perform a plot check for <n> proofs on the newly created plot.
 
  --check-threshold <f>: Proof threshold rate below which the plots that don't pass
@@ -131,6 +135,8 @@ void CudaK32Plotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli )
             continue;
         if( cli.ReadUnswitch( cfg.temp2DirectIO, "--no-t2-direct" ) )
             continue;
+        if( cli.ReadU32( cfg.ioQueueDepth, "--io-depth" ) )
+            continue;
 
         if( cli.ReadU64( cfg.plotCheckCount, "--check" ) )
             continue;
@@ -260,7 +266,7 @@ void InitContext( CudaK32PlotConfig& cfg, CudaK32PlotContext*& outContext )
     if( cx.cfg.hybrid128Mode )
     {
         cx.diskContext             = new CudaK32HybridMode{};
-        cx.diskContext->temp1Queue = new DiskQueue( cx.cfg.temp1Path );
+        cx.diskContext->temp1Queue = new DiskQueue( cx.cfg.temp1Path, cx.cfg.ioQueueDepth );
 
         // Re-use the same queue for temp2 if temp1 and temp2 are pointing to the same path
         auto t1Path = std::filesystem::canonical( cx.cfg.temp1Path );
@@ -268,7 +274,7 @@ void InitContext( CudaK32PlotConfig& cfg, CudaK32PlotContext*& outContext )
         if( t1Path.compare( t2Path ) == 0 )
             cx.diskContext->temp2Queue = cx.diskContext->temp1Queue;
         else
-            cx.diskContext->temp2Queue = new DiskQueue( cx.cfg.temp2Path );
+            cx.diskContext->temp2Queue = new DiskQueue( cx.cfg.temp2Path, cx.cfg.ioQueueDepth );
     }
 
     cx.phase2 = new CudaK32Phase2{};
@@ -4,6 +4,7 @@
 #include "util/CliParser.h"
 #include "PlotContext.h"
 #include "plotting/IPlotter.h"
+#include "io/FileIOBatch.h"
 
 struct CudaK32PlotConfig
 {
@@ -23,6 +24,8 @@ struct CudaK32PlotConfig
     bool temp1DirectIO            = true;    // Use direct I/O for temp1 files
     bool temp2DirectIO            = true;    // Use direct I/O for temp2 files
 
+    uint32 ioQueueDepth           = FileIOBatch::DefaultQueueDepth;  // Temp file reads/writes in flight with io_uring. 0 disables it.
+
     uint64 plotCheckCount         = 0;       // For performing plot check command after plotting
     double plotCheckThreshhold    = 0.6;     // Proof/check threshhold below which plots will be deleted
 };
@@ -91,6 +91,7 @@ const double kRValues[7] = { 4.7, 2.75, 2.75, 2.7, 2.6, 2.45 };
 #define BB_CHIA_CHALLENGE_SIZE 32
 #define BB_CHIA_QUALITY_SIZE   32
 
+#define BB_CHIA_K_MIN_VALUE    18
 #define BB_CHIA_K_MAX_VALUE    50
 
 
@@ -152,7 +153,7 @@ inline constexpr size_t CalculateParkSize( TableId tableId )
 //-----------------------------------------------------------
 inline constexpr size_t CalculateParkSize( const TableId tableId, const uint32 k )
 {
-    ASSERT( k >= 20 );
+    ASSERT( k >= BB_CHIA_K_MIN_VALUE );
 
     return 
         CDiv( k * 2, 8 ) +                                         // LinePoint size
@@ -171,6 +172,16 @@ constexpr inline static size_t CalculateC3Size()
     return (size_t)CDiv( kC3BitsPerEntry * kCheckpoint1Interval, 8 );
 }
 
+// chiapos uses a full byte per entry for C3 parks of k < 20
+//-----------------------------------------------------------
+constexpr inline static size_t CalculateC3Size( const uint32 k )
+{
+    if( k < 20 )
+        return (size_t)CDiv( 8 * kCheckpoint1Interval, 8 );
+
+    return CalculateC3Size();
+}
+
 //-----------------------------------------------------------
 inline constexpr static size_t CalculatePark7Size( const uint k )
 {
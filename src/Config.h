@@ -5,9 +5,9 @@
 #define MAX_THREADS 256
 #define BB_MAX_JOBS MAX_THREADS
 
-// Perform Y sorts at the block level.
-// Unrolling loops by chacha block size.
-#define Y_SORT_BLOCK_MODE 1
+// Number of Fx entries staged before hashing them
+// together in parallel SIMD lanes (blake3_hash_many_small).
+#define BB_FX_HASH_BATCH_SIZE 64
 
 ///
 /// Debug Stuff
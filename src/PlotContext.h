@@ -21,6 +21,11 @@ struct PlotRequest
 struct MemPlotConfig
 {
     const struct GlobalPlotConfig* gCfg;
+
+    // If true, and the system has multiple NUMA nodes, each table buffer is split
+    // into one contiguous range per node, instead of interleaving its pages, and the
+    // threads are pinned in node order, so that each thread's slice of a table is node-local.
+    bool numaLocal;
 };
 
 ///
@@ -33,6 +38,9 @@ struct MemPlotContext
     // They id of the plot being plotted
     const byte* plotId;
 
+    // Size (k) of the plots being plotted. Buffer sizes are derived from it.
+    uint32      k;
+
     const byte* plotMemo;
     uint16      plotMemoSize;
 
@@ -46,13 +54,17 @@ struct MemPlotContext
     ///
     /// Buffers
     ///
-    // Permanent table data buffers
+    // Permanent table data buffers (sizes given for k32)
+    // Tables 2-6 store their back pointers packed as a 32-bit left index
+    // and a 16-bit offset from it to the right index (see GetPackedPair()).
+    // Table 7 stores full pairs, as its buffer is also used as
+    // the unsorted pair buffer for the other tables in phase 1.
     uint32* t1XBuffer ;       // 16 GiB
-    Pair*   t2LRBuffer;       // 32 GiB
-    Pair*   t3LRBuffer;       // 32 GiB
-    Pair*   t4LRBuffer;       // 32 GiB
-    Pair*   t5LRBuffer;       // 32 GiB
-    Pair*   t6LRBuffer;       // 32 GiB
+    Pairs   t2LRBuffer;       // 24 GiB
+    Pairs   t3LRBuffer;       // 24 GiB
+    Pairs   t4LRBuffer;       // 24 GiB
+    Pairs   t5LRBuffer;       // 24 GiB
+    Pairs   t6LRBuffer;       // 24 GiB
     Pair*   t7LRBuffer;       // 32 GiB
     uint32* t7YBuffer ;       // 16 GiB
 
@@ -71,7 +83,7 @@ struct MemPlotContext
     uint64 entryCount[7];
 
     // Added by Phase 2:
-    byte* usedEntries[6];   // Used entries per each table.
+    uint64* usedEntries[6]; // Used entries per each table, as bit fields (see BitField).
                             // These are only used for tables 2-6 (inclusive).
                             // These buffers map to regions in yBuffer0.
 
@@ -88,3 +100,9 @@ struct MemPlotContext
     uint64 plotCount;
 };
 
+//-----------------------------------------------------------
+inline Pair GetPackedPair( const Pairs pairs, const uint64 index )
+{
+    const uint32 left = pairs.left[index];
+    return { left, left + pairs.right[index] };
+}
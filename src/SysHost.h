@@ -11,6 +11,24 @@ enum class VProtect : uint
 };
 ImplementFlagOps( VProtect );
 
+enum class HugePageMode : uint
+{
+    None = 0,       // Regular pages only
+    Transparent,    // Advise the kernel to back allocations with transparent huge pages
+    Pages2MiB,      // Explicit 2 MiB huge pages, falling back to transparent huge pages
+    Pages1GiB,      // Explicit 1 GiB huge pages, falling back to 2 MiB pages
+};
+
+// Bytes obtained by large allocations since huge pages were enabled
+struct HugePageStats
+{
+    size_t pages1GiB;           // Mapped with explicit 1 GiB pages
+    size_t pages2MiB;           // Mapped with explicit 2 MiB pages
+    size_t transparent;         // Advised for transparent huge pages
+    size_t transparentBacked;   // Backed by transparent huge pages in the whole process right now, if known
+    size_t regular;             // Huge pages were requested, but regular pages were obtained
+};
+
 struct NumaInfo
 {
     uint        nodeCount;      // How many NUMA nodes in the system
@@ -41,12 +59,24 @@ public:
     /// Create an allocation in the virtual memory space
     /// If initialize == true, then all pages are touched so that
     /// the pages are actually assigned.
-    static void* VirtualAlloc( size_t size, bool initialize = false );
+    /// Pass explicitHugePages == false for allocations that will have pages protected
+    /// with VirtualProtect(), as explicit huge pages can only be protected whole.
+    static void* VirtualAlloc( size_t size, bool initialize = false, bool explicitHugePages = true );
     
     static void VirtualFree( void* ptr );
 
     static bool VirtualProtect( void* ptr, size_t size, VProtect flags = VProtect::NoAccess );
 
+    /// Set the kind of huge pages used by subsequent VirtualAlloc() calls.
+    /// Allocations smaller than 2 MiB always use regular pages.
+    /// Only supported on Linux. Returns false if the mode is not supported.
+    static bool SetHugePageMode( HugePageMode mode );
+
+    static HugePageMode GetHugePageMode();
+
+    /// Get the amount of memory allocated with each kind of page since huge pages were enabled
+    static HugePageStats GetHugePageStats();
+
     /// Set the processor affinity mask for the current process
     // static uint64 SetCurrentProcessAffinityMask( uint64 mask );
 
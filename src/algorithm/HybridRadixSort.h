@@ -0,0 +1,537 @@
+#pragma once
+#include "threading/ThreadPool.h"
+#include "threading/MTJob.h"
+#include "util/Util.h"
+#include <algorithm>
+
+///
+/// Cache-blocked radix sort.
+/// A single parallel MSD pass scatters the entries into buckets on their most significant
+/// bits, through per-thread software write-combining buffers. Each thread then finishes
+/// the buckets which fall in its own slice of the output on its own: Buckets that are still
+/// larger than the L2 cache are split again with another MSD pass, and the resulting
+/// blocks are sorted with LSD passes that stay cache-resident.
+///
+/// Unlike RadixSort256, the whole table is only read and scattered twice (counting aside),
+/// and threads only synchronize between the MSD pass and the bucket pass.
+/// Since a thread's slice of the input and its slice of the output cover the same range,
+/// both are node-local when the buffers are split across NUMA nodes in thread order.
+///
+/// The sort is stable. The sorted entries are written to tmp (and keyTmp),
+/// input (and keyInput) is used as scratch space.
+///
+class HybridRadixSort
+{
+public:
+    static constexpr uint32 MSD_BITS   = 10;        // Bits sorted by each MSD bucketing pass
+    static constexpr uint32 LSD_BITS   = 8;         // Bits sorted by each cache-resident LSD pass
+    static constexpr size_t BLOCK_SIZE = 256 KiB;   // Blocks (entries + keys) at or below this size are finished with LSD passes
+
+    // Sorts entries on their lowest keyBits bits. Higher bits are carried along, but are not sorted on.
+    template<uint32 MaxJobs, typename T>
+    static void Sort( ThreadPool& pool, T* input, T* tmp, uint64 length, uint32 keyBits );
+
+    template<uint32 MaxJobs, typename T, typename TK>
+    static void SortWithKey( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits );
+
+    // Same as SortWithKey, but the sorted output is handed out as it completes, instead of all at the end.
+    // After the MSD pass, free threads take the buckets in ascending order. Once a bucket and all the
+    // buckets before it are sorted, onSorted( bucket, start, end ) is called for it from the thread
+    // that completed that prefix, while the other threads keep sorting the following buckets.
+    // tmp[start, end) (and keyTmp) hold the bucket's final entries by then, and input[start, end)
+    // (and keyInput) is no longer used by the sort. Calls for different buckets may overlap.
+    template<uint32 MaxJobs, typename T, typename TK, typename TOnSorted>
+    static void SortWithKeyStreamed( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits,
+                                     TOnSorted&& onSorted );
+
+private:
+    static constexpr uint32 MSD_BUCKETS = 1u << MSD_BITS;
+    static constexpr uint32 LSD_RADIX   = 1u << LSD_BITS;
+    static constexpr uint32 MAX_LEVELS  = ( 64 + MSD_BITS - 1 ) / MSD_BITS;
+
+    // Per-thread working memory
+    template<typename T, typename TK>
+    struct Scratch
+    {
+        static constexpr uint32 WC_ENTRIES = 64 / sizeof( T );     // Entries per write-combining buffer (a cache line)
+
+        uint64 counts   [MAX_LEVELS][MSD_BUCKETS];                 // Bucket counts, then bucket positions, for each MSD level
+        uint32 lsdCounts[sizeof( T ) * 8 / LSD_BITS][LSD_RADIX];   // Counts for each LSD pass
+        uint32 wcFill   [MSD_BUCKETS];
+        T      wcEntries[MSD_BUCKETS * WC_ENTRIES];
+        TK     wcKeys   [MSD_BUCKETS * WC_ENTRIES];
+    };
+
+    template<typename T, typename TK>
+    struct SortJob
+    {
+        Scratch<T, TK>* scratch;
+
+        T*      input;
+        T*      tmp;
+        TK*     keyInput;
+        TK*     keyTmp;
+
+        uint64  offset;         // Slice of the input scattered by this thread
+        uint64  length;
+        uint32  keyBits;
+        uint32  msdShift;
+
+        const uint64* bucketStarts;
+        uint32        firstBucket;  // Buckets finished by this thread
+        uint32        bucketCount;
+    };
+
+    struct NotStreamed { inline void operator()( uint32, uint64, uint64 ) {} };
+
+    template<uint32 MaxJobs, bool HasKey, typename T, typename TK, typename TOnSorted>
+    static void DoSort( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits,
+                        TOnSorted& onSorted );
+
+    template<typename T, typename TK, typename TOnSorted>
+    static void FinishBucketsStreamed( ThreadPool& pool, uint32 threadCount, SortJob<T, TK>& job, uint32 bucketCount,
+                                       const uint64* bucketStarts, Scratch<T, TK>* scratch, TOnSorted& onSorted );
+
+    template<bool HasKey, typename T, typename TK>
+    static void CountThread( SortJob<T, TK>* job );
+
+    template<bool HasKey, typename T, typename TK>
+    static void ScatterThread( SortJob<T, TK>* job );
+
+    template<bool HasKey, typename T, typename TK>
+    static void FinishBucketsThread( SortJob<T, TK>* job );
+
+    // Sorts the block in a on its lowest bits, using b as scratch space,
+    // leaving the result in b if resultInB is set, or in a otherwise.
+    template<bool HasKey, typename T, typename TK>
+    static void SortBlock( T* a, T* b, TK* keyA, TK* keyB, uint64 length, uint32 bits, bool resultInB,
+                           uint32 level, Scratch<T, TK>& scratch );
+
+    template<bool HasKey, typename T, typename TK>
+    static void SortBlockLSD( T* a, T* b, TK* keyA, TK* keyB, uint64 length, uint32 bits, bool resultInB,
+                              Scratch<T, TK>& scratch );
+
+    template<bool HasKey, typename T, typename TK>
+    static void ScatterToBuckets( const T* src, const TK* keySrc, uint64 length, uint32 shift, uint32 bucketCount,
+                                  T* dst, TK* keyDst, uint64* positions, Scratch<T, TK>& scratch );
+};
+
+
+//-----------------------------------------------------------
+template<uint32 MaxJobs, typename T>
+inline void HybridRadixSort::Sort( ThreadPool& pool, T* input, T* tmp, uint64 length, uint32 keyBits )
+{
+    NotStreamed onSorted;
+    DoSort<MaxJobs, false, T, uint32>( pool, input, tmp, nullptr, nullptr, length, keyBits, onSorted );
+}
+
+//-----------------------------------------------------------
+template<uint32 MaxJobs, typename T, typename TK>
+inline void HybridRadixSort::SortWithKey( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits )
+{
+    NotStreamed onSorted;
+    DoSort<MaxJobs, true, T, TK>( pool, input, tmp, keyInput, keyTmp, length, keyBits, onSorted );
+}
+
+//-----------------------------------------------------------
+template<uint32 MaxJobs, typename T, typename TK, typename TOnSorted>
+inline void HybridRadixSort::SortWithKeyStreamed( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits,
+                                                  TOnSorted&& onSorted )
+{
+    DoSort<MaxJobs, true, T, TK>( pool, input, tmp, keyInput, keyTmp, length, keyBits, onSorted );
+}
+
+//-----------------------------------------------------------
+template<uint32 MaxJobs, bool HasKey, typename T, typename TK, typename TOnSorted>
+inline void HybridRadixSort::DoSort( ThreadPool& pool, T* input, T* tmp, TK* keyInput, TK* keyTmp, uint64 length, uint32 keyBits,
+                                     TOnSorted& onSorted )
+{
+    constexpr bool IsStreamed = !std::is_same_v<TOnSorted, NotStreamed>;
+
+    ASSERT( keyBits > 0 && keyBits <= sizeof( T ) * 8 );
+
+    if( length == 0 )
+        return;
+
+    const uint32 threadCount = std::min( pool.ThreadCount(), MaxJobs );
+
+    Scratch<T, TK>* scratch = bbmalloc<Scratch<T, TK>>( sizeof( Scratch<T, TK> ) * threadCount );
+
+    // Not worth bucketing in parallel
+    const size_t entrySize = sizeof( T ) + ( HasKey ? sizeof( TK ) : 0 );
+    if( length * entrySize <= BLOCK_SIZE )
+    {
+        SortBlock<HasKey, T, TK>( input, tmp, keyInput, keyTmp, length, keyBits, true, 0, scratch[0] );
+
+        if constexpr ( IsStreamed )
+            onSorted( 0, 0, length );
+
+        free( scratch );
+        return;
+    }
+
+    const uint32 msdBits     = std::min( MSD_BITS, keyBits );
+    const uint32 msdShift    = keyBits - msdBits;
+    const uint32 bucketCount = 1u << msdBits;
+
+    const uint64 entriesPerThread = length / threadCount;
+    const uint64 trailingEntries  = length - entriesPerThread * threadCount;
+
+    SortJob<T, TK> jobs[MaxJobs];
+
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        auto& job = jobs[i];
+
+        job.scratch  = &scratch[i];
+        job.input    = input;
+        job.tmp      = tmp;
+        job.keyInput = keyInput;
+        job.keyTmp   = keyTmp;
+        job.offset   = i * entriesPerThread;
+        job.length   = entriesPerThread;
+        job.keyBits  = keyBits;
+        job.msdShift = msdShift;
+    }
+
+    jobs[threadCount-1].length += trailingEntries;
+
+    // Count each thread's entries per bucket
+    pool.RunJob( CountThread<HasKey, T, TK>, jobs, threadCount );
+
+    // Turn the counts into each thread's starting position in each bucket.
+    // Threads are laid out in order within a bucket, which keeps the sort stable.
+    uint64 bucketStarts[MSD_BUCKETS+1];
+
+    uint64 position = 0;
+    for( uint32 b = 0; b < bucketCount; b++ )
+    {
+        bucketStarts[b] = position;
+
+        for( uint32 i = 0; i < threadCount; i++ )
+        {
+            uint64&      count   = scratch[i].counts[0][b];
+            const uint64 entries = count;
+
+            count     = position;
+            position += entries;
+        }
+    }
+    bucketStarts[bucketCount] = position;
+    ASSERT( position == length );
+
+    pool.RunJob( ScatterThread<HasKey, T, TK>, jobs, threadCount );
+
+    if constexpr ( IsStreamed )
+    {
+        FinishBucketsStreamed<T, TK, TOnSorted>( pool, threadCount, jobs[0], bucketCount, bucketStarts, scratch, onSorted );
+        free( scratch );
+        return;
+    }
+
+    // Each thread finishes the buckets starting within its slice of the output
+    uint32 bucket = 0;
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        const uint64 sliceEnd = i == threadCount-1 ? length : ( i + 1 ) * entriesPerThread;
+
+        auto& job = jobs[i];
+        job.bucketStarts = bucketStarts;
+        job.firstBucket  = bucket;
+
+        while( bucket < bucketCount && bucketStarts[bucket] < sliceEnd )
+            bucket++;
+
+        job.bucketCount = bucket - job.firstBucket;
+    }
+    jobs[threadCount-1].bucketCount += bucketCount - bucket;
+
+    pool.RunJob( FinishBucketsThread<HasKey, T, TK>, jobs, threadCount );
+
+    free( scratch );
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::CountThread( SortJob<T, TK>* job )
+{
+    const uint32 shift = job->msdShift;
+    const uint64 mask  = ( 1ull << ( job->keyBits - shift ) ) - 1;
+
+    uint64* counts = job->scratch->counts[0];
+    memset( counts, 0, sizeof( uint64 ) * MSD_BUCKETS );
+
+    const T*     src    = job->input + job->offset;
+    const uint64 length = job->length;
+
+    for( uint64 i = 0; i < length; i++ )
+        counts[( src[i] >> shift ) & mask]++;
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::ScatterThread( SortJob<T, TK>* job )
+{
+    const uint32 shift       = job->msdShift;
+    const uint32 bucketCount = 1u << ( job->keyBits - shift );
+
+    const TK* keySrc = HasKey ? job->keyInput + job->offset : nullptr;
+
+    ScatterToBuckets<HasKey, T, TK>( job->input + job->offset, keySrc, job->length, shift, bucketCount,
+                                     job->tmp, job->keyTmp, job->scratch->counts[0], *job->scratch );
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::FinishBucketsThread( SortJob<T, TK>* job )
+{
+    const uint64* bucketStarts = job->bucketStarts;
+    const uint32  end          = job->firstBucket + job->bucketCount;
+
+    for( uint32 b = job->firstBucket; b < end; b++ )
+    {
+        const uint64 start  = bucketStarts[b];
+        const uint64 length = bucketStarts[b+1] - start;
+
+        TK* keyA = HasKey ? job->keyTmp   + start : nullptr;
+        TK* keyB = HasKey ? job->keyInput + start : nullptr;
+
+        // The bucket is in tmp, where the result goes as well
+        SortBlock<HasKey, T, TK>( job->tmp + start, job->input + start, keyA, keyB,
+                                  length, job->msdShift, false, 1, *job->scratch );
+    }
+}
+
+//-----------------------------------------------------------
+template<typename T, typename TK, typename TOnSorted>
+inline void HybridRadixSort::FinishBucketsStreamed( ThreadPool& pool, const uint32 threadCount, SortJob<T, TK>& job, const uint32 bucketCount,
+                                                    const uint64* bucketStarts, Scratch<T, TK>* scratch, TOnSorted& onSorted )
+{
+    std::atomic<uint32> nextBucket   = 0;
+    std::atomic<uint32> sortedPrefix = 0;       // Buckets below this one have been handed to onSorted
+    std::atomic<uint32> sorted[MSD_BUCKETS];
+
+    for( uint32 b = 0; b < bucketCount; b++ )
+        sorted[b].store( 0, std::memory_order_relaxed );
+
+    AnonMTJob::Run( pool, threadCount, [&]( AnonMTJob* self ) {
+
+        Scratch<T, TK>& threadScratch = scratch[self->JobId()];
+
+        for( ;; )
+        {
+            const uint32 bucket = nextBucket.fetch_add( 1, std::memory_order_relaxed );
+            if( bucket >= bucketCount )
+                break;
+
+            const uint64 start  = bucketStarts[bucket];
+            const uint64 length = bucketStarts[bucket+1] - start;
+
+            SortBlock<true, T, TK>( job.tmp + start, job.input + start, job.keyTmp + start, job.keyInput + start,
+                                    length, job.msdShift, false, 1, threadScratch );
+
+            // Sequentially consistent, so that the thread which sorted the next bucket
+            // of the prefix and this one can't both miss the other's progress.
+            sorted[bucket].store( 1 );
+
+            // Hand out every bucket that completes the sorted prefix
+            uint32 prefix = sortedPrefix.load();
+
+            while( prefix < bucketCount && sorted[prefix].load() )
+            {
+                if( sortedPrefix.compare_exchange_strong( prefix, prefix + 1 ) )
+                {
+                    onSorted( prefix, bucketStarts[prefix], bucketStarts[prefix+1] );
+                    prefix++;
+                }
+            }
+        }
+    });
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::SortBlock( T* a, T* b, TK* keyA, TK* keyB, const uint64 length, const uint32 bits,
+                                        const bool resultInB, const uint32 level, Scratch<T, TK>& scratch )
+{
+    if( length == 0 )
+        return;
+
+    const size_t entrySize = sizeof( T ) + ( HasKey ? sizeof( TK ) : 0 );
+
+    if( bits <= LSD_BITS * 2 || length * entrySize <= BLOCK_SIZE )
+    {
+        SortBlockLSD<HasKey, T, TK>( a, b, keyA, keyB, length, bits, resultInB, scratch );
+        return;
+    }
+
+    // Still too large to fit in the cache, split it again
+    ASSERT( level < MAX_LEVELS );
+
+    const uint32 msdBits     = std::min( MSD_BITS, bits );
+    const uint32 shift       = bits - msdBits;
+    const uint32 bucketCount = 1u << msdBits;
+    const uint64 mask        = bucketCount - 1;
+
+    uint64* positions = scratch.counts[level];
+    memset( positions, 0, sizeof( uint64 ) * bucketCount );
+
+    for( uint64 i = 0; i < length; i++ )
+        positions[( a[i] >> shift ) & mask]++;
+
+    uint64 position = 0;
+    for( uint32 i = 0; i < bucketCount; i++ )
+    {
+        const uint64 count = positions[i];
+        positions[i] = position;
+        position    += count;
+    }
+
+    ScatterToBuckets<HasKey, T, TK>( a, keyA, length, shift, bucketCount, b, keyB, positions, scratch );
+
+    // After scattering, each position points to the end of its bucket
+    uint64 start = 0;
+    for( uint32 i = 0; i < bucketCount; i++ )
+    {
+        const uint64 end = positions[i];
+
+        SortBlock<HasKey, T, TK>( b + start, a + start,
+                                  HasKey ? keyB + start : nullptr, HasKey ? keyA + start : nullptr,
+                                  end - start, shift, !resultInB, level + 1, scratch );
+        start = end;
+    }
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::SortBlockLSD( T* a, T* b, TK* keyA, TK* keyB, const uint64 length, const uint32 bits,
+                                           const bool resultInB, Scratch<T, TK>& scratch )
+{
+    ASSERT( length <= 0xFFFFFFFF );
+
+    const uint32 passCount = CDiv( bits, (int)LSD_BITS );
+    const uint64 keyMask   = bits >= 64 ? ~0ull : ( 1ull << bits ) - 1;
+
+    // Count all the digits in a single read
+    auto& counts = scratch.lsdCounts;
+    memset( counts, 0, sizeof( uint32 ) * LSD_RADIX * passCount );
+
+    for( uint64 i = 0; i < length; i++ )
+    {
+        const uint64 value = (uint64)a[i] & keyMask;
+
+        for( uint32 p = 0; p < passCount; p++ )
+            counts[p][( value >> ( p * LSD_BITS ) ) & ( LSD_RADIX - 1 )]++;
+    }
+
+    T*  src    = a;
+    T*  dst    = b;
+    TK* keySrc = keyA;
+    TK* keyDst = keyB;
+
+    for( uint32 p = 0; p < passCount; p++ )
+    {
+        uint32*      pfxSum = counts[p];
+        const uint32 shift  = p * LSD_BITS;
+
+        // Skip passes where all entries have the same digit
+        if( pfxSum[( ( (uint64)src[0] & keyMask ) >> shift ) & ( LSD_RADIX - 1 )] == length )
+            continue;
+
+        uint32 position = 0;
+        for( uint32 i = 0; i < LSD_RADIX; i++ )
+        {
+            const uint32 count = pfxSum[i];
+            pfxSum[i] = position;
+            position += count;
+        }
+
+        for( uint64 i = 0; i < length; i++ )
+        {
+            const T      value  = src[i];
+            const uint32 dstIdx = pfxSum[( ( (uint64)value & keyMask ) >> shift ) & ( LSD_RADIX - 1 )]++;
+
+            dst[dstIdx] = value;
+
+            if constexpr ( HasKey )
+                keyDst[dstIdx] = keySrc[i];
+        }
+
+        std::swap( src, dst );
+
+        if constexpr ( HasKey )
+            std::swap( keySrc, keyDst );
+    }
+
+    // The result is in src now, make sure it ends up where it's expected
+    if( ( src == b ) != resultInB )
+    {
+        memcpy( dst, src, sizeof( T ) * length );
+
+        if constexpr ( HasKey )
+            memcpy( keyDst, keySrc, sizeof( TK ) * length );
+    }
+}
+
+//-----------------------------------------------------------
+template<bool HasKey, typename T, typename TK>
+inline void HybridRadixSort::ScatterToBuckets( const T* src, const TK* keySrc, const uint64 length, const uint32 shift, const uint32 bucketCount,
+                                               T* dst, TK* keyDst, uint64* positions, Scratch<T, TK>& scratch )
+{
+    // Entries are gathered into a cache line-sized buffer per bucket first,
+    // so that each bucket is written to in whole lines, instead of one entry at a time.
+    constexpr uint32 WC_ENTRIES = Scratch<T, TK>::WC_ENTRIES;
+
+    const uint64 mask = bucketCount - 1;
+
+    uint32* fill      = scratch.wcFill;
+    T*      wcEntries = scratch.wcEntries;
+    TK*     wcKeys    = scratch.wcKeys;
+
+    memset( fill, 0, sizeof( uint32 ) * bucketCount );
+
+    for( uint64 i = 0; i < length; i++ )
+    {
+        const T      value  = src[i];
+        const uint64 bucket = ( value >> shift ) & mask;
+
+        uint32 count = fill[bucket];
+
+        wcEntries[bucket * WC_ENTRIES + count] = value;
+
+        if constexpr ( HasKey )
+            wcKeys[bucket * WC_ENTRIES + count] = keySrc[i];
+
+        if( ++count == WC_ENTRIES )
+        {
+            const uint64 pos = positions[bucket];
+
+            memcpy( dst + pos, wcEntries + bucket * WC_ENTRIES, sizeof( T ) * WC_ENTRIES );
+
+            if constexpr ( HasKey )
+                memcpy( keyDst + pos, wcKeys + bucket * WC_ENTRIES, sizeof( TK ) * WC_ENTRIES );
+
+            positions[bucket] = pos + WC_ENTRIES;
+            count = 0;
+        }
+
+        fill[bucket] = count;
+    }
+
+    // Flush partially-filled buffers
+    for( uint32 bucket = 0; bucket < bucketCount; bucket++ )
+    {
+        const uint32 count = fill[bucket];
+        if( count == 0 )
+            continue;
+
+        const uint64 pos = positions[bucket];
+
+        memcpy( dst + pos, wcEntries + bucket * WC_ENTRIES, sizeof( T ) * count );
+
+        if constexpr ( HasKey )
+            memcpy( keyDst + pos, wcKeys + bucket * WC_ENTRIES, sizeof( TK ) * count );
+
+        positions[bucket] = pos + count;
+    }
+}
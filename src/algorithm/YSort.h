@@ -1,5 +1,5 @@
 #pragma once
-
+#include "ChiaConsts.h"
 
 class ThreadPool;
 
@@ -7,10 +7,11 @@ class ThreadPool;
 class YSorter
 {
 public:
-    YSorter( ThreadPool& pool );
+    // Sorts y values of k + kExtraBits bits
+    YSorter( ThreadPool& pool, uint32 k = _K );
     ~YSorter();
     
-    // template<uint MaxJobs>
+    // The sorted values are written to yTmp (and sortKeyTmp)
     void Sort( 
         uint64 length, 
         uint64* yBuffer, uint64* yTmp );
@@ -20,15 +21,7 @@ public:
         uint64* yBuffer, uint64* yTmp,
         uint32* sortKey, uint32* sortKeyTmp );
 
-private:
-    void DoSort( bool useSortKey, uint64 length, 
-                uint64* yBuffer, uint64* yTmp,
-                uint32* sortKey, uint32* sortKeyTmp );
 private:
     ThreadPool& _pool;
-    // byte*       _pageCounts;
+    uint32      _k;
 };
-
-
-
-
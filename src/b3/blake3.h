@@ -49,6 +49,14 @@ void blake3_hasher_finalize(const blake3_hasher *self, uint8_t *out,
 void blake3_hasher_finalize_seek(const blake3_hasher *self, uint64_t seek,
                                  uint8_t *out, size_t out_len);
 
+// Hashes num_inputs independent messages of input_len bytes (1 to
+// BLAKE3_BLOCK_LEN) each, in parallel SIMD lanes where available. Each message
+// occupies its own BLAKE3_BLOCK_LEN-sized slot in inputs and must be
+// zero-padded past input_len. Writes the first BLAKE3_OUT_LEN bytes of each
+// message's hash to out, identical to blake3_hasher_finalize.
+void blake3_hash_many_small(const uint8_t *inputs, size_t num_inputs,
+                            size_t input_len, uint8_t *out);
+
 #ifdef __cplusplus
 }
 #endif
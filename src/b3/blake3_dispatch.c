@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include "blake3_impl.h"
+#include "util/CpuFeatures.h"
 
 #if defined(IS_X86)
 #if defined(_MSC_VER)
@@ -222,6 +223,48 @@ void blake3_hash_many(const uint8_t *const *inputs, size_t num_inputs,
                             out);
 }
 
+void blake3_hash_many_small(const uint8_t *inputs, size_t num_inputs,
+                            size_t input_len, uint8_t *out) {
+  assert(input_len > 0 && input_len <= BLAKE3_BLOCK_LEN);
+  const uint8_t block_len = (uint8_t)input_len;
+
+#if defined(IS_X86)
+#if !defined(BLAKE3_NO_AVX512)
+  if (CpuSupportsAVX512F() && CpuSupportsAVX512VL()) {
+    const size_t count = num_inputs - num_inputs % 16;
+    blake3_hash_many_small_avx512(inputs, count, block_len, out);
+    inputs += count * BLAKE3_BLOCK_LEN;
+    out += count * BLAKE3_OUT_LEN;
+    num_inputs -= count;
+  }
+#endif
+#if !defined(BLAKE3_NO_AVX2)
+  if (CpuSupportsAVX2()) {
+    const size_t count = num_inputs - num_inputs % 8;
+    blake3_hash_many_small_avx2(inputs, count, block_len, out);
+    inputs += count * BLAKE3_BLOCK_LEN;
+    out += count * BLAKE3_OUT_LEN;
+    num_inputs -= count;
+  }
+#endif
+#endif
+
+  // Remainder, one compression per input
+  for (; num_inputs > 0; num_inputs--, inputs += BLAKE3_BLOCK_LEN,
+                         out += BLAKE3_OUT_LEN) {
+    uint32_t cv[8];
+    memcpy(cv, IV, sizeof(cv));
+    blake3_compress_in_place(cv, inputs, block_len, 0,
+                             CHUNK_START | CHUNK_END | ROOT);
+    for (size_t i = 0; i < 8; i++) {
+      out[i * 4 + 0] = (uint8_t)(cv[i] >> 0);
+      out[i * 4 + 1] = (uint8_t)(cv[i] >> 8);
+      out[i * 4 + 2] = (uint8_t)(cv[i] >> 16);
+      out[i * 4 + 3] = (uint8_t)(cv[i] >> 24);
+    }
+  }
+}
+
 // The dynamically detected SIMD degree of the current platform.
 size_t blake3_simd_degree(void) {
 #if defined(IS_X86)
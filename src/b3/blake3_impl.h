@@ -198,6 +198,8 @@ void blake3_hash_many_sse41(const uint8_t *const *inputs, size_t num_inputs,
                             uint8_t flags_end, uint8_t *out);
 #endif
 #if !defined(BLAKE3_NO_AVX2)
+void blake3_hash_many_small_avx2(const uint8_t *inputs, size_t num_inputs,
+                                 uint8_t block_len, uint8_t *out);
 void blake3_hash_many_avx2(const uint8_t *const *inputs, size_t num_inputs,
                            size_t blocks, const uint32_t key[8],
                            uint64_t counter, bool increment_counter,
@@ -215,6 +217,9 @@ void blake3_compress_xof_avx512(const uint32_t cv[8],
                                 uint8_t block_len, uint64_t counter,
                                 uint8_t flags, uint8_t out[64]);
 
+void blake3_hash_many_small_avx512(const uint8_t *inputs, size_t num_inputs,
+                                   uint8_t block_len, uint8_t *out);
+
 void blake3_hash_many_avx512(const uint8_t *const *inputs, size_t num_inputs,
                              size_t blocks, const uint32_t key[8],
                              uint64_t counter, bool increment_counter,
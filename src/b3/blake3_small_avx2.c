@@ -0,0 +1,150 @@
+#include "blake3_impl.h"
+
+#include <immintrin.h>
+
+// Hashes many independent messages of at most one block (BLAKE3_BLOCK_LEN bytes)
+// in parallel lanes. Unlike blake3_hash_many, the block length is a parameter,
+// so the output matches blake3_hasher for short inputs (ie. Fx evaluation).
+
+#define DEGREE 8
+
+INLINE __m256i loadu(const uint8_t src[32]) {
+  return _mm256_loadu_si256((const __m256i *)src);
+}
+
+INLINE void storeu(__m256i src, uint8_t dest[32]) {
+  _mm256_storeu_si256((__m256i *)dest, src);
+}
+
+INLINE __m256i addv(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+
+INLINE __m256i xorv(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+
+INLINE __m256i set1(uint32_t x) { return _mm256_set1_epi32((int32_t)x); }
+
+INLINE __m256i rot16(__m256i x) {
+  return _mm256_shuffle_epi8(
+      x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                         13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+INLINE __m256i rot12(__m256i x) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 32 - 12));
+}
+
+INLINE __m256i rot8(__m256i x) {
+  return _mm256_shuffle_epi8(
+      x, _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+                         12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+}
+
+INLINE __m256i rot7(__m256i x) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 32 - 7));
+}
+
+#define G(a, b, c, d, mx, my)                     \
+  v[a] = addv(addv(v[a], v[b]), mx);              \
+  v[d] = rot16(xorv(v[d], v[a]));                 \
+  v[c] = addv(v[c], v[d]);                        \
+  v[b] = rot12(xorv(v[b], v[c]));                 \
+  v[a] = addv(addv(v[a], v[b]), my);              \
+  v[d] = rot8(xorv(v[d], v[a]));                  \
+  v[c] = addv(v[c], v[d]);                        \
+  v[b] = rot7(xorv(v[b], v[c]))
+
+INLINE void round_fn(__m256i v[16], const __m256i m[16], size_t r) {
+  const uint8_t *s = MSG_SCHEDULE[r];
+
+  G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+  G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+  G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+  G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+  G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+  G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+  G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+  G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+}
+
+#undef G
+
+INLINE void transpose_vecs(__m256i vecs[DEGREE]) {
+  __m256i ab_0145 = _mm256_unpacklo_epi32(vecs[0], vecs[1]);
+  __m256i ab_2367 = _mm256_unpackhi_epi32(vecs[0], vecs[1]);
+  __m256i cd_0145 = _mm256_unpacklo_epi32(vecs[2], vecs[3]);
+  __m256i cd_2367 = _mm256_unpackhi_epi32(vecs[2], vecs[3]);
+  __m256i ef_0145 = _mm256_unpacklo_epi32(vecs[4], vecs[5]);
+  __m256i ef_2367 = _mm256_unpackhi_epi32(vecs[4], vecs[5]);
+  __m256i gh_0145 = _mm256_unpacklo_epi32(vecs[6], vecs[7]);
+  __m256i gh_2367 = _mm256_unpackhi_epi32(vecs[6], vecs[7]);
+
+  __m256i abcd_04 = _mm256_unpacklo_epi64(ab_0145, cd_0145);
+  __m256i abcd_15 = _mm256_unpackhi_epi64(ab_0145, cd_0145);
+  __m256i abcd_26 = _mm256_unpacklo_epi64(ab_2367, cd_2367);
+  __m256i abcd_37 = _mm256_unpackhi_epi64(ab_2367, cd_2367);
+  __m256i efgh_04 = _mm256_unpacklo_epi64(ef_0145, gh_0145);
+  __m256i efgh_15 = _mm256_unpackhi_epi64(ef_0145, gh_0145);
+  __m256i efgh_26 = _mm256_unpacklo_epi64(ef_2367, gh_2367);
+  __m256i efgh_37 = _mm256_unpackhi_epi64(ef_2367, gh_2367);
+
+  vecs[0] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x20);
+  vecs[1] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x20);
+  vecs[2] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x20);
+  vecs[3] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x20);
+  vecs[4] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x31);
+  vecs[5] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x31);
+  vecs[6] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x31);
+  vecs[7] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x31);
+}
+
+void blake3_hash_many_small_avx2(const uint8_t *inputs, size_t num_inputs,
+                                 uint8_t block_len, uint8_t *out) {
+  const uint8_t flags = CHUNK_START | CHUNK_END | ROOT;
+
+  for (; num_inputs >= DEGREE; num_inputs -= DEGREE,
+                               inputs += DEGREE * BLAKE3_BLOCK_LEN,
+                               out += DEGREE * BLAKE3_OUT_LEN) {
+    __m256i m[16];
+
+    for (size_t i = 0; i < DEGREE; i++) {
+      m[i] = loadu(&inputs[i * BLAKE3_BLOCK_LEN]);
+    }
+    transpose_vecs(&m[0]);
+
+    // The upper half of the block is only zero-padding for short inputs
+    if (block_len > 32) {
+      for (size_t i = 0; i < DEGREE; i++) {
+        m[8 + i] = loadu(&inputs[i * BLAKE3_BLOCK_LEN + 32]);
+      }
+      transpose_vecs(&m[8]);
+    } else {
+      for (size_t i = 8; i < 16; i++) {
+        m[i] = _mm256_setzero_si256();
+      }
+    }
+
+    __m256i v[16] = {
+        set1(IV[0]), set1(IV[1]), set1(IV[2]),     set1(IV[3]),
+        set1(IV[4]), set1(IV[5]), set1(IV[6]),     set1(IV[7]),
+        set1(IV[0]), set1(IV[1]), set1(IV[2]),     set1(IV[3]),
+        set1(0),     set1(0),     set1(block_len), set1(flags),
+    };
+
+    round_fn(v, m, 0);
+    round_fn(v, m, 1);
+    round_fn(v, m, 2);
+    round_fn(v, m, 3);
+    round_fn(v, m, 4);
+    round_fn(v, m, 5);
+    round_fn(v, m, 6);
+
+    __m256i h[DEGREE];
+    for (size_t i = 0; i < DEGREE; i++) {
+      h[i] = xorv(v[i], v[i + 8]);
+    }
+    transpose_vecs(h);
+
+    for (size_t i = 0; i < DEGREE; i++) {
+      storeu(h[i], &out[i * BLAKE3_OUT_LEN]);
+    }
+  }
+}
@@ -0,0 +1,167 @@
+#include "blake3_impl.h"
+
+#include <immintrin.h>
+
+// 16-lane variant of blake3_hash_many_small_avx2.
+
+#define DEGREE 16
+
+INLINE __m512i add_512(__m512i a, __m512i b) { return _mm512_add_epi32(a, b); }
+
+INLINE __m512i xor_512(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+
+INLINE __m512i set1_512(uint32_t x) { return _mm512_set1_epi32((int32_t)x); }
+
+#define G(a, b, c, d, mx, my)                               \
+  v[a] = add_512(add_512(v[a], v[b]), mx);                  \
+  v[d] = _mm512_ror_epi32(xor_512(v[d], v[a]), 16);         \
+  v[c] = add_512(v[c], v[d]);                               \
+  v[b] = _mm512_ror_epi32(xor_512(v[b], v[c]), 12);         \
+  v[a] = add_512(add_512(v[a], v[b]), my);                  \
+  v[d] = _mm512_ror_epi32(xor_512(v[d], v[a]), 8);          \
+  v[c] = add_512(v[c], v[d]);                               \
+  v[b] = _mm512_ror_epi32(xor_512(v[b], v[c]), 7)
+
+INLINE void round_fn16(__m512i v[16], const __m512i m[16], size_t r) {
+  const uint8_t *s = MSG_SCHEDULE[r];
+
+  G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+  G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+  G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+  G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+  G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+  G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+  G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+  G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+}
+
+#undef G
+
+// 0b10001000, or lanes a0/a2/b0/b2 in little-endian order
+#define LO_IMM8 0x88
+
+INLINE __m512i unpack_lo_128(__m512i a, __m512i b) {
+  return _mm512_shuffle_i32x4(a, b, LO_IMM8);
+}
+
+// 0b11011101, or lanes a1/a3/b1/b3 in little-endian order
+#define HI_IMM8 0xdd
+
+INLINE __m512i unpack_hi_128(__m512i a, __m512i b) {
+  return _mm512_shuffle_i32x4(a, b, HI_IMM8);
+}
+
+INLINE void transpose_vecs_512(__m512i vecs[16]) {
+  __m512i ab_0 = _mm512_unpacklo_epi32(vecs[0], vecs[1]);
+  __m512i ab_2 = _mm512_unpackhi_epi32(vecs[0], vecs[1]);
+  __m512i cd_0 = _mm512_unpacklo_epi32(vecs[2], vecs[3]);
+  __m512i cd_2 = _mm512_unpackhi_epi32(vecs[2], vecs[3]);
+  __m512i ef_0 = _mm512_unpacklo_epi32(vecs[4], vecs[5]);
+  __m512i ef_2 = _mm512_unpackhi_epi32(vecs[4], vecs[5]);
+  __m512i gh_0 = _mm512_unpacklo_epi32(vecs[6], vecs[7]);
+  __m512i gh_2 = _mm512_unpackhi_epi32(vecs[6], vecs[7]);
+  __m512i ij_0 = _mm512_unpacklo_epi32(vecs[8], vecs[9]);
+  __m512i ij_2 = _mm512_unpackhi_epi32(vecs[8], vecs[9]);
+  __m512i kl_0 = _mm512_unpacklo_epi32(vecs[10], vecs[11]);
+  __m512i kl_2 = _mm512_unpackhi_epi32(vecs[10], vecs[11]);
+  __m512i mn_0 = _mm512_unpacklo_epi32(vecs[12], vecs[13]);
+  __m512i mn_2 = _mm512_unpackhi_epi32(vecs[12], vecs[13]);
+  __m512i op_0 = _mm512_unpacklo_epi32(vecs[14], vecs[15]);
+  __m512i op_2 = _mm512_unpackhi_epi32(vecs[14], vecs[15]);
+
+  __m512i abcd_0 = _mm512_unpacklo_epi64(ab_0, cd_0);
+  __m512i abcd_1 = _mm512_unpackhi_epi64(ab_0, cd_0);
+  __m512i abcd_2 = _mm512_unpacklo_epi64(ab_2, cd_2);
+  __m512i abcd_3 = _mm512_unpackhi_epi64(ab_2, cd_2);
+  __m512i efgh_0 = _mm512_unpacklo_epi64(ef_0, gh_0);
+  __m512i efgh_1 = _mm512_unpackhi_epi64(ef_0, gh_0);
+  __m512i efgh_2 = _mm512_unpacklo_epi64(ef_2, gh_2);
+  __m512i efgh_3 = _mm512_unpackhi_epi64(ef_2, gh_2);
+  __m512i ijkl_0 = _mm512_unpacklo_epi64(ij_0, kl_0);
+  __m512i ijkl_1 = _mm512_unpackhi_epi64(ij_0, kl_0);
+  __m512i ijkl_2 = _mm512_unpacklo_epi64(ij_2, kl_2);
+  __m512i ijkl_3 = _mm512_unpackhi_epi64(ij_2, kl_2);
+  __m512i mnop_0 = _mm512_unpacklo_epi64(mn_0, op_0);
+  __m512i mnop_1 = _mm512_unpackhi_epi64(mn_0, op_0);
+  __m512i mnop_2 = _mm512_unpacklo_epi64(mn_2, op_2);
+  __m512i mnop_3 = _mm512_unpackhi_epi64(mn_2, op_2);
+
+  __m512i abcdefgh_0 = unpack_lo_128(abcd_0, efgh_0);
+  __m512i abcdefgh_1 = unpack_lo_128(abcd_1, efgh_1);
+  __m512i abcdefgh_2 = unpack_lo_128(abcd_2, efgh_2);
+  __m512i abcdefgh_3 = unpack_lo_128(abcd_3, efgh_3);
+  __m512i abcdefgh_4 = unpack_hi_128(abcd_0, efgh_0);
+  __m512i abcdefgh_5 = unpack_hi_128(abcd_1, efgh_1);
+  __m512i abcdefgh_6 = unpack_hi_128(abcd_2, efgh_2);
+  __m512i abcdefgh_7 = unpack_hi_128(abcd_3, efgh_3);
+  __m512i ijklmnop_0 = unpack_lo_128(ijkl_0, mnop_0);
+  __m512i ijklmnop_1 = unpack_lo_128(ijkl_1, mnop_1);
+  __m512i ijklmnop_2 = unpack_lo_128(ijkl_2, mnop_2);
+  __m512i ijklmnop_3 = unpack_lo_128(ijkl_3, mnop_3);
+  __m512i ijklmnop_4 = unpack_hi_128(ijkl_0, mnop_0);
+  __m512i ijklmnop_5 = unpack_hi_128(ijkl_1, mnop_1);
+  __m512i ijklmnop_6 = unpack_hi_128(ijkl_2, mnop_2);
+  __m512i ijklmnop_7 = unpack_hi_128(ijkl_3, mnop_3);
+
+  vecs[0] = unpack_lo_128(abcdefgh_0, ijklmnop_0);
+  vecs[1] = unpack_lo_128(abcdefgh_1, ijklmnop_1);
+  vecs[2] = unpack_lo_128(abcdefgh_2, ijklmnop_2);
+  vecs[3] = unpack_lo_128(abcdefgh_3, ijklmnop_3);
+  vecs[4] = unpack_lo_128(abcdefgh_4, ijklmnop_4);
+  vecs[5] = unpack_lo_128(abcdefgh_5, ijklmnop_5);
+  vecs[6] = unpack_lo_128(abcdefgh_6, ijklmnop_6);
+  vecs[7] = unpack_lo_128(abcdefgh_7, ijklmnop_7);
+  vecs[8] = unpack_hi_128(abcdefgh_0, ijklmnop_0);
+  vecs[9] = unpack_hi_128(abcdefgh_1, ijklmnop_1);
+  vecs[10] = unpack_hi_128(abcdefgh_2, ijklmnop_2);
+  vecs[11] = unpack_hi_128(abcdefgh_3, ijklmnop_3);
+  vecs[12] = unpack_hi_128(abcdefgh_4, ijklmnop_4);
+  vecs[13] = unpack_hi_128(abcdefgh_5, ijklmnop_5);
+  vecs[14] = unpack_hi_128(abcdefgh_6, ijklmnop_6);
+  vecs[15] = unpack_hi_128(abcdefgh_7, ijklmnop_7);
+}
+
+void blake3_hash_many_small_avx512(const uint8_t *inputs, size_t num_inputs,
+                                   uint8_t block_len, uint8_t *out) {
+  const uint8_t flags = CHUNK_START | CHUNK_END | ROOT;
+
+  for (; num_inputs >= DEGREE; num_inputs -= DEGREE,
+                               inputs += DEGREE * BLAKE3_BLOCK_LEN,
+                               out += DEGREE * BLAKE3_OUT_LEN) {
+    __m512i m[16];
+
+    for (size_t i = 0; i < DEGREE; i++) {
+      m[i] = _mm512_loadu_si512((const void *)&inputs[i * BLAKE3_BLOCK_LEN]);
+    }
+    transpose_vecs_512(m);
+
+    __m512i v[16] = {
+        set1_512(IV[0]), set1_512(IV[1]), set1_512(IV[2]),     set1_512(IV[3]),
+        set1_512(IV[4]), set1_512(IV[5]), set1_512(IV[6]),     set1_512(IV[7]),
+        set1_512(IV[0]), set1_512(IV[1]), set1_512(IV[2]),     set1_512(IV[3]),
+        set1_512(0),     set1_512(0),     set1_512(block_len), set1_512(flags),
+    };
+
+    round_fn16(v, m, 0);
+    round_fn16(v, m, 1);
+    round_fn16(v, m, 2);
+    round_fn16(v, m, 3);
+    round_fn16(v, m, 4);
+    round_fn16(v, m, 5);
+    round_fn16(v, m, 6);
+
+    // Pad the 8 output words to a 16x16 matrix for the transpose,
+    // then store the lower half of each vector.
+    __m512i h[16];
+    for (size_t i = 0; i < 8; i++) {
+      h[i] = xor_512(v[i], v[i + 8]);
+      h[i + 8] = _mm512_setzero_si512();
+    }
+    transpose_vecs_512(h);
+
+    for (size_t i = 0; i < DEGREE; i++) {
+      _mm256_storeu_si256((__m256i *)&out[i * BLAKE3_OUT_LEN],
+                          _mm512_castsi512_si256(h[i]));
+    }
+  }
+}
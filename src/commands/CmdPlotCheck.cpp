@@ -5,6 +5,7 @@
 #include "plotting/PlotValidation.h"
 #include "plotting/f1/F1Gen.h"
 #include "tools/PlotChecker.h"
+#include "tools/PlotCheckpointCache.h"
 #include "harvesting/GreenReaper.h"
 
 
@@ -18,6 +19,9 @@ struct PlotCheckConfig
     bool                     hasSeed    = false;
     bool                     noGpu      = false;
     int32                    gpuIndex   = -1;
+    bool                     useMMap    = false;
+    const char*              indexDir   = nullptr;
+    size_t                   cpCache    = PlotCheckpointCache::DEFAULT_MEMORY_BUDGET;
 };
 
 void CmdPlotsCheckHelp();
@@ -42,6 +46,9 @@ void CmdPlotsCheckMain( GlobalPlotConfig& gCfg, CliParser& cli )
         else if( cli.ReadU64( cfg.proofCount, "-n", "--iterations" ) ) continue;
         else if( cli.ReadSwitch( cfg.noGpu, "-g", "--no-gpu" ) ) continue;
         else if( cli.ReadI32( cfg.gpuIndex, "-d", "--device" ) ) continue;
+        else if( cli.ReadSwitch( cfg.useMMap, "--mmap" ) ) continue;
+        else if( cli.ReadStr( cfg.indexDir, "--index-dir" ) ) continue;
+        else if( cli.ReadSize( cfg.cpCache, "--checkpoint-cache" ) ) continue;
         else
             break;
     }
@@ -76,13 +83,19 @@ void CmdPlotsCheckMain( GlobalPlotConfig& gCfg, CliParser& cli )
         .silent             = false,
         .hasSeed            = cfg.hasSeed,
         .deletePlots        = false,
-        .deleteThreshold    = 0.0
+        .deleteThreshold    = 0.0,
+        .useMMap            = cfg.useMMap
     };
 
     static_assert( sizeof( checkerCfg.seed ) == sizeof( cfg.seed ) );
     if( cfg.hasSeed )
         memcpy( checkerCfg.seed, cfg.seed, sizeof( checkerCfg.seed ) );
 
+    if( cfg.indexDir )
+        PlotCheckpointCache::SetSidecarDirectory( cfg.indexDir );
+
+    PlotCheckpointCache::SetMemoryBudget( cfg.cpCache );
+
     ptr<PlotChecker> checker( PlotChecker::Create( checkerCfg ) );
 
     for( auto* plotPath : cfg.plotPaths )
@@ -100,6 +113,8 @@ void CmdPlotsCheckMain( GlobalPlotConfig& gCfg, CliParser& cli )
         //     (llu)result.proofCount, (llu)cfg.proofCount, ((double)result.proofCount / cfg.proofCount) * 100.0 );
     }
 
+    PlotCheckpointCache::LogStats();
+
 }
 
 //-----------------------------------------------------------
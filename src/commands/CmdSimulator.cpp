@@ -1,6 +1,7 @@
 #include "Commands.h"
 #include "plotting/GlobalPlotConfig.h"
 #include "tools/PlotReader.h"
+#include "tools/PlotCheckpointCache.h"
 #include "threading/MTJob.h"
 #include "harvesting/GreenReaper.h"
 #include "plotting/f1/F1Gen.h"
@@ -29,6 +30,10 @@ struct Config
     double      powerSimSeconds = -1;
     bool        noCuda          = false;
     int32       cudaDevice      = 0;
+    bool        useMMap         = false;
+    const char* indexDir        = nullptr;
+    size_t      checkpointCache = PlotCheckpointCache::DEFAULT_MEMORY_BUDGET;
+    uint32      fetchThreads    = 0;
 
     // Internally set
     double      partialRatio  = 0;
@@ -52,9 +57,10 @@ struct JobStats
 struct SimulatorJob : MTJob<SimulatorJob>
 {
     Config*        cfg;
-    Span<FilePlot> plots;
+    Span<IPlotFile*> plots;
     JobStats*      stats;
     uint32         decompressorThreadCount;
+    GRContextPool* grPool;
 
     virtual void Run() override;
 
@@ -93,6 +99,10 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
         else if( cli.ReadHexStrAsBytes( cfg.randomSeed, sizeof( cfg.randomSeed ), "--seed" ) ) continue;
         else if( cli.ReadSwitch( cfg.noCuda, "--no-cuda" ) ) continue;
         else if( cli.ReadI32( cfg.cudaDevice, "-d", "--device" ) ) continue;
+        else if( cli.ReadSwitch( cfg.useMMap, "--mmap" ) ) continue;
+        else if( cli.ReadStr( cfg.indexDir, "--index-dir" ) ) continue;
+        else if( cli.ReadSize( cfg.checkpointCache, "--checkpoint-cache" ) ) continue;
+        else if( cli.ReadU32( cfg.fetchThreads, "--fetch-threads" ) ) continue;
         else
             break;
     }
@@ -133,14 +143,21 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
     }
 
 
-    FilePlot* plot = new FilePlot[cfg.parallelCount];
+    if( cfg.indexDir )
+        PlotCheckpointCache::SetSidecarDirectory( cfg.indexDir );
+
+    PlotCheckpointCache::SetMemoryBudget( cfg.checkpointCache );
+
+    IPlotFile** plot = new IPlotFile*[cfg.parallelCount];
     for( uint32 i = 0; i < cfg.parallelCount; i++ )
     {
-        if( !plot[i].Open( cfg.plotPath ) )
-            Fatal( "Failed to open plot file at '%s' with error %d.", cfg.plotPath, plot[i].GetError() );
+        plot[i] = cfg.useMMap ? (IPlotFile*)new MMapPlot() : (IPlotFile*)new FilePlot();
+
+        if( !plot[i]->Open( cfg.plotPath ) )
+            Fatal( "Failed to open plot file at '%s' with error %d.", cfg.plotPath, plot[i]->GetError() );
     }
 
-    const uint32 compressionLevel = plot[0].CompressionLevel();
+    const uint32 compressionLevel = plot[0]->CompressionLevel();
     FatalIf( compressionLevel < 1, "The plot %s is not compressed.", cfg.plotPath );
 
     if( powerMode ) 
@@ -148,7 +165,7 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
         if( cfg.farmSize == 0 )
         {
             // Set a default farm size when at least 1 plot per context passes the filter
-            const size_t plotSize = CalculatePlotSizeBytes( plot->K(), compressionLevel );
+            const size_t plotSize = CalculatePlotSizeBytes( plot[0]->K(), compressionLevel );
             cfg.farmSize = (uint64)cfg.parallelCount * plotSize * cfg.filterBits;
             Log::Line( "Setting default farm size to %llu TB (use --size <size> to set a farm size manually).",
                 (llu)BtoTBSi( cfg.farmSize ) );
@@ -160,7 +177,7 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
 
 
 
-    Log::Line( "[Simulator for harvester farm capacity for K%2u C%u plots]", plot->K(), compressionLevel );
+    Log::Line( "[Simulator for harvester farm capacity for K%2u C%u plots]", plot[0]->K(), compressionLevel );
     Log::Line( " Random seed: 0x%s", BytesToHexStdString( cfg.randomSeed, sizeof( cfg.randomSeed ) ).c_str() );
     Log::Line( " Simulating..." );
     Log::NewLine();
@@ -171,12 +188,43 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
     const uint32 decompressorThreadCount = std::min( gCfg.threadCount == 0 ? 8 : gCfg.threadCount, SysHost::GetLogicalCPUCount() );
     JobStats stats = {};
 
+    // Preallocate one decompression context per parallel instance up front
+    GRContextPool* grPool = nullptr;
+    {
+        GRContextPoolConfig poolCfg = {};
+        poolCfg.apiVersion          = GR_API_VERSION;
+        poolCfg.contextCount        = cfg.parallelCount;
+        poolCfg.k                   = plot[0]->K();
+        poolCfg.maxCompressionLevel = compressionLevel;
+        poolCfg.numaPinning         = gCfg.disableNuma ? GR_FALSE : GR_TRUE;
+
+        GreenReaperConfig& grCfg = poolCfg.contextConfig;
+        grCfg.apiVersion         = GR_API_VERSION;
+        grCfg.threadCount        = decompressorThreadCount;
+        grCfg.cpuOffset          = 0;
+        grCfg.disableCpuAffinity = gCfg.disableCpuAffinity;
+        grCfg.gpuRequest         = cfg.noCuda ? GRGpuRequestKind_None : GRGpuRequestKind_FirstAvailable;
+        grCfg.gpuDeviceIndex     = cfg.cudaDevice;
+
+        const auto result = grCreateContextPool( &grPool, &poolCfg, sizeof( poolCfg ) );
+        FatalIf( !grPool, "Failed to create decompression contexts with error %d.", (int)result );
+
+        GreenReaperContext* grContext = grAcquireContext( grPool, GR_TRUE );
+
+        if( grCfg.gpuRequest != GRGpuRequestKind_None && !(bool)grHasGpuDecompressor( grContext ) )
+            Log::Line( "Warning: No GPU device decompressor selected. Falling back to CPU-based simulation." );
+
+        cfg.jobsMemoryUsed = grGetMemoryUsage( grContext );
+        grReleaseContext( grPool, grContext );
+    }
+
     {
         SimulatorJob job = {};
         job.cfg                     = &cfg;
-        job.plots                   = Span<FilePlot>( plot, cfg.parallelCount );
+        job.plots                   = Span<IPlotFile*>( plot, cfg.parallelCount );
         job.stats                   = &stats;
         job.decompressorThreadCount = decompressorThreadCount;
+        job.grPool                  = grPool;
 
         MTJobRunner<SimulatorJob>::RunFromInstance( pool, cfg.parallelCount, job );
 
@@ -184,6 +232,8 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
             stats.minFPFetchTimeNano = 0;
     }
 
+    grDestroyContextPool( grPool );
+
     // Report
     {
         const uint64 actualFetchCount        = stats.nActualFetches;
@@ -209,6 +259,7 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
         Log::Line( " Worst plot lookup lookup time : %.3lf seconds", fetchMaxSecs       );
         Log::Line( " Average full proof lookup time: %.3lf seconds", fetchFpAverageSecs );
         Log::Line( " Fastest full proof lookup time: %.3lf seconds", stats.nActualFullProofFetches == 0 ? 0.0 : NanoSecondsToSeconds( stats.minFPFetchTimeNano ) );
+        PlotCheckpointCache::LogStats();
         Log::NewLine();
 
         if( fetchMaxSecs >= cfg.maxLookupTime )
@@ -220,7 +271,7 @@ void CmdSimulateMain( GlobalPlotConfig& gCfg, CliParser& cli )
         // Calculate farm size for this compression level
         Log::Line( " %10s | %-10s | %-10s | %-10s ", "compression", "plot count", "size TB", "size PB" );
         Log::Line( "------------------------------------------------" );
-        DumpCompressedPlotCapacity( cfg, plot->K(), compressionLevel, fetchAverageSecs );
+        DumpCompressedPlotCapacity( cfg, plot[0]->K(), compressionLevel, fetchAverageSecs );
     }
 
     Log::NewLine();
@@ -289,30 +340,15 @@ size_t CalculatePlotSizeBytes( const uint32 k, const uint32 compressionLevel )
 
 void SimulatorJob::Run()
 {
-    FilePlot& plot = plots[JobId()];
+    IPlotFile& plot = *plots[JobId()];
 
     PlotReader reader( plot );
 
-    {
-        GreenReaperConfig grCfg = {};
-        grCfg.apiVersion         = GR_API_VERSION;
-        grCfg.threadCount        = decompressorThreadCount;
-        grCfg.cpuOffset          = decompressorThreadCount * JobId();
-        grCfg.disableCpuAffinity = cfg->gCfg->disableCpuAffinity;
-        grCfg.gpuRequest         = cfg->noCuda ? GRGpuRequestKind_None : GRGpuRequestKind_FirstAvailable;
-        grCfg.gpuDeviceIndex     = cfg->cudaDevice;
-
-        GreenReaperContext* grContext = nullptr;
-        const auto result = grCreateContext( &grContext, &grCfg, sizeof( GreenReaperConfig ) );
-        FatalIf( !grContext, "Failed to create decompression context with error %d.", (int)result );
-
-        if( grCfg.gpuRequest != GRGpuRequestKind_None && !(bool)grHasGpuDecompressor( grContext ) )
-            Log::Line( "Warning: No GPU device decompressor selected. Falling back to CPU-based simulation." );
-
-        reader.AssignDecompressionContext( grContext );
-    }
+    reader.AssignDecompressionContextPool( grPool );
     // reader.ConfigDecompressor( decompressorThreadCount, cfg->gCfg->disableCpuAffinity, decompressorThreadCount * JobId() );
 
+    reader.ConfigProofFetch( cfg->fetchThreads );
+
 
     const double challengeRatio = cfg->fetchCount / (double)CHALLENGES_PER_DAY;
     const uint64 actualPartials = (uint64)(cfg->partials * challengeRatio);
@@ -326,9 +362,6 @@ void SimulatorJob::Run()
     }
 
     RunFarm( reader, fetchCountForJob, (uint32)partialsForJob );
-
-    if( IsControlThread() )
-        cfg->jobsMemoryUsed = grGetMemoryUsage( reader.GetDecompressorContext() );
 }
 
 void SimulatorJob::RunFarm( PlotReader& reader, const uint64 challengeCount, const uint32 partialCount )
@@ -523,6 +556,12 @@ OPTIONS:
  --seed <hex>             : 64 char hex string to use as a random seed for challenges.
  --no-cuda                : Don't use CUDA for decompression.
  -d, --device <index>     : Cuda device index. (default = 0)
+ --mmap                   : Memory-map the plot instead of reading it through file I/O.
+ --index-dir <path>       : Directory where plot checkpoint (C1/C2) index files are kept, to skip re-reading them.
+ --checkpoint-cache <size>: Memory used to cache plot checkpoint (C1/C2) entries across lookups. 0 disables it.
+                            (default = 256MiB)
+ --fetch-threads <count>  : Threads used to read the parks of each table level of a full proof concurrently.
+                            (default = 0, read them one at a time)
 )";
 
 void CmdSimulateHelp()
@@ -3,6 +3,8 @@
 #include "harvesting/Thresher.h"
 #include "threading/ThreadPool.h"
 #include "threading/GenJob.h"
+#include "threading/Thread.h"
+#include "threading/AutoResetSignal.h"
 #include "plotting/Tables.h"
 #include "tools/PlotReader.h"
 #include "plotmem/LPGen.h"
@@ -14,12 +16,20 @@
 #include "util/BitView.h"
 #include "util/VirtualAllocator.h"
 #include "plotting/matching/GroupScan.h"
+#include "plotting/matching/KBCMatch.h"
+#include "plotting/LinePointBatch.h"
 #include <mutex>
+#include <queue>
 #include <algorithm>
 
 
 static std::mutex _lTargetLock;
 
+#if BB_TEST_MODE
+    bool   grTestDisableQualitiesFastPath = false;
+    uint64 grTestQualitiesFastPathHits    = 0;
+#endif
+
 // Internal types
 struct ProofContext
 {
@@ -106,6 +116,38 @@ struct ProofTable
     // }
 };
 
+// A request submitted through the asynchronous API
+struct GRAsyncRequest
+{
+    GRTicket          ticket;
+    bool              isProof;
+    void*             req;          // GRCompressedProofRequest or GRCompressedQualitiesRequest
+    GRRequestCallback callback;
+    void*             userData;
+};
+
+struct GRAsyncResult
+{
+    GRTicket ticket;
+    GRResult result;
+};
+
+// Work queue serving the asynchronous API. Requests are dispatched
+// in submission order, in batches, by a single thread owned by the context.
+struct GRAsyncQueue
+{
+    Thread*                    thread         = nullptr;
+    std::mutex                 lock;
+    std::queue<GRAsyncRequest> pending;
+    std::vector<GRAsyncResult> completed;               // Results not yet retrieved by grPoll/grWait
+    GRTicket                   nextTicket     = 1;
+    GRTicket                   lastCompleted  = 0;      // All tickets at or below this value have completed
+    uint32                     outstanding    = 0;      // Requests submitted and not yet released (by grPoll/grWait or their callback)
+    AutoResetSignal            requestSignal;
+    AutoResetSignal            completedSignal;
+    std::atomic<bool>          exitSignal     = false;
+};
+
 // Used for qualities fetch. Line point and index.
 // Represents a line point and its original, pre-sort index.
 struct LPIndex { uint64 lp; uint32 index; };
@@ -152,6 +194,29 @@ struct GreenReaperContext
     IThresher*     cudaThresher         = nullptr;
     bool           cudaRecreateThresher = false;    // In case a CUDA error occurred or the device was lost,
                                                     // we need to re-create it.
+
+    GreenReaperContext** lanes     = nullptr;       // Child contexts used to decompress batched requests concurrently
+    uint32               laneCount = 0;
+    std::mutex           lock;                      // Guards lane creation and the start of the dispatch thread
+
+    int32          numaNode      = -1;              // NUMA node the context's threads and buffers are bound to, if any
+    uint32         numaCpuOffset = 0;               // Index of the first node CPU used by the context's threads
+
+    GRAsyncQueue   async;
+
+    GRProofTimings timings = {};    // Timings for the request currently being processed
+    GRStats        stats   = {};
+    std::mutex     statsLock;
+};
+
+// Pool of preallocated contexts shared by many plot readers
+struct GRContextPool
+{
+    GRContextPoolConfig              config;
+    std::vector<GreenReaperContext*> contexts;
+    std::vector<GreenReaperContext*> available;
+    std::mutex                       lock;
+    AutoResetSignal                  releasedSignal;
 };
 
 enum class ForwardPropResult
@@ -189,6 +254,31 @@ struct Table1BucketContext
 /// Internal functions
 static GRResult RequestSetup( GreenReaperContext* cx, const uint32 k, const uint32 compressionLevel );
 
+static GRResult FetchProof( GreenReaperContext* cx, GRCompressedProofRequest* req );
+static GRResult FetchQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req );
+static GRResult DecompressProof( GreenReaperContext* cx, GRCompressedProofRequest* req );
+static GRResult DecompressQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req );
+
+template<typename TRequest>
+static GRResult RunTimedRequest( GreenReaperContext* cx, TRequest* req, GRResult (*decompress)( GreenReaperContext*, TRequest* ) );
+
+inline void AddElapsedNS( uint64_t& accumulator, const TimePoint startTime )
+{
+    accumulator += (uint64_t)TicksToNanoSeconds( TimerEndTicks( startTime ) );
+}
+
+template<typename TRequest>
+static GRResult FetchBatch( GreenReaperContext* cx, TRequest* reqs, uint32 reqCount, GRResult* outResults,
+                            GRResult (*fetch)( GreenReaperContext*, TRequest* ) );
+
+static bool CreateBatchLanes( GreenReaperContext& cx );
+static bool IsAsyncBusy( GreenReaperContext& cx );
+
+static GRResult SubmitAsyncRequest( GreenReaperContext* cx, bool isProof, void* req, const uint8_t* plotId, uint32 compressionLevel,
+                                    GRRequestCallback callback, void* userData, GRTicket* outTicket );
+static void AsyncDispatchThread( GreenReaperContext* cx );
+static void RunAsyncBatch( GreenReaperContext& cx, const std::vector<GRAsyncRequest>& requests, bool cancel );
+
 static void SortQualityXs( const uint32 k, const byte plotId[BB_PLOT_ID_LEN], uint64* xs, const uint32 count );
 
 static GRResult ProcessTable1Bucket( Table1BucketContext& tcx, const uint64 x1, const uint64 x2, const uint32 groupIndex );
@@ -197,7 +287,14 @@ static GRResult ProcessTable1BucketCPU( Table1BucketContext& tcx, const uint64 x
 static void FreeBucketBuffers( GreenReaperContext& cx );
 static bool ReserveBucketBuffers( GreenReaperContext& cx, uint32 k, uint32 compressionLevel );
 
+static void BindContextToNumaNode( GreenReaperContext& cx, uint32 node, uint32 cpuOffset );
+static void AssignBucketBuffersToNumaNode( GreenReaperContext& cx );
+
 static void GenerateF1( GreenReaperContext& cx, const byte plotId[32], const uint64 bucketEntryCount, const uint32 x0, const uint32 x1 );
+static void GenerateF1Buckets( GreenReaperContext& cx, const byte plotId[32], const uint64 bucketEntryCount, const uint32 x0, const uint32 x1, uint32* xBuffer, uint64* yBuffer );
+
+static bool FetchQualitiesXPairLowCompression( GreenReaperContext& cx, GRCompressedQualitiesRequest& req, const uint32 xGroups[4], const uint64 entriesPerBucket );
+static void SelectQualityXPair( GRCompressedQualitiesRequest& req, uint64 qualityXs[4] );
 static Span<Pair> Match( GreenReaperContext& cx, const Span<uint64> yEntries, Span<Pair> outPairs, const uint32 pairOffset  );
 
 template<TableId rTable>
@@ -240,6 +337,19 @@ GRResult grPopulateApi( GRApi* api, const size_t apiStructSize, const int apiVer
     api->GetMemoryUsage                 = &grGetMemoryUsage;
     api->HasGpuDecompressor             = &grHasGpuDecompressor;
     api->GetCompressionInfo             = &grGetCompressionInfo;
+    api->FetchProofsBatch               = &grFetchProofsBatch;
+    api->FetchQualitiesBatch            = &grFetchQualitiesBatch;
+    api->SubmitProofRequest             = &grSubmitProofRequest;
+    api->SubmitQualitiesRequest         = &grSubmitQualitiesRequest;
+    api->Poll                           = &grPoll;
+    api->Wait                           = &grWait;
+    api->GetStats                       = &grGetStats;
+    api->ResetStats                     = &grResetStats;
+    api->CreateContextPool              = &grCreateContextPool;
+    api->DestroyContextPool             = &grDestroyContextPool;
+    api->AcquireContext                 = &grAcquireContext;
+    api->ReleaseContext                 = &grReleaseContext;
+    api->GetContextPoolSize             = &grGetContextPoolSize;
 
     return GRResult_OK;
 }
@@ -297,8 +407,22 @@ void grDestroyContext( GreenReaperContext* context )
     if( context == nullptr )
         return;
 
+    // Stop the dispatch thread. Requests still pending are cancelled.
+    if( context->async.thread )
+    {
+        context->async.exitSignal = true;
+        context->async.requestSignal.Signal();
+        context->async.thread->WaitForExit();
+        delete context->async.thread;
+    }
+
     FreeBucketBuffers( *context );
 
+    for( uint32 i = 0; i < context->laneCount; i++ )
+        grDestroyContext( context->lanes[i] );
+    
+    delete[] context->lanes;
+
     if( context->pool )
         delete context->pool;
 
@@ -314,10 +438,23 @@ GRResult grPreallocateForCompressionLevel( GreenReaperContext* context, const ui
     if( k != 32 )
         return GRResult_Failed;
 
+    if( IsAsyncBusy( *context ) )
+        return GRResult_Failed;
+
     // Ensure our buffers have enough for the specified entry bit count
     if( !ReserveBucketBuffers( *context, k, maxCompressionLevel ) )
         return GRResult_OutOfMemory;
 
+    // Batch lanes own their buffers as well, so reserve them now rather than on the first batch
+    if( context->config.batchLaneCount > 1 && context->cudaThresher == nullptr && CreateBatchLanes( *context ) )
+    {
+        for( uint32 i = 0; i < context->laneCount; i++ )
+        {
+            if( !ReserveBucketBuffers( *context->lanes[i], k, maxCompressionLevel ) )
+                return GRResult_OutOfMemory;
+        }
+    }
+
     return GRResult_OK;
 }
 
@@ -327,7 +464,72 @@ size_t grGetMemoryUsage( GreenReaperContext* context )
     if( !context )
         return 0;
 
-    return context->allocationSize;
+    size_t size = context->allocationSize;
+
+    std::lock_guard<std::mutex> lock( context->lock );
+    for( uint32 i = 0; i < context->laneCount; i++ )
+        size += context->lanes[i]->allocationSize;
+
+    return size;
+}
+
+//-----------------------------------------------------------
+static void AddTimings( GRProofTimings& dst, const GRProofTimings& src )
+{
+    dst.totalElapsedNS     += src.totalElapsedNS;
+    dst.f1ElapsedNS        += src.f1ElapsedNS;
+    dst.sortElapsedNS      += src.sortElapsedNS;
+    dst.matchElapsedNS     += src.matchElapsedNS;
+    dst.fxElapsedNS        += src.fxElapsedNS;
+    dst.backtraceElapsedNS += src.backtraceElapsedNS;
+}
+
+//-----------------------------------------------------------
+GRResult grGetStats( GreenReaperContext* context, GRStats* outStats, const size_t statsStructSize )
+{
+    if( statsStructSize != sizeof( GRStats ) )
+        return GRResult_WrongVersion;
+
+    if( context == nullptr || outStats == nullptr )
+        return GRResult_InvalidArg;
+
+    GRStats stats = {};
+
+    // Requests processed by batch lanes are accounted in the lanes themselves
+    std::lock_guard<std::mutex> lanesLock( context->lock );
+
+    for( uint32 i = 0; i <= context->laneCount; i++ )
+    {
+        GreenReaperContext& cx = i < context->laneCount ? *context->lanes[i] : *context;
+
+        std::lock_guard<std::mutex> lock( cx.statsLock );
+        stats.proofRequests     += cx.stats.proofRequests;
+        stats.proofsFound       += cx.stats.proofsFound;
+        stats.qualitiesRequests += cx.stats.qualitiesRequests;
+        stats.qualitiesFound    += cx.stats.qualitiesFound;
+        AddTimings( stats.proofTimings    , cx.stats.proofTimings     );
+        AddTimings( stats.qualitiesTimings, cx.stats.qualitiesTimings );
+    }
+
+    *outStats = stats;
+    return GRResult_OK;
+}
+
+//-----------------------------------------------------------
+void grResetStats( GreenReaperContext* context )
+{
+    if( context == nullptr )
+        return;
+
+    std::lock_guard<std::mutex> lanesLock( context->lock );
+
+    for( uint32 i = 0; i <= context->laneCount; i++ )
+    {
+        GreenReaperContext& cx = i < context->laneCount ? *context->lanes[i] : *context;
+
+        std::lock_guard<std::mutex> lock( cx.statsLock );
+        cx.stats = {};
+    }
 }
 
 //-----------------------------------------------------------
@@ -360,10 +562,139 @@ GRResult grGetCompressionInfo( GRCompressionInfo* outInfo, const size_t infoStru
     return GRResult_OK;
 }
 
+//-----------------------------------------------------------
+GRResult grCreateContextPool( GRContextPool** outPool, GRContextPoolConfig* config, const size_t configStructSize )
+{
+    if( outPool == nullptr || config == nullptr )
+        return GRResult_InvalidArg;
+
+    if( configStructSize != sizeof( GRContextPoolConfig ) || config->apiVersion != GR_API_VERSION )
+        return GRResult_WrongVersion;
+
+    if( config->contextCount < 1 || config->contextConfig.threadCount < 1 )
+        return GRResult_InvalidArg;
+
+    // Only pin when there's more than one node to choose from
+    const NumaInfo* numa = config->numaPinning ? SysHost::GetNUMAInfo() : nullptr;
+    if( numa && numa->nodeCount < 2 )
+        numa = nullptr;
+
+    auto* pool = new GRContextPool{};
+    pool->config = *config;
+    pool->contexts.reserve( config->contextCount );
+
+    const uint32 threadCount = config->contextConfig.threadCount;
+
+    for( uint32 i = 0; i < config->contextCount; i++ )
+    {
+        GreenReaperConfig cfg = config->contextConfig;
+        cfg.apiVersion = GR_API_VERSION;
+
+        if( !numa )
+            cfg.cpuOffset = config->contextConfig.cpuOffset + i * threadCount;
+
+        GreenReaperContext* cx = nullptr;
+        GRResult r = grCreateContext( &cx, &cfg, sizeof( cfg ) );
+
+        // Bind before preallocating so that the buffers are placed in the context's node
+        if( r == GRResult_OK && numa )
+        {
+            const uint32 node = i % numa->nodeCount;
+            BindContextToNumaNode( *cx, node, ( i / numa->nodeCount ) * threadCount );
+        }
+
+        if( r == GRResult_OK && config->maxCompressionLevel > 0 )
+            r = grPreallocateForCompressionLevel( cx, config->k, config->maxCompressionLevel );
+
+        if( r != GRResult_OK )
+        {
+            grDestroyContext( cx );
+            grDestroyContextPool( pool );
+            return r;
+        }
+
+        pool->contexts.push_back( cx );
+    }
+
+    pool->available = pool->contexts;
+
+    *outPool = pool;
+    return GRResult_OK;
+}
+
+//-----------------------------------------------------------
+void grDestroyContextPool( GRContextPool* pool )
+{
+    if( pool == nullptr )
+        return;
+
+    ASSERT( pool->available.size() == pool->contexts.size() );
+
+    for( GreenReaperContext* cx : pool->contexts )
+        grDestroyContext( cx );
+
+    delete pool;
+}
+
+//-----------------------------------------------------------
+GreenReaperContext* grAcquireContext( GRContextPool* pool, const GRBool wait )
+{
+    if( pool == nullptr )
+        return nullptr;
+
+    for( ;; )
+    {
+        {
+            std::lock_guard<std::mutex> lock( pool->lock );
+
+            if( !pool->available.empty() )
+            {
+                GreenReaperContext* cx = pool->available.back();
+                pool->available.pop_back();
+
+                // Releases may have coalesced into a single signal, so pass it on to the next waiter
+                if( !pool->available.empty() )
+                    pool->releasedSignal.Signal();
+
+                return cx;
+            }
+        }
+
+        if( !wait )
+            return nullptr;
+
+        pool->releasedSignal.Wait();
+    }
+}
+
+//-----------------------------------------------------------
+void grReleaseContext( GRContextPool* pool, GreenReaperContext* context )
+{
+    if( pool == nullptr || context == nullptr )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( pool->lock );
+
+        ASSERT( std::find( pool->contexts.begin(), pool->contexts.end(), context ) != pool->contexts.end() );
+        ASSERT( std::find( pool->available.begin(), pool->available.end(), context ) == pool->available.end() );
+
+        pool->available.push_back( context );
+    }
+
+    pool->releasedSignal.Signal();
+}
+
+//-----------------------------------------------------------
+uint32_t grGetContextPoolSize( GRContextPool* pool )
+{
+    return pool ? (uint32_t)pool->contexts.size() : 0;
+}
+
 //-----------------------------------------------------------
 GRResult grFetchProofForChallenge( GreenReaperContext* cx, GRCompressedProofRequest* req )
 {
-    if( !req || !req->plotId )
+    if( !req || !req->plotId || ( cx && IsAsyncBusy( *cx ) ) )
         return GRResult_Failed;
 
     const uint32 k = 32;
@@ -373,6 +704,166 @@ GRResult grFetchProofForChallenge( GreenReaperContext* cx, GRCompressedProofRequ
             return r;
     }
 
+    return FetchProof( cx, req );
+}
+
+//-----------------------------------------------------------
+GRResult grGetFetchQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req )
+{
+    if( !req || !req->plotId || ( cx && IsAsyncBusy( *cx ) ) )
+        return GRResult_Failed;
+
+    const uint32 k = 32;
+    {
+        auto r = RequestSetup( cx, k, req->compressionLevel );
+        if( r != GRResult_OK )
+            return r;
+    }
+
+    return FetchQualitiesXPair( cx, req );
+}
+
+//-----------------------------------------------------------
+GRResult grFetchProofsBatch( GreenReaperContext* cx, GRCompressedProofRequest* reqs, const uint32_t reqCount, GRResult* outResults )
+{
+    if( cx && IsAsyncBusy( *cx ) )
+        return GRResult_Failed;
+
+    return FetchBatch( cx, reqs, reqCount, outResults, &FetchProof );
+}
+
+//-----------------------------------------------------------
+GRResult grFetchQualitiesBatch( GreenReaperContext* cx, GRCompressedQualitiesRequest* reqs, const uint32_t reqCount, GRResult* outResults )
+{
+    if( cx && IsAsyncBusy( *cx ) )
+        return GRResult_Failed;
+
+    return FetchBatch( cx, reqs, reqCount, outResults, &FetchQualitiesXPair );
+}
+
+//-----------------------------------------------------------
+GRResult grSubmitProofRequest( GreenReaperContext* cx, GRCompressedProofRequest* req, 
+                               GRRequestCallback callback, void* userData, GRTicket* outTicket )
+{
+    if( !req )
+        return GRResult_InvalidArg;
+
+    return SubmitAsyncRequest( cx, true, req, req->plotId, req->compressionLevel, callback, userData, outTicket );
+}
+
+//-----------------------------------------------------------
+GRResult grSubmitQualitiesRequest( GreenReaperContext* cx, GRCompressedQualitiesRequest* req, 
+                                   GRRequestCallback callback, void* userData, GRTicket* outTicket )
+{
+    if( !req )
+        return GRResult_InvalidArg;
+
+    return SubmitAsyncRequest( cx, false, req, req->plotId, req->compressionLevel, callback, userData, outTicket );
+}
+
+//-----------------------------------------------------------
+GRBool grPoll( GreenReaperContext* cx, const GRTicket ticket, GRResult* outResult )
+{
+    if( cx == nullptr || outResult == nullptr )
+        return GR_FALSE;
+
+    GRAsyncQueue& q = cx->async;
+    std::lock_guard<std::mutex> lock( q.lock );
+
+    if( ticket == GR_INVALID_TICKET || ticket >= q.nextTicket )
+    {
+        *outResult = GRResult_InvalidArg;
+        return GR_TRUE;
+    }
+
+    if( ticket > q.lastCompleted )
+        return GR_FALSE;
+
+    for( size_t i = 0; i < q.completed.size(); i++ )
+    {
+        if( q.completed[i].ticket == ticket )
+        {
+            *outResult = q.completed[i].result;
+
+            q.completed[i] = q.completed.back();
+            q.completed.pop_back();
+            q.outstanding--;
+            return GR_TRUE;
+        }
+    }
+
+    // Already released, or completed through a callback
+    *outResult = GRResult_InvalidArg;
+    return GR_TRUE;
+}
+
+//-----------------------------------------------------------
+GRResult grWait( GreenReaperContext* cx, const GRTicket ticket )
+{
+    if( cx == nullptr )
+        return GRResult_InvalidArg;
+
+    GRResult result;
+    while( !grPoll( cx, ticket, &result ) )
+        cx->async.completedSignal.Wait();
+
+    return result;
+}
+
+
+///
+/// Private Funcs
+///
+//-----------------------------------------------------------
+GRResult FetchProof( GreenReaperContext* cx, GRCompressedProofRequest* req )
+{
+    return RunTimedRequest( cx, req, &DecompressProof );
+}
+
+//-----------------------------------------------------------
+GRResult FetchQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req )
+{
+    return RunTimedRequest( cx, req, &DecompressQualitiesXPair );
+}
+
+//-----------------------------------------------------------
+template<typename TRequest>
+GRResult RunTimedRequest( GreenReaperContext* cx, TRequest* req, GRResult (*decompress)( GreenReaperContext*, TRequest* ) )
+{
+    constexpr bool isProof = std::is_same_v<TRequest, GRCompressedProofRequest>;
+
+    cx->timings = {};
+
+    const auto timer = TimerBegin();
+    const GRResult r = decompress( cx, req );
+    AddElapsedNS( cx->timings.totalElapsedNS, timer );
+
+    if( req->outTimings )
+        *req->outTimings = cx->timings;
+
+    std::lock_guard<std::mutex> lock( cx->statsLock );
+
+    if constexpr( isProof )
+    {
+        cx->stats.proofRequests++;
+        cx->stats.proofsFound += r == GRResult_OK ? 1 : 0;
+        AddTimings( cx->stats.proofTimings, cx->timings );
+    }
+    else
+    {
+        cx->stats.qualitiesRequests++;
+        cx->stats.qualitiesFound += r == GRResult_OK ? 1 : 0;
+        AddTimings( cx->stats.qualitiesTimings, cx->timings );
+    }
+
+    return r;
+}
+
+//-----------------------------------------------------------
+GRResult DecompressProof( GreenReaperContext* cx, GRCompressedProofRequest* req )
+{
+    const uint32 k = 32;
+
     const uint32 numGroups        = GR_POST_PROOF_CMP_X_COUNT;
     const uint64 entriesPerBucket = GetEntriesPerBucketForCompressionLevel( k, req->compressionLevel );
     ASSERT( entriesPerBucket <= 0xFFFFFFFF );
@@ -385,12 +876,22 @@ GRResult grFetchProofForChallenge( GreenReaperContext* cx, GRCompressedProofRequ
     uint32 xGroups[GR_POST_PROOF_X_COUNT] = {};
 
     // Unpack x groups first
+    // The x groups are 32-bit line points, which are converted together
+    uint64  xLinePoints[GR_POST_PROOF_CMP_X_COUNT];
+    BackPtr xSquares   [GR_POST_PROOF_CMP_X_COUNT];
+
+    const uint32 numXLinePoints = req->compressionLevel < 9 ? numGroups : numGroups / 2;
+
+    for( uint32 i = 0; i < numXLinePoints; i++ )
+        xLinePoints[i] = (uint32)req->compressedProof[i];
+
+    LinePointsToSquares( xLinePoints, numXLinePoints, xSquares );
+
     if( req->compressionLevel < 9 )
     {
         for( uint32 i = 0, j = 0; i < numGroups; i++, j+=2 )
         {
-            const uint32  xLinePoint = (uint32)req->compressedProof[i];
-            const BackPtr xs         = LinePointToSquare64( xLinePoint );
+            const BackPtr xs = xSquares[i];
 
             proofMightBeDropped = proofMightBeDropped || (xs.x == 0 || xs.y == 0);
 
@@ -402,8 +903,7 @@ GRResult grFetchProofForChallenge( GreenReaperContext* cx, GRCompressedProofRequ
     {
         for( uint32 i = 0, j = 0; i < numGroups / 2; i++, j+=4 )
         {
-            const uint32  xLinePoint = (uint32)req->compressedProof[i];
-            const BackPtr xs         = LinePointToSquare64( xLinePoint );
+            const BackPtr xs = xSquares[i];
 
             const uint32 entrybits = GetCompressionInfoForLevel( req->compressionLevel ).entrySizeBits;
             const uint32 mask      = (1u << entrybits) - 1;
@@ -473,17 +973,9 @@ GRResult grFetchProofForChallenge( GreenReaperContext* cx, GRCompressedProofRequ
 }
 
 //-----------------------------------------------------------
-GRResult grGetFetchQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req )
+GRResult DecompressQualitiesXPair( GreenReaperContext* cx, GRCompressedQualitiesRequest* req )
 {
-    if( !req || !req->plotId )
-        return GRResult_Failed;
-
     const uint32 k = 32;
-    {
-        auto r = RequestSetup( cx, k, req->compressionLevel );
-        if( r != GRResult_OK )
-            return r;
-    }
 
     if( cx->cudaThresher ) cx->cudaThresher->ClearTimings();
 
@@ -575,136 +1067,656 @@ GRResult grGetFetchQualitiesXPair( GreenReaperContext* cx, GRCompressedQualities
         }
     }
 
-    for( uint32 i = 0; i < numXGroups; i++ )
+    // At low compression levels the x groups are small enough that matching them
+    // directly is cheaper than sorting them and forward-propagating the tables.
+    if( numXGroups == 2 && !proofMightBeDropped && cx->cudaThresher == nullptr &&
+        req->compressionLevel <= GR_QUALITIES_FAST_PATH_MAX_LEVEL )
+    {
+    #if BB_TEST_MODE
+        if( !grTestDisableQualitiesFastPath )
+    #endif
+        if( FetchQualitiesXPairLowCompression( *cx, *req, xGroups, entriesPerBucket ) )
+        {
+        #if BB_TEST_MODE
+            grTestQualitiesFastPathHits++;
+        #endif
+            return GRResult_OK;
+        }
+    }
+
+    for( uint32 i = 0; i < numXGroups; i++ )
+    {
+        // Gen sorted f1
+        const uint32 xIdx = i*2;
+        const uint64 x1   = xGroups[xIdx+0];
+        const uint64 x2   = xGroups[xIdx+1];
+
+        const uint32 groupIndex = i / 2;
+        if( (i & 1) == 0 )
+            cx->tables[1].BeginGroup( groupIndex );
+
+        const auto r = ProcessTable1Bucket( tcx, x1, x2, groupIndex );
+
+        if( r != GRResult_OK )
+            return proofMightBeDropped ? GRResult_NoProof : GRResult_Failed;
+    }
+
+    if( cx->tables[1]._length == 1 )
+    {
+        // #TODO: Add this path, but this should never happen
+        Log::Line( "[GR_WARNING] Unexpected qualities match on first 2nd table." );
+        return GRResult_Failed;
+    }
+
+    // Continue forward propagation to the next table
+    cx->proofContext.leftLength  = (uint32)cx->tables[1]._length;
+
+    uint64 fullProof[GR_POST_PROOF_X_COUNT] = {};
+
+    cx->proofContext.yLeft     = cx->yBuffer.Ptr();
+    cx->proofContext.metaLeft  = cx->metaBuffer.Ptr();
+    cx->proofContext.yRight    = cx->yBufferTmp.Ptr();
+    cx->proofContext.metaRight = cx->metaBufferTmp.Ptr();
+    cx->proofContext.proof     = fullProof;
+
+    SortTableAndFlipBuffers<TableId::Table2>( *cx, numXGroups / 2 );
+
+
+    TableId matchTable = TableId::Table3;
+
+    auto fpResult = ForwardPropTable<TableId::Table3>( *cx, numXGroups /= 2, true );
+
+    if( fpResult == ForwardPropResult::Continue )
+    {
+        matchTable = TableId::Table4;
+        fpResult = ForwardPropTable<TableId::Table4>( *cx, numXGroups /= 2, true );
+    }
+    if( fpResult == ForwardPropResult::Continue )
+    {
+        matchTable = TableId::Table5;
+        fpResult = ForwardPropTable<TableId::Table5>( *cx, numXGroups /= 2, true );
+    }
+    if( fpResult == ForwardPropResult::Continue )
+    {
+        matchTable = TableId::Table6;
+        fpResult = ForwardPropTable<TableId::Table6>( *cx, numXGroups /= 2, true );
+    }
+
+    if( fpResult != ForwardPropResult::Success )
+        return proofMightBeDropped ? GRResult_NoProof : GRResult_Failed;
+
+    const auto backtraceTimer = TimerBegin();
+
+    // If we have more than 1 group, we need to only trace back to
+    // the ones that belong to the first group
+    uint64 qualityXs[8] = {};
+
+    {
+        Pair  pairs[2][4] = {};
+        Pair* pairsIn  = pairs[0];
+        Pair* pairsOut = pairs[1];
+
+        if( cx->cudaThresher )
+            bbmemcpy_t( cx->tables[(int)matchTable]._pairs, cx->pairs.Ptr(), cx->tables[(int)matchTable]._length );
+
+        bbmemcpy_t( pairs[0], cx->tables[(int)matchTable]._pairs, cx->tables[(int)matchTable]._length );
+
+        for( TableId rTable = matchTable; rTable > TableId::Table3; rTable-- )
+        {
+            auto& inTable  = cx->tables[(int)rTable];
+            auto& outTable = cx->tables[(int)rTable-1];
+
+            for( uint32 i = 0; i < inTable._length; i++ )
+            {
+                const auto pair = inTable._pairs[i];
+
+                pairsOut[i*2+0] = outTable._pairs[pair.left ];
+                pairsOut[i*2+1] = outTable._pairs[pair.right];
+            }
+
+            std::swap( pairsOut, pairsIn );
+        }
+
+        // From table 3, only take the pair that points to the first group
+        const Pair t3Pair = pairsIn[0].left < cx->tables[1]._groups[0].count ?
+                            pairsIn[0] : pairsIn[1];
+
+        // Grab the x's from the first group only
+        const Pair xPair0 = cx->tables[1]._pairs[t3Pair.left ];
+        const Pair xPair1 = cx->tables[1]._pairs[t3Pair.right];
+
+        qualityXs[0] = xPair0.left;
+        qualityXs[1] = xPair0.right;
+        qualityXs[2] = xPair1.left;
+        qualityXs[3] = xPair1.right;
+    }
+
+    AddElapsedNS( cx->timings.backtraceElapsedNS, backtraceTimer );
+
+    SelectQualityXPair( *req, qualityXs );
+    return GRResult_OK;
+}
+
+//-----------------------------------------------------------
+void SelectQualityXPair( GRCompressedQualitiesRequest& req, uint64 qualityXs[4] )
+{
+    const uint32 k = 32;
+
+    // We need to now sort the X's on y, in order to chose the right path
+    SortQualityXs( k, req.plotId, qualityXs, 4 );
+
+    // Follow the last path, based on the challenge in our x's
+    const uint32 last5Bits      = (uint32)req.challenge[31] & 0x1f;
+    const bool   isTable1BitSet = (last5Bits & 1) == 1;
+
+    if( !isTable1BitSet )
+    {
+        req.x1 = qualityXs[0];
+        req.x2 = qualityXs[1];
+    }
+    else
+    {
+        req.x1 = qualityXs[2];
+        req.x2 = qualityXs[3];
+    }
+}
+
+///
+/// Low compression qualities
+///
+// Chained hash index of entries on their BC group.
+// Lets us match small, unsorted sets of entries without sorting them first.
+struct BCGroupIndex
+{
+    static constexpr uint32 NONE = 0xFFFFFFFF;
+
+    const uint64* y;
+    uint32*       heads;
+    uint32*       next;
+    uint32        headMask;
+
+    inline static uint32 Hash( const uint64 group )
+    {
+        return (uint32)( ( group * 0x9E3779B97F4A7C15ull ) >> 32 );
+    }
+
+    inline void Build( const uint64* entries, const uint32 count, uint32* headBuffer, const uint32 headCount, uint32* nextBuffer )
+    {
+        ASSERT( headCount && ( headCount & ( headCount - 1 ) ) == 0 );
+
+        y        = entries;
+        heads    = headBuffer;
+        next     = nextBuffer;
+        headMask = headCount - 1;
+
+        memset( heads, 0xFF, sizeof( uint32 ) * headCount );
+
+        for( uint32 i = 0; i < count; i++ )
+        {
+            const uint32 slot = Hash( entries[i] / kBC ) & headMask;
+
+            next[i]     = heads[slot];
+            heads[slot] = i;
+        }
+    }
+
+    template<typename TFunc>
+    inline void ForEachInGroup( const uint64 group, TFunc func ) const
+    {
+        for( uint32 i = heads[Hash( group ) & headMask]; i != NONE; i = next[i] )
+        {
+            if( y[i] / kBC == group )
+                func( i );
+        }
+    }
+};
+
+// Same test as the L_targets lookup, for a single pair of entries.
+//-----------------------------------------------------------
+inline bool IsBCMatch( const uint64 yL, const uint64 yR )
+{
+    const uint64 groupL = yL / kBC;
+    if( yR / kBC != groupL + 1 )
+        return false;
+
+    const uint32 parity = (uint32)( groupL & 1 );
+    const uint32 localL = (uint32)( yL - groupL * kBC );
+    const uint32 localR = (uint32)( yR - ( groupL + 1 ) * kBC );
+
+    const uint32 m = (uint32)( ( localR / kC + kB - localL / kC ) % kB );
+    if( m >= kExtraBitsPow )
+        return false;
+
+    const uint32 t = 2 * m + parity;
+    return localR % kC == ( localL % kC + t * t ) % kC;
+}
+
+//-----------------------------------------------------------
+bool FetchQualitiesXPairLowCompression( GreenReaperContext& cx, GRCompressedQualitiesRequest& req, const uint32 xGroups[4], const uint64 entriesPerBucket )
+{
+    // Both x groups (x1/x2 and x3/x4) are generated unsorted, then matched through a hash index
+    // into their table 2 entries. The table 3 match is the only one needed to get the quality x's,
+    // and it must pair an entry from each x group. We don't forward-propagate any further.
+    // Returns false when a single table 3 match can't be found, in which case the caller
+    // falls back to the full decompression path.
+    const uint32 entryCount = (uint32)entriesPerBucket * 2;
+    ASSERT( cx.groupsBoundaries.Length() >= entryCount );
+    ASSERT( cx.xBuffer.Length() >= entryCount );
+
+    uint32* heads = cx.groupsBoundaries.Ptr();
+    uint32* next  = cx.xBuffer.Ptr();
+    uint32* xs    = cx.xBufferTmp.Ptr();
+    uint64* ys    = cx.yBufferF1.Ptr();
+
+    Span<Pair>     pairs  = cx.pairs;
+    Span<uint64>   t2Y    = cx.yBufferTmp;
+    Span<K32Meta2> t2Meta = cx.metaBufferTmp.template As<K32Meta2>();
+    uint32         t2Counts[2];
+
+    BCGroupIndex index;
+
+    for( uint32 g = 0; g < 2; g++ )
+    {
+        GenerateF1Buckets( cx, req.plotId, entriesPerBucket, xGroups[g*2], xGroups[g*2+1], xs, ys );
+
+        const auto matchTimer = TimerBegin();
+
+        index.Build( ys, entryCount, heads, entryCount, next );
+
+        uint64 matchCount = 0;
+        bool   overflow   = false;
+
+        for( uint32 iR = 0; iR < entryCount && !overflow; iR++ )
+        {
+            const uint64 yR     = ys[iR];
+            const uint64 groupR = yR / kBC;
+
+            if( groupR == 0 )
+                continue;
+
+            index.ForEachInGroup( groupR - 1, [&]( const uint32 iL ) {
+
+                if( !IsBCMatch( ys[iL], yR ) )
+                    return;
+
+                if( matchCount >= pairs.Length() )
+                {
+                    overflow = true;
+                    return;
+                }
+
+                Pair& pair = pairs[matchCount++];
+                pair.left  = iL;
+                pair.right = iR;
+            });
+        }
+
+        AddElapsedNS( cx.timings.matchElapsedNS, matchTimer );
+
+        if( overflow || matchCount == 0 || matchCount > t2Y.Length() )
+            return false;
+
+        GenerateFxForPairs<TableId::Table2>( cx, pairs.SliceSize( matchCount ),
+            MakeSpan( ys, entryCount ), MakeSpan( xs, entryCount ), t2Y, t2Meta );
+
+        t2Counts[g] = (uint32)matchCount;
+        t2Y         = t2Y   .Slice( matchCount );
+        t2Meta      = t2Meta.Slice( matchCount );
+    }
+
+    // Match table 2 entries from the first x group against the ones from the second group
+    const auto matchTimer = TimerBegin();
+
+    const uint64*   yA    = cx.yBufferTmp.Ptr();
+    const uint64*   yB    = yA + t2Counts[0];
+    const K32Meta2* metaA = cx.metaBufferTmp.template As<K32Meta2>().Ptr();
+    const K32Meta2* metaB = metaA + t2Counts[0];
+
+    uint32 headCount = 1;
+    while( headCount < t2Counts[0] * 2 && headCount < entryCount )
+        headCount <<= 1;
+
+    index.Build( yA, t2Counts[0], heads, headCount, next );
+
+    uint32 matchCount = 0;
+    uint32 matchA     = 0;
+    uint32 matchB     = 0;
+
+    for( uint32 iB = 0; iB < t2Counts[1] && matchCount < 2; iB++ )
+    {
+        const uint64 y     = yB[iB];
+        const uint64 group = y / kBC;
+
+        auto onMatch = [&]( const uint32 iA ) {
+            matchCount++;
+            matchA = iA;
+            matchB = iB;
+        };
+
+        if( group > 0 )
+            index.ForEachInGroup( group - 1, [&]( const uint32 iA ) {
+                if( IsBCMatch( yA[iA], y ) ) onMatch( iA );
+            });
+
+        index.ForEachInGroup( group + 1, [&]( const uint32 iA ) {
+            if( IsBCMatch( y, yA[iA] ) ) onMatch( iA );
+        });
+    }
+
+    AddElapsedNS( cx.timings.matchElapsedNS, matchTimer );
+
+    // No match or an ambiguous one
+    if( matchCount != 1 )
+        return false;
+
+    // Table 2 metadata holds the x pair that generated each entry
+    const K32Meta2 xPairA = metaA[matchA];
+    const K32Meta2 xPairB = metaB[matchB];
+
+    uint64 qualityXs[4] = {
+        xPairA >> 32, xPairA & 0xFFFFFFFF,
+        xPairB >> 32, xPairB & 0xFFFFFFFF
+    };
+
+    SelectQualityXPair( req, qualityXs );
+    return true;
+}
+
+//-----------------------------------------------------------
+template<typename TRequest>
+GRResult FetchBatch( GreenReaperContext* cx, TRequest* reqs, const uint32 reqCount, GRResult* outResults,
+                     GRResult (*fetch)( GreenReaperContext*, TRequest* ) )
+{
+    if( cx == nullptr || reqs == nullptr || outResults == nullptr )
+        return GRResult_InvalidArg;
+
+    const uint32 k = 32;
+
+    // Validate all requests up front and reserve once for the highest compression level in the batch
+    uint32 maxCompressionLevel = 0;
+
+    for( uint32 i = 0; i < reqCount; i++ )
     {
-        // Gen sorted f1
-        const uint32 xIdx = i*2;
-        const uint64 x1   = xGroups[xIdx+0];
-        const uint64 x2   = xGroups[xIdx+1];
-
-        const uint32 groupIndex = i / 2;
-        if( (i & 1) == 0 )
-            cx->tables[1].BeginGroup( groupIndex );
+        const TRequest& req = reqs[i];
 
-        const auto r = ProcessTable1Bucket( tcx, x1, x2, groupIndex );
+        if( !req.plotId || req.compressionLevel < 1 || req.compressionLevel > 9 )
+            return GRResult_InvalidArg;
 
-        if( r != GRResult_OK )
-            return proofMightBeDropped ? GRResult_NoProof : GRResult_Failed;
+        maxCompressionLevel = std::max( maxCompressionLevel, req.compressionLevel );
     }
 
-    if( cx->tables[1]._length == 1 )
+    if( reqCount == 0 )
+        return GRResult_OK;
+
+    const bool useLanes = reqCount > 1 && cx->cudaThresher == nullptr && CreateBatchLanes( *cx );
+
+    if( !useLanes )
     {
-        // #TODO: Add this path, but this should never happen
-        Log::Line( "[GR_WARNING] Unexpected qualities match on first 2nd table." );
-        return GRResult_Failed;
+        const GRResult r = RequestSetup( cx, k, maxCompressionLevel );
+        if( r != GRResult_OK )
+            return r;
+
+        for( uint32 i = 0; i < reqCount; i++ )
+            outResults[i] = fetch( cx, &reqs[i] );
+
+        return GRResult_OK;
     }
 
-    // Continue forward propagation to the next table
-    cx->proofContext.leftLength  = (uint32)cx->tables[1]._length;
+    // Each lane pulls the next pending request from the batch and decompresses
+    // it on its own thread subset and buffers, so that the small, poorly-parallel
+    // steps of one request overlap with the bucket work of another.
+    const uint32 laneCount = std::min( cx->laneCount, reqCount );
 
-    uint64 fullProof[GR_POST_PROOF_X_COUNT] = {};
+    std::atomic<uint32>   nextRequest = 0;
+    std::atomic<GRResult> setupResult = GRResult_OK;
 
-    cx->proofContext.yLeft     = cx->yBuffer.Ptr();
-    cx->proofContext.metaLeft  = cx->metaBuffer.Ptr();
-    cx->proofContext.yRight    = cx->yBufferTmp.Ptr();
-    cx->proofContext.metaRight = cx->metaBufferTmp.Ptr();
-    cx->proofContext.proof     = fullProof;
+    AnonMTJob::Run( *cx->pool, laneCount, [&]( AnonMTJob* self ) {
 
-    SortTableAndFlipBuffers<TableId::Table2>( *cx, numXGroups / 2 );
+        GreenReaperContext* lane = cx->lanes[self->JobId()];
+
+        const GRResult r = RequestSetup( lane, k, maxCompressionLevel );
+        if( r != GRResult_OK )
+            setupResult = r;
 
+        self->SyncThreads();
 
-    TableId matchTable = TableId::Table3;
+        if( setupResult != GRResult_OK )
+            return;
 
-    auto fpResult = ForwardPropTable<TableId::Table3>( *cx, numXGroups /= 2, true );
+        for( ;; )
+        {
+            const uint32 i = nextRequest.fetch_add( 1, std::memory_order_relaxed );
+            if( i >= reqCount )
+                break;
 
-    if( fpResult == ForwardPropResult::Continue )
+            outResults[i] = fetch( lane, &reqs[i] );
+        }
+    });
+
+    return setupResult;
+}
+
+//-----------------------------------------------------------
+GRResult SubmitAsyncRequest( GreenReaperContext* cx, const bool isProof, void* req, const uint8_t* plotId, const uint32 compressionLevel,
+                             GRRequestCallback callback, void* userData, GRTicket* outTicket )
+{
+    if( cx == nullptr || outTicket == nullptr || plotId == nullptr || compressionLevel < 1 || compressionLevel > 9 )
+        return GRResult_InvalidArg;
+
+    GRAsyncQueue& q = cx->async;
+
+    // Start the dispatch thread on first use
     {
-        matchTable = TableId::Table4;
-        fpResult = ForwardPropTable<TableId::Table4>( *cx, numXGroups /= 2, true );
+        std::lock_guard<std::mutex> lock( cx->lock );
+
+        if( q.thread == nullptr )
+        {
+            q.thread = new Thread( 4 MiB );
+            q.thread->Run( AsyncDispatchThread, cx );
+        }
     }
-    if( fpResult == ForwardPropResult::Continue )
+
+    GRAsyncRequest r;
+    r.isProof  = isProof;
+    r.req      = req;
+    r.callback = callback;
+    r.userData = userData;
+
+    // Bound the results kept for callers that never retrieve them
+    q.lock.lock();
+    if( q.outstanding >= GR_MAX_ASYNC_REQUESTS )
     {
-        matchTable = TableId::Table5;
-        fpResult = ForwardPropTable<TableId::Table5>( *cx, numXGroups /= 2, true );
+        q.lock.unlock();
+        return GRResult_OutOfMemory;
     }
-    if( fpResult == ForwardPropResult::Continue )
+
+    r.ticket = q.nextTicket++;
+    q.outstanding++;
+    q.pending.push( r );
+    q.lock.unlock();
+
+    *outTicket = r.ticket;
+
+    q.requestSignal.Signal();
+    return GRResult_OK;
+}
+
+//-----------------------------------------------------------
+void AsyncDispatchThread( GreenReaperContext* cx )
+{
+    GRAsyncQueue& q = cx->async;
+
+    std::vector<GRAsyncRequest> requests;
+
+    for( ;; )
     {
-        matchTable = TableId::Table6;
-        fpResult = ForwardPropTable<TableId::Table6>( *cx, numXGroups /= 2, true );
+        q.requestSignal.Wait();
+
+        // Drain everything that was queued so far as a single batch,
+        // so that all lanes of the context can be kept busy.
+        for( ;; )
+        {
+            requests.clear();
+
+            q.lock.lock();
+            while( !q.pending.empty() )
+            {
+                requests.push_back( q.pending.front() );
+                q.pending.pop();
+            }
+            q.lock.unlock();
+
+            if( requests.empty() )
+                break;
+
+            RunAsyncBatch( *cx, requests, q.exitSignal );
+        }
+
+        if( q.exitSignal )
+            break;
     }
+}
 
-    if( fpResult != ForwardPropResult::Success )
-        return proofMightBeDropped ? GRResult_NoProof : GRResult_Failed;
+//-----------------------------------------------------------
+void RunAsyncBatch( GreenReaperContext& cx, const std::vector<GRAsyncRequest>& requests, const bool cancel )
+{
+    GRAsyncQueue& q = cx.async;
 
-    // If we have more than 1 group, we need to only trace back to
-    // the ones that belong to the first group
-    uint64 qualityXs[8] = {};
+    std::vector<GRResult>                     results( requests.size(), GRResult_Failed );
+    std::vector<GRCompressedProofRequest>     proofReqs;
+    std::vector<GRCompressedQualitiesRequest> qualityReqs;
 
+    // Run each contiguous span of requests of the same kind as a batch
+    for( size_t start = 0; !cancel && start < requests.size(); )
     {
-        Pair  pairs[2][4] = {};
-        Pair* pairsIn  = pairs[0];
-        Pair* pairsOut = pairs[1];
+        const bool isProof = requests[start].isProof;
 
-        if( cx->cudaThresher )
-            bbmemcpy_t( cx->tables[(int)matchTable]._pairs, cx->pairs.Ptr(), cx->tables[(int)matchTable]._length );
+        size_t end = start + 1;
+        while( end < requests.size() && requests[end].isProof == isProof )
+            end++;
 
-        bbmemcpy_t( pairs[0], cx->tables[(int)matchTable]._pairs, cx->tables[(int)matchTable]._length );
+        const uint32 count = (uint32)(end - start);
+        GRResult r;
 
-        for( TableId rTable = matchTable; rTable > TableId::Table3; rTable-- )
+        if( isProof )
         {
-            auto& inTable  = cx->tables[(int)rTable];
-            auto& outTable = cx->tables[(int)rTable-1];
-
-            for( uint32 i = 0; i < inTable._length; i++ )
-            {
-                const auto pair = inTable._pairs[i];
+            proofReqs.resize( count );
+            for( uint32 i = 0; i < count; i++ )
+                proofReqs[i] = *(GRCompressedProofRequest*)requests[start+i].req;
 
-                pairsOut[i*2+0] = outTable._pairs[pair.left ];
-                pairsOut[i*2+1] = outTable._pairs[pair.right];
-            }
+            r = FetchBatch( &cx, proofReqs.data(), count, results.data() + start, &FetchProof );
 
-            std::swap( pairsOut, pairsIn );
+            for( uint32 i = 0; i < count; i++ )
+                *(GRCompressedProofRequest*)requests[start+i].req = proofReqs[i];
         }
+        else
+        {
+            qualityReqs.resize( count );
+            for( uint32 i = 0; i < count; i++ )
+                qualityReqs[i] = *(GRCompressedQualitiesRequest*)requests[start+i].req;
 
-        // From table 3, only take the pair that points to the first group
-        const Pair t3Pair = pairsIn[0].left < cx->tables[1]._groups[0].count ?
-                            pairsIn[0] : pairsIn[1];
+            r = FetchBatch( &cx, qualityReqs.data(), count, results.data() + start, &FetchQualitiesXPair );
 
-        // Grab the x's from the first group only
-        const Pair xPair0 = cx->tables[1]._pairs[t3Pair.left ];
-        const Pair xPair1 = cx->tables[1]._pairs[t3Pair.right];
+            for( uint32 i = 0; i < count; i++ )
+            {
+                auto* req = (GRCompressedQualitiesRequest*)requests[start+i].req;
+                req->x1 = qualityReqs[i].x1;
+                req->x2 = qualityReqs[i].x2;
+            }
+        }
 
-        qualityXs[0] = xPair0.left;
-        qualityXs[1] = xPair0.right;
-        qualityXs[2] = xPair1.left;
-        qualityXs[3] = xPair1.right;
+        if( r != GRResult_OK )
+            std::fill( results.begin() + (ptrdiff_t)start, results.begin() + (ptrdiff_t)end, r );
+
+        start = end;
     }
 
-    // We need to now sort the X's on y, in order to chose the right path
-    SortQualityXs( k, req->plotId, qualityXs, 4 );
+    // Publish results
+    q.lock.lock();
+    for( size_t i = 0; i < requests.size(); i++ )
+    {
+        if( requests[i].callback == nullptr )
+            q.completed.push_back( { requests[i].ticket, results[i] } );
+    }
+    q.lastCompleted = requests.back().ticket;
+    q.lock.unlock();
 
-    // Follow the last path, based on the challenge in our x's
-    const uint32 last5Bits      = (uint32)req->challenge[31] & 0x1f;
-    const bool   isTable1BitSet = (last5Bits & 1) == 1;
+    uint32 callbackCount = 0;
 
-    if( !isTable1BitSet )
+    for( size_t i = 0; i < requests.size(); i++ )
     {
-        req->x1 = qualityXs[0];
-        req->x2 = qualityXs[1];
+        if( requests[i].callback != nullptr )
+        {
+            requests[i].callback( &cx, requests[i].ticket, results[i], requests[i].userData );
+            callbackCount++;
+        }
     }
-    else
+
+    if( callbackCount )
     {
-        req->x1 = qualityXs[2];
-        req->x2 = qualityXs[3];
+        q.lock.lock();
+        q.outstanding -= callbackCount;
+        q.lock.unlock();
     }
 
-    return GRResult_OK;
+    q.completedSignal.Signal();
 }
 
+//-----------------------------------------------------------
+bool IsAsyncBusy( GreenReaperContext& cx )
+{
+    // The context's buffers belong to the dispatch thread until all submitted requests complete
+    GRAsyncQueue& q = cx.async;
+    std::lock_guard<std::mutex> lock( q.lock );
+
+    return q.lastCompleted + 1 < q.nextTicket;
+}
+
+//-----------------------------------------------------------
+bool CreateBatchLanes( GreenReaperContext& cx )
+{
+    std::lock_guard<std::mutex> lock( cx.lock );
+
+    if( cx.laneCount > 0 )
+        return true;
+
+    const uint32 threadCount = cx.pool->ThreadCount();
+    const uint32 laneCount   = std::min( cx.config.batchLaneCount, threadCount );
+
+    if( laneCount < 2 )
+        return false;
+
+    const uint32 threadsPerLane = threadCount / laneCount;
+
+    cx.lanes = new GreenReaperContext*[laneCount]{};
+
+    for( uint32 i = 0; i < laneCount; i++ )
+    {
+        GreenReaperConfig cfg = cx.config;
+        cfg.apiVersion     = GR_API_VERSION;
+        cfg.threadCount    = threadsPerLane + ( i == laneCount-1 ? threadCount - threadsPerLane * laneCount : 0 );
+        cfg.cpuOffset      = cx.config.cpuOffset + i * threadsPerLane;
+        cfg.gpuRequest     = GRGpuRequestKind_None;
+        cfg.batchLaneCount = 0;
+
+        if( grCreateContext( &cx.lanes[i], &cfg, sizeof( cfg ) ) != GRResult_OK )
+        {
+            for( uint32 j = 0; j < i; j++ )
+                grDestroyContext( cx.lanes[j] );
+
+            delete[] cx.lanes;
+            cx.lanes = nullptr;
+            return false;
+        }
+
+        if( cx.numaNode >= 0 )
+            BindContextToNumaNode( *cx.lanes[i], (uint32)cx.numaNode, cx.numaCpuOffset + i * threadsPerLane );
+    }
+
+    cx.laneCount = laneCount;
+    return true;
+}
 
-///
-/// Private Funcs
-///
 //-----------------------------------------------------------
 GRResult ProcessTable1Bucket( Table1BucketContext& tcx, const uint64 x1, const uint64 x2, const uint32 groupIndex )
 {
@@ -825,6 +1837,8 @@ GRResult ProcessTable1BucketCPU( Table1BucketContext& tcx, const uint64 x1, cons
 //-----------------------------------------------------------
 void BacktraceProof( GreenReaperContext& cx, const TableId tableStart, uint64 proof[GR_POST_PROOF_X_COUNT] )
 {
+    const auto timer = TimerBegin();
+
     Pair _backtrace[2][64] = {};
 
     Pair* backTraceIn  = _backtrace[0];
@@ -883,6 +1897,8 @@ void BacktraceProof( GreenReaperContext& cx, const TableId tableStart, uint64 pr
         proof[idx+1] = backTraceIn[i].right;
     }
 
+    AddElapsedNS( cx.timings.backtraceElapsedNS, timer );
+
 // #if _DEBUG
 //     Log::Line( "" );
 //     Log::Line( "Recovered Proof:" );
@@ -986,6 +2002,9 @@ bool ReserveBucketBuffers( GreenReaperContext& cx, const uint32 k, const uint32
 
         cx.maxEntriesPerBucket         = entriesPerBucket;
         cx.maxCompressionLevelReserved = compressionLevel;
+
+        if( cx.numaNode >= 0 )
+            AssignBucketBuffersToNumaNode( cx );
     }
 
     if( cx.cudaThresher != nullptr )
@@ -1003,6 +2022,61 @@ bool ReserveBucketBuffers( GreenReaperContext& cx, const uint32 k, const uint32
     return true;
 }
 
+//-----------------------------------------------------------
+void BindContextToNumaNode( GreenReaperContext& cx, const uint32 node, const uint32 cpuOffset )
+{
+    const NumaInfo* numa = SysHost::GetNUMAInfo();
+    ASSERT( numa && node < numa->nodeCount );
+
+    cx.numaNode      = (int32)node;
+    cx.numaCpuOffset = cpuOffset;
+
+    // Re-pin the pool's threads onto the node's CPUs, as they are not necessarily contiguous
+    if( !cx.config.disableCpuAffinity )
+    {
+        const Span<uint> cpus = numa->cpuIds[node];
+
+        AnonMTJob::Run( *cx.pool, [&]( AnonMTJob* self ) {
+            SysHost::SetCurrentThreadAffinityCpuId( cpus[( cpuOffset + self->JobId() ) % cpus.Length()] );
+        });
+    }
+
+    if( cx.maxCompressionLevelReserved > 0 )
+        AssignBucketBuffersToNumaNode( cx );
+}
+
+//-----------------------------------------------------------
+void AssignBucketBuffersToNumaNode( GreenReaperContext& cx )
+{
+    ASSERT( cx.numaNode >= 0 );
+    const uint node = (uint)cx.numaNode;
+
+    // Pages are not touched until the buffers are used,
+    // so this places them in the node when first faulted in.
+    auto assign = [=]( auto span ) {
+        if( span.Ptr() )
+            SysHost::NumaAssignPages( span.Ptr(), span.Length() * sizeof( *span.Ptr() ), node );
+    };
+
+    assign( cx.yBufferF1 );
+    assign( cx.yBuffer );
+    assign( cx.yBufferTmp );
+    assign( cx.xBuffer );
+    assign( cx.xBufferTmp );
+    assign( cx.sortKey );
+    assign( cx.metaBuffer );
+    assign( cx.metaBufferTmp );
+    assign( cx.pairs );
+    assign( cx.pairsTmp );
+    assign( cx.groupsBoundaries );
+
+    for( uint32 i = 1; i < 7; i++ )
+    {
+        if( cx.tables[i]._pairs )
+            SysHost::NumaAssignPages( cx.tables[i]._pairs, cx.tables[i]._capacity * sizeof( Pair ), node );
+    }
+}
+
 //-----------------------------------------------------------
 void FreeBucketBuffers( GreenReaperContext& cx )
 {
@@ -1057,9 +2131,8 @@ inline void SortTableAndFlipBuffers( GreenReaperContext& cx, const uint32 groupC
         return;
     }
 
-    #if SHOW_TIMINGS
-        const auto timer = TimerBegin();
-    #endif
+    const auto timer = TimerBegin();
+
     using TMeta = typename K32MetaType<rTable>::Out;
 
     ProofTable& table = cx.tables[(int)rTable];
@@ -1118,6 +2191,8 @@ inline void SortTableAndFlipBuffers( GreenReaperContext& cx, const uint32 groupC
     cx.proofContext.leftLength  = (uint32)tableLength;
     cx.proofContext.rightLength = (uint32)cx.tables[(int)rTable+1]._capacity;
 
+    AddElapsedNS( cx.timings.sortElapsedNS, timer );
+
     #if SHOW_TIMINGS
         Log::Line( "Sort elapsed: %.3lf s", TimerEnd( timer ) );
     #endif
@@ -1129,9 +2204,26 @@ inline void SortTableAndFlipBuffers( GreenReaperContext& cx, const uint32 groupC
 //-----------------------------------------------------------
 void GenerateF1( GreenReaperContext& cx, const byte plotId[32], const uint64 bucketEntryCount, const uint32 x0, const uint32 x1 )
 {
-    #if SHOW_TIMINGS
-        const auto timer = TimerBegin();
-    #endif
+    // Out buffers are continuous, so that we can merge both buckets into one
+    uint32* xBuffer = cx.xBufferTmp.Ptr();
+    uint64* yBuffer = cx.yBufferF1 .Ptr();
+
+    GenerateF1Buckets( cx, plotId, bucketEntryCount, x0, x1, xBuffer, yBuffer );
+
+    // Sort f1 on y
+    const auto sortTimer = TimerBegin();
+
+    const uint64 mergedEntryCount = bucketEntryCount * 2;
+    RadixSort256::SortYWithKey<BB_MAX_JOBS>( *cx.pool, yBuffer, cx.yBuffer.Ptr(), xBuffer, cx.xBuffer.Ptr(), mergedEntryCount );
+
+    AddElapsedNS( cx.timings.sortElapsedNS, sortTimer );
+}
+
+//-----------------------------------------------------------
+void GenerateF1Buckets( GreenReaperContext& cx, const byte plotId[32], const uint64 bucketEntryCount, const uint32 x0, const uint32 x1,
+                        uint32* xBuffer, uint64* yBuffer )
+{
+    const auto timer = TimerBegin();
 
     const uint32 k = 32;
     const uint32 f1BlocksPerBucket = (uint32)(bucketEntryCount * sizeof( uint32 ) / kF1BlockSize);
@@ -1140,10 +2232,6 @@ void GenerateF1( GreenReaperContext& cx, const byte plotId[32], const uint64 buc
 
     while( f1BlocksPerBucket < threadCount )
         threadCount--;
-    
-    // Out buffers are continuous, so that we can merge both buckets into one
-    uint32* xBuffer = cx.xBufferTmp.Ptr();
-    uint64* yBuffer = cx.yBufferF1 .Ptr();
 
     auto blocks = Span<uint32>( (uint32*)cx.yBuffer.Ptr(), bucketEntryCount );
 
@@ -1214,13 +2302,7 @@ void GenerateF1( GreenReaperContext& cx, const byte plotId[32], const uint64 buc
     // Log::Line( "Completed F1 in %.2lf seconds.", TimerEnd( timer ) );
 
 
-    // Sort f1 on y
-    const uint64 mergedEntryCount = bucketEntryCount * 2;
-    RadixSort256::SortYWithKey<BB_MAX_JOBS>( *cx.pool, yBuffer, cx.yBuffer.Ptr(), xBuffer, cx.xBuffer.Ptr(), mergedEntryCount );
-    
-    #if SHOW_TIMINGS
-        Log::Line( "F1 elapsed: %.3lf s", TimerEnd( timer ) );
-    #endif
+    AddElapsedNS( cx.timings.f1ElapsedNS, timer );
 }
 
 //-----------------------------------------------------------
@@ -1546,6 +2628,8 @@ Span<Pair> Match( GreenReaperContext& cx, const Span<uint64> yEntries, Span<Pair
     ASSERT( yEntries.length <= 0xFFFFFFFF );
     ASSERT( cx.groupsBoundaries.length <= 0xFFFFFFFF );
 
+    const auto timer = TimerBegin();
+
     // Get the group boundaries and the adjusted thread count
     const uint64 groupCount = ScanBCGroupMT32( 
         *cx.pool,
@@ -1575,6 +2659,8 @@ Span<Pair> Match( GreenReaperContext& cx, const Span<uint64> yEntries, Span<Pair
     const uint32 matchThreadCount = std::min( cx.config.threadCount, (uint32)groupCount );
     MTJobRunner<GRMatchJob>::RunFromInstance( *cx.pool, matchThreadCount, job );
 
+    AddElapsedNS( cx.timings.matchElapsedNS, timer );
+
     return outputPairs.SliceSize( matchCount );
 }
 
@@ -1631,8 +2717,8 @@ uint32 MatchJob(
 
     uint32 pairCount = 0;
 
-    uint8  rMapCounts [kBC];
-    uint16 rMapIndices[kBC];
+    KBCRMap rMap;
+    rMap.Clear();
 
     uint64 groupLStart = groupBoundaries[0];
     uint64 groupL      = yEntries[groupLStart] / kBC;
@@ -1645,64 +2731,18 @@ uint32 MatchJob(
         if( groupR - groupL == 1 )
         {
             // Groups are adjacent, calculate matches
-            const uint16 parity           = groupL & 1;
-            const uint64 groupREnd        = groupBoundaries[i+1];
-
-            const uint64 groupLRangeStart = groupL * kBC;
-            const uint64 groupRRangeStart = groupR * kBC;
-
-            ASSERT( groupREnd - groupRStart <= 350 );
-            ASSERT( groupLRangeStart == groupRRangeStart - kBC );
-
-            // Prepare a map of range kBC to store which indices from groupR are used
-            // For now just iterate our bGroup to find the pairs
-
-            // #NOTE: memset(0) works faster on average than keeping a separate a clearing buffer
-            memset( rMapCounts, 0, sizeof( rMapCounts ) );
-
-            for( uint64 iR = groupRStart; iR < groupREnd; iR++ )
-            {
-                uint64 localRY = yEntries[iR] - groupRRangeStart;
-                ASSERT( yEntries[iR] / kBC == groupR );
-
-                if( rMapCounts[localRY] == 0 )
-                    rMapIndices[localRY] = (uint16)( iR - groupRStart );
+            const uint64 groupREnd = groupBoundaries[i+1];
 
-                rMapCounts[localRY] ++;
-            }
+            bool overflowed = false;
+            pairCount += (uint32)MatchKBCGroups( rMap, yEntries.Ptr(), groupL, groupLStart, groupRStart, groupRStart, groupREnd,
+                                                 pairs.Ptr() + pairCount, maxPairs - pairCount, pairOffset, &overflowed );
 
-            // For each group L entry
-            for( uint64 iL = groupLStart; iL < groupRStart; iL++ )
+            // Only an error if there were more pairs than fit, filling the buffer exactly is fine
+            if( overflowed )
             {
-                const uint64 yL     = yEntries[iL];
-                const uint64 localL = yL - groupLRangeStart;
-
-                for( int iK = 0; iK < kExtraBitsPow; iK++ )
-                {
-                    const uint16 targetR = L_targets[parity][localL][iK];
-
-                    // for( uint j = 0; j < rMapCounts[targetR]; j++ )
-                    if( rMapCounts[targetR] > 0 )
-                    {
-                        for( uint j = 0; j < rMapCounts[targetR]; j++ )
-                        {
-                            const uint64 iR = groupRStart + rMapIndices[targetR] + j;
-                            ASSERT( iL < iR );
-
-                            // Add a new pair
-                            if( pairCount >= maxPairs )
-                            {
-                                // #TODO: Set error
-                                ASSERT( 0 );
-                                return pairCount;
-                            }
-
-                            Pair& pair = pairs[pairCount++];
-                            pair.left  = (uint32)iL + pairOffset;
-                            pair.right = (uint32)iR + pairOffset;
-                        }
-                    }
-                }
+                // #TODO: Set error
+                ASSERT( 0 );
+                return pairCount;
             }
         }
         // Else: Not an adjacent group, skip to next one.
@@ -1726,21 +2766,26 @@ void GenerateFxForPairs( GreenReaperContext& cx, const Span<Pair> pairs, const S
     ASSERT( yOut.Length() >= pairs.Length() );
     ASSERT( metaOut.Length() >= pairs.Length() );
 
+    const auto timer = TimerBegin();
+
     const uint32 threadCount = std::min( cx.config.threadCount, (uint32)pairs.Length() );
 
     if( threadCount == 1 )
     {
         GenerateFx<rTable, TMetaIn, TMetaOut>( pairs, yIn, metaIn, yOut, metaOut );
-        return;
+    }
+    else
+    {
+        AnonMTJob::Run( *cx.pool, cx.config.threadCount, [&]( AnonMTJob* self ){
+            
+            uint64 count, offset, _;
+            GetThreadOffsets( self, (uint64)pairs.Length(), count, offset, _ );
+            
+            GenerateFx<rTable, TMetaIn, TMetaOut>( pairs.Slice( offset, count ), yIn, metaIn, yOut.Slice( offset, count ), metaOut.Slice( offset, count ) );
+        });
     }
 
-    AnonMTJob::Run( *cx.pool, cx.config.threadCount, [&]( AnonMTJob* self ){
-        
-        uint64 count, offset, _;
-        GetThreadOffsets( self, (uint64)pairs.Length(), count, offset, _ );
-        
-        GenerateFx<rTable, TMetaIn, TMetaOut>( pairs.Slice( offset, count ), yIn, metaIn, yOut.Slice( offset, count ), metaOut.Slice( offset, count ) );
-    });
+    AddElapsedNS( cx.timings.fxElapsedNS, timer );
 }
 
 //-----------------------------------------------------------
@@ -1760,12 +2805,13 @@ inline void GenerateFx( const Span<Pair> pairs, const Span<uint64> yIn, const Sp
     const size_t metaSizeLR  = metaSize * 2;
     const size_t bufferSize  = CDiv( ySize + metaSizeLR, 8 );
 
-    // Hashing
-    uint64 input [5]; // y + L + R
-    uint64 output[4]; // blake3 hashed output
+    // Hashing. Inputs are staged in batches and hashed together in parallel lanes.
+    // Each input is zero-padded to a full blake3 block.
+    uint64 fxInput [BB_FX_HASH_BATCH_SIZE][8] = {}; // y + L + R
+    uint64 fxOutput[BB_FX_HASH_BATCH_SIZE][4];       // blake3 hashed output
+    uint64 batchCount = 0;
 
-    blake3_hasher hasher;
-    static_assert( bufferSize <= sizeof( input ), "Invalid fx input buffer size." );
+    static_assert( bufferSize <= sizeof( fxInput[0] ), "Invalid fx input buffer size." );
 
     for( uint64 i = 0; i < pairs.Length(); i++ )
     {
@@ -1775,7 +2821,8 @@ inline void GenerateFx( const Span<Pair> pairs, const Span<uint64> yIn, const Sp
         const TMetaIn metaL = metaIn[pair.left ];
         const TMetaIn metaR = metaIn[pair.right];
 
-        TMetaOut& mOut = outMeta[i];
+        TMetaOut& mOut  = outMeta[i];
+        uint64*   input = fxInput[batchCount++];
 
         if constexpr( MetaInMulti == 1 )
         {
@@ -1829,38 +2876,49 @@ inline void GenerateFx( const Span<Pair> pairs, const Span<uint64> yIn, const Sp
             input[4] = Swap64( r.m1 << 26 );
         }
 
-        // Hash the input
-        blake3_hasher_init( &hasher );
-        blake3_hasher_update( &hasher, input, bufferSize );
-        blake3_hasher_finalize( &hasher, (uint8_t*)output, sizeof( output ) );
+        // Hash the staged inputs once the batch is full or we've reached the last entry
+        if( batchCount == BB_FX_HASH_BATCH_SIZE || i + 1 == pairs.Length() )
+        {
+            blake3_hash_many_small( (const uint8_t*)fxInput, batchCount, bufferSize, (uint8_t*)fxOutput );
+
+            const uint64 first = i + 1 - batchCount;
 
-        const uint64 f = Swap64( *output ) >> yShift;
-        yOut[i] = f;
+            for( uint64 j = 0; j < batchCount; j++ )
+            {
+                const uint64* output = fxOutput[j];
+                auto&         mOut   = outMeta[first + j];
 
-        if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
-        {
-            const uint64 h0 = Swap64( output[0] );
-            const uint64 h1 = Swap64( output[1] );
+                const uint64 f = Swap64( *output ) >> yShift;
+                yOut[first + j] = f;
 
-            mOut = h0 << ySize | h1 >> 26;
-        }
-        else if constexpr ( MetaOutMulti == 3 )
-        {
-            const uint64 h0 = Swap64( output[0] );
-            const uint64 h1 = Swap64( output[1] );
-            const uint64 h2 = Swap64( output[2] );
+                if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
+                {
+                    const uint64 h0 = Swap64( output[0] );
+                    const uint64 h1 = Swap64( output[1] );
 
-            mOut.m0 = h0 << ySize | h1 >> 26;
-            mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
-        }
-        else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
-        {
-            const uint64 h0 = Swap64( output[0] );
-            const uint64 h1 = Swap64( output[1] );
-            const uint64 h2 = Swap64( output[2] );
+                    mOut = h0 << ySize | h1 >> 26;
+                }
+                else if constexpr ( MetaOutMulti == 3 )
+                {
+                    const uint64 h0 = Swap64( output[0] );
+                    const uint64 h1 = Swap64( output[1] );
+                    const uint64 h2 = Swap64( output[2] );
+
+                    mOut.m0 = h0 << ySize | h1 >> 26;
+                    mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
+                }
+                else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
+                {
+                    const uint64 h0 = Swap64( output[0] );
+                    const uint64 h1 = Swap64( output[1] );
+                    const uint64 h2 = Swap64( output[2] );
+
+                    mOut.m0 = h0 << ySize | h1 >> 26;
+                    mOut.m1 = h1 << 38    | h2 >> 26;
+                }
+            }
 
-            mOut.m0 = h0 << ySize | h1 >> 26;
-            mOut.m1 = h1 << 38    | h2 >> 26;
+            batchCount = 0;
         }
     }
 }
@@ -21,7 +21,7 @@
 extern "C" {
 #endif
 
-#define GR_API_VERSION 1
+#define GR_API_VERSION 2
 
 #define GR_POST_PROOF_X_COUNT 64
 #define GR_POST_PROOF_CMP_X_COUNT (GR_POST_PROOF_X_COUNT/2)
@@ -31,6 +31,7 @@ typedef int32_t GRBool;
 #define GR_TRUE  1
 
 typedef struct GreenReaperContext GreenReaperContext;
+typedef struct GRContextPool GRContextPool;
 
 /// How to select GPU for harvesting.
 typedef enum GRGpuRequestKind
@@ -50,10 +51,28 @@ typedef struct GreenReaperConfig
     GRBool             disableCpuAffinity;
     GRGpuRequestKind_t gpuRequest;         // What kind of GPU to select for harvesting.
     uint32_t           gpuDeviceIndex;     // Which device index to use (0 by default)
+    uint32_t           batchLaneCount;     // Number of requests a batch call may decompress concurrently (0 or 1 for serial).
+                                           // Each lane owns a slice of threadCount and its own set of bucket buffers,
+                                           // so a context uses up to (batchLaneCount+1) times the memory of a serial one.
+                                           // Lanes are allocated by grPreallocateForCompressionLevel, or else on the first batch.
 
-    uint32_t           _reserved[16];      // Reserved for future use
+    uint32_t           _reserved[15];      // Reserved for future use
 } GreenReaperConfig;
 
+typedef struct GRContextPoolConfig
+{
+    uint32_t           apiVersion;
+    uint32_t           contextCount;        // Number of contexts to create up front.
+    uint32_t           k;                   // Maximum k and compression level that the contexts must support.
+    uint32_t           maxCompressionLevel; // Their buffers are fully allocated when the pool is created.
+    GRBool             numaPinning;         // Distribute contexts round-robin across NUMA nodes, binding each context's
+                                            // threads and buffers to its node. Ignored on systems without NUMA.
+    GreenReaperConfig  contextConfig;       // Configuration for every context. threadCount is per context.
+                                            // Unless NUMA-pinned, contexts use consecutive cpuOffsets starting at contextConfig.cpuOffset.
+
+    uint32_t           _reserved[8];        // Reserved for future use
+} GRContextPoolConfig;
+
 typedef enum GRResult
 {
     GRResult_Failed        = 0,
@@ -66,6 +85,17 @@ typedef enum GRResult
 
 } GRResult;
 
+/// Identifies a request submitted asynchronously to a context.
+typedef uint64_t GRTicket;
+#define GR_INVALID_TICKET 0
+
+/// Maximum number of asynchronous requests per context that may be pending or awaiting retrieval.
+#define GR_MAX_ASYNC_REQUESTS 4096
+
+/// Invoked from the context's dispatch thread when an asynchronously submitted request completes.
+/// The request struct may be re-used or freed once this is called.
+typedef void (*GRRequestCallback)( GreenReaperContext* context, GRTicket ticket, GRResult result, void* userData );
+
 typedef struct GRCompressionInfo
 {
     uint32_t entrySizeBits;
@@ -74,15 +104,29 @@ typedef struct GRCompressionInfo
     double   ansRValue;
 } GRCompressionInfo;
 
-// Timings expressed in nanoseconds
-// typedef struct GRProofTimings
-// {
-//     uint64_t totalElapsedNS;
-//     uint64_t f1ElapsedNS;
-//     uint64_t sortElapsedNS;
-//     uint64_t matchElapsedNS;
-//     uint64_t fxElapsedNS;
-// };
+// Timings expressed in nanoseconds.
+// Per-stage timings are only collected for CPU decompression, 
+// GPU requests report only the total elapsed time.
+typedef struct GRProofTimings
+{
+    uint64_t totalElapsedNS;
+    uint64_t f1ElapsedNS;
+    uint64_t sortElapsedNS;
+    uint64_t matchElapsedNS;
+    uint64_t fxElapsedNS;
+    uint64_t backtraceElapsedNS;
+} GRProofTimings;
+
+// Aggregate counters for all requests processed by a context
+typedef struct GRStats
+{
+    uint64_t       proofRequests;       // Full proof requests processed
+    uint64_t       proofsFound;         // Full proof requests that completed with GRResult_OK
+    uint64_t       qualitiesRequests;   // Qualities requests processed
+    uint64_t       qualitiesFound;      // Qualities requests that completed with GRResult_OK
+    GRProofTimings proofTimings;        // Sum of the timings of all full proof requests
+    GRProofTimings qualitiesTimings;    // Sum of the timings of all qualities requests
+} GRStats;
 
 typedef struct GRCompressedProofRequest
 {
@@ -96,7 +140,7 @@ typedef struct GRCompressedProofRequest
 
     // Pass a pointer to a timings struct if 
     // you'd like detailed timings output
-    // GRProofTimings* outTimings;
+    GRProofTimings* outTimings;
           
 } GRCompressedProofRequest;
 
@@ -116,6 +160,7 @@ typedef struct GRCompressedQualitiesRequest
 
     // Output
     uint64_t        x1, x2;             // Output x qualities
+    GRProofTimings* outTimings;         // Optional. Set to receive detailed timings output.
 
 } GRCompressedQualitiesRequest;
 
@@ -129,6 +174,19 @@ typedef struct GRApiV1
     size_t   (*GetMemoryUsage)( GreenReaperContext* context );
     GRBool   (*HasGpuDecompressor)( GreenReaperContext* context );
     GRResult (*GetCompressionInfo)( GRCompressionInfo* outInfo, size_t infoStructSize, uint32_t k, uint32_t compressionLevel );
+    GRResult (*FetchProofsBatch)( GreenReaperContext* context, GRCompressedProofRequest* reqs, uint32_t reqCount, GRResult* outResults );
+    GRResult (*FetchQualitiesBatch)( GreenReaperContext* context, GRCompressedQualitiesRequest* reqs, uint32_t reqCount, GRResult* outResults );
+    GRResult (*SubmitProofRequest)( GreenReaperContext* context, GRCompressedProofRequest* req, GRRequestCallback callback, void* userData, GRTicket* outTicket );
+    GRResult (*SubmitQualitiesRequest)( GreenReaperContext* context, GRCompressedQualitiesRequest* req, GRRequestCallback callback, void* userData, GRTicket* outTicket );
+    GRBool   (*Poll)( GreenReaperContext* context, GRTicket ticket, GRResult* outResult );
+    GRResult (*Wait)( GreenReaperContext* context, GRTicket ticket );
+    GRResult (*GetStats)( GreenReaperContext* context, GRStats* outStats, size_t statsStructSize );
+    void     (*ResetStats)( GreenReaperContext* context );
+    GRResult (*CreateContextPool)( GRContextPool** outPool, GRContextPoolConfig* config, size_t configStructSize );
+    void     (*DestroyContextPool)( GRContextPool* pool );
+    GreenReaperContext* (*AcquireContext)( GRContextPool* pool, GRBool wait );
+    void     (*ReleaseContext)( GRContextPool* pool, GreenReaperContext* context );
+    uint32_t (*GetContextPoolSize)( GRContextPool* pool );
 
 } GRApiV1;
 
@@ -149,7 +207,8 @@ GR_API GRResult grCreateContext( GreenReaperContext** outContext, GreenReaperCon
 /// Destroy decompression context
 GR_API void grDestroyContext( GreenReaperContext* context );
 
-/// Preallocate context's in-memory buffers to support a maximum compression level
+/// Preallocate context's in-memory buffers to support a maximum compression level.
+/// This includes the buffers of the context's batch lanes, if any.
 GR_API GRResult grPreallocateForCompressionLevel( GreenReaperContext* context, uint32_t k, uint32_t maxCompressionLevel );
 
 /// Full proof of space request given a challenge
@@ -158,6 +217,46 @@ GR_API GRResult grFetchProofForChallenge( GreenReaperContext* context, GRCompres
 /// Request plot qualities for a challenge
 GR_API GRResult grGetFetchQualitiesXPair( GreenReaperContext* context, GRCompressedQualitiesRequest* req );
 
+/// Full proof of space requests for a batch of challenges.
+/// The result of each request is written to outResults[i].
+/// Returns GRResult_OK if all requests were processed, even if some of them yielded no proof.
+GR_API GRResult grFetchProofsBatch( GreenReaperContext* context, GRCompressedProofRequest* reqs, uint32_t reqCount, GRResult* outResults );
+
+/// Request plot qualities for a batch of challenges.
+/// The result of each request is written to outResults[i].
+/// Returns GRResult_OK if all requests were processed, even if some of them yielded no qualities.
+GR_API GRResult grFetchQualitiesBatch( GreenReaperContext* context, GRCompressedQualitiesRequest* reqs, uint32_t reqCount, GRResult* outResults );
+
+/// Queue a full proof request on the context and return immediately.
+/// The request struct must remain valid until the request completes.
+/// If a callback is given, it is called with the result on completion and the ticket can not be polled.
+/// Otherwise the result must be retrieved with grPoll or grWait, which releases the ticket.
+/// Returns GRResult_OutOfMemory if GR_MAX_ASYNC_REQUESTS requests have not been released yet.
+/// While submitted requests have not completed, synchronous requests on the same context
+/// (including grPreallocateForCompressionLevel) fail with GRResult_Failed.
+GR_API GRResult grSubmitProofRequest( GreenReaperContext* context, GRCompressedProofRequest* req, 
+                                      GRRequestCallback callback, void* userData, GRTicket* outTicket );
+
+/// Queue a qualities request on the context and return immediately.
+/// Same rules as grSubmitProofRequest apply.
+GR_API GRResult grSubmitQualitiesRequest( GreenReaperContext* context, GRCompressedQualitiesRequest* req, 
+                                          GRRequestCallback callback, void* userData, GRTicket* outTicket );
+
+/// Returns GR_TRUE if the request has completed, and sets its result in outResult.
+/// Unknown or already released tickets complete with GRResult_InvalidArg.
+/// Should only be called from a single thread.
+GR_API GRBool grPoll( GreenReaperContext* context, GRTicket ticket, GRResult* outResult );
+
+/// Blocks until the request has completed and returns its result.
+/// Should only be called from a single thread.
+GR_API GRResult grWait( GreenReaperContext* context, GRTicket ticket );
+
+/// Get the aggregate request counters and timings of the context since it was created or last reset.
+GR_API GRResult grGetStats( GreenReaperContext* context, GRStats* outStats, size_t statsStructSize );
+
+/// Clear the aggregate request counters and timings of the context.
+GR_API void grResetStats( GreenReaperContext* context );
+
 GR_API size_t grGetMemoryUsage( GreenReaperContext* context );
 
 /// Returns true if the context has a Gpu-based decompressor created.
@@ -165,6 +264,23 @@ GR_API GRBool grHasGpuDecompressor( GreenReaperContext* context );
 
 GR_API GRResult grGetCompressionInfo( GRCompressionInfo* outInfo, size_t infoStructSize, uint32_t k, uint32_t compressionLevel );
 
+/// Create a pool of contexts preallocated for a maximum k and compression level,
+/// to be shared by many plot readers instead of each owning a context.
+GR_API GRResult grCreateContextPool( GRContextPool** outPool, GRContextPoolConfig* config, size_t configStructSize );
+
+/// Destroy a context pool and all of its contexts. All contexts must have been released.
+GR_API void grDestroyContextPool( GRContextPool* pool );
+
+/// Borrow a context from the pool. If none is available, it blocks until one is released when wait is set,
+/// otherwise it returns NULL. Contexts are handed out to one borrower at a time.
+GR_API GreenReaperContext* grAcquireContext( GRContextPool* pool, GRBool wait );
+
+/// Return a context borrowed with grAcquireContext to the pool.
+GR_API void grReleaseContext( GRContextPool* pool, GreenReaperContext* context );
+
+/// Number of contexts owned by the pool.
+GR_API uint32_t grGetContextPoolSize( GRContextPool* pool );
+
 inline const char* grResultToString( const GRResult r )
 {
     switch( r )
@@ -8,6 +8,16 @@ static constexpr double GR_MAX_MATCHES_MULTIPLIER_2T_DROP = 0.018;  // For C9+
 static constexpr uint32 GR_MAX_BUCKETS                    = 32;
 static constexpr uint64 GR_MIN_TABLE_PAIRS                = 1024;
 
+// Highest compression level for which qualities are fetched by matching
+// the x buckets directly, instead of sorting them and forward-propagating.
+static constexpr uint32 GR_QUALITIES_FAST_PATH_MAX_LEVEL  = 3;
+
+#if BB_TEST_MODE
+    // Lets tests compare the qualities fast path against the full decompression path
+    extern bool   grTestDisableQualitiesFastPath;
+    extern uint64 grTestQualitiesFastPathHits;     // Requests answered by the fast path
+#endif
+
 struct CudaThresherConfig
 {
     uint deviceId;
@@ -0,0 +1,147 @@
+#include "BitPackTransform.h"
+#include "util/Util.h"
+
+struct BitPackHeader
+{
+    uint32 count;       // Number of packed entries, including the first one
+    uint32 first;       // First entry, when delta-encoded
+    uint32 bits;        // Bits per packed entry
+    uint32 delta;       // Entries are packed as deltas from the previous entry
+};
+static_assert( sizeof( BitPackHeader ) == 16 );
+
+//-----------------------------------------------------------
+inline static uint32 ZigZag( const uint32 delta )
+{
+    return ( delta << 1 ) ^ (uint32)( (int32)delta >> 31 );
+}
+
+//-----------------------------------------------------------
+inline static uint32 UnZigZag( const uint32 value )
+{
+    return ( value >> 1 ) ^ ( 0u - ( value & 1 ) );
+}
+
+//-----------------------------------------------------------
+inline static uint32 BitWidth( const uint32 value )
+{
+    return value ? bblog2( value ) + 1 : 0;
+}
+
+//-----------------------------------------------------------
+size_t BitPackTransform::Encode( const void* src, const size_t size, const size_t dataSize, void* dst )
+{
+    if( size % sizeof( uint32 ) != 0 || size < sizeof( BitPackHeader ) )
+        return 0;
+
+    const uint32* entries = (const uint32*)src;
+    const uint64  count   = std::min( dataSize, size ) / sizeof( uint32 );
+
+    if( count < 2 || count > 0xFFFFFFFF )
+        return 0;
+
+    // The widest value and delta determine the bits needed for either
+    uint32 valueBits = entries[0];
+    uint32 deltaBits = 0;
+
+    for( uint64 i = 1; i < count; i++ )
+    {
+        valueBits |= entries[i];
+        deltaBits |= ZigZag( entries[i] - entries[i-1] );
+    }
+
+    valueBits = BitWidth( valueBits );
+    deltaBits = BitWidth( deltaBits );
+
+    const bool   delta       = deltaBits < valueBits;
+    const uint32 bits        = delta ? deltaBits : valueBits;
+    const uint64 packCount   = delta ? count - 1 : count;
+    const size_t tailSize    = size - count * sizeof( uint32 );
+    const size_t encodedSize = sizeof( BitPackHeader ) + CDivT<uint64>( packCount * bits, 64 ) * sizeof( uint64 ) + tailSize;
+
+    if( bits >= 32 || encodedSize >= size )
+        return 0;
+
+    BitPackHeader& header = *(BitPackHeader*)dst;
+    header.count = (uint32)count;
+    header.first = entries[0];
+    header.bits  = bits;
+    header.delta = delta ? 1 : 0;
+
+    uint64* fields  = (uint64*)( (byte*)dst + sizeof( BitPackHeader ) );
+    uint64  field   = 0;
+    uint32  used    = 0;    // Bits used in the current field
+
+    for( uint64 i = count - packCount; i < count; i++ )
+    {
+        const uint64 value = delta ? ZigZag( entries[i] - entries[i-1] ) : entries[i];
+
+        field |= value << used;
+        used  += bits;
+
+        if( used >= 64 )
+        {
+            *fields++ = field;
+            used     -= 64;
+            field     = used ? value >> ( bits - used ) : 0;
+        }
+    }
+
+    if( used )
+        *fields++ = field;
+
+    memcpy( fields, entries + count, tailSize );
+
+    return encodedSize;
+}
+
+//-----------------------------------------------------------
+void BitPackTransform::Decode( const void* src, const size_t encodedSize, void* dst, const size_t size )
+{
+    const BitPackHeader& header = *(const BitPackHeader*)src;
+
+    const uint64  count     = header.count;
+    const uint32  bits      = header.bits;
+    const bool    delta     = header.delta != 0;
+    const uint64  mask      = ( 1ull << bits ) - 1;
+    const size_t  tailSize  = size - count * sizeof( uint32 );
+
+    ASSERT( count * sizeof( uint32 ) <= size );
+    ASSERT( sizeof( BitPackHeader ) + CDivT<uint64>( ( delta ? count - 1 : count ) * bits, 64 ) * sizeof( uint64 ) + tailSize <= encodedSize );
+    (void)encodedSize;
+
+    const uint64* fields  = (const uint64*)( (const byte*)src + sizeof( BitPackHeader ) );
+          uint32* entries = (uint32*)dst;
+          uint64  field   = 0;
+          uint32  left    = 0;  // Bits left in the current field
+          uint32  prev    = header.first;
+
+    uint64 i = 0;
+    if( delta )
+        entries[i++] = prev;
+
+    for( ; i < count; i++ )
+    {
+        uint32 value;
+
+        if( left >= bits )
+        {
+            value  = (uint32)( field & mask );
+            field >>= bits;
+            left  -= bits;
+        }
+        else
+        {
+            const uint64 next = *fields++;
+
+            value = (uint32)( ( field | ( next << left ) ) & mask );
+            field = next >> ( bits - left );
+            left  = 64 - ( bits - left );
+        }
+
+        prev       = delta ? prev + UnZigZag( value ) : value;
+        entries[i] = prev;
+    }
+
+    memcpy( entries + count, fields, tailSize );
+}
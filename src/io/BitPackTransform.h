@@ -0,0 +1,18 @@
+#pragma once
+
+#include "io/IIOTransform.h"
+
+///
+/// Packs buffers of uint32 entries down to the bit width actually used by them.
+/// Entries are stored either as-is or as the (zig-zag encoded) difference from the previous entry,
+/// whichever needs fewer bits. So y values only keep their true width, while mostly ordered values,
+/// such as indices, shrink to the width of the gaps between them.
+/// Bytes past the data size (padding) are stored raw.
+///
+class BitPackTransform : public IIOTransform
+{
+public:
+    size_t Encode( const void* src, size_t size, size_t dataSize, void* dst ) override;
+
+    void Decode( const void* src, size_t encodedSize, void* dst, size_t size ) override;
+};
@@ -0,0 +1,432 @@
+#include "FileIOBatch.h"
+
+#if PLATFORM_IS_LINUX && defined( __has_include )
+    #if __has_include( <linux/io_uring.h> )
+        #define BB_IO_URING_AVAILABLE 1
+    #endif
+#endif
+
+#if BB_IO_URING_AVAILABLE
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+    #include <sys/uio.h>
+    #include <sys/resource.h>
+    #include <unistd.h>
+    #include <errno.h>
+
+    // The io_uring syscalls are used directly, so that liburing is not required to build or to run.
+    #ifndef __NR_io_uring_setup
+        #define __NR_io_uring_setup    425
+        #define __NR_io_uring_enter    426
+        #define __NR_io_uring_register 427
+    #endif
+#endif
+
+// The kernel does not allow registering buffers larger than this
+static constexpr size_t RegisteredChunkSize = 1 GiB;
+
+//-----------------------------------------------------------
+FileIOBatch::~FileIOBatch()
+{
+    Destroy();
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::Queue( FileStream& file, byte* buffer, size_t size, const int64 offset, const uint32 tag, const bool write )
+{
+    ASSERT( buffer || !size );
+    ASSERT( offset >= 0 );
+
+    // Split large requests so that they are serviced concurrently too
+    for( size_t pos = 0; pos < size; pos += MaxRequestSize )
+    {
+        Request req;
+        req.buffer = buffer + pos;
+        req.size   = std::min( size - pos, MaxRequestSize );
+        req.offset = offset + (int64)pos;
+        req.fd     = (int32)file.Id();
+        req.tag    = tag;
+        req.write  = write;
+
+        _requests.push_back( req );
+    }
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::Read( FileStream& file, void* buffer, const size_t size, const int64 offset, const uint32 tag )
+{
+    Queue( file, (byte*)buffer, size, offset, tag, false );
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::Write( FileStream& file, const void* buffer, const size_t size, const int64 offset, const uint32 tag )
+{
+    Queue( file, (byte*)buffer, size, offset, tag, true );
+}
+
+//-----------------------------------------------------------
+int32 FileIOBatch::GetBufferIndex( const byte* buffer, const size_t size ) const
+{
+    if( buffer < _registeredBase || buffer + size > _registeredBase + _registeredSize )
+        return -1;
+
+    const size_t start = (size_t)( buffer - _registeredBase );
+    const size_t index = start / RegisteredChunkSize;
+
+    // Fixed requests must not cross into the next registered buffer
+    if( ( start + size - 1 ) / RegisteredChunkSize != index )
+        return -1;
+
+    return (int32)index;
+}
+
+#if BB_IO_URING_AVAILABLE
+
+//-----------------------------------------------------------
+bool FileIOBatch::Init( const uint32 queueDepth )
+{
+    ASSERT( !IsValid() );
+    if( queueDepth < 1 )
+        return false;
+
+    io_uring_params params;
+    memset( &params, 0, sizeof( params ) );
+
+    const int fd = (int)syscall( __NR_io_uring_setup, queueDepth, &params );
+    if( fd < 0 )
+        return false;   // Not supported by the kernel, or blocked by the container
+
+    _ringFd    = fd;
+    _sqEntries = params.sq_entries;
+    _cqEntries = params.cq_entries;
+
+    // IORING_OP_READ and IORING_OP_WRITE were added in the same kernel version as this feature (5.6)
+    if( !( params.features & IORING_FEAT_RW_CUR_POS ) )
+    {
+        Destroy();
+        return false;
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof( uint32 );
+    _cqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof( io_uring_cqe );
+    _sqesSize   = params.sq_entries * sizeof( io_uring_sqe );
+
+    const bool singleMap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if( singleMap )
+        _sqRingSize = _cqRingSize = std::max( _sqRingSize, _cqRingSize );
+
+    _sqRing = mmap( nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if( _sqRing == MAP_FAILED )
+    {
+        _sqRing = nullptr;
+        Destroy();
+        return false;
+    }
+
+    if( singleMap )
+        _cqRing = _sqRing;
+    else
+    {
+        _cqRing = mmap( nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if( _cqRing == MAP_FAILED )
+        {
+            _cqRing = nullptr;
+            Destroy();
+            return false;
+        }
+    }
+
+    _sqes = mmap( nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if( _sqes == MAP_FAILED )
+    {
+        _sqes = nullptr;
+        Destroy();
+        return false;
+    }
+
+    byte* sq = (byte*)_sqRing;
+    byte* cq = (byte*)_cqRing;
+
+    _sqHead  = (uint32*)( sq + params.sq_off.head      );
+    _sqTail  = (uint32*)( sq + params.sq_off.tail      );
+    _sqMask  = (uint32*)( sq + params.sq_off.ring_mask );
+    _sqArray = (uint32*)( sq + params.sq_off.array     );
+    _cqHead  = (uint32*)( cq + params.cq_off.head      );
+    _cqTail  = (uint32*)( cq + params.cq_off.tail      );
+    _cqMask  = (uint32*)( cq + params.cq_off.ring_mask );
+    _cqes    = cq + params.cq_off.cqes;
+
+    _requests.reserve( _sqEntries * 4 );
+    _retries .reserve( _sqEntries );
+
+    return true;
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::Destroy()
+{
+    if( _sqes )
+        munmap( _sqes, _sqesSize );
+    if( _cqRing && _cqRing != _sqRing )
+        munmap( _cqRing, _cqRingSize );
+    if( _sqRing )
+        munmap( _sqRing, _sqRingSize );
+
+    // Also releases registered buffers
+    if( _ringFd >= 0 )
+        close( _ringFd );
+
+    _ringFd         = -1;
+    _sqEntries      = 0;
+    _cqEntries      = 0;
+    _sqRing         = nullptr;
+    _cqRing         = nullptr;
+    _sqes           = nullptr;
+    _registeredBase = nullptr;
+    _registeredSize = 0;
+
+    _requests.clear();
+    _retries .clear();
+}
+
+//-----------------------------------------------------------
+bool FileIOBatch::RegisterBuffer( const void* buffer, const size_t size )
+{
+    ASSERT( IsValid() );
+    ASSERT( buffer && size );
+
+    UnregisterBuffers();
+
+    // The pinned pages count against the locked memory limit, unless running as root.
+    // Don't fault-in the whole buffer just to have the kernel refuse it.
+    rlimit memLock;
+    if( geteuid() != 0 && getrlimit( RLIMIT_MEMLOCK, &memLock ) == 0 &&
+        memLock.rlim_cur != RLIM_INFINITY && (size_t)memLock.rlim_cur < size )
+        return false;
+
+    const uint32 count = (uint32)CDivT( size, RegisteredChunkSize );
+
+    std::vector<iovec> iovecs( count );
+    for( uint32 i = 0; i < count; i++ )
+    {
+        const size_t offset = i * RegisteredChunkSize;
+
+        iovecs[i].iov_base = (byte*)buffer + offset;
+        iovecs[i].iov_len  = std::min( size - offset, RegisteredChunkSize );
+    }
+
+    // Pins the pages, so this faults-in the whole buffer
+    if( syscall( __NR_io_uring_register, _ringFd, IORING_REGISTER_BUFFERS, iovecs.data(), count ) < 0 )
+        return false;
+
+    _registeredBase = (const byte*)buffer;
+    _registeredSize = size;
+
+    return true;
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::UnregisterBuffers()
+{
+    if( !_registeredBase )
+        return;
+
+    syscall( __NR_io_uring_register, _ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+
+    _registeredBase = nullptr;
+    _registeredSize = 0;
+}
+
+//-----------------------------------------------------------
+bool FileIOBatch::Execute( int& outError, uint32& outTag )
+{
+    ASSERT( IsValid() );
+
+    outError = 0;
+    outTag   = 0;
+
+    const uint32 requestCount = (uint32)_requests.size();
+
+    uint32 nextRequest = 0;
+    uint32 inFlight    = 0;     // Submitted to the kernel, and not yet completed
+    uint32 toSubmit    = 0;     // Added to the submission ring, but not yet accepted by the kernel
+    bool   failed      = false;
+
+    const uint32 sqMask = *_sqMask;
+    const uint32 cqMask = *_cqMask;
+
+    io_uring_sqe* sqes = (io_uring_sqe*)_sqes;
+    io_uring_cqe* cqes = (io_uring_cqe*)_cqes;
+
+    for( ;; )
+    {
+        // Fill the submission ring. Once a request failed, only wait for the ones in flight.
+        uint32 tail = *_sqTail;
+
+        while( !failed && inFlight + toSubmit < _sqEntries && inFlight + toSubmit < _cqEntries &&
+               ( _retries.size() > 0 || nextRequest < requestCount ) )
+        {
+            uint32 reqIdx;
+            if( _retries.size() > 0 )
+            {
+                reqIdx = _retries.back();
+                _retries.pop_back();
+            }
+            else
+                reqIdx = nextRequest++;
+
+            const Request& req      = _requests[reqIdx];
+            const int32    bufIndex = GetBufferIndex( req.buffer, req.size );
+
+            const uint32   sqIdx = tail & sqMask;
+            io_uring_sqe&  sqe   = sqes[sqIdx];
+
+            memset( &sqe, 0, sizeof( sqe ) );
+            sqe.fd        = req.fd;
+            sqe.addr      = (uint64)(uintptr_t)req.buffer;
+            sqe.len       = (uint32)req.size;
+            sqe.off       = (uint64)req.offset;
+            sqe.user_data = reqIdx;
+
+            if( bufIndex >= 0 )
+            {
+                sqe.opcode    = req.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+                sqe.buf_index = (uint16)bufIndex;
+            }
+            else
+                sqe.opcode    = req.write ? IORING_OP_WRITE : IORING_OP_READ;
+
+            _sqArray[sqIdx] = sqIdx;
+
+            tail++;
+            toSubmit++;
+        }
+
+        __atomic_store_n( _sqTail, tail, __ATOMIC_RELEASE );
+
+        if( inFlight + toSubmit == 0 )
+            break;
+
+        const int submitted = (int)syscall( __NR_io_uring_enter, _ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0 );
+        if( submitted < 0 )
+        {
+            const int err = errno;
+            if( err != EINTR && err != EAGAIN && err != EBUSY )
+            {
+                if( !failed )
+                {
+                    outError = err;
+                    failed   = true;
+                }
+
+                // Take back the entries the kernel did not consume, so that they are not
+                // submitted by the next Execute(), nor by the calls below.
+                __atomic_store_n( _sqTail, __atomic_load_n( _sqHead, __ATOMIC_ACQUIRE ), __ATOMIC_RELEASE );
+                toSubmit = 0;
+
+                // Nothing more can be submitted, but we must not return while the kernel still uses the buffers
+                if( inFlight == 0 )
+                    break;
+
+                if( syscall( __NR_io_uring_enter, _ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) < 0 && errno != EINTR )
+                    break;
+            }
+        }
+        else
+        {
+            toSubmit -= (uint32)submitted;
+            inFlight += (uint32)submitted;
+        }
+
+        // Reap completions
+        uint32       head   = *_cqHead;
+        const uint32 cqTail = __atomic_load_n( _cqTail, __ATOMIC_ACQUIRE );
+
+        for( ; head != cqTail; head++ )
+        {
+            const io_uring_cqe& cqe    = cqes[head & cqMask];
+            const uint32        reqIdx = (uint32)cqe.user_data;
+            const int32         result = cqe.res;
+            Request&            req    = _requests[reqIdx];
+
+            ASSERT( inFlight > 0 );
+            inFlight--;
+
+            if( result == -EAGAIN || result == -EINTR )
+            {
+                _retries.push_back( reqIdx );
+                continue;
+            }
+
+            if( result <= 0 )
+            {
+                if( !failed )
+                {
+                    // A read of 0 bytes means the file ended before the requested size
+                    outError = result < 0 ? -result : EIO;
+                    outTag   = req.tag;
+                    failed   = true;
+                }
+                continue;
+            }
+
+            ASSERT( (size_t)result <= req.size );
+            req.buffer += result;
+            req.offset += result;
+            req.size   -= (size_t)result;
+
+            if( req.size > 0 )
+                _retries.push_back( reqIdx );
+        }
+
+        __atomic_store_n( _cqHead, head, __ATOMIC_RELEASE );
+    }
+
+    _requests.clear();
+    _retries .clear();
+
+    return !failed;
+}
+
+#else
+
+//-----------------------------------------------------------
+bool FileIOBatch::Init( const uint32 queueDepth )
+{
+    (void)queueDepth;
+    return false;
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::Destroy()
+{
+    _requests.clear();
+    _retries .clear();
+}
+
+//-----------------------------------------------------------
+bool FileIOBatch::RegisterBuffer( const void* buffer, const size_t size )
+{
+    (void)buffer;
+    (void)size;
+    return false;
+}
+
+//-----------------------------------------------------------
+void FileIOBatch::UnregisterBuffers()
+{
+}
+
+//-----------------------------------------------------------
+bool FileIOBatch::Execute( int& outError, uint32& outTag )
+{
+    ASSERT( 0 );
+
+    _requests.clear();
+    outError = -1;
+    outTag   = 0;
+    return false;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "io/FileStream.h"
+#include "util/Util.h"
+#include <vector>
+
+///
+/// Positional reads and writes to one or more files, queued and then executed together
+/// so that many of them are in flight at once. Uses io_uring on Linux.
+/// Where it is not available Init() fails, and the caller should use the regular blocking
+/// FileStream path instead.
+/// Batches are not thread-safe, and should be used from a single I/O thread.
+///
+class FileIOBatch
+{
+public:
+    static constexpr uint32 DefaultQueueDepth = 64;
+    static constexpr size_t MaxRequestSize    = 8 MiB;     // Larger requests are split into multiple in-flight requests
+
+    FileIOBatch() = default;
+    ~FileIOBatch();
+
+    FileIOBatch( const FileIOBatch& ) = delete;
+    FileIOBatch& operator=( const FileIOBatch& ) = delete;
+
+    // Returns false if asynchronous I/O is not supported by the system.
+    bool Init( uint32 queueDepth = DefaultQueueDepth );
+
+    void Destroy();
+
+    inline bool IsValid() const { return _ringFd >= 0; }
+
+    inline uint32 QueueDepth() const { return _sqEntries; }
+
+    // Register a buffer with the kernel so that I/O to and from it does not need to map its pages on every request.
+    // Replaces the currently registered buffer, if any. Requests outside of the buffer still work, unregistered.
+    // The whole buffer is pinned in memory, so it must fit in the locked memory limit (RLIMIT_MEMLOCK),
+    // unless running as root. Returns false if the buffer could not be registered.
+    bool RegisterBuffer( const void* buffer, size_t size );
+
+    void UnregisterBuffers();
+
+    // Queue requests at an absolute offset. The stream position is not used nor updated.
+    // The tag is returned by Execute() if the request fails.
+    void Read ( FileStream& file, void* buffer, size_t size, int64 offset, uint32 tag = 0 );
+    void Write( FileStream& file, const void* buffer, size_t size, int64 offset, uint32 tag = 0 );
+
+    // Submit all queued requests and wait for all of them to complete. Short reads and writes are resumed.
+    // Returns false if any request failed, with the error and the tag of the first one that failed.
+    // The queue is empty afterwards either way.
+    bool Execute( int& outError, uint32& outTag );
+
+    inline size_t PendingCount() const { return _requests.size(); }
+
+private:
+    struct Request
+    {
+        byte*  buffer;
+        size_t size;
+        int64  offset;
+        int32  fd;
+        uint32 tag;
+        bool   write;
+    };
+
+    void Queue( FileStream& file, byte* buffer, size_t size, int64 offset, uint32 tag, bool write );
+
+    // Index of the registered buffer which fully contains the range, or -1
+    int32 GetBufferIndex( const byte* buffer, size_t size ) const;
+
+private:
+    int32                _ringFd          = -1;
+    uint32               _sqEntries       = 0;
+    uint32               _cqEntries       = 0;
+
+    void*                _sqRing          = nullptr;
+    void*                _cqRing          = nullptr;
+    void*                _sqes            = nullptr;
+    size_t               _sqRingSize      = 0;
+    size_t               _cqRingSize      = 0;
+    size_t               _sqesSize        = 0;
+
+    // Pointers into the mapped rings
+    uint32*              _sqHead          = nullptr;
+    uint32*              _sqTail          = nullptr;
+    uint32*              _sqMask          = nullptr;
+    uint32*              _sqArray         = nullptr;
+    uint32*              _cqHead          = nullptr;
+    uint32*              _cqTail          = nullptr;
+    uint32*              _cqMask          = nullptr;
+    void*                _cqes            = nullptr;
+
+    const byte*          _registeredBase  = nullptr;    // Registered buffer, split into 1 GiB kernel buffers
+    size_t               _registeredSize  = 0;
+
+    std::vector<Request> _requests;
+    std::vector<uint32>  _retries;                      // Requests which were partially completed and must be resubmitted
+};
@@ -1,2 +1,6 @@
 #include "FileStream.h"
 
+#if BB_TEST_MODE
+    size_t FileStream::TestBlockSize = 0;
+#endif
+
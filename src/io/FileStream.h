@@ -68,6 +68,10 @@ public:
     ssize_t Read( void* buffer, size_t size ) override;
     ssize_t Write( const void* buffer, size_t size ) override;
 
+    // Read at an absolute file offset without using or updating the stream position.
+    // Safe to call concurrently from multiple threads on the same file.
+    ssize_t ReadAt( void* buffer, size_t size, int64 offset );
+
     bool Reserve( ssize_t size );
 
     bool Seek( int64 offset, SeekOrigin origin ) override;
@@ -102,8 +106,17 @@ public:
 
     inline intptr_t Id() { return (intptr_t)_fd; }
 
+    // Current stream position, as tracked by Read(), Write() and Seek()
+    inline size_t Position() const { return _position; }
+
     static size_t GetBlockSizeForPath( const char* pathU8 );
 
+    #if BB_TEST_MODE
+        // When not 0, reported as the block size of all files opened after it is set.
+        // Must be a multiple of the real block size. Used to test large-block (ie. RAID) file systems.
+        static size_t TestBlockSize;
+    #endif
+
     // Change name or location of file
     static bool   Move( const char* oldPathU8, const char* newPathU8, int32* outError = nullptr );
 
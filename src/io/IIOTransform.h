@@ -0,0 +1,21 @@
+#pragma once
+
+///
+/// Transforms data on its way to and from a temp file (ie. compresses it).
+/// Data is transformed in units: Each write is encoded on its own and
+/// must be read back whole, with the same size it was written with.
+///
+class IIOTransform
+{
+public:
+    inline virtual ~IIOTransform() {}
+
+    // Encode size bytes of src into dst, which holds at least size bytes.
+    // Only the first dataSize bytes hold meaningful data, the rest (ie. padding) must still be preserved.
+    // Returns the encoded size, or 0 if the data can't be made smaller, in which case it is stored as-is.
+    virtual size_t Encode( const void* src, size_t size, size_t dataSize, void* dst ) = 0;
+
+    // Decode the output of Encode() back into size bytes.
+    // encodedSize may be larger than the size returned by Encode() (ie. padded to the block size).
+    virtual void Decode( const void* src, size_t encodedSize, void* dst, size_t size ) = 0;
+};
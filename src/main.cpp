@@ -16,6 +16,7 @@
 
 static void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, const char* argv[] );
 static void PrintUsage();
+static void PrintHugePageStats();
 
 // See IOTester.cpp
 void IOTestMain( GlobalPlotConfig& gCfg, CliParser& cli );
@@ -25,6 +26,10 @@ void IOTestPrintUsage();
 void MemTestMain( GlobalPlotConfig& gCfg, CliParser& cli );
 void MemTestPrintUsage();
 
+// Benchmarks.cpp
+void BenchMain( GlobalPlotConfig& gCfg, CliParser& cli );
+void BenchPrintUsage();
+
 // PlotValidator.cpp
 void PlotValidatorMain( GlobalPlotConfig& gCfg, CliParser& cli );
 void PlotValidatorPrintUsage();
@@ -105,7 +110,7 @@ int main( int argc, const char* argv[] )
             memcpy( plotOutPath, curOutputDir.data(), curOutputDir.length() );
 
             plotFileName = plotOutPath + curOutputDir.length();
-            PlotTools::GenPlotFileName( plotId, (char*)plotFileName, cfg.compressionLevel );
+            PlotTools::GenPlotFileName( plotId, (char*)plotFileName, cfg.compressionLevel, cfg.k );
         }
 
         // Begin plot
@@ -151,6 +156,7 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
     const char* farmerPublicKey     = nullptr;
     const char* poolPublicKey       = nullptr;
     const char* poolContractAddress = nullptr;
+    const char* hugePages           = nullptr;
 
     outPlotter        = nullptr;
     IPlotter* plotter = nullptr;
@@ -161,6 +167,8 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
             continue;
         else if( cli.ReadU32( cfg.plotCount, "-n", "--count" ) )
             continue;
+        else if( cli.ReadU32( cfg.k, "-k", "--size" ) )
+            continue;
         else if( cli.ReadStr( farmerPublicKey, "-f", "--farmer-key" ) )
             continue;
         else if( cli.ReadStr( poolPublicKey, "-p", "--pool-key" ) )
@@ -191,6 +199,22 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
             continue;
         else if( cli.ReadSwitch( cfg.disableCpuAffinity, "--no-cpu-affinity" ) )
             continue;
+        else if( cli.ReadStr( hugePages, "--huge-pages" ) )
+        {
+            // Applied right away, as commands like bench run before the config is validated
+            HugePageMode mode = HugePageMode::None;
+
+            if( strcmp( hugePages, "thp" ) == 0 )
+                mode = HugePageMode::Transparent;
+            else if( strcmp( hugePages, "2m" ) == 0 )
+                mode = HugePageMode::Pages2MiB;
+            else if( strcmp( hugePages, "1g" ) == 0 )
+                mode = HugePageMode::Pages1GiB;
+            else
+                Fatal( "Invalid huge page mode '%s'. Expected 'thp', '2m' or '1g'.", hugePages );
+
+            FatalIf( !SysHost::SetHugePageMode( mode ), "Huge pages are not supported on this platform." );
+        }
         else if( cli.ReadSwitch( cfg.verbose, "-v", "--verbose" ) )
         {
             Log::SetVerbose( true );
@@ -198,8 +222,7 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
         else if( cli.ArgConsume( "--memory" ) )
         {
             // #TODO: We should move the required part to the memplot command
-            // #TODO: Get this value from Memplotter
-            const size_t requiredMem  = 416ull GB;
+            const size_t requiredMem  = MemPlotter::GetRequiredMemory( 32 );
             const size_t availableMem = SysHost::GetAvailableSystemMemory();
             const size_t totalMem     = SysHost::GetTotalSystemMemory();
 
@@ -211,8 +234,7 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
         }
         else if( cli.ArgConsume( "--memory-json" ) )
         {
-            // #TODO: Get this value from Memplotter
-            const size_t requiredMem  = 416ull GB;
+            const size_t requiredMem  = MemPlotter::GetRequiredMemory( 32 );
             const size_t availableMem = SysHost::GetAvailableSystemMemory();
             const size_t totalMem     = SysHost::GetTotalSystemMemory();
 
@@ -249,6 +271,7 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
         {
             // #TODO: Remove when fixed
             FatalIf( cfg.compressionLevel > 0, "diskplot is currently disabled for compressed plotting due to a bug." );
+            FatalIf( cfg.k != 32, "diskplot currently only supports k32 plots. Use ramplot for other k values." );
 
             plotter = new DiskPlotter();
             
@@ -281,6 +304,7 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
     #if BB_CUDA_ENABLED
         else if( cli.ArgConsume( "cudaplot" ) )
         {
+            FatalIf( cfg.k != 32, "cudaplot currently only supports k32 plots." );
             plotter = new CudaK32Plotter();
             break;
         }
@@ -295,6 +319,11 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
             MemTestMain( cfg, cli );
             Exit( 0 );
         }
+        else if( cli.ArgConsume( "bench" ) )
+        {
+            BenchMain( cfg, cli );
+            Exit( 0 );
+        }
         else if( cli.ArgConsume( "validate" ) )
         {
             PlotValidatorMain( cfg, cli );
@@ -327,7 +356,11 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
                 if( cli.ArgMatch( "diskplot" ) )
                     DiskPlotter::PrintUsage();
                 else if( cli.ArgMatch( "ramplot" ) )
-                    Log::Line( "bladebit -f ... -p/c ... ramplot <out_dirs>" );
+                {
+                    Log::Line( "bladebit -f ... -p/c ... ramplot [--numa-local] <out_dirs>" );
+                    Log::Line( "" );
+                    Log::Line( " --numa-local    : Place each table slice on the NUMA node of the threads that process it." );
+                }
             #if BB_CUDA_ENABLED
                 else if( cli.ArgMatch( "cudaplot" ) )
                     CudaK32PlotterPrintHelp();
@@ -336,6 +369,8 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
                     IOTestPrintUsage();
                 else if( cli.ArgMatch( "memtest" ) )
                     MemTestPrintUsage();
+                else if( cli.ArgMatch( "bench" ) )
+                    BenchPrintUsage();
                 else if( cli.ArgMatch( "validate" ) )
                     PlotValidatorPrintUsage();
                 else if( cli.ArgMatch( "plotcmp" ) )
@@ -389,6 +424,10 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
         Fatal( "Error: Either a pool public key or a pool contract address must be specified." );
 
 
+    FatalIf( cfg.k < BB_CHIA_K_MIN_VALUE || cfg.k > 32, "Unsupported plot size k%u. Please specify a k value between %u and 32 (inclusive).",
+             cfg.k, (uint32)BB_CHIA_K_MIN_VALUE );
+    FatalIf( cfg.k != 32 && cfg.compressionLevel > 0, "Compressed plots are currently only supported for k32." );
+
     // FatalIf( cfg.compressionLevel > 7, "Invalid compression level. Please specify a compression level between 0 and 7 (inclusive)." );
     FatalIf( cfg.compressionLevel > 9, "Invalid compression level. Please specify a compression level between 0 and 9 (inclusive)." );
     // If making compressed plots, get thr compression CTable, etc.
@@ -463,10 +502,12 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
     else
         Log::Line( " Will create %u plots.", cfg.plotCount );
 
+    Log::Line( " K size                : %u", cfg.k );
     Log::Line( " Thread count          : %d", cfg.threadCount );
     Log::Line( " Warm start enabled    : %s", cfg.warmStart ? "true" : "false" );
     Log::Line( " NUMA disabled         : %s", cfg.disableNuma ? "true" : "false" );
     Log::Line( " CPU affinity disabled : %s", cfg.disableCpuAffinity ? "true" : "false" );
+    Log::Line( " Huge pages            : %s", hugePages ? hugePages : "disabled" );
 
     Log::Line( " Farmer public key     : %s", farmerPublicKey );
 
@@ -522,12 +563,32 @@ void ParseCommandLine( GlobalPlotConfig& cfg, IPlotter*& outPlotter, int argc, c
     // Initialize plotter
     plotter->Init();
 
+    if( SysHost::GetHugePageMode() != HugePageMode::None )
+        PrintHugePageStats();
+
     Log::Line( "" );
 
     outPlotter = plotter;
 }
 
 
+//-----------------------------------------------------------
+void PrintHugePageStats()
+{
+    const HugePageStats stats = SysHost::GetHugePageStats();
+
+    Log::Line( "Huge page allocations:" );
+    Log::Line( " 1 GiB pages           : %.2lf GiB", (double)stats.pages1GiB   BtoGB );
+    Log::Line( " 2 MiB pages           : %.2lf GiB", (double)stats.pages2MiB   BtoGB );
+    Log::Line( " Transparent (advised) : %.2lf GiB", (double)stats.transparent BtoGB );
+
+    // Transparent huge pages are only assigned as pages are faulted
+    if( stats.transparent )
+        Log::Line( " Transparent (in use)  : %.2lf GiB", (double)stats.transparentBacked BtoGB );
+
+    Log::Line( " Regular pages         : %.2lf GiB", (double)stats.regular BtoGB );
+}
+
 //-----------------------------------------------------------
 static const char* USAGE = "bladebit [GLOBAL_OPTIONS] <command> [COMMAND_OPTIONS]\n"
 R"(
@@ -537,6 +598,7 @@ R"(
  ramplot    : Create a plot completely in-ram.
  iotest     : Perform a write and read test on a specified disk.
  memtest    : Perform a memory (RAM) copy test.
+ bench      : Run a microbenchmark of a plotting kernel.
  validate   : Validates all entries in a plot to ensure they all evaluate to a valid proof.
  simulate   : Simulation tool useful for compressed plot capacity.
  check      : Check and validate random proofs in a plot.
@@ -550,6 +612,10 @@ R"(
 
  -n, --count          : Number of plots to create. Default = 1.
 
+ -k, --size           : Size (k) of the plots to create. Default = 32.
+                        Values from 18 to 32 (inclusive) are supported by ramplot.
+                        Other plotters and compressed plots only support k32.
+
  -f, --farmer-key     : Farmer public key, specified in hexadecimal format.
                         *REQUIRED*
 
@@ -593,6 +659,15 @@ R"(
                         instances of Bladebit as you can manually
                         assign thread affinity yourself when launching Bladebit.
 
+ --huge-pages <mode>  : Back large buffer allocations with huge pages, to reduce TLB misses. (Linux only)
+                        thp: Advise the kernel to use transparent huge pages.
+                        2m : Use 2 MiB pages from the hugetlbfs pool, or thp if unavailable.
+                        1g : Use 1 GiB pages from the hugetlbfs pool, or 2m if unavailable.
+                        Explicit pages must be reserved beforehand.
+                        Ex: sysctl vm.nr_hugepages=<2 MiB page count>
+                        The memory obtained with each kind of page is reported.
+                        Combine with -w to fault the pages in before plotting.
+
  --memory             : Display system memory available, in bytes, and the 
                         required memory to run Bladebit, in bytes.
 
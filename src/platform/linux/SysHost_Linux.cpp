@@ -24,6 +24,31 @@
 
 std::atomic<bool> _crashed = false;
 
+#ifndef MAP_HUGE_SHIFT
+    #define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+    #define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+    #define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+static constexpr size_t HUGE_PAGE_2MIB = 2ull MiB;
+static constexpr size_t HUGE_PAGE_1GIB = 1ull GiB;
+
+static std::atomic<HugePageMode> _hugePageMode          = HugePageMode::None;
+static std::atomic<size_t>       _hugePageBytes1GiB     = 0;
+static std::atomic<size_t>       _hugePageBytes2MiB     = 0;
+static std::atomic<size_t>       _hugePageBytesTHP      = 0;
+static std::atomic<size_t>       _hugePageBytesRegular  = 0;
+
+static void* MapHugePages( size_t& size, HugePageMode mode, size_t pageSize );
+
+#if BB_NUMA_ENABLED
+    static long BindMemory( void* ptr, size_t size, int policy, const unsigned long* mask, unsigned long maxNode );
+#endif
+
 
 //-----------------------------------------------------------
 size_t SysHost::GetPageSize()
@@ -52,7 +77,7 @@ size_t SysHost::GetAvailableSystemMemory()
  }
 
 //-----------------------------------------------------------
-void* SysHost::VirtualAlloc( size_t size, bool initialize )
+void* SysHost::VirtualAlloc( size_t size, bool initialize, bool explicitHugePages )
 {
     // Align size to page boundary
     const size_t pageSize = GetPageSize();
@@ -63,11 +88,23 @@ void* SysHost::VirtualAlloc( size_t size, bool initialize )
     // Add one page to store our size (yup a whole page for it...)
     size += pageSize;
 
-    void* ptr = mmap( NULL, size, 
-        PROT_READ | PROT_WRITE, 
-        MAP_ANONYMOUS | MAP_PRIVATE,
-        -1, 0
-    );
+    void* ptr = MAP_FAILED;
+
+    HugePageMode hugePageMode = _hugePageMode.load( std::memory_order_relaxed );
+    if( !explicitHugePages )
+        hugePageMode = std::min( hugePageMode, HugePageMode::Transparent );
+
+    if( hugePageMode != HugePageMode::None && size >= HUGE_PAGE_2MIB )
+        ptr = MapHugePages( size, hugePageMode, pageSize );
+
+    if( ptr == MAP_FAILED )
+    {
+        ptr = mmap( NULL, size, 
+            PROT_READ | PROT_WRITE, 
+            MAP_ANONYMOUS | MAP_PRIVATE,
+            -1, 0
+        );
+    }
 
     if( ptr == MAP_FAILED )
     {
@@ -114,6 +151,128 @@ void SysHost::VirtualFree( void* ptr )
     munmap( realPtr, size );
 }
 
+// Explicit huge pages are only used when rounding up to them wastes at most 1/16th of the allocation.
+// Explicit pages are reserved when mapping, so a failure here means the hugetlbfs pool is too small.
+// On success, size is set to the size of the mapping.
+//-----------------------------------------------------------
+void* MapHugePages( size_t& size, const HugePageMode mode, const size_t pageSize )
+{
+    struct ExplicitPages { HugePageMode minMode; size_t pageSize; int flags; std::atomic<size_t>* bytes; };
+
+    const ExplicitPages explicitPages[] = {
+        { HugePageMode::Pages1GiB, HUGE_PAGE_1GIB, MAP_HUGE_1GB, &_hugePageBytes1GiB },
+        { HugePageMode::Pages2MiB, HUGE_PAGE_2MIB, MAP_HUGE_2MB, &_hugePageBytes2MiB },
+    };
+
+    const size_t userSize = size - pageSize;
+
+    for( const ExplicitPages& pages : explicitPages )
+    {
+        if( mode < pages.minMode )
+            continue;
+
+        const size_t hugeSize = RoundUpToNextBoundaryT( userSize, pages.pageSize );
+        if( hugeSize - userSize > userSize / 16 )
+            continue;
+
+        // The user region must start at a huge page boundary, as mbind() and mprotect() can't split huge pages.
+        // Reserve room to align it, then map the huge pages over it and keep a regular page before it for our size.
+        const size_t reserveSize = hugeSize + pages.pageSize;
+
+        byte* reserved = (byte*)mmap( NULL, reserveSize, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0 );
+        if( reserved == MAP_FAILED )
+            break;
+
+        byte* user = (byte*)RoundUpToNextBoundaryT( (uintptr_t)reserved + pageSize, (uintptr_t)pages.pageSize );
+        byte* ptr  = user - pageSize;
+
+        if( mmap( user, hugeSize, PROT_READ | PROT_WRITE,
+                  MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED | MAP_HUGETLB | pages.flags, -1, 0 ) == MAP_FAILED ||
+            mprotect( ptr, pageSize, PROT_READ | PROT_WRITE ) != 0 )
+        {
+            munmap( reserved, reserveSize );
+            continue;
+        }
+
+        const size_t headSize = (size_t)( ptr - reserved );
+        const size_t tailSize = reserveSize - headSize - pageSize - hugeSize;
+
+        if( headSize ) munmap( reserved, headSize );
+        if( tailSize ) munmap( user + hugeSize, tailSize );
+
+        size = pageSize + hugeSize;
+        *pages.bytes += hugeSize;
+        return ptr;
+    }
+
+    // Transparent huge pages. Over-allocate so that the user region, which follows
+    // our size page, can start at a huge page boundary, then trim the excess.
+    const size_t reserveSize = size + HUGE_PAGE_2MIB;
+
+    byte* reserved = (byte*)mmap( NULL, reserveSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0 );
+    if( reserved == MAP_FAILED )
+        return MAP_FAILED;
+
+    byte* user = (byte*)RoundUpToNextBoundaryT( (uintptr_t)reserved + pageSize, (uintptr_t)HUGE_PAGE_2MIB );
+    byte* ptr  = user - pageSize;
+
+    const size_t headSize = (size_t)( ptr - reserved );
+    const size_t tailSize = reserveSize - headSize - size;
+
+    if( headSize ) munmap( reserved, headSize );
+    if( tailSize ) munmap( ptr + size, tailSize );
+
+    if( madvise( user, size - pageSize, MADV_HUGEPAGE ) == 0 )
+        _hugePageBytesTHP += size;
+    else
+        _hugePageBytesRegular += size;
+
+    return ptr;
+}
+
+//-----------------------------------------------------------
+bool SysHost::SetHugePageMode( const HugePageMode mode )
+{
+    _hugePageMode = mode;
+    return true;
+}
+
+//-----------------------------------------------------------
+HugePageMode SysHost::GetHugePageMode()
+{
+    return _hugePageMode;
+}
+
+//-----------------------------------------------------------
+HugePageStats SysHost::GetHugePageStats()
+{
+    HugePageStats stats = {};
+    stats.pages1GiB   = _hugePageBytes1GiB;
+    stats.pages2MiB   = _hugePageBytes2MiB;
+    stats.transparent = _hugePageBytesTHP;
+    stats.regular     = _hugePageBytesRegular;
+
+    // Whether transparent huge pages were actually obtained is only known once pages are faulted
+    FILE* file = fopen( "/proc/self/smaps_rollup", "r" );
+    if( file )
+    {
+        char line[256];
+        while( fgets( line, sizeof( line ), file ) )
+        {
+            unsigned long long kib = 0;
+            if( sscanf( line, "AnonHugePages: %llu kB", &kib ) == 1 )
+            {
+                stats.transparentBacked = (size_t)kib * 1024;
+                break;
+            }
+        }
+
+        fclose( file );
+    }
+
+    return stats;
+}
+
 //-----------------------------------------------------------
 bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
 {
@@ -378,7 +537,21 @@ const NumaInfo* SysHost::GetNUMAInfo()
 void SysHost::NumaAssignPages( void* ptr, size_t size, uint node )
 {
 #if BB_NUMA_ENABLED
-    numa_tonode_memory( ptr, size, (int)node );
+    const size_t MASK_SIZE = 128;
+    unsigned long mask[MASK_SIZE] = {};
+
+    ASSERT( node < MASK_SIZE * 64 );
+    mask[node / 64] = 1ul << ( node % 64 );
+
+    // Same as numa_tonode_memory(), which doesn't handle explicit huge pages
+    const int maxPossibleNodes = numa_num_possible_nodes();
+    long r = BindMemory( ptr, size, MPOL_BIND, mask, (unsigned long)maxPossibleNodes + 1 );
+
+    if( r )
+    {
+        int err = errno;
+        Log::Error( "Warning: mbind() failed with error %d (0x%x).", err, err );
+    }
 #endif
 }
 
@@ -426,7 +599,7 @@ bool SysHost::NumaSetMemoryInterleavedMode( void* ptr, size_t size )
     const int maxPossibleNodes = numa_num_possible_nodes();
     ASSERT( (MASK_SIZE * 64) >= (size_t)maxPossibleNodes );
 
-    long r = mbind( ptr, size, MPOL_INTERLEAVE, mask, maxPossibleNodes, 0 ); 
+    long r = BindMemory( ptr, size, MPOL_INTERLEAVE, mask, maxPossibleNodes );
     
     #if _DEBUG
     if( r )
@@ -440,6 +613,38 @@ bool SysHost::NumaSetMemoryInterleavedMode( void* ptr, size_t size )
 #endif // BB_NUMA_ENABLED
 }
 
+#if BB_NUMA_ENABLED
+// mbind() fails with EINVAL on ranges that split explicit huge pages. Our explicit huge page regions
+// start at a huge page boundary and span whole huge pages, so such ranges are widened to the huge pages
+// they touch. Huge pages shared by 2 ranges keep the policy of the last call.
+//-----------------------------------------------------------
+long BindMemory( void* ptr, const size_t size, const int policy, const unsigned long* mask, const unsigned long maxNode )
+{
+    long r = mbind( ptr, size, policy, mask, maxNode, 0 );
+
+    const struct { size_t pageSize; const std::atomic<size_t>& bytes; } explicitPages[] = {
+        { HUGE_PAGE_2MIB, _hugePageBytes2MiB },
+        { HUGE_PAGE_1GIB, _hugePageBytes1GiB },
+    };
+
+    for( auto& pages : explicitPages )
+    {
+        if( r == 0 || errno != EINVAL )
+            break;
+
+        if( pages.bytes == 0 )
+            continue;
+
+        const uintptr_t start = (uintptr_t)ptr / pages.pageSize * pages.pageSize;
+        const uintptr_t end   = RoundUpToNextBoundaryT( (uintptr_t)ptr + size, (uintptr_t)pages.pageSize );
+
+        r = mbind( (void*)start, end - start, policy, mask, maxNode, 0 );
+    }
+
+    return r;
+}
+#endif
+
 //-----------------------------------------------------------
 int SysHost::NumaGetNodeFromPage( void* ptr )
 {
@@ -68,7 +68,7 @@ uint SysHost::GetLogicalCPUCount()
 }
 
 //-----------------------------------------------------------
-void* SysHost::VirtualAlloc( size_t size, bool initialize )
+void* SysHost::VirtualAlloc( size_t size, bool initialize, bool explicitHugePages )
 {
     // #TODO: Remove initialize
 
@@ -170,6 +170,25 @@ void SysHost::VirtualFree( void* ptr )
         Log::Line("Warning: vm_deallocate() failed with error %d.", (int32)r );
 }
 
+// Huge pages are not supported on macOS
+//-----------------------------------------------------------
+bool SysHost::SetHugePageMode( const HugePageMode mode )
+{
+    return mode == HugePageMode::None;
+}
+
+//-----------------------------------------------------------
+HugePageMode SysHost::GetHugePageMode()
+{
+    return HugePageMode::None;
+}
+
+//-----------------------------------------------------------
+HugePageStats SysHost::GetHugePageStats()
+{
+    return {};
+}
+
 //-----------------------------------------------------------
 bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
 {
@@ -82,6 +82,11 @@ bool FileStream::Open( const char* path, FileStream& file, FileMode mode, FileAc
         }
 
         ASSERT( blockSize > 0 );
+
+        #if BB_TEST_MODE
+            if( TestBlockSize )
+                blockSize = (int)TestBlockSize;
+        #endif
     }
     
     file._fd            = fd;
@@ -185,6 +190,39 @@ ssize_t FileStream::Read( void* buffer, size_t size )
     return sizeRead;
 }
 
+//-----------------------------------------------------------
+ssize_t FileStream::ReadAt( void* buffer, size_t size, int64 offset )
+{
+    ASSERT( buffer );
+
+    if( buffer == nullptr || offset < 0 )
+    {
+        _error = -1;
+        return -1;
+    }
+
+    if( ! IsFlagSet( _access, FileAccess::Read ) )
+    {
+        _error = -1;
+        return -1;
+    }
+
+    if( _fd < 0 )
+    {
+        _error = -1;
+        return -1;
+    }
+
+    if( size < 1 )
+        return 0;
+
+    const ssize_t sizeRead = pread( _fd, buffer, size, (off_t)offset );
+    if( sizeRead < 0 )
+        _error = errno;
+
+    return sizeRead;
+}
+
 //-----------------------------------------------------------
 ssize_t FileStream::Write( const void* buffer, size_t size )
 {
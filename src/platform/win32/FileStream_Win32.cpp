@@ -71,6 +71,11 @@ bool FileStream::Open( const char* path, FileStream& file, FileMode mode, FileAc
         if( !GetFileClusterSize( fd, blockSize ) )
             Log::Error( "Failed to obtain file block size. Defaulting to %llu, but writes may fail.", blockSize );
 
+        #if BB_TEST_MODE
+            if( TestBlockSize )
+                blockSize = TestBlockSize;
+        #endif
+
         file._fd            = fd;
         file._blockSize     = blockSize;
         file._position      = 0;
@@ -158,6 +163,48 @@ ssize_t FileStream::Read( void* buffer, size_t size )
     return (ssize_t)bytesRead;
 }
 
+//-----------------------------------------------------------
+ssize_t FileStream::ReadAt( void* buffer, size_t size, int64 offset )
+{
+    ASSERT( buffer );
+
+    if( buffer == nullptr || offset < 0 )
+        return -1;
+
+    if( !IsFlagSet( _access, FileAccess::Read ) )
+        return -1;
+
+    if( !HasValidFD() )
+        return -1;
+
+    if( size < 1 )
+        return 0;
+
+    DWORD bytesToRead = size > std::numeric_limits<DWORD>::max() ?
+                               std::numeric_limits<DWORD>::max() : 
+                               (DWORD)size;
+
+    if( IsFlagSet( _flags, FileFlags::NoBuffering ) )
+        bytesToRead = (DWORD)( bytesToRead / _blockSize * _blockSize );
+
+    // #NOTE: On synchronous handles ReadFile() also moves the file pointer,
+    //        so callers must not mix ReadAt() with Read()/Seek() without seeking first.
+    OVERLAPPED overlapped = {};
+    overlapped.Offset     = (DWORD)( (uint64)offset & 0xFFFFFFFF );
+    overlapped.OffsetHigh = (DWORD)( (uint64)offset >> 32 );
+
+    DWORD bytesRead = 0;
+    const BOOL r = ReadFile( _fd, buffer, bytesToRead, &bytesRead, &overlapped );
+    
+    if( !r )
+    {
+        _error = (int)GetLastError();
+        return -1;
+    }
+
+    return (ssize_t)bytesRead;
+}
+
 //-----------------------------------------------------------
 ssize_t FileStream::Write( const void* buffer, size_t size )
 {
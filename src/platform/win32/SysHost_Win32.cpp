@@ -112,7 +112,7 @@ uint SysHost::GetLogicalCPUCount()
 }
 
 //-----------------------------------------------------------
-void* SysHost::VirtualAlloc( size_t size, bool initialize )
+void* SysHost::VirtualAlloc( size_t size, bool initialize, bool explicitHugePages )
 {
     SYSTEM_INFO info;
     ::GetSystemInfo( &info );
@@ -182,6 +182,25 @@ void SysHost::VirtualFree( void* ptr )
     }
 }
 
+// Large pages require the lock memory privilege, which we don't request yet
+//-----------------------------------------------------------
+bool SysHost::SetHugePageMode( const HugePageMode mode )
+{
+    return mode == HugePageMode::None;
+}
+
+//-----------------------------------------------------------
+HugePageMode SysHost::GetHugePageMode()
+{
+    return HugePageMode::None;
+}
+
+//-----------------------------------------------------------
+HugePageStats SysHost::GetHugePageStats()
+{
+    return {};
+}
+
 //-----------------------------------------------------------
 bool SysHost::VirtualProtect( void* ptr, size_t size, VProtect flags )
 {
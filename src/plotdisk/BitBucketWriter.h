@@ -3,6 +3,8 @@
 #include "util/BitView.h"
 
 
+// Writes bit-packed buckets in segments of the file set's write alignment (see DiskBufferQueue::WriteAlignment()),
+// keeping the bits left over for the next write.
 template<uint32 _numBuckets>
 class BitBucketWriter
 {
@@ -13,7 +15,7 @@ class BitBucketWriter
     };
 
     DiskBufferQueue* _queue                          = nullptr;
-    uint64*          _remainderFields  [_numBuckets] = { nullptr };   // Left-over block buffers
+    uint64*          _remainderFields  [_numBuckets] = { nullptr };   // Left-over buffers, one write alignment in size
     uint64           _remainderBitCount[_numBuckets] = { 0 };
     BitBucket        _buckets          [_numBuckets] = { 0 };
     FileId           _fileId                         = FileId::None;
@@ -51,7 +53,7 @@ public:
     //-----------------------------------------------------------
     inline void BeginWriteBuckets( const uint64 bucketBitSizes[_numBuckets] )
     {
-        const size_t fsBlockSize     = _queue->BlockSize( _fileId );
+        const size_t fsBlockSize     = _queue->WriteAlignment( _fileId );
         const size_t fsBlockSizeBits = fsBlockSize * 8;
         ASSERT( fsBlockSize > 0 );
 
@@ -70,7 +72,7 @@ public:
     {
         ASSERT( bucketBuffers );
         
-        const size_t fsBlockSizeBits = _queue->BlockSize( _fileId ) * 8;
+        const size_t fsBlockSizeBits = _queue->WriteAlignment( _fileId ) * 8;
         ASSERT( fsBlockSizeBits > 0 );
 
         // Initialize our BitWriters
@@ -98,7 +100,7 @@ public:
     //-----------------------------------------------------------
     inline void Submit()
     {
-        const size_t fsBlockSize     = _queue->BlockSize( _fileId );
+        const size_t fsBlockSize     = _queue->WriteAlignment( _fileId );
         const size_t fsBlockSizeBits = fsBlockSize * 8;
 
         // Save any overflow bits
@@ -140,7 +142,7 @@ public:
     //-----------------------------------------------------------
     inline void SubmitLeftOvers()
     {
-        const size_t fsBlockSize = _queue->BlockSize( _fileId );
+        const size_t fsBlockSize = _queue->WriteAlignment( _fileId );
         ASSERT( fsBlockSize );
 
         for( uint32 i = 0; i < _numBuckets; i++ )
@@ -172,7 +174,7 @@ private:
     //-----------------------------------------------------------
     inline void SetBlockBuffers( byte* blockBuffers )
     {
-        const size_t fsBlockSize = _queue->BlockSize( _fileId );
+        const size_t fsBlockSize = _queue->WriteAlignment( _fileId );
         ASSERT( fsBlockSize > 0 );
 
         for( uint32 i = 0; i < _numBuckets; i++ )
@@ -1,6 +1,7 @@
 #include "DiskBufferQueue.h"
 #include "io/FileStream.h"
 #include "io/HybridStream.h"
+#include "io/IIOTransform.h"
 #include "plotdisk/DiskPlotConfig.h"
 #include "jobs/IOJob.h"
 #include "util/Util.h"
@@ -19,13 +20,12 @@
 
 //-----------------------------------------------------------
 DiskBufferQueue::DiskBufferQueue( 
-    const char* workDir1, const char* workDir2, const char* plotDir, byte* workBuffer, 
+    Span<const char*> workDirs1, Span<const char*> workDirs2, const char* plotDir, byte* workBuffer, 
     size_t workBufferSize, uint ioThreadCount,
-    int32 threadBindId
+    int32 threadBindId, uint32 ioQueueDepth, const char* tmpFilePrefix, size_t coalesceBufferSize
 )
-    : _workDir1      ( workDir1 )
-    , _workDir2      ( workDir2 )
-    , _plotDir       ( plotDir  )
+    : _plotDir       ( plotDir  )
+    , _tmpFilePrefix ( tmpFilePrefix ? tmpFilePrefix : "" )
     , _workHeap      ( workBufferSize, workBuffer )
     // , _threadPool    ( ioThreadCount, ThreadPool::Mode::Fixed, true )
     , _dispatchThread()
@@ -34,31 +34,61 @@ DiskBufferQueue::DiskBufferQueue(
     , _deleteQueue   ( 128 )
     , _threadBindId  ( threadBindId )
 {
-    ASSERT( workDir1 );
+    ASSERT( workDirs1.Length() );
     ASSERT( plotDir  );
     
-    if( !workDir2 )
-        workDir2 = workDir1;
+    if( workDirs2.Length() == 0 )
+        workDirs2 = workDirs1;
 
     // Initialize path buffers
-    FatalIf( _workDir1.length() < 1, "Working directory path 1 is empty." );
-    FatalIf( _workDir2.length() < 1, "Working directory path 2 is empty." );
+    size_t workDirLen = 0;
+
+    auto initWorkDirs = [&]( std::vector<std::string>& dirs, Span<const char*> paths, const uint32 tmpIdx ) {
+
+        for( size_t i = 0; i < paths.Length(); i++ )
+        {
+            std::string dir = paths[i] ? paths[i] : "";
+            FatalIf( dir.length() < 1, "Working directory path %u is empty.", tmpIdx );
+
+            // Add a trailing slash if we don't have one
+            if( !CheckPathSeparator( dir.back() ) )
+                dir += PATH_SEPA_STR;
+
+            workDirLen = std::max( workDirLen, dir.length() );
+            dirs.push_back( std::move( dir ) );
+        }
+    };
+
+    initWorkDirs( _workDirs1, workDirs1, 1 );
+    initWorkDirs( _workDirs2, workDirs2, 2 );
+
     FatalIf( _plotDir.length()  < 1, "Plot tmp directory is empty." );
 
-    // Add a trailing slash if we don't have one
-    if( !CheckPathSeparator( _workDir1.back() ) )
-        _workDir1 += PATH_SEPA_STR;
-    if( !CheckPathSeparator( _workDir2.back() ) )
-        _workDir2 += PATH_SEPA_STR;
     if( !CheckPathSeparator( _plotDir.back() ) )
         _plotDir += PATH_SEPA_STR;
 
-    const size_t workDirLen = std::max( _workDir1.length(), _workDir2.length() );
+    workDirLen = std::max( workDirLen, _plotDir.length() );
 
     const size_t PLOT_FILE_LEN = sizeof( "/plot-k32-2021-08-05-18-55-77a011fc20f0003c3adcc739b615041ae56351a22b690fd854ccb6726e5f43b7.plot.tmp" );
 
-    _filePathBuffer    = bbmalloc<char>( workDirLen + PLOT_FILE_LEN );  // Should be enough for all our file names
-    _delFilePathBuffer = bbmalloc<char>( workDirLen + PLOT_FILE_LEN );
+    _filePathBuffer    = bbmalloc<char>( workDirLen + _tmpFilePrefix.length() + PLOT_FILE_LEN );  // Should be enough for all our file names
+    _delFilePathBuffer = bbmalloc<char>( workDirLen + _tmpFilePrefix.length() + PLOT_FILE_LEN );
+
+    // Use io_uring when available, otherwise I/O blocks on each read and write
+    if( ioQueueDepth > 0 )
+        _ioBatch.Init( ioQueueDepth );
+
+    // Bucket files are striped across the directories, but without io_uring a single
+    // thread reads and writes them one at a time, so the directories are never busy together.
+    if( !_ioBatch.IsValid() && ( _workDirs1.size() > 1 || _workDirs2.size() > 1 ) )
+    {
+        Log::Line( "Warning: Multiple temp directories are used without io_uring (%s). Their I/O will not overlap.",
+            ioQueueDepth > 0 ? "not supported by this system" : "--io-depth 0" );
+    }
+    else if( _ioBatch.IsValid() )
+        InitDirWriters( ioQueueDepth );
+
+    _coalesceBufferSize = coalesceBufferSize;
 
     // Initialize file deleter thread
     _deleterThread.Run( DeleterThreadMain, this );
@@ -74,11 +104,32 @@ DiskBufferQueue::~DiskBufferQueue()
     _deleteSignal.Signal();
     _deleterThread.WaitForExit();
 
+    // Writers finish their queued writes before exiting
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        _dirWriters[i].exit = true;
+        _dirWriters[i].readySignal.Signal();
+        _dirWriters[i].thread.WaitForExit();
+    }
+    delete[] _dirWriters;
+
     // #TODO: Wait for command thread
     // #TODO: Delete our file sets
 
     free( _filePathBuffer    );
     free( _delFilePathBuffer );
+
+    for( FileSet& fileSet : _files )
+        ReleaseTransform( fileSet );
+
+    if( _ioBatchBlocks )
+        bbvirtfree( _ioBatchBlocks );
+
+    if( _transformBuffer )
+        bbvirtfree( _transformBuffer );
+
+    if( _coalesceBuffer )
+        bbvirtfree( _coalesceBuffer );
 }
 
 //-----------------------------------------------------------
@@ -88,6 +139,21 @@ size_t DiskBufferQueue::BlockSize( FileId fileId ) const
     return _files[(int)fileId].files[0]->BlockSize();
 }
 
+//-----------------------------------------------------------
+size_t DiskBufferQueue::GetWriteAlignment( const size_t blockSize, const FileSetOptions options )
+{
+    if( IsFlagSet( options, FileSetOptions::BlockAlign ) && blockSize >= CoalesceMinBlockSize )
+        return sizeof( uint64 );
+
+    return blockSize;
+}
+
+//-----------------------------------------------------------
+size_t DiskBufferQueue::WriteAlignment( FileId fileId ) const
+{
+    return GetWriteAlignment( BlockSize( fileId ), _files[(int)fileId].options );
+}
+
 //-----------------------------------------------------------
 void DiskBufferQueue::ResetHeap( const size_t heapSize, void* heapBuffer )
 {
@@ -104,14 +170,8 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
 bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketCount, const FileSetOptions options, const FileSetInitData* optsData )
 {
     const bool isPlotFile = fileId == FileId::PLOT;
-    const bool useTmp2    = IsFlagSet( options, FileSetOptions::UseTemp2 );
-
-    const std::string& wokrDir = isPlotFile ? _plotDir :
-                                    useTmp2 ? _workDir2 : _workDir1;
-    memcpy( _filePathBuffer, wokrDir.c_str(), wokrDir.length() );
 
     const char* pathBuffer = _filePathBuffer;
-          char* baseName   = _filePathBuffer + wokrDir.length();
 
     FileFlags flags = FileFlags::LargeFile;
     if( IsFlagSet( options, FileSetOptions::DirectIO ) )
@@ -148,6 +208,11 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
             ASSERT( fileSet.maxSliceSize );
         }
     }
+    else
+    {
+        // The transform belongs to the previous user of the file set, which sets it again if needed
+        ReleaseTransform( fileSet );
+    }
 
     const bool isCachable = IsFlagSet( options, FileSetOptions::Cachable ) && optsData->cacheSize > 0;
     ASSERT( !isCachable || optsData );
@@ -164,6 +229,12 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
     {
         IStream* file = fileSet.files[i];
 
+        // Each bucket may be in a different directory
+        const std::string& wokrDir = isPlotFile ? _plotDir : GetWorkDir( fileId, i );
+        memcpy( _filePathBuffer, wokrDir.c_str(), wokrDir.length() );
+
+        char* baseName = _filePathBuffer + wokrDir.length();
+
         if( !file )
         {
             if( isCachable )
@@ -183,7 +254,7 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
         #endif
 
         if( !isPlotFile )
-            sprintf( baseName, "%s_%u.tmp", name, i );
+            sprintf( baseName, "%s%s_%u.tmp", _tmpFilePrefix.c_str(), name, i );
         else
         {
             sprintf( baseName, "%s", name );
@@ -204,6 +275,10 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
         else
             opened = static_cast<FileStream*>( file )->Open( pathBuffer, fileMode, FileAccess::ReadWrite, flags );
 
+        // Anything written through a transform or staged before is gone now
+        ClearTransformFrames( fileSet, i );
+        FlushCoalescedFile( fileSet, i, true, true );
+
         if( !opened )
         {
             // Allow plot file to fail opening
@@ -226,13 +301,53 @@ bool DiskBufferQueue::InitFileSet( FileId fileId, const char* name, uint bucketC
         }
     }
 
+    // Coalesce writes only where aligning them would be costly
+    if( IsFlagSet( fileSet.options, FileSetOptions::BlockAlign ) )
+    {
+        ASSERT( !IsFlagSet( fileSet.options, FileSetOptions::Interleaved ) && !IsFlagSet( fileSet.options, FileSetOptions::Alternating ) );
+        ASSERT( !IsFlagSet( fileSet.options, FileSetOptions::Cachable ) );
+
+        const size_t blockSize = fileSet.files[0]->BlockSize();
+
+        if( GetWriteAlignment( blockSize, fileSet.options ) == blockSize )
+            UnSetFlag( fileSet.options, FileSetOptions::BlockAlign );
+        else if( !fileSet.coalesceExtents.Ptr() )
+        {
+            InitWriteCoalescing();
+            FatalIf( _coalesceExtentSize % blockSize != 0, "Block size of %s files (%llu) is not supported for coalesced writes.",
+                name, (llu)blockSize );
+
+            fileSet.coalesceExtents.SetTo( new int32[bucketCount], bucketCount );
+            fileSet.coalesceTails  .SetTo( new size_t[bucketCount]{}, bucketCount );
+
+            for( uint32 i = 0; i < bucketCount; i++ )
+                fileSet.coalesceExtents[i] = -1;
+        }
+    }
+
     return true;
 }
 
 //-----------------------------------------------------------
 void DiskBufferQueue::SetTransform( FileId fileId, IIOTransform& transform )
 {
-    // _files[(int)fileId].transform = &transform;
+    FileSet& fileSet = _files[(int)fileId];
+    ASSERT( fileSet.name );
+    ASSERT( IsFlagSet( fileSet.options, FileSetOptions::Interleaved ) || IsFlagSet( fileSet.options, FileSetOptions::Alternating ) );
+
+    // Cached file sets are (mostly) kept in memory, there's nothing to gain from transforming them
+    if( IsFlagSet( fileSet.options, FileSetOptions::Cachable ) )
+        return;
+
+    const uint32 bucketCount = (uint32)fileSet.files.Length();
+
+    if( !fileSet.transformFrames.Ptr() )
+    {
+        fileSet.transformFrames.SetTo( new std::map<int64, TransformFrame>[bucketCount], bucketCount );
+        fileSet.transformCarry .SetTo( new size_t[bucketCount]{}, bucketCount );
+    }
+
+    fileSet.transform = &transform;
 }
 
 //-----------------------------------------------------------
@@ -602,7 +717,12 @@ void DiskBufferQueue::CommandMain()
             _cmdConsumedSignal.Signal();
 
             for( int i = 0; i < cmdCount; i++ )
+            {
+                if( _dirWriterCount && OrderWithDirWrites( commands[i] ) )
+                    continue;
+
                 ExecuteCommand( commands[i] );
+            }
         }
     }
 }
@@ -656,6 +776,8 @@ void DiskBufferQueue::ExecuteCommand( Command& cmd )
             #if DBG_LOG_ENABLE
                 Log::Debug( "[DiskBufferQueue] ^ Cmd SeekFile: (%u) bucket:%u offset:%lld origin:%ld", cmd.seek.fileId, cmd.seek.bucket, cmd.seek.offset, (int)cmd.seek.origin );
             #endif
+                FlushCoalescedFile( _files[(uint)cmd.seek.fileId], cmd.seek.bucket, false, true );
+
                 if( !_files[(uint)cmd.seek.fileId].files[cmd.seek.bucket]->Seek( cmd.seek.offset, cmd.seek.origin ) )
                 {
                     int err = _files[(uint)cmd.seek.fileId].files[cmd.seek.bucket]->GetError();
@@ -746,6 +868,7 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
     const uint*  sizes   = cmd.buckets.writeSizes;
     const byte*  buffers = cmd.buckets.buffers;
     FileSet&     fileSet = _files[(int)fileId];
+    ASSERT( !fileSet.coalesceExtents.Ptr() );   // Coalesced file sets can only be written one file at a time
 
     // ASSERT( IsFlagSet( fileBuckets.files[0]->GetFileAccess(), FileAccess::ReadWrite ) );
 
@@ -755,6 +878,8 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
 
     // Single-threaded for now... We don't have file handles for all the threads yet!
     const size_t blockSize = fileSet.files[0]->BlockSize();
+    const bool   useBatch      = UseIOBatch( fileSet );
+    const bool   useDirWriters = UseDirWriters( fileSet );
     
     const byte* buffer = buffers;
 
@@ -780,7 +905,11 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
         ASSERT( writeSize / blockSize * blockSize == writeSize );
         ASSERT( fileSet.writeBucket < fileSet.files.Length() );
 
-        if( IsFlagSet( fileSet.options, FileSetOptions::Alternating ) )
+        if( fileSet.transform )
+        {
+            WriteBucketsTransformed( fileSet, cmd, elementSize, useBatch );
+        }
+        else if( IsFlagSet( fileSet.options, FileSetOptions::Alternating ) )
         {
             const bool interleaved = cmd.buckets.interleaved;
 
@@ -797,25 +926,52 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
                 const uint32   fileBucketIdx  = interleaved ? fileSet.writeBucket : slice;
                       IStream& file           = *fileSet.files[fileBucketIdx];
 
-                // Seek to the start of the (fixed-size) slice boundary
-                {
-                    const uint32 sliceSeekIdx = interleaved ? slice : fileSet.writeBucket;
-                    const int64  sliceOffset  = (int64)( sliceSeekIdx * maxSliceSize );
+                const uint32 sliceSeekIdx = interleaved ? slice : fileSet.writeBucket;
+                const int64  sliceOffset  = (int64)( sliceSeekIdx * maxSliceSize );
 
-                    FatalIf( !file.Seek( sliceOffset, SeekOrigin::Begin ),
-                        "Failed to seek file %s.%u.tmp to slice boundary.", fileSet.name, fileBucketIdx );
+                if( useDirWriters )
+                {
+                    QueueDirWrite( fileId, fileBucketIdx, buffer, sliceWriteSize, sliceOffset );
+                    buffer += sliceWriteSize;
+                    continue;
                 }
+                
+                if( useBatch )
+                {
+                    BatchWrite( fileSet, fileBucketIdx, buffer, sliceWriteSize, sliceOffset );
+                    buffer += sliceWriteSize;
+                    continue;
+                }
+
+                // Seek to the start of the (fixed-size) slice boundary
+                FatalIf( !file.Seek( sliceOffset, SeekOrigin::Begin ),
+                    "Failed to seek file %s.%u.tmp to slice boundary.", fileSet.name, fileBucketIdx );
 
                 WriteToFile( file, sliceWriteSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, fileBucketIdx );
 
                 buffer += sliceWriteSize;
             }
         }
+        else if( useDirWriters )
+        {
+            FileStream& file = *static_cast<FileStream*>( fileSet.files[fileSet.writeBucket] );
+            QueueDirWrite( fileId, fileSet.writeBucket, buffer, writeSize, (int64)file.Position() );
+        }
+        else if( useBatch )
+        {
+            FileStream& file = *static_cast<FileStream*>( fileSet.files[fileSet.writeBucket] );
+            BatchWrite( fileSet, fileSet.writeBucket, buffer, writeSize, (int64)file.Position() );
+        }
         else
         {
             WriteToFile( *fileSet.files[fileSet.writeBucket], writeSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, fileSet.writeBucket );
         }
 
+        if( useDirWriters )
+            SubmitDirWrites();
+        else if( useBatch )
+            ExecuteIOBatch( fileSet, true );
+
         if( ++fileSet.writeBucket >= bucketCount )
         {
             ASSERT( fileSet.writeBucket <= fileSet.files.Length() );
@@ -833,11 +989,21 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
 
             // Only write up-to the block-aligned boundary. The caller is in charge of handling unlaigned data.
             ASSERT( bufferSize == bufferSize / blockSize * blockSize );
-            WriteToFile( *fileSet.files[i], bufferSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, i );
+            if( useDirWriters )
+                QueueDirWrite( fileId, i, buffer, bufferSize, (int64)static_cast<FileStream*>( fileSet.files[i] )->Position() );
+            else if( useBatch )
+                BatchWrite( fileSet, i, buffer, bufferSize, (int64)static_cast<FileStream*>( fileSet.files[i] )->Position() );
+            else
+                WriteToFile( *fileSet.files[i], bufferSize, buffer, (byte*)fileSet.blockBuffer, fileSet.name, i );
 
             // ASSERT( IsFlagSet( fileBuckets.files[i].GetFileAccess(), FileAccess::ReadWrite ) );
             buffer += bufferSize;
         }
+
+        if( useDirWriters )
+            SubmitDirWrites();
+        else if( useBatch )
+            ExecuteIOBatch( fileSet, true );
     }
 }
 
@@ -845,7 +1011,18 @@ void DiskBufferQueue::CmdWriteBuckets( const Command& cmd, const size_t elementS
 void DiskBufferQueue::CndWriteFile( const Command& cmd )
 {
     FileSet& fileBuckets = _files[(int)cmd.file.fileId];
-    WriteToFile( *fileBuckets.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileBuckets.blockBuffer, fileBuckets.name, cmd.file.bucket );
+    ASSERT( !fileBuckets.transform );   // Transformed file sets can only be written in buckets
+
+    if( fileBuckets.coalesceExtents.Ptr() )
+        CoalesceWrite( fileBuckets, cmd.file.bucket, cmd.file.buffer, cmd.file.size );
+    else if( UseDirWriters( fileBuckets ) )
+    {
+        FileStream& file = *static_cast<FileStream*>( fileBuckets.files[cmd.file.bucket] );
+        QueueDirWrite( cmd.file.fileId, cmd.file.bucket, cmd.file.buffer, cmd.file.size, (int64)file.Position() );
+        SubmitDirWrites();
+    }
+    else
+        WriteToFile( *fileBuckets.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileBuckets.blockBuffer, fileBuckets.name, cmd.file.bucket );
 }
 
 //-----------------------------------------------------------
@@ -855,6 +1032,7 @@ void DiskBufferQueue::CmdReadBucket( const Command& cmd )
     const size_t elementSize = cmd.readBucket.elementSize;
     FileSet&     fileSet     = _files[(int)fileId];
     const uint32 bucketCount = (uint32)fileSet.files.Length();
+    ASSERT( !fileSet.coalesceExtents.Ptr() );   // Coalesced file sets can only be read one file at a time
 
     const bool alternating               = IsFlagSet( fileSet.options, FileSetOptions::Alternating );
     const bool alternatingNonInterleaved = alternating && !cmd.readBucket.interleaved;
@@ -894,48 +1072,55 @@ void DiskBufferQueue::CmdReadBucket( const Command& cmd )
 
     const uint64 maxSliceSize = fileSet.maxSliceSize;
 
-    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    if( fileSet.transform )
+        ReadBucketSlicesTransformed( fileSet, readBuffer.Ptr(), alternating, alternatingNonInterleaved, UseIOBatch( fileSet ) );
+    else if( UseIOBatch( fileSet ) )
+        ReadBucketSlicesBatched( fileSet, readBuffer.Ptr(), alternating, alternatingNonInterleaved );
+    else
     {
-        const size_t   sliceSize     = sliceSizes[slice][fileSet.readBucket];
-        const size_t   readSize      = sliceSize + tempBlock.Length();
-        const size_t   alignedSize   = CDivT( readSize, blockSize ) * blockSize;   // Sizes are written aligned, and must also be read aligned
+        for( uint32 slice = 0; slice < bucketCount; slice++ )
+        {
+            const size_t   sliceSize     = sliceSizes[slice][fileSet.readBucket];
+            const size_t   readSize      = sliceSize + tempBlock.Length();
+            const size_t   alignedSize   = CDivT( readSize, blockSize ) * blockSize;   // Sizes are written aligned, and must also be read aligned
 
-        const uint32   fileBucketIdx = alternatingNonInterleaved ? fileSet.readBucket : slice;
-              IStream& stream        = *fileSet.files[fileBucketIdx];
+            const uint32   fileBucketIdx = alternatingNonInterleaved ? fileSet.readBucket : slice;
+                  IStream& stream        = *fileSet.files[fileBucketIdx];
 
-        // When alternating, we need to seek to the start of the slice boundary
-        if( alternating )
-        {
-            const uint32 sliceOffsetIdx = alternatingNonInterleaved ? slice : fileSet.readBucket;
-            const int64  sliceOffset    = (int64)( sliceOffsetIdx * maxSliceSize );
+            // When alternating, we need to seek to the start of the slice boundary
+            if( alternating )
+            {
+                const uint32 sliceOffsetIdx = alternatingNonInterleaved ? slice : fileSet.readBucket;
+                const int64  sliceOffset    = (int64)( sliceOffsetIdx * maxSliceSize );
 
-            FatalIf( !stream.Seek( sliceOffset, SeekOrigin::Begin ), 
-                "Failed to seek while reading alternating bucket %s.%u.tmp.", fileSet.name, fileBucketIdx );
-        }
+                FatalIf( !stream.Seek( sliceOffset, SeekOrigin::Begin ), 
+                    "Failed to seek while reading alternating bucket %s.%u.tmp.", fileSet.name, fileBucketIdx );
+            }
 
-        ReadFromFile( stream, alignedSize, readBuffer.Ptr(), nullptr, blockSize, directIO, fileSet.name, fileBucketIdx );
+            ReadFromFile( stream, alignedSize, readBuffer.Ptr(), nullptr, blockSize, directIO, fileSet.name, fileBucketIdx );
 
-        // Replace the temp block we just overwrote, if we have one
-        if( tempBlock.Length() )
-            tempBlock.CopyTo( readBuffer );
+            // Replace the temp block we just overwrote, if we have one
+            if( tempBlock.Length() )
+                tempBlock.CopyTo( readBuffer );
 
-        // Copy offset temporarily (only if readSize is not block-aligned)
-        if( readSize < alignedSize )
-        {
-            ASSERT( alignedSize - readSize < blockSize );
+            // Copy offset temporarily (only if readSize is not block-aligned)
+            if( readSize < alignedSize )
+            {
+                ASSERT( alignedSize - readSize < blockSize );
             
-            const auto   lastBlockOffset = alignedSize - blockSize;         ASSERT( readSize > lastBlockOffset );
-            const size_t lastBlockSize   = readSize - lastBlockOffset;
+                const auto   lastBlockOffset = alignedSize - blockSize;         ASSERT( readSize > lastBlockOffset );
+                const size_t lastBlockSize   = readSize - lastBlockOffset;
 
-            readBuffer = readBuffer.Slice( lastBlockOffset );
-            tempBlock  = blockBuffer.Slice( 0, lastBlockSize );
+                readBuffer = readBuffer.Slice( lastBlockOffset );
+                tempBlock  = blockBuffer.Slice( 0, lastBlockSize );
             
-            readBuffer.CopyTo( tempBlock, lastBlockSize );
-        }
-        else
-        {
-            readBuffer = readBuffer.Slice( alignedSize ); // We just read everything block aligned
-            tempBlock  = {};
+                readBuffer.CopyTo( tempBlock, lastBlockSize );
+            }
+            else
+            {
+                readBuffer = readBuffer.Slice( alignedSize ); // We just read everything block aligned
+                tempBlock  = {};
+            }
         }
     }
 
@@ -956,6 +1141,9 @@ void DiskBufferQueue::CmdReadFile( const Command& cmd )
     FileSet& fileSet = _files[(int)cmd.file.fileId];
     const bool   directIO  = IsFlagSet( fileSet.options, FileSetOptions::DirectIO );
     const size_t blockSize = fileSet.files[0]->BlockSize();
+    ASSERT( !fileSet.transform );   // Transformed file sets can only be read in buckets
+
+    FlushCoalescedFile( fileSet, cmd.file.bucket, false, false );
 
     ReadFromFile( *fileSet.files[cmd.file.bucket], cmd.file.size, cmd.file.buffer, (byte*)fileSet.blockBuffer, blockSize, directIO, fileSet.name, cmd.file.bucket );
 }
@@ -971,6 +1159,8 @@ void DiskBufferQueue::CmdSeekBucket( const Command& cmd )
 
     for( uint i = 0; i < bucketCount; i++ )
     {
+        FlushCoalescedFile( fileBuckets, i, false, true );
+
         if( !fileBuckets.files[i]->Seek( seekOffset, seekOrigin ) )
         {
             int err = fileBuckets.files[i]->GetError();
@@ -1120,167 +1310,1085 @@ inline void DiskBufferQueue::ReadFromFile( IStream& file, size_t size, byte* buf
 //     }
 }
 
-//----------------------------------------------------------
-void DiskBufferQueue::CmdDeleteFile( const Command& cmd )
+//-----------------------------------------------------------
+void DiskBufferQueue::BatchWrite( FileSet& fileSet, const uint32 bucket, const byte* buffer, const size_t size, const int64 offset )
 {
-    DeleteFileNow( cmd.deleteFile.fileId, cmd.deleteFile.bucket );
+    ASSERT( UseIOBatch( fileSet ) );
+    FileStream& file = *static_cast<FileStream*>( fileSet.files[bucket] );
 
-    // FileDeleteCommand delCmd;
-    // delCmd.fileId = cmd.deleteFile.fileId;
-    // delCmd.bucket = (int64)cmd.deleteFile.bucket;
-    // while( !_deleteQueue.Enqueue( delCmd ) );
+    _ioBatch.Write( file, buffer, size, offset, bucket );
+    _ioBatchEnds.push_back( { &file, offset + (int64)size } );
 
-    // _deleteSignal.Signal();
+    #if _DEBUG || BB_IO_METRICS_ON
+        _writeMetrics.size += size;
+        _writeMetrics.count++;
+    #endif
 }
 
-//----------------------------------------------------------
-void DiskBufferQueue::CmdDeleteBucket( const Command& cmd )
+//-----------------------------------------------------------
+void DiskBufferQueue::BatchRead( FileSet& fileSet, const uint32 bucket, byte* buffer, const size_t size, const int64 offset )
 {
-    DeleteBucketNow( cmd.deleteFile.fileId );
+    ASSERT( UseIOBatch( fileSet ) );
+    FileStream& file = *static_cast<FileStream*>( fileSet.files[bucket] );
 
-    // FileDeleteCommand delCmd;
-    // delCmd.fileId = cmd.deleteFile.fileId;
-    // delCmd.bucket = -1;
-    // while( !_deleteQueue.Enqueue( delCmd ) );
-    
-    // _deleteSignal.Signal();
+    _ioBatch.Read( file, buffer, size, offset, bucket );
+    _ioBatchEnds.push_back( { &file, offset + (int64)size } );
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        _readMetrics.size += size;
+        _readMetrics.count++;
+    #endif
 }
 
 //-----------------------------------------------------------
-void DiskBufferQueue::CmdTruncateBucket( const Command& cmd )
+void DiskBufferQueue::ExecuteIOBatch( const FileSet& fileSet, const bool isWrite )
 {
-    const auto& tcmd = cmd.truncateBucket;
-
-    FileSet& files = _files[(int)tcmd.fileId];
-
-    for( size_t i = 0; i < files.files.Length(); i++ )
+    // Register the heap lazily, as pinning it faults-in all of its pages.
+    // If it can't be registered (ie. not enough locked memory is allowed), I/O still works without it.
+    if( _ioBatchHeap != _workHeap.Heap() )
     {
-        const bool r = files.files[i]->Truncate( tcmd.position );
-        if( !r )
+        _ioBatchHeap = _workHeap.Heap();
+
+        if( !_ioBatch.RegisterBuffer( _workHeap.Heap(), _workHeap.HeapSize() ) )
         {
-            ASSERT( 0 );
-            Log::Line( "Warning: Failed to truncate file %s:%llu", files.name, (uint64)i );
+            Log::Line( "Note: Could not register the %.2lf GiB I/O heap with io_uring, which requires locking it in memory (see ulimit -l).",
+                (double)_workHeap.HeapSize() BtoGB );
+            Log::Line( "      I/O will work without it, at a higher CPU cost." );
         }
     }
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        const auto timer = TimerBegin();
+    #endif
+
+    int    err;
+    uint32 bucket;
+    if( !_ioBatch.Execute( err, bucket ) )
+    {
+        Fatal( "Failed to %s '%s_%u' work file with error %d (0x%x).", isWrite ? "write to" : "read from",
+            fileSet.name, bucket, err, err );
+    }
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        if( isWrite )
+            _writeMetrics.time += TimerEndTicks( timer );
+        else
+            _readMetrics.time += TimerEndTicks( timer );
+    #endif
+
+    // Positional I/O does not move the streams, so leave them where sequential I/O would have.
+    // Entries are in request order, so the last one for each stream wins.
+    for( auto& end : _ioBatchEnds )
+    {
+        FatalIf( !end.first->Seek( end.second, SeekOrigin::Begin ),
+            "Failed to seek '%s' work file with error %d.", fileSet.name, end.first->GetError() );
+    }
+
+    _ioBatchEnds.clear();
 }
 
+// Reads all slices of a bucket concurrently, producing the same buffer contents as the sequential read in CmdReadBucket().
+// Each slice is read block-aligned starting at the partial last block of the previous slice, so the reads overlap.
+// To avoid that, partial last blocks are read into separate blocks, which are then stitched back in slice order.
 //-----------------------------------------------------------
-inline const char* DiskBufferQueue::DbgGetCommandName( Command::CommandType type )
+void DiskBufferQueue::ReadBucketSlicesBatched( FileSet& fileSet, byte* readBuffer, const bool alternating, const bool alternatingNonInterleaved )
 {
-    switch( type )
+    struct SliceRead
     {
-        case DiskBufferQueue::Command::WriteFile:
-            return "WriteFile";
+        byte*  buffer;
+        size_t bodySize;        // Block-aligned size read directly into the buffer
+        size_t lastBlockSize;   // Used size of the partial last block, or 0
+    };
+
+    const uint32 bucketCount  = (uint32)fileSet.files.Length();
+    const size_t blockSize    = fileSet.files[0]->BlockSize();
+    const auto   sliceSizes   = fileSet.readSliceSizes;
+    const uint64 maxSliceSize = fileSet.maxSliceSize;
 
-        case DiskBufferQueue::Command::WriteBuckets:
-            return "WriteBuckets";
+    ASSERT( bucketCount <= BB_DP_MAX_BUCKET_COUNT );
+    SliceRead slices[BB_DP_MAX_BUCKET_COUNT];
 
-        case DiskBufferQueue::Command::ReadFile:
-            return "ReadFile";
+    const size_t lastBlocksSize = bucketCount * blockSize;
+    if( _ioBatchBlocksSize < lastBlocksSize )
+    {
+        if( _ioBatchBlocks )
+            bbvirtfree( _ioBatchBlocks );
 
-        case DiskBufferQueue::Command::ReleaseBuffer:
-            return "ReleaseBuffer";
+        _ioBatchBlocks     = bbvirtalloc<byte>( lastBlocksSize );
+        _ioBatchBlocksSize = lastBlocksSize;
+    }
 
-        case DiskBufferQueue::Command::SeekFile:
-            return "SeekFile";
+    size_t carrySize = 0;   // Size of the previous slice's partial last block, which this slice's read starts on
 
-        case DiskBufferQueue::Command::SeekBucket:
-            return "SeekBucket";
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        const size_t sliceSize     = sliceSizes[slice][fileSet.readBucket];
+        const size_t readSize      = sliceSize + carrySize;
+        const size_t alignedSize   = CDivT( readSize, blockSize ) * blockSize;
+        const bool   isPartial     = readSize < alignedSize;
+        const size_t bodySize      = isPartial ? alignedSize - blockSize : alignedSize;
 
-        case DiskBufferQueue::Command::SignalFence:
-            return "SignalFence";
+        const uint32 fileBucketIdx = alternatingNonInterleaved ? fileSet.readBucket : slice;
 
-        case DiskBufferQueue::Command::WaitForFence:
-            return "WaitForFence";
+        int64 offset;
+        if( alternating )
+        {
+            const uint32 sliceOffsetIdx = alternatingNonInterleaved ? slice : fileSet.readBucket;
+            offset = (int64)( sliceOffsetIdx * maxSliceSize );
+        }
+        else
+            offset = (int64)static_cast<FileStream*>( fileSet.files[fileBucketIdx] )->Position();
 
-        case DiskBufferQueue::Command::DeleteFile:
-            return "DeleteFile";
+        if( bodySize )
+            BatchRead( fileSet, fileBucketIdx, readBuffer, bodySize, offset );
+        if( isPartial )
+            BatchRead( fileSet, fileBucketIdx, _ioBatchBlocks + slice * blockSize, blockSize, offset + (int64)bodySize );
 
-        case DiskBufferQueue::Command::DeleteBucket:
-            return "DeleteBucket";
+        slices[slice].buffer        = readBuffer;
+        slices[slice].bodySize      = bodySize;
+        slices[slice].lastBlockSize = isPartial ? readSize - bodySize : 0;
 
-        case DiskBufferQueue::Command::TruncateBucket:
-            return "TruncateBucket";
+        readBuffer += bodySize;
+        carrySize   = slices[slice].lastBlockSize;
+    }
 
-        default:
-            ASSERT( 0 );
-            return nullptr;
+    ExecuteIOBatch( fileSet, false );
+
+    // Each slice read starts with the previous slice's partial last block, which must be restored
+    const byte* carry = nullptr;
+    carrySize = 0;
+
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        const SliceRead& s         = slices[slice];
+              byte*      lastBlock = _ioBatchBlocks + slice * blockSize;
+
+        if( carrySize )
+            memcpy( s.bodySize ? s.buffer : lastBlock, carry, carrySize );
+
+        carry     = lastBlock;
+        carrySize = s.lastBlockSize;
+
+        // The last partial block is not overwritten by another slice, so it is kept whole
+        if( carrySize && slice == bucketCount - 1 )
+            memcpy( s.buffer + s.bodySize, lastBlock, blockSize );
     }
 }
 
 //-----------------------------------------------------------
-void DiskBufferQueue::CmdPlotWriterCommand( const Command& cmd )
+byte* DiskBufferQueue::GetTransformBuffer( const size_t size )
 {
-    ASSERT( cmd.type == Command::PlotWriterCommand );
-    cmd.plotWriterCmd.writer->ExecuteCommand( cmd.plotWriterCmd.cmd );   
+    if( _transformBufferSize < size )
+    {
+        if( _transformBuffer )
+            bbvirtfree( _transformBuffer );
+
+        // Leave some room, as buckets don't all have the same size
+        _transformBufferSize = size + size / 8;
+        _transformBuffer     = bbvirtalloc<byte>( _transformBufferSize );
+    }
+
+    return _transformBuffer;
 }
 
-#if _DEBUG
+// Writes each slice of a bucket write as its own transformed unit, at the same offset it would have been written at otherwise,
+// so that slices can be found and read back in the same way.
 //-----------------------------------------------------------
-void DiskBufferQueue::CmdDbgWriteSliceSizes( const Command& cmd )
+void DiskBufferQueue::WriteBucketsTransformed( FileSet& fileSet, const Command& cmd, const size_t elementSize, const bool useBatch )
 {
-    const FileId fileId = cmd.dbgSliceSizes.fileId;;
-    const char*  fName  = ( fileId == FileId::FX0   || fileId == FileId::FX1   ) ? "y"     :
-                          ( fileId == FileId::META0 || fileId == FileId::META1 ) ?  "meta" : "index";
+    const uint32  bucketCount  = (uint32)fileSet.files.Length();
+    const uint*   sizes        = cmd.buckets.writeSizes;
+    const uint32* sliceSizes   = cmd.buckets.sliceSizes;
+    const size_t  blockSize    = fileSet.files[0]->BlockSize();
+    const bool    alternating  = IsFlagSet( fileSet.options, FileSetOptions::Alternating );
+    const uint64  maxSliceSize = fileSet.maxSliceSize;
+
+    size_t totalSize = 0;
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+        totalSize += sizes[slice] * elementSize;
 
-    char path[1024];
-    sprintf( path, "%st%d.%s.slices.tmp", BB_DP_DBG_TEST_DIR, (int)cmd.dbgSliceSizes.table+1, fName );
+    byte*       scratch = GetTransformBuffer( totalSize );
+    const byte* buffer  = cmd.buckets.buffers;
 
-    FileStream file;
-    if( !file.Open( path, FileMode::Create, FileAccess::Write ) )
-    {
-        Log::Error( "Failed to open '%s' for writing.", path );
-        return;
-    }
-    // FatalIf( !file.Open( path, FileMode::Create, FileAccess::Write ), "Failed to open '%s' for writing.", path );
+    // Bucket writes of a table begin with no leftover blocks
+    if( fileSet.writeBucket == 0 )
+        memset( fileSet.transformCarry.Ptr(), 0, sizeof( size_t ) * bucketCount );
 
-    FileSet& fileSet        = _files[(int)fileId];
-    const uint32 numBuckets = (uint32)fileSet.files.Length();
+    // When interleaved, all slices are written one after another to the same file
+    int64 interleavedOffset = alternating ? 0 : (int64)static_cast<FileStream*>( fileSet.files[fileSet.writeBucket] )->Position();
 
-    for( uint32 i = 0; i < numBuckets; i++ )
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
     {
-              auto   slices    = fileSet.writeSliceSizes[i];
-        const size_t sizeWrite = sizeof( size_t ) * numBuckets;
+        const size_t size = sizes[slice] * elementSize;
 
-        if( file.Write( slices.Ptr(), sizeWrite ) != (ssize_t)sizeWrite )
+        // Slices start with the leftover partial block of the previous slice of the same bucket,
+        // and end in padding up to the block boundary. Only the data in between is worth encoding.
+        size_t&      carry    = fileSet.transformCarry[slice];
+        const size_t dataSize = std::min( size, carry + sliceSizes[slice] * elementSize );
+        carry = dataSize % blockSize;
+
+        uint32 bucket;
+        int64  offset;
+
+        if( alternating )
         {
-            Log::Error( "Failed to write slice size for table %d", (int)cmd.dbgSliceSizes.table+1 );
-            return;
+            bucket = cmd.buckets.interleaved ? fileSet.writeBucket : slice;
+            offset = (int64)( ( cmd.buckets.interleaved ? slice : fileSet.writeBucket ) * maxSliceSize );
         }
-        // FatalIf( file.Write( slices.Ptr(), sizeWrite ) != sizeWrite,
-        //     "Failed to write slice size for table %d", (int)cmd.dbgSliceSizes.table+1  );
+        else
+        {
+            bucket = fileSet.writeBucket;
+            offset = interleavedOffset;
+            interleavedOffset += (int64)size;
+        }
+
+        WriteTransformed( fileSet, bucket, buffer, size, dataSize, offset, scratch, useBatch );
+        buffer += size;
     }
 }
 
+// Only the encoded size (block-aligned) is written, leaving the rest of the unit's range in the file unused.
+// The stream is left at the end of the unit's range, like a regular write.
 //-----------------------------------------------------------
-void DiskBufferQueue::CmdDbgReadSliceSizes( const Command& cmd )
+void DiskBufferQueue::WriteTransformed( FileSet& fileSet, const uint32 bucket, const byte* buffer, const size_t size, const size_t dataSize,
+                                        const int64 offset, byte*& scratch, const bool useBatch )
 {
-    const FileId fileId = cmd.dbgSliceSizes.fileId;;
-    const char*  fName  = ( fileId == FileId::FX0   || fileId == FileId::FX1   ) ? "y"     :
-                          ( fileId == FileId::META0 || fileId == FileId::META1 ) ?  "meta" : "index";
-
-    char path[1024];
-    sprintf( path, "%st%d.%s.slices.tmp", BB_DP_DBG_TEST_DIR, (int)cmd.dbgSliceSizes.table+1, fName );
+    if( size == 0 )
+        return;
 
-    FileStream file;
-    FatalIf( !file.Open( path, FileMode::Open, FileAccess::Read ), "Failed to open '%s' for reading.", path );
+    const size_t blockSize   = fileSet.files[0]->BlockSize();
+    const size_t encodedSize = fileSet.transform->Encode( buffer, size, dataSize, scratch );
+    const size_t alignedSize = RoundUpToNextBoundaryT( encodedSize, blockSize );
+    const bool   encoded     = encodedSize > 0 && alignedSize < size;
 
-    FileSet& fileSet        = _files[(int)cmd.dbgSliceSizes.fileId];
-    const uint32 numBuckets = (uint32)fileSet.files.Length();
+    const byte*  data        = buffer;
+    size_t       storedSize  = size;
 
-    for( uint32 i = 0; i < numBuckets; i++ )
+    if( encoded )
     {
-              auto   slices   = fileSet.readSliceSizes[i];
-        const size_t sizeRead = sizeof( size_t ) * numBuckets;
+        memset( scratch + encodedSize, 0, alignedSize - encodedSize );
 
-        FatalIf( file.Read( slices.Ptr(), sizeRead ) != sizeRead,
-            "Failed to read slice size for table %d", (int)cmd.dbgSliceSizes.table+1  );
+        data       = scratch;
+        storedSize = alignedSize;
+        scratch   += alignedSize;
     }
-}
+
+    // Replace any units that were written over
+    auto& frames = fileSet.transformFrames[bucket];
+    auto  it     = frames.lower_bound( offset );
+
+    if( it != frames.begin() && std::prev( it )->first + (int64)std::prev( it )->second.size > offset )
+        --it;
+
+    while( it != frames.end() && it->first < offset + (int64)size )
+        it = frames.erase( it );
+
+    frames[offset] = { size, storedSize, encoded };
+
+    _transformWriteSize  += size;
+    _transformStoredSize += storedSize;
+
+    if( useBatch )
+    {
+        BatchWrite( fileSet, bucket, data, storedSize, offset );
+        _ioBatchEnds.back().second = offset + (int64)size;
+        return;
+    }
+
+    IStream& file = *fileSet.files[bucket];
+
+    FatalIf( !file.Seek( offset, SeekOrigin::Begin ),
+        "Failed to seek file %s.%u.tmp to transformed slice.", fileSet.name, bucket );
+
+    WriteToFile( file, storedSize, data, (byte*)fileSet.blockBuffer, fileSet.name, bucket );
+
+    if( storedSize < size )
+    {
+        FatalIf( !file.Seek( offset + (int64)size, SeekOrigin::Begin ),
+            "Failed to seek file %s.%u.tmp past transformed slice.", fileSet.name, bucket );
+    }
+}
+
+// Slice reads cover the same ranges as the slice writes, so each one reads back a whole unit written by WriteTransformed().
+// Units are decoded in slice order, producing the same buffer contents as the sequential read in CmdReadBucket().
+//-----------------------------------------------------------
+void DiskBufferQueue::ReadBucketSlicesTransformed( FileSet& fileSet, byte* readBuffer, const bool alternating, const bool alternatingNonInterleaved, const bool useBatch )
+{
+    struct SliceRead
+    {
+        const TransformFrame* frame;
+        const byte*           stored;
+        int64                 offset;
+        size_t                readSize;
+        size_t                alignedSize;
+        uint32                bucket;
+    };
+
+    const uint32 bucketCount  = (uint32)fileSet.files.Length();
+    const size_t blockSize    = fileSet.files[0]->BlockSize();
+    const bool   directIO     = IsFlagSet( fileSet.options, FileSetOptions::DirectIO );
+    const auto   sliceSizes   = fileSet.readSliceSizes;
+    const uint64 maxSliceSize = fileSet.maxSliceSize;
+
+    ASSERT( bucketCount <= BB_DP_MAX_BUCKET_COUNT );
+    SliceRead slices[BB_DP_MAX_BUCKET_COUNT];
+
+    // Find the unit stored for each slice
+    size_t storedSize = 0;
+    size_t carrySize  = 0;
+
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        SliceRead& s = slices[slice];
+
+        s.readSize    = sliceSizes[slice][fileSet.readBucket] + carrySize;
+        s.alignedSize = CDivT( s.readSize, blockSize ) * blockSize;
+        s.bucket      = alternatingNonInterleaved ? fileSet.readBucket : slice;
+        s.frame       = nullptr;
+
+        if( alternating )
+        {
+            const uint32 sliceOffsetIdx = alternatingNonInterleaved ? slice : fileSet.readBucket;
+            s.offset = (int64)( sliceOffsetIdx * maxSliceSize );
+        }
+        else
+            s.offset = (int64)static_cast<FileStream*>( fileSet.files[s.bucket] )->Position();
+
+        if( s.alignedSize )
+        {
+            const auto& frames = fileSet.transformFrames[s.bucket];
+            const auto  it     = frames.find( s.offset );
+
+            FatalIf( it == frames.end() || it->second.size != s.alignedSize,
+                "Slice read from '%s_%u' work file does not match a transformed write.", fileSet.name, s.bucket );
+
+            s.frame     = &it->second;
+            storedSize += it->second.storedSize;
+        }
+
+        carrySize = s.readSize < s.alignedSize ? s.readSize - ( s.alignedSize - blockSize ) : 0;
+    }
+
+    // Read the stored units
+    byte* stored = GetTransformBuffer( storedSize );
+
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        SliceRead& s = slices[slice];
+        if( !s.frame )
+            continue;
+
+        s.stored = stored;
+
+        if( useBatch )
+            BatchRead( fileSet, s.bucket, stored, s.frame->storedSize, s.offset );
+        else
+        {
+            IStream& stream = *fileSet.files[s.bucket];
+
+            FatalIf( !stream.Seek( s.offset, SeekOrigin::Begin ),
+                "Failed to seek while reading transformed bucket %s.%u.tmp.", fileSet.name, s.bucket );
+
+            ReadFromFile( stream, s.frame->storedSize, stored, nullptr, blockSize, directIO, fileSet.name, s.bucket );
+        }
+
+        stored += s.frame->storedSize;
+    }
+
+    if( useBatch )
+        ExecuteIOBatch( fileSet, false );
+
+    // Leave the streams where a regular read would have
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        const SliceRead& s = slices[slice];
+
+        if( s.frame && !fileSet.files[s.bucket]->Seek( s.offset + (int64)s.alignedSize, SeekOrigin::Begin ) )
+        {
+            const int err = fileSet.files[s.bucket]->GetError();
+            Fatal( "Failed to seek '%s_%u' work file with error %d (0x%x).", fileSet.name, s.bucket, err, err );
+        }
+    }
+
+    // Decode each slice in place, keeping the previous slice's partial last block, like a regular read does
+    byte*  tempBlock     = (byte*)fileSet.blockBuffer;
+    size_t tempBlockSize = 0;
+
+    for( uint32 slice = 0; slice < bucketCount; slice++ )
+    {
+        const SliceRead& s = slices[slice];
+
+        if( s.frame )
+        {
+            if( s.frame->encoded )
+                fileSet.transform->Decode( s.stored, s.frame->storedSize, readBuffer, s.alignedSize );
+            else
+                memcpy( readBuffer, s.stored, s.alignedSize );
+        }
+
+        if( tempBlockSize )
+            memcpy( readBuffer, tempBlock, tempBlockSize );
+
+        if( s.readSize < s.alignedSize )
+        {
+            const size_t lastBlockOffset = s.alignedSize - blockSize;
+
+            readBuffer   += lastBlockOffset;
+            tempBlockSize = s.readSize - lastBlockOffset;
+
+            memcpy( tempBlock, readBuffer, tempBlockSize );
+        }
+        else
+        {
+            readBuffer   += s.alignedSize;
+            tempBlockSize = 0;
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::ClearTransformFrames( FileSet& fileSet, const uint32 bucket, const int64 fromOffset )
+{
+    if( !fileSet.transformFrames.Ptr() )
+        return;
+
+    // Units that only partially remain are unreadable as well
+    auto& frames = fileSet.transformFrames[bucket];
+    auto  it     = frames.lower_bound( fromOffset );
+
+    if( it != frames.begin() && std::prev( it )->first + (int64)std::prev( it )->second.size > fromOffset )
+        --it;
+
+    frames.erase( it, frames.end() );
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::ReleaseTransform( FileSet& fileSet )
+{
+    delete[] fileSet.transformFrames.Ptr();
+    delete[] fileSet.transformCarry .Ptr();
+
+    fileSet.transformFrames.SetTo( nullptr, 0 );
+    fileSet.transformCarry .SetTo( nullptr, 0 );
+    fileSet.transform = nullptr;
+}
+
+//-----------------------------------------------------------
+size_t DiskBufferQueue::GetCoalesceBufferSize( const size_t coalesceBufferSize, const size_t maxBlockSize )
+{
+    // Made of at least 2 whole extents
+    const size_t extentSize = RoundUpToNextBoundaryT( std::max( CoalesceExtentSize, maxBlockSize ), maxBlockSize );
+
+    return std::max( coalesceBufferSize / extentSize, (size_t)2 ) * extentSize;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::InitWriteCoalescing()
+{
+    if( _coalesceBuffer )
+        return;
+
+    // Extents must hold whole blocks of any of the temp directories
+    size_t blockSize = 1;
+
+    for( const auto* workDirs : { &_workDirs1, &_workDirs2 } )
+        for( const std::string& dir : *workDirs )
+            blockSize = std::max( blockSize, FileStream::GetBlockSizeForPath( dir.c_str() ) );
+
+    _coalesceExtentSize = RoundUpToNextBoundaryT( std::max( CoalesceExtentSize, blockSize ), blockSize );
+    _coalesceBufferSize = GetCoalesceBufferSize( _coalesceBufferSize, blockSize );
+    _coalesceBuffer     = bbvirtalloc<byte>( _coalesceBufferSize );
+
+    const size_t extentCount = _coalesceBufferSize / _coalesceExtentSize;
+
+    _coalesceExtents.resize( extentCount );
+    for( size_t i = 0; i < extentCount; i++ )
+        _coalesceExtents[i].buffer = _coalesceBuffer + i * _coalesceExtentSize;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::CoalesceWrite( FileSet& fileSet, const uint32 bucket, const byte* buffer, size_t size )
+{
+    IStream&     file      = *fileSet.files[bucket];
+    const size_t blockSize = file.BlockSize();
+
+    while( size )
+    {
+        int32 extentIdx = fileSet.coalesceExtents[bucket];
+
+        if( extentIdx < 0 )
+        {
+            extentIdx = AcquireCoalesceExtent( fileSet, bucket );
+
+            // The last flush ended on a partial block: Read it back so that it is overwritten whole
+            const size_t tail = fileSet.coalesceTails[bucket];
+
+            if( tail )
+            {
+                CoalesceExtent& extent = _coalesceExtents[extentIdx];
+
+                FatalIf( !file.Seek( -(int64)blockSize, SeekOrigin::Current ),
+                    "Failed to seek file %s.%u.tmp with error %d.", fileSet.name, bucket, file.GetError() );
+
+                ReadFromFile( file, blockSize, extent.buffer, (byte*)fileSet.blockBuffer, blockSize,
+                              IsFlagSet( fileSet.options, FileSetOptions::DirectIO ), fileSet.name, bucket );
+
+                FatalIf( !file.Seek( -(int64)blockSize, SeekOrigin::Current ),
+                    "Failed to seek file %s.%u.tmp with error %d.", fileSet.name, bucket, file.GetError() );
+
+                extent.size = tail;
+                fileSet.coalesceTails[bucket] = 0;
+            }
+        }
+
+        CoalesceExtent& extent   = _coalesceExtents[extentIdx];
+        const size_t    copySize = std::min( size, _coalesceExtentSize - extent.size );
+
+        memcpy( extent.buffer + extent.size, buffer, copySize );
+        extent.size += copySize;
+        buffer      += copySize;
+        size        -= copySize;
+
+        if( extent.size == _coalesceExtentSize )
+        {
+            WriteToFile( file, extent.size, extent.buffer, (byte*)fileSet.blockBuffer, fileSet.name, bucket );
+            extent.size = 0;
+        }
+    }
+}
+
+//-----------------------------------------------------------
+int32 DiskBufferQueue::AcquireCoalesceExtent( FileSet& fileSet, const uint32 bucket )
+{
+    // Take a free extent, otherwise make room by flushing the fullest one
+    int32 extentIdx = 0;
+
+    for( int32 i = 0; i < (int32)_coalesceExtents.size(); i++ )
+    {
+        const CoalesceExtent& extent = _coalesceExtents[i];
+
+        if( !extent.fileSet )
+        {
+            extentIdx = i;
+            break;
+        }
+
+        if( extent.size > _coalesceExtents[extentIdx].size )
+            extentIdx = i;
+    }
+
+    if( _coalesceExtents[extentIdx].fileSet )
+        FlushCoalesceExtent( extentIdx, false );
+
+    CoalesceExtent& extent = _coalesceExtents[extentIdx];
+    extent.fileSet = &fileSet;
+    extent.bucket  = bucket;
+    extent.size    = 0;
+
+    fileSet.coalesceExtents[bucket] = extentIdx;
+    return extentIdx;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::FlushCoalesceExtent( const int32 extentIdx, const bool discard )
+{
+    CoalesceExtent& extent  = _coalesceExtents[extentIdx];
+    FileSet&        fileSet = *extent.fileSet;
+    const uint32    bucket  = extent.bucket;
+
+    if( extent.size && !discard )
+    {
+        IStream&     file        = *fileSet.files[bucket];
+        const size_t blockSize   = file.BlockSize();
+        const size_t alignedSize = RoundUpToNextBoundaryT( extent.size, blockSize );
+
+        // The last block is written zero-padded, and read back if more is written to the file later
+        memset( extent.buffer + extent.size, 0, alignedSize - extent.size );
+        WriteToFile( file, alignedSize, extent.buffer, (byte*)fileSet.blockBuffer, fileSet.name, bucket );
+
+        fileSet.coalesceTails[bucket] = extent.size % blockSize;
+    }
+
+    fileSet.coalesceExtents[bucket] = -1;
+    extent.fileSet = nullptr;
+    extent.size    = 0;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::FlushCoalescedFile( FileSet& fileSet, const uint32 bucket, const bool discard, const bool resetTail )
+{
+    if( !fileSet.coalesceExtents.Ptr() )
+        return;
+
+    const int32 extentIdx = fileSet.coalesceExtents[bucket];
+
+    if( extentIdx >= 0 )
+        FlushCoalesceExtent( extentIdx, discard );
+
+    // Once the file is repositioned, the partial block is no longer where writes continue from
+    if( resetTail )
+        fileSet.coalesceTails[bucket] = 0;
+}
+
+//----------------------------------------------------------
+void DiskBufferQueue::CmdDeleteFile( const Command& cmd )
+{
+    DeleteFileNow( cmd.deleteFile.fileId, cmd.deleteFile.bucket );
+
+    // FileDeleteCommand delCmd;
+    // delCmd.fileId = cmd.deleteFile.fileId;
+    // delCmd.bucket = (int64)cmd.deleteFile.bucket;
+    // while( !_deleteQueue.Enqueue( delCmd ) );
+
+    // _deleteSignal.Signal();
+}
+
+//----------------------------------------------------------
+void DiskBufferQueue::CmdDeleteBucket( const Command& cmd )
+{
+    DeleteBucketNow( cmd.deleteFile.fileId );
+
+    // FileDeleteCommand delCmd;
+    // delCmd.fileId = cmd.deleteFile.fileId;
+    // delCmd.bucket = -1;
+    // while( !_deleteQueue.Enqueue( delCmd ) );
+    
+    // _deleteSignal.Signal();
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::CmdTruncateBucket( const Command& cmd )
+{
+    const auto& tcmd = cmd.truncateBucket;
+
+    FileSet& files = _files[(int)tcmd.fileId];
+
+    for( size_t i = 0; i < files.files.Length(); i++ )
+    {
+        FlushCoalescedFile( files, (uint32)i, false, true );
+
+        const bool r = files.files[i]->Truncate( tcmd.position );
+        if( !r )
+        {
+            ASSERT( 0 );
+            Log::Line( "Warning: Failed to truncate file %s:%llu", files.name, (uint64)i );
+        }
+
+        ClearTransformFrames( files, (uint32)i, (int64)tcmd.position );
+    }
+}
+
+//-----------------------------------------------------------
+inline const char* DiskBufferQueue::DbgGetCommandName( Command::CommandType type )
+{
+    switch( type )
+    {
+        case DiskBufferQueue::Command::WriteFile:
+            return "WriteFile";
+
+        case DiskBufferQueue::Command::WriteBuckets:
+            return "WriteBuckets";
+
+        case DiskBufferQueue::Command::ReadFile:
+            return "ReadFile";
+
+        case DiskBufferQueue::Command::ReleaseBuffer:
+            return "ReleaseBuffer";
+
+        case DiskBufferQueue::Command::SeekFile:
+            return "SeekFile";
+
+        case DiskBufferQueue::Command::SeekBucket:
+            return "SeekBucket";
+
+        case DiskBufferQueue::Command::SignalFence:
+            return "SignalFence";
+
+        case DiskBufferQueue::Command::WaitForFence:
+            return "WaitForFence";
+
+        case DiskBufferQueue::Command::DeleteFile:
+            return "DeleteFile";
+
+        case DiskBufferQueue::Command::DeleteBucket:
+            return "DeleteBucket";
+
+        case DiskBufferQueue::Command::TruncateBucket:
+            return "TruncateBucket";
+
+        default:
+            ASSERT( 0 );
+            return nullptr;
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::CmdPlotWriterCommand( const Command& cmd )
+{
+    ASSERT( cmd.type == Command::PlotWriterCommand );
+    cmd.plotWriterCmd.writer->ExecuteCommand( cmd.plotWriterCmd.cmd );   
+}
+
+#if _DEBUG
+//-----------------------------------------------------------
+void DiskBufferQueue::CmdDbgWriteSliceSizes( const Command& cmd )
+{
+    const FileId fileId = cmd.dbgSliceSizes.fileId;;
+    const char*  fName  = ( fileId == FileId::FX0   || fileId == FileId::FX1   ) ? "y"     :
+                          ( fileId == FileId::META0 || fileId == FileId::META1 ) ?  "meta" : "index";
+
+    char path[1024];
+    sprintf( path, "%st%d.%s.slices.tmp", BB_DP_DBG_TEST_DIR, (int)cmd.dbgSliceSizes.table+1, fName );
+
+    FileStream file;
+    if( !file.Open( path, FileMode::Create, FileAccess::Write ) )
+    {
+        Log::Error( "Failed to open '%s' for writing.", path );
+        return;
+    }
+    // FatalIf( !file.Open( path, FileMode::Create, FileAccess::Write ), "Failed to open '%s' for writing.", path );
+
+    FileSet& fileSet        = _files[(int)fileId];
+    const uint32 numBuckets = (uint32)fileSet.files.Length();
+
+    for( uint32 i = 0; i < numBuckets; i++ )
+    {
+              auto   slices    = fileSet.writeSliceSizes[i];
+        const size_t sizeWrite = sizeof( size_t ) * numBuckets;
+
+        if( file.Write( slices.Ptr(), sizeWrite ) != (ssize_t)sizeWrite )
+        {
+            Log::Error( "Failed to write slice size for table %d", (int)cmd.dbgSliceSizes.table+1 );
+            return;
+        }
+        // FatalIf( file.Write( slices.Ptr(), sizeWrite ) != sizeWrite,
+        //     "Failed to write slice size for table %d", (int)cmd.dbgSliceSizes.table+1  );
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::CmdDbgReadSliceSizes( const Command& cmd )
+{
+    const FileId fileId = cmd.dbgSliceSizes.fileId;;
+    const char*  fName  = ( fileId == FileId::FX0   || fileId == FileId::FX1   ) ? "y"     :
+                          ( fileId == FileId::META0 || fileId == FileId::META1 ) ?  "meta" : "index";
+
+    char path[1024];
+    sprintf( path, "%st%d.%s.slices.tmp", BB_DP_DBG_TEST_DIR, (int)cmd.dbgSliceSizes.table+1, fName );
+
+    FileStream file;
+    FatalIf( !file.Open( path, FileMode::Open, FileAccess::Read ), "Failed to open '%s' for reading.", path );
+
+    FileSet& fileSet        = _files[(int)cmd.dbgSliceSizes.fileId];
+    const uint32 numBuckets = (uint32)fileSet.files.Length();
+
+    for( uint32 i = 0; i < numBuckets; i++ )
+    {
+              auto   slices   = fileSet.readSliceSizes[i];
+        const size_t sizeRead = sizeof( size_t ) * numBuckets;
+
+        FatalIf( file.Read( slices.Ptr(), sizeRead ) != sizeRead,
+            "Failed to read slice size for table %d", (int)cmd.dbgSliceSizes.table+1  );
+    }
+}
 
 
 #endif
 
+///
+/// Directory Writer Threads
+///
+//-----------------------------------------------------------
+void DiskBufferQueue::InitDirWriters( const uint32 ioQueueDepth )
+{
+    // Directories which are both temp 1 and temp 2 directories share a writer
+    std::vector<std::string> dirs;
+
+    auto mapWriters = [&]( const std::vector<std::string>& workDirs, std::vector<uint32>& writers ) {
+
+        for( const std::string& dir : workDirs )
+        {
+            const auto it = std::find( dirs.begin(), dirs.end(), dir );
+            writers.push_back( (uint32)( it - dirs.begin() ) );
+
+            if( it == dirs.end() )
+                dirs.push_back( dir );
+        }
+    };
+
+    mapWriters( _workDirs1, _workDirWriters1 );
+    mapWriters( _workDirs2, _workDirWriters2 );
+
+    // A single directory is written by the command thread itself
+    if( dirs.size() < 2 )
+        return;
+
+    DirWriter* writers = new DirWriter[dirs.size()];
+
+    for( size_t i = 0; i < dirs.size(); i++ )
+    {
+        if( !writers[i].ioBatch.Init( ioQueueDepth ) )
+        {
+            Log::Line( "Warning: Failed to create an I/O queue for temp directory '%s'. Writes to the temp directories will not overlap.", dirs[i].c_str() );
+            delete[] writers;
+            return;
+        }
+    }
+
+    _dirWriters     = writers;
+    _dirWriterCount = (uint32)dirs.size();
+
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        _dirWriters[i].queue = this;
+        _dirWriters[i].thread.Run( DirWriterThreadMain, &_dirWriters[i] );
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::DirWriterThreadMain( DirWriter* writer )
+{
+    writer->queue->DirWriterMain( *writer );
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::DirWriterMain( DirWriter& writer )
+{
+    const int BUFFER_SIZE = 64;
+    DirWriteJob jobs[BUFFER_SIZE];
+
+    for( ;; )
+    {
+        writer.readySignal.Wait();
+
+        // Keep grabbing jobs until there's none more
+        for( ;; )
+        {
+            const int count = writer.jobs.Dequeue( jobs, BUFFER_SIZE );
+
+            if( count == 0 )
+            {
+                if( writer.exit )
+                    return;
+
+                break;
+            }
+
+            // Writes are queued until a barrier, or until the end of the jobs, so that they are all in flight together
+            for( int i = 0; i < count; i++ )
+            {
+                const DirWriteJob& job = jobs[i];
+
+                if( job.file )
+                {
+                    writer.ioBatch.Write( *job.file, job.buffer, job.size, job.offset, (uint32)i );
+                    continue;
+                }
+
+                ExecuteDirWrites( writer, jobs );
+
+                // The last writer to reach the barrier executes its command
+                if( job.barrier->pending.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+                {
+                    ExecuteCommand( job.barrier->cmd );
+                    delete job.barrier;
+                }
+            }
+
+            ExecuteDirWrites( writer, jobs );
+
+            writer.completed.fetch_add( (uint64)count, std::memory_order_release );
+            writer.doneSignal.Signal();
+        }
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::ExecuteDirWrites( DirWriter& writer, const DirWriteJob* jobs )
+{
+    if( writer.ioBatch.PendingCount() == 0 )
+        return;
+
+    // Same as for the command thread's batch, registration failure is not an error
+    if( writer.ioBatchHeap != _workHeap.Heap() )
+    {
+        writer.ioBatchHeap = _workHeap.Heap();
+        writer.ioBatch.RegisterBuffer( _workHeap.Heap(), _workHeap.HeapSize() );
+    }
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        const auto timer = TimerBegin();
+    #endif
+
+    int    err;
+    uint32 jobIdx;
+    if( !writer.ioBatch.Execute( err, jobIdx ) )
+    {
+        Fatal( "Failed to write to '%s_%u' work file with error %d (0x%x).",
+            jobs[jobIdx].fileName, jobs[jobIdx].bucket, err, err );
+    }
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        writer.writeTime += TimerEndTicks( timer );
+    #endif
+}
+
+// Commands which don't touch files keep running while the directory writers are busy.
+// Returns true if the command was handed over to the directory writers, which then execute it.
+//-----------------------------------------------------------
+bool DiskBufferQueue::OrderWithDirWrites( Command& cmd )
+{
+    switch( cmd.type )
+    {
+        // Queued to the directory writers by the commands themselves, when their file set allows it
+        case Command::WriteBuckets:
+        case Command::WriteBucketElements:
+            if( !UseDirWriters( _files[(int)cmd.buckets.fileId] ) )
+                DrainDirWrites();
+            return false;
+
+        case Command::WriteFile:
+            if( !UseDirWriters( _files[(int)cmd.file.fileId] ) )
+                DrainDirWrites();
+            return false;
+
+        case Command::WaitForFence:
+            return false;
+
+        // Buffers are released and fences signalled once the writes queued before them are done
+        case Command::ReleaseBuffer:
+        case Command::SignalFence:
+            return QueueDirWriteBarrier( cmd );
+
+        default:
+            DrainDirWrites();
+            return false;
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::QueueDirWrite( const FileId fileId, const uint32 bucket, const byte* buffer, const size_t size, const int64 offset )
+{
+    if( size == 0 )
+        return;
+
+    FileSet&    fileSet = _files[(int)fileId];
+    FileStream& file    = *static_cast<FileStream*>( fileSet.files[bucket] );
+    DirWriter&  writer  = GetDirWriter( fileId, bucket );
+
+    DirWriteJob* job;
+    while( !writer.jobs.Write( job ) )
+    {
+        // Full, wait for the writer to make room
+        SubmitDirWrites();
+        writer.doneSignal.Wait();
+    }
+
+    job->file     = &file;
+    job->buffer   = buffer;
+    job->size     = size;
+    job->offset   = offset;
+    job->fileName = fileSet.name;
+    job->bucket   = bucket;
+    job->barrier  = nullptr;
+    writer.written++;
+
+    // Positional writes don't move the stream, so leave it where a sequential write would have
+    FatalIf( !file.Seek( offset + (int64)size, SeekOrigin::Begin ),
+        "Failed to seek '%s' work file with error %d.", fileSet.name, file.GetError() );
+
+    #if _DEBUG || BB_IO_METRICS_ON
+        _writeMetrics.size += size;
+        _writeMetrics.count++;
+    #endif
+}
+
+// Returns false if no directory writer is busy, in which case the command is to be executed right away.
+//-----------------------------------------------------------
+bool DiskBufferQueue::QueueDirWriteBarrier( const Command& cmd )
+{
+    ASSERT( _dirWriterCount <= 64 );
+
+    // Writers that completed everything they were given can't hold an earlier barrier either
+    uint64 busyWriters = 0;
+    uint32 busyCount   = 0;
+
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        if( _dirWriters[i].completed.load( std::memory_order_acquire ) != _dirWriters[i].submitted )
+        {
+            busyWriters |= 1ull << i;
+            busyCount++;
+        }
+    }
+
+    if( busyCount == 0 )
+        return false;
+
+    DirWriteBarrier* barrier = new DirWriteBarrier();
+    barrier->pending = busyCount;
+    barrier->cmd     = cmd;
+
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        if( !( busyWriters & ( 1ull << i ) ) )
+            continue;
+
+        DirWriter& writer = _dirWriters[i];
+
+        DirWriteJob* job;
+        while( !writer.jobs.Write( job ) )
+        {
+            SubmitDirWrites();
+            writer.doneSignal.Wait();
+        }
+
+        job->file    = nullptr;
+        job->barrier = barrier;
+        writer.written++;
+    }
+
+    SubmitDirWrites();
+    return true;
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::SubmitDirWrites()
+{
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        DirWriter& writer = _dirWriters[i];
+
+        if( writer.written == 0 )
+            continue;
+
+        writer.submitted += writer.written;
+        writer.written    = 0;
+
+        writer.jobs.Commit();
+        writer.readySignal.Signal();
+    }
+}
+
+//-----------------------------------------------------------
+void DiskBufferQueue::DrainDirWrites()
+{
+    for( uint32 i = 0; i < _dirWriterCount; i++ )
+    {
+        DirWriter& writer = _dirWriters[i];
+        ASSERT( writer.written == 0 );
+
+        while( writer.completed.load( std::memory_order_acquire ) != writer.submitted )
+            writer.doneSignal.Wait();
+
+        // Writers are idle, so their times can be read
+        #if _DEBUG || BB_IO_METRICS_ON
+            _writeMetrics.time += writer.writeTime;
+            writer.writeTime    = Duration::zero();
+        #endif
+    }
+}
+
 ///
 /// File-Deleter Thread
 ///
@@ -1326,11 +2434,43 @@ void DiskBufferQueue::DeleterMain()
     }
 }
 
+//-----------------------------------------------------------
+const std::string& DiskBufferQueue::GetWorkDir( const FileId fileId, const uint32 bucket ) const
+{
+    const bool useTmp2 = IsFlagSet( _files[(int)fileId].options, FileSetOptions::UseTemp2 );
+
+    const std::vector<std::string>& dirs = useTmp2 ? _workDirs2 : _workDirs1;
+    return dirs[GetWorkDirIndex( fileId, bucket )];
+}
+
+// Bucket files are striped round-robin across the directories. Each file set starts at a different directory,
+// so that the single-file sets are spread out as well.
+//-----------------------------------------------------------
+uint32 DiskBufferQueue::GetWorkDirIndex( const FileId fileId, const uint32 bucket ) const
+{
+    const bool useTmp2 = IsFlagSet( _files[(int)fileId].options, FileSetOptions::UseTemp2 );
+
+    const size_t dirCount = useTmp2 ? _workDirs2.size() : _workDirs1.size();
+    return (uint32)( ( (uint32)fileId + bucket ) % dirCount );
+}
+
+//-----------------------------------------------------------
+DiskBufferQueue::DirWriter& DiskBufferQueue::GetDirWriter( const FileId fileId, const uint32 bucket )
+{
+    ASSERT( _dirWriterCount );
+    const bool useTmp2 = IsFlagSet( _files[(int)fileId].options, FileSetOptions::UseTemp2 );
+
+    const std::vector<uint32>& writers = useTmp2 ? _workDirWriters2 : _workDirWriters1;
+    return _dirWriters[writers[GetWorkDirIndex( fileId, bucket )]];
+}
+
 //-----------------------------------------------------------
 inline void DiskBufferQueue::CloseFileNow( const FileId fileId, const uint32 bucket )
 {
     FileSet& fileSet = _files[(int)fileId];
 
+    ClearTransformFrames( fileSet, bucket );
+
     // NOTE: Why are we doing it this way?? Just add Close() to IStream.
     const bool isHybridFile = IsFlagSet( fileSet.options, FileSetOptions::Cachable );
     if( isHybridFile )
@@ -1350,17 +2490,16 @@ void DiskBufferQueue::DeleteFileNow( const FileId fileId, const uint32 bucket )
 {
     FileSet& fileSet = _files[(int)fileId];
 
+    FlushCoalescedFile( fileSet, bucket, true, true );
     CloseFileNow( fileId, bucket );
 
-    const bool useTmp2 = IsFlagSet( fileSet.options, FileSetOptions::UseTemp2 );
-
-    const std::string& wokrDir  = useTmp2 ? _workDir2 : _workDir1;
+    const std::string& wokrDir  = GetWorkDir( fileId, bucket );
                  char* filePath = _delFilePathBuffer;
 
     memcpy( filePath, wokrDir.c_str(), wokrDir.length() );
     char* baseName = filePath + wokrDir.length();
     
-    sprintf( baseName, "%s_%u.tmp", fileSet.name, bucket );
+    sprintf( baseName, "%s%s_%u.tmp", _tmpFilePrefix.c_str(), fileSet.name, bucket );
     
     const int r = remove( filePath );
 
@@ -1373,19 +2512,17 @@ void DiskBufferQueue::DeleteBucketNow( const FileId fileId )
 {
     FileSet& fileSet = _files[(int)fileId];
 
-    const bool useTmp2 = IsFlagSet( fileSet.options, FileSetOptions::UseTemp2 );
-
-    const std::string& wokrDir  = useTmp2 ? _workDir2 : _workDir1;
-                 char* filePath = _delFilePathBuffer;
-
-    memcpy( filePath, wokrDir.c_str(), wokrDir.length() );
-    char* baseName = filePath + wokrDir.length();
+    char* filePath = _delFilePathBuffer;
 
     for( size_t i = 0; i < fileSet.files.length; i++ )
     {
+        FlushCoalescedFile( fileSet, (uint32)i, true, true );
         CloseFileNow( fileId, (uint32)i );
 
-        sprintf( baseName, "%s_%u.tmp", fileSet.name, (uint)i );
+        const std::string& wokrDir = GetWorkDir( fileId, (uint32)i );
+        memcpy( filePath, wokrDir.c_str(), wokrDir.length() );
+
+        sprintf( filePath + wokrDir.length(), "%s%s_%u.tmp", _tmpFilePrefix.c_str(), fileSet.name, (uint)i );
     
         const int r = remove( filePath );
 
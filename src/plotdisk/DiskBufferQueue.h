@@ -1,13 +1,16 @@
 #pragma once
 
 #include "io/IStream.h"
+#include "io/FileIOBatch.h"
 #include "threading/Fence.h"
 #include "threading/ThreadPool.h"
+#include "threading/Thread.h"
 #include "threading/MTJob.h"
 #include "plotting/WorkHeap.h"
 #include "plotting/Tables.h"
 #include "plotting/PlotWriter.h"
 #include "FileId.h"
+#include <map>
 
 class Thread;
 class IIOTransform;
@@ -23,11 +26,12 @@ enum FileSetOptions
     
     Alternating = 1 << 4,   // Alternate between bucket writing/reading modes. This allows for lower cache size.
 
-    BlockAlign  = 1 << 5,   // Only write in block-aligned segments. Keeping a block-sized buffer for left overs.
-                            // The last write flushes the whole block.
-                            // This can be very memory-costly on file systems with large block sizes
-                            // as interleaved buckets will need many block buffers.
-                            // This must be used with DirectIO.
+    BlockAlign  = 1 << 5,   // Writes don't need to be block-aligned. They are coalesced into block-aligned extents,
+                            // in a staging arena shared by all file sets, which are written out as they fill up.
+                            // Writers would otherwise need a block buffer per bucket for their left overs, which is
+                            // very memory-costly on file systems with large block sizes. So it only takes effect
+                            // on those (see DiskBufferQueue::GetWriteAlignment()).
+                            // Only for file sets written with WriteFile(), and not cached.
 };
 ImplementFlagOps( FileSetOptions );
 
@@ -41,6 +45,14 @@ struct FileSetInitData
     uint64 maxSliceSize = 0;        // Maximum size (in bytes) of a bucket slice
 };
 
+// A bucket write unit that was stored through a file set's transform
+struct TransformFrame
+{
+    size_t size;        // Size of the unit before it was transformed
+    size_t storedSize;  // Block-aligned size actually stored in the file
+    bool   encoded;     // False if the unit was stored as-is
+};
+
 struct FileSet
 {
     const char*        name         = nullptr;
@@ -53,7 +65,20 @@ struct FileSet
     uint32             readBucket   = 0;                     // Current read/write bucket that generated slices. Valid when writing in interleaved mode and alternating mode
     uint32             writeBucket  = 0;
     FileSetOptions     options      = FileSetOptions::None;
+    IIOTransform*      transform    = nullptr;               // Applied to bucket writes and reads, when set
+    Span<std::map<int64, TransformFrame>> transformFrames;   // Units stored through the transform, per file, by offset
+    Span<size_t>       transformCarry;                       // Size of the leading partial block of the next unit of each bucket
+    Span<int32>        coalesceExtents;                      // Extent staging each file's writes (or -1), for FileSetOptions::BlockAlign
+    Span<size_t>       coalesceTails;                        // Size of the partial last block that was flushed to each file
+};
 
+// Writes staged for a FileSetOptions::BlockAlign file
+struct CoalesceExtent
+{
+    byte*    buffer  = nullptr;
+    size_t   size    = 0;           // Bytes staged
+    FileSet* fileSet = nullptr;     // File set and bucket the extent is staging writes for, if any
+    uint32   bucket  = 0;
 };
 
 class DiskBufferQueue
@@ -169,6 +194,45 @@ class DiskBufferQueue
         int64  bucket;  // If < 0, delete all buckets
     };
 
+    // A fence or buffer release which must wait for the directory writes queued before it.
+    // Queued to every busy directory writer, and executed by the last one to reach it.
+    struct DirWriteBarrier
+    {
+        std::atomic<uint32> pending;
+        Command             cmd;
+    };
+
+    struct DirWriteJob
+    {
+        FileStream*      file;      // nullptr for barriers
+        const byte*      buffer;
+        size_t           size;
+        int64            offset;
+        const char*      fileName;
+        uint32           bucket;
+        DirWriteBarrier* barrier;
+    };
+
+    static constexpr int DIR_WRITE_QUEUE_SIZE = 256;
+
+    // Writes the bucket files of one temp directory, so that writes to different
+    // directories are in flight together, even when each command writes to a single file.
+    struct DirWriter
+    {
+        DiskBufferQueue*    queue       = nullptr;
+        Thread              thread;
+        AutoResetSignal     readySignal;
+        AutoResetSignal     doneSignal;
+        SPCQueue<DirWriteJob, DIR_WRITE_QUEUE_SIZE> jobs;
+        FileIOBatch         ioBatch;
+        const void*         ioBatchHeap = nullptr;
+        uint64              written     = 0;            // Jobs written, but not committed yet. Only used by the command thread
+        uint64              submitted   = 0;            // Only used by the command thread
+        std::atomic<uint64> completed   = 0;
+        Duration            writeTime   = Duration::zero();
+        bool                exit        = false;
+    };
+
 #if _DEBUG || BB_IO_METRICS_ON
 public:
     struct IOMetric
@@ -180,9 +244,24 @@ public:
 #endif
 
 public:
-    DiskBufferQueue( const char* workDir1, const char* workDir2, const char* plotDir,
+    // Writes to FileSetOptions::BlockAlign file sets are coalesced on file systems with at least this block size
+    static constexpr size_t CoalesceMinBlockSize      = 64 KiB;
+    static constexpr size_t CoalesceExtentSize        = 1 MiB;     // Minimum size of the staged extents. Rounded up to the largest block size.
+    static constexpr size_t DefaultCoalesceBufferSize = 256 MiB;
+
+    // Size of the staging arena actually allocated for coalesced writes,
+    // given the requested size and the largest block size of the temp directories.
+    static size_t GetCoalesceBufferSize( size_t coalesceBufferSize, size_t maxBlockSize );
+
+    // Bucket files are striped across all of the given temp 1 and temp 2 directories.
+    // If no temp 2 directories are given, the temp 1 directories are used instead.
+    // tmpFilePrefix is prepended to the name of all temporary files, so that multiple plots
+    // (ie. concurrent plots, or multiple processes) can share the same temp directories.
+    // coalesceBufferSize is the size of the staging arena for coalesced writes, which is only allocated if they are used.
+    DiskBufferQueue( Span<const char*> workDirs1, Span<const char*> workDirs2, const char* plotDir,
                      byte* workBuffer, size_t workBufferSize, uint ioThreadCount,
-                     int32 threadBindId = -1 );
+                     int32 threadBindId = -1, uint32 ioQueueDepth = FileIOBatch::DefaultQueueDepth,
+                     const char* tmpFilePrefix = nullptr, size_t coalesceBufferSize = DefaultCoalesceBufferSize );
 
     ~DiskBufferQueue();
 
@@ -274,9 +353,22 @@ public:
 
     inline size_t BlockSize() const { return _blockSize; }
     size_t BlockSize( FileId fileId ) const;
+
+    // Size multiple of the writes to a file set, and of the left overs kept by its writers.
+    // Writes to file sets whose writes are coalesced only need to be field-aligned.
+    static size_t GetWriteAlignment( size_t blockSize, FileSetOptions options );
+    size_t WriteAlignment( FileId fileId ) const;
     
     inline const WorkHeap& Heap() const { return _workHeap; }
 
+    // Total size of bucket writes that went through a transform, and the size that was actually stored for them
+    inline uint64 TransformedWriteSize() const { return _transformWriteSize; }
+    inline uint64 TransformedStoredSize() const { return _transformStoredSize; }
+    inline void   ClearTransformedSizes() { _transformWriteSize = 0; _transformStoredSize = 0; }
+
+    // Number of bucket slice reads/writes kept in flight with io_uring. 0 if blocking I/O is used.
+    inline uint32 IOQueueDepth() const { return _ioBatch.QueueDepth(); }
+
     inline size_t PlotHeaderSize() const { return _plotHeaderSize; }
 
     inline uint64 PlotTablePointersAddress() const { return _plotTablesPointers; }
@@ -408,11 +500,61 @@ private:
     void WriteToFile( IStream& file, size_t size, const byte* buffer, byte* blockBuffer, const char* fileName, uint bucket );
     void ReadFromFile( IStream& file, size_t size, byte* buffer, byte* blockBuffer, const size_t blockSize, const bool directIO, const char* fileName, const uint bucket );
 
+    // Batched I/O. Cachable file sets are not batched, as they are not backed only by a file.
+    inline bool UseIOBatch( const FileSet& fileSet ) const
+    {
+        return _ioBatch.IsValid() && !IsFlagSet( fileSet.options, FileSetOptions::Cachable );
+    }
+
+    void BatchWrite( FileSet& fileSet, uint32 bucket, const byte* buffer, size_t size, int64 offset );
+    void BatchRead( FileSet& fileSet, uint32 bucket, byte* buffer, size_t size, int64 offset );
+    void ExecuteIOBatch( const FileSet& fileSet, bool isWrite );
+
+    // Per-directory writers. Bucket writes are handed to the writer of the file's directory,
+    // and any other command which touches files waits for the writes before it.
+    void InitDirWriters( uint32 ioQueueDepth );
+    static void DirWriterThreadMain( DirWriter* writer );
+    void DirWriterMain( DirWriter& writer );
+    void ExecuteDirWrites( DirWriter& writer, const DirWriteJob* jobs );
+
+    inline bool UseDirWriters( const FileSet& fileSet ) const
+    {
+        return _dirWriterCount > 0 && UseIOBatch( fileSet ) && !fileSet.transform && !fileSet.coalesceExtents.Ptr()
+            && &fileSet != &_files[(int)FileId::PLOT];
+    }
+
+    bool OrderWithDirWrites( Command& cmd );
+    void QueueDirWrite( FileId fileId, uint32 bucket, const byte* buffer, size_t size, int64 offset );
+    bool QueueDirWriteBarrier( const Command& cmd );
+    void SubmitDirWrites();
+    void DrainDirWrites();
+    void ReadBucketSlicesBatched( FileSet& fileSet, byte* readBuffer, bool alternating, bool alternatingNonInterleaved );
+
+    // Transformed file sets
+    byte* GetTransformBuffer( size_t size );
+    void WriteBucketsTransformed( FileSet& fileSet, const Command& cmd, size_t elementSize, bool useBatch );
+    void WriteTransformed( FileSet& fileSet, uint32 bucket, const byte* buffer, size_t size, size_t dataSize, int64 offset, byte*& scratch, bool useBatch );
+    void ReadBucketSlicesTransformed( FileSet& fileSet, byte* readBuffer, bool alternating, bool alternatingNonInterleaved, bool useBatch );
+    void ClearTransformFrames( FileSet& fileSet, uint32 bucket, int64 fromOffset = 0 );
+    static void ReleaseTransform( FileSet& fileSet );
+
+    // Coalesced writes (FileSetOptions::BlockAlign)
+    void InitWriteCoalescing();
+    void CoalesceWrite( FileSet& fileSet, uint32 bucket, const byte* buffer, size_t size );
+    int32 AcquireCoalesceExtent( FileSet& fileSet, uint32 bucket );
+    void FlushCoalesceExtent( int32 extentIdx, bool discard );
+    void FlushCoalescedFile( FileSet& fileSet, uint32 bucket, bool discard, bool resetTail );
+
     void CmdDeleteFile( const Command& cmd );
     void CmdDeleteBucket( const Command& cmd );
 
     void CmdTruncateBucket( const Command& cmd );
 
+    // Directory in which a file set's bucket file is stored
+    const std::string& GetWorkDir( const FileId fileId, const uint32 bucket ) const;
+    uint32 GetWorkDirIndex( const FileId fileId, const uint32 bucket ) const;
+    DirWriter& GetDirWriter( const FileId fileId, const uint32 bucket );
+
     void CloseFileNow( const FileId fileId, const uint32 bucket );
     void DeleteFileNow( const FileId fileId, const uint32 bucket );
     void DeleteBucketNow( const FileId fileId );
@@ -428,12 +570,38 @@ private:
 
 
 private:
-    std::string      _workDir1;     // Temporary 1 directory in which we will store our long-lived temporary files
-    std::string      _workDir2;     // Temporary 2 directory in which we will store our short-live, high-req I/O temporary files
+    std::vector<std::string> _workDirs1;    // Temporary 1 directories in which we will store our long-lived temporary files
+    std::vector<std::string> _workDirs2;    // Temporary 2 directories in which we will store our short-live, high-req I/O temporary files
     std::string      _plotDir;      // Temporary plot directory
     std::string      _plotFullName; // Full path of the plot file without '.tmp'
+    std::string      _tmpFilePrefix;    // Prepended to temp file names
 
     WorkHeap         _workHeap;     // Reserved memory for performing plot work and I/O // #TODO: Remove this
+
+    // Batched I/O, only used by the command thread
+    FileIOBatch      _ioBatch;
+    const void*      _ioBatchHeap        = nullptr;         // Heap for which buffer registration was last attempted
+    byte*            _ioBatchBlocks      = nullptr;         // Partial last blocks of bucket slices read concurrently
+    size_t           _ioBatchBlocksSize  = 0;
+    std::vector<std::pair<FileStream*, int64>> _ioBatchEnds;    // Stream positions to restore once the batch completes
+
+    // Per-directory writers, only used with io_uring and more than one temp directory
+    DirWriter*          _dirWriters      = nullptr;
+    uint32              _dirWriterCount  = 0;
+    std::vector<uint32> _workDirWriters1;                   // Writer of each temp 1 directory
+    std::vector<uint32> _workDirWriters2;                   // Writer of each temp 2 directory
+
+    // Transformed I/O, only used by the command thread
+    byte*            _transformBuffer     = nullptr;        // Encoded units on their way to or from disk
+    size_t           _transformBufferSize = 0;
+    uint64           _transformWriteSize  = 0;
+    uint64           _transformStoredSize = 0;
+
+    // Coalesced writes, only used by the command thread
+    byte*            _coalesceBuffer      = nullptr;        // Staging arena, split into extents
+    size_t           _coalesceBufferSize  = 0;
+    size_t           _coalesceExtentSize  = 0;
+    std::vector<CoalesceExtent> _coalesceExtents;
     
     // Handles to all files needed to create a plot
     FileSet          _files[(size_t)FileId::_COUNT];
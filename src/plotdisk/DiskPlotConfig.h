@@ -8,6 +8,8 @@
 #define BB_DP_MIN_BUCKET_COUNT 64      // Below 128 we can't fit y+map in a qword, so it's only available in bounded mode.
 #define BB_DP_MAX_BUCKET_COUNT 1024
 
+#define BB_DP_MAX_TMP_DIRS 16           // Per temp dir kind (temp 1 and temp 2)
+
 #define BB_DP_ENTRIES_PER_BUCKET        ( ( 1ull << _K ) / BB_DP_BUCKET_COUNT )
 #define BB_DP_XTRA_ENTRIES_PER_BUCKET   1.1
 #define BB_DP_ENTRY_SLICE_MULTIPLIER    1.025
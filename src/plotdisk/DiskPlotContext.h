@@ -15,16 +15,27 @@ struct DiskPlotConfig
     const GlobalPlotConfig* globalCfg          = nullptr;
     const char*       tmpPath                  = nullptr;
     const char*       tmpPath2                 = nullptr;
+    const char*       tmpPaths [BB_DP_MAX_TMP_DIRS] = {};   // All temp 1 directories, tmpPath being the first one. Bucket files are striped across them.
+    const char*       tmpPaths2[BB_DP_MAX_TMP_DIRS] = {};   // All temp 2 directories, tmpPath2 being the first one.
+    uint32            tmpPathCount             = 0;
+    uint32            tmpPath2Count            = 0;
+    const char*       tmpPrefix                = nullptr;   // Prefix for temp file names. A random one is chosen if not set.
     size_t            expectedTmpDirBlockSize  = 0;
     uint32            numBuckets               = 256;
     uint32            ioThreadCount            = 0;
     uint32            ioBufferCount            = 0;
+    uint32            ioQueueDepth             = FileIOBatch::DefaultQueueDepth;    // Temp file reads/writes in flight with io_uring. 0 disables it.
     size_t            cacheSize                = 0;
+    size_t            coalesceBufferSize       = DiskBufferQueue::DefaultCoalesceBufferSize;  // Staging memory for coalesced writes on large-block file systems
+    uint32            concurrentCount          = 1;     // Number of plots to run at the same time, each on its own plotter instance
+    uint32            concurrentPhase1Count    = 1;     // Number of concurrent plots that may run Phase 1 at the same time
+    uint32            cpuOffset                = 0;     // First CPU the thread pool is pinned to. Concurrent instances start on different ones.
 
     bool              bounded                  = true;  // Do not overflow entries
     bool              alternateBuckets         = false; // Alternate bucket writing method between interleaved and not
     bool              noTmp1DirectIO           = false; // Disable direct I/O on tmp 1
     bool              noTmp2DirectIO           = false; // Disable direct I/O on tmp 1
+    bool              compressTmp2             = false; // Bit-pack y and index buckets in the tmp 2 files
 
     uint32            f1ThreadCount            = 0;
     uint32            fpThreadCount            = 0;
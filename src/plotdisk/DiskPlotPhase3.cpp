@@ -3,6 +3,7 @@
 #include "plotdisk/BitBucketWriter.h"
 #include "plotdisk/MapWriter.h"
 #include "plotmem/LPGen.h"
+#include "plotting/LinePointBatch.h"
 #include "algorithm/RadixSort.h"
 #include "plotting/TableWriter.h"
 #include "plotmem/ParkWriter.h"
@@ -473,33 +474,9 @@ private:
             // Now we can convert our pruned pairs to line points
             uint64* outLinePoints = _rPrunedLinePoints + dstOffset;
             ASSERT( (uintptr_t)outLinePoints == (uintptr_t)outPairsStart);
-            {
-                const uint32* lTable = lMap;
-                
-                for( int64 i = 0; i < prunedLength; i++ )
-                {
-                    Pair p = outPairsStart[i];
-
-                    const uint64 x = lTable[p.left ];
-                    const uint64 y = lTable[p.right];
 
-                    ASSERT( x || y );
-                    outLinePoints[i] = SquareToLinePoint( x, y );
-// #if _DEBUG
-//         if( x == y )
-//         {
-//             std::atomic<uint64>& sameLP = *const_cast<std::atomic<uint64>*>( numSameLP );
-//             sameLP++;
-//         }
-//         else
-//         {
-//             const BackPtr deconverted = LinePointToSquare64( outLinePoints[i] ) ;
-//             ASSERT( ( deconverted.x == x && deconverted.y == y ) || 
-//                     ( deconverted.y == x && deconverted.y == x ) );
-//         }
-// #endif
-                }
-            }
+            // Converted in-place, each line point overwrites the pair it was made from
+            PairsToLinePoints( lMap, outPairsStart, (uint64)prunedLength, outLinePoints );
         });
 
         int64 prunedEntryCount = 0;
@@ -14,6 +14,7 @@
 
 
 size_t ValidateTmpPathAndGetBlockSize( DiskPlotter::Config& cfg );
+static std::string CreateTmpFilePrefix( const DiskPlotter::Config& cfg );
 
 
 //-----------------------------------------------------------
@@ -25,6 +26,12 @@ void DiskPlotter::Init()
     // Initialize tables for matching
     LoadLTargets();
 
+    if( _cfg.concurrentCount > 1 )
+    {
+        InitConcurrent();
+        return;
+    }
+
     Config& cfg = _cfg;
 
     ASSERT( cfg.tmpPath  );
@@ -39,6 +46,22 @@ void DiskPlotter::Init()
 
     FatalIf( _cx.tmp1BlockSize < 8 || _cx.tmp2BlockSize < 8,"File system block size is too small.." );
 
+    // Buckets are aligned the same way in all the directories they are striped across
+    auto validateBlockSizes = [&]( const char* const* paths, const uint32 count, const size_t blockSize, const uint32 tmpIdx ) {
+        
+        for( uint32 i = 1; i < count; i++ )
+        {
+            const size_t pathBlockSize = FileStream::GetBlockSizeForPath( paths[i] );
+
+            FatalIf( pathBlockSize != blockSize, 
+                "Temp %u directory '%s' has a block size of %llu, but '%s' has a block size of %llu. All temp %u directories must have the same block size.",
+                tmpIdx, paths[i], (llu)pathBlockSize, paths[0], (llu)blockSize, tmpIdx );
+        }
+    };
+
+    validateBlockSizes( cfg.tmpPaths , cfg.tmpPathCount , _cx.tmp1BlockSize, 1 );
+    validateBlockSizes( cfg.tmpPaths2, cfg.tmpPath2Count, _cx.tmp2BlockSize, 2 );
+
     const uint  sysLogicalCoreCount = SysHost::GetLogicalCPUCount();
     const auto* numa                = SysHost::GetNUMAInfo();
 
@@ -53,6 +76,9 @@ void DiskPlotter::Init()
     const size_t heapSize = GetRequiredSizeForBuckets( true, cfg.numBuckets, _cx.tmp1BlockSize, _cx.tmp2BlockSize, _cx.fpThreadCount );
     ASSERT( heapSize );
 
+    // Namespace our temp files so that other plots can share the temp directories
+    const std::string tmpFilePrefix = CreateTmpFilePrefix( cfg );
+
     _cfg                    = cfg;
     _cx.cfg                 = &_cfg;
     _cx.tmpPath             = cfg.tmpPath;
@@ -74,8 +100,15 @@ void DiskPlotter::Init()
     Log::Line( " I/O threads    : %u"       , _cx.ioThreadCount );
     Log::Line( " Temp1 block sz : %u"       , _cx.tmp1BlockSize );
     Log::Line( " Temp2 block sz : %u"       , _cx.tmp2BlockSize );
-    Log::Line( " Temp1 path     : %s"       , _cx.tmpPath       );
-    Log::Line( " Temp2 path     : %s"       , _cx.tmpPath2      );
+    for( uint32 i = 0; i < cfg.tmpPathCount; i++ )
+        Log::Line( " Temp1 path     : %s"   , cfg.tmpPaths[i]   );
+    for( uint32 i = 0; i < cfg.tmpPath2Count; i++ )
+        Log::Line( " Temp2 path     : %s"   , cfg.tmpPaths2[i]  );
+    if( tmpFilePrefix.length() )
+        Log::Line( " Temp file name : %s*.tmp", tmpFilePrefix.c_str() );
+    const size_t coalesceBufferSize = GetCoalesceBufferSize( cfg, _cx.tmp1BlockSize, _cx.tmp2BlockSize );
+    if( coalesceBufferSize )
+        Log::Line( " Coalesce buffer: %.2lf MiB", (double)coalesceBufferSize BtoMB );
 
 #if BB_IO_METRICS_ON
     Log::Line( " I/O metrices enabled." );
@@ -113,11 +146,18 @@ void DiskPlotter::Init()
 
     // Initialize our Thread Pool and IO Queue
     const int32 ioThreadId = -1;    // Force unpinned IO thread for now. We should bind it to the last used thread, of the max threads used...
-    _cx.threadPool = new ThreadPool( sysLogicalCoreCount, ThreadPool::Mode::Fixed, gCfg.disableCpuAffinity );
-    _cx.ioQueue    = new DiskBufferQueue( _cx.tmpPath, _cx.tmpPath2, gCfg.outputFolder, _cx.heapBuffer, _cx.heapSize, _cx.ioThreadCount, ioThreadId );
+    _cx.threadPool = new ThreadPool( sysLogicalCoreCount, ThreadPool::Mode::Fixed, gCfg.disableCpuAffinity, cfg.cpuOffset );
+    _cx.ioQueue    = new DiskBufferQueue( Span<const char*>( cfg.tmpPaths, cfg.tmpPathCount ), Span<const char*>( cfg.tmpPaths2, cfg.tmpPath2Count ),
+                                          gCfg.outputFolder, _cx.heapBuffer, _cx.heapSize, _cx.ioThreadCount, ioThreadId, cfg.ioQueueDepth,
+                                          tmpFilePrefix.c_str(), cfg.coalesceBufferSize );
     _cx.fencePool  = new FencePool( 8 );
     _cx.plotWriter = new PlotWriter( *_cx.ioQueue );
 
+    if( _cx.ioQueue->IOQueueDepth() )
+        Log::Line( " Using io_uring for temp file I/O with a queue depth of %u.", _cx.ioQueue->IOQueueDepth() );
+    else if( cfg.ioQueueDepth )
+        Log::Line( " io_uring is not available, using blocking temp file I/O." );
+
     if( cfg.globalCfg->warmStart )
     {
         Log::Line( "Warm start: Pre-faulting memory pages..." );
@@ -134,9 +174,73 @@ void DiskPlotter::Init()
     }
 }
 
+//-----------------------------------------------------------
+void DiskPlotter::InitConcurrent()
+{
+    const Config& cfg   = _cfg;
+    const uint32  count = cfg.concurrentCount;
+
+    ASSERT( count > 1 );
+
+    // Each instance gets its own heap, I/O queue and thread pool and runs its own plot.
+    // The instances are given different temp file name prefixes, which share the base prefix.
+    std::string basePrefix = CreateTmpFilePrefix( cfg );
+    if( basePrefix.length() )
+        basePrefix.pop_back();
+
+    Log::Line( "[Bladebit Disk Plotter] Running %u concurrent plots, up to %u in Phase 1 at a time.",
+        count, cfg.concurrentPhase1Count );
+
+    // Each instance's thread pool spans all CPUs, but starts on a different one, so that
+    // the instances' jobs, which use the first threads of their pool, are not pinned to the same CPUs.
+    const uint32 sysLogicalCoreCount = SysHost::GetLogicalCPUCount();
+
+    _phase1Budget    = new Semaphore( (int)cfg.concurrentPhase1Count );
+    _concurrentPlots = new ConcurrentPlot[count];
+
+    size_t totalHeapSize = 0;
+
+    for( uint32 i = 0; i < count; i++ )
+    {
+        ConcurrentPlot& plot = _concurrentPlots[i];
+
+        plot.tmpPrefix = basePrefix + "-" + std::to_string( i );
+        plot.logPrefix = "[" + std::to_string( i+1 ) + "] ";
+        plot.plotter   = new DiskPlotter();
+
+        DiskPlotter& plotter = *plot.plotter;
+        plotter._cfg                 = cfg;
+        plotter._cfg.concurrentCount = 1;
+        plotter._cfg.tmpPrefix       = plot.tmpPrefix.c_str();
+        plotter._cfg.cpuOffset       = (uint32)( (uint64)i * sysLogicalCoreCount / count );
+        plotter._phase1Budget        = _phase1Budget;
+
+        Log::Line( "" );
+        Log::Line( "Initializing plotter instance %u / %u", i+1, count );
+
+        Log::SetThreadPrefix( plot.logPrefix.c_str() );
+        plotter.Init();
+        if( !cfg.globalCfg->disableCpuAffinity )
+            Log::Line( " First CPU      : %u", plotter._cfg.cpuOffset );
+        Log::SetThreadPrefix( nullptr );
+
+        totalHeapSize += plotter._cx.heapSize + plotter._cx.cacheSize +
+                         GetCoalesceBufferSize( plotter._cfg, plotter._cx.tmp1BlockSize, plotter._cx.tmp2BlockSize );
+    }
+
+    Log::Line( "" );
+    Log::Line( "Total memory for %u plotter instances: %.2lf GiB", count, (double)totalHeapSize BtoGB );
+}
+
 //-----------------------------------------------------------
 void DiskPlotter::Run( const PlotRequest& req )
 {
+    if( _concurrentPlots )
+    {
+        RunConcurrent( req );
+        return;
+    }
+
     auto& gCfg = *_cfg.globalCfg;
 
     // Reset state
@@ -167,6 +271,18 @@ void DiskPlotter::Run( const PlotRequest& req )
     auto plotTimer = TimerBegin();
 
     {
+        // When running concurrent plots, Phase 1 is where most of the CPU and temp 2 I/O is spent,
+        // so we only let a limited number of plots run it at the same time, while the rest run their I/O-bound phases.
+        if( _phase1Budget )
+        {
+            const auto waitTimer = TimerBegin();
+            _phase1Budget->Wait();
+
+            const double waitElapsed = TimerEnd( waitTimer );
+            if( waitElapsed >= 1.0 )
+                Log::Line( "Waited %.2lf seconds for another plot to complete Phase 1.", waitElapsed );
+        }
+
         Log::Line( "Running Phase 1" );
         const auto timer = TimerBegin();
 
@@ -177,12 +293,25 @@ void DiskPlotter::Run( const PlotRequest& req )
             #endif
         }
 
+        if( _phase1Budget )
+            _phase1Budget->Release();
+
         #if ( _DEBUG && !BB_DP_DBG_SKIP_PHASE_1 )
             BB_DP_DBG_WriteTableCounts( _cx );
         #endif
 
         const double elapsed = TimerEnd( timer );
         Log::Line( "Finished Phase 1 in %.2lf seconds ( %.1lf minutes ).", elapsed, elapsed / 60 );
+
+        const uint64 packedSize = _cx.ioQueue->TransformedWriteSize();
+        if( packedSize )
+        {
+            const uint64 storedSize = _cx.ioQueue->TransformedStoredSize();
+            Log::Line( " Packed temp 2 writes: %.2lf GiB stored as %.2lf GiB ( %.1lf%% ).",
+                (double)packedSize BtoGB, (double)storedSize BtoGB, storedSize * 100.0 / packedSize );
+
+            _cx.ioQueue->ClearTransformedSizes();
+        }
     }
 
     {
@@ -234,12 +363,72 @@ void DiskPlotter::Run( const PlotRequest& req )
     }
 }
 
+//-----------------------------------------------------------
+void DiskPlotter::RunConcurrent( const PlotRequest& req )
+{
+    // Plots are handed to the instances in order. Since only a limited number of them
+    // run Phase 1 at a time, they also complete roughly in order.
+    ConcurrentPlot& plot = _concurrentPlots[_nextConcurrentPlot];
+    _nextConcurrentPlot = ( _nextConcurrentPlot + 1 ) % _cfg.concurrentCount;
+
+    WaitForConcurrentPlot( plot );
+
+    ASSERT( req.memoSize <= sizeof( plot.memo ) );
+    memcpy( plot.plotId, req.plotId, sizeof( plot.plotId ) );
+    memcpy( plot.memo  , req.memo  , req.memoSize );
+
+    // The plot file name points into the full output path
+    const size_t fileNameOffset = (size_t)( req.plotFileName - req.plotOutPath );
+    ASSERT( req.plotFileName >= req.plotOutPath && fileNameOffset <= strlen( req.plotOutPath ) );
+
+    plot.outDir      = req.outDir;
+    plot.plotOutPath = req.plotOutPath;
+
+    plot.req              = req;
+    plot.req.plotId       = plot.plotId;
+    plot.req.memo         = plot.memo;
+    plot.req.outDir       = plot.outDir.c_str();
+    plot.req.plotOutPath  = plot.plotOutPath.c_str();
+    plot.req.plotFileName = plot.plotOutPath.c_str() + fileNameOffset;
+
+    plot.thread = new Thread();
+    plot.thread->Run( RunConcurrentPlotThread, &plot );
+
+    if( req.IsFinalPlot )
+    {
+        for( uint32 i = 0; i < _cfg.concurrentCount; i++ )
+            WaitForConcurrentPlot( _concurrentPlots[i] );
+    }
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::WaitForConcurrentPlot( ConcurrentPlot& plot )
+{
+    if( !plot.thread )
+        return;
+
+    plot.thread->WaitForExit();
+    delete plot.thread;
+    plot.thread = nullptr;
+}
+
+//-----------------------------------------------------------
+void DiskPlotter::RunConcurrentPlotThread( ConcurrentPlot* plot )
+{
+    // Tell apart the log lines of the plots
+    Log::SetThreadPrefix( plot->logPrefix.c_str() );
+
+    plot->plotter->Run( plot->req );
+}
+
 //-----------------------------------------------------------
 void DiskPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli  )
 {
     Config& cfg = _cfg;
     cfg.globalCfg = &gCfg;
 
+    const char* tmpPath = nullptr;
+
     while( cli.HasArgs() )
     {
         if( cli.ReadU32( cfg.numBuckets,  "-b", "--buckets" ) ) 
@@ -248,16 +437,38 @@ void DiskPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli  )
             continue;
         if( cli.ReadSwitch( cfg.alternateBuckets, "-a", "--alternate" ) )
             continue;
-        if( cli.ReadStr( cfg.tmpPath, "-t1", "--temp1" ) )
+        if( cli.ReadStr( tmpPath, "-t1", "--temp1" ) )
+        {
+            FatalIf( cfg.tmpPathCount >= BB_DP_MAX_TMP_DIRS, "Too many temp 1 directories. A maximum of %u are supported.", BB_DP_MAX_TMP_DIRS );
+            cfg.tmpPaths[cfg.tmpPathCount++] = tmpPath;
+            cfg.tmpPath = cfg.tmpPaths[0];
             continue;
-        if( cli.ReadStr( cfg.tmpPath2, "-t2", "--temp2" ) )
+        }
+        if( cli.ReadStr( tmpPath, "-t2", "--temp2" ) )
+        {
+            FatalIf( cfg.tmpPath2Count >= BB_DP_MAX_TMP_DIRS, "Too many temp 2 directories. A maximum of %u are supported.", BB_DP_MAX_TMP_DIRS );
+            cfg.tmpPaths2[cfg.tmpPath2Count++] = tmpPath;
+            cfg.tmpPath2 = cfg.tmpPaths2[0];
             continue;
+        }
         if( cli.ReadSwitch( cfg.noTmp1DirectIO, "--no-t1-direct" ) )
             continue;
         if( cli.ReadSwitch( cfg.noTmp2DirectIO, "--no-t2-direct" ) )
             continue;
+        if( cli.ReadU32( cfg.ioQueueDepth, "--io-depth" ) )
+            continue;
+        if( cli.ReadSwitch( cfg.compressTmp2, "--compress-t2" ) )
+            continue;
         if( cli.ReadSize( cfg.cacheSize, "--cache" ) )
             continue;
+        if( cli.ReadSize( cfg.coalesceBufferSize, "--coalesce-buffer" ) )
+            continue;
+        if( cli.ReadStr( cfg.tmpPrefix, "--temp-prefix" ) )
+            continue;
+        if( cli.ReadU32( cfg.concurrentCount, "--concurrent" ) )
+            continue;
+        if( cli.ReadU32( cfg.concurrentPhase1Count, "--concurrent-p1" ) )
+            continue;
         if( cli.ReadU32( cfg.f1ThreadCount, "--f1-threads" ) )
             continue;
         if( cli.ReadU32( cfg.fpThreadCount, "--fp-threads" ) )
@@ -282,6 +493,20 @@ void DiskPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli  )
             heapSize = GetRequiredSizeForBuckets( cfg.bounded, cfg.numBuckets, cfg.tmpPath2, cfg.tmpPath, threadCount );
             
             Log::Line( "Buckets: %u | Heap Sizes: %.2lf GiB", cfg.numBuckets, (double)heapSize BtoGB );
+
+            size_t tmp1BlockSize = 0, tmp2BlockSize = 0;
+            FatalIf( !GetTmpPathsBlockSizes( cfg.tmpPath, cfg.tmpPath2, tmp1BlockSize, tmp2BlockSize ), "Failed to obtain temp paths block size." );
+
+            const size_t coalesceBufferSize = GetCoalesceBufferSize( cfg, tmp1BlockSize, tmp2BlockSize );
+            if( coalesceBufferSize )
+                Log::Line( "Coalesce buffer: %.2lf MiB", (double)coalesceBufferSize BtoMB );
+
+            const size_t plotSize = heapSize + cfg.cacheSize + coalesceBufferSize;
+            if( cfg.concurrentCount > 1 )
+                Log::Line( "Total memory for %u concurrent plots: %.2lf GiB", cfg.concurrentCount, (double)( plotSize * cfg.concurrentCount ) BtoGB );
+            else
+                Log::Line( "Total memory: %.2lf GiB", (double)plotSize BtoGB );
+
             exit( 0 );
         }
         if( cli.ArgConsume( "-h", "--help" ) )
@@ -310,7 +535,11 @@ void DiskPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli  )
     ///
     FatalIf( cfg.tmpPath == nullptr, "At least 1 temporary path (--temp) must be specified." );
     if( cfg.tmpPath2 == nullptr )
-        cfg.tmpPath2 = cfg.tmpPath;
+    {
+        memcpy( cfg.tmpPaths2, cfg.tmpPaths, sizeof( cfg.tmpPaths ) );
+        cfg.tmpPath2Count = cfg.tmpPathCount;
+        cfg.tmpPath2      = cfg.tmpPath;
+    }
 
     FatalIf( cfg.numBuckets < BB_DP_MIN_BUCKET_COUNT || cfg.numBuckets > BB_DP_MAX_BUCKET_COUNT,
         "Buckets must be between %u and %u, inclusive.", (uint)BB_DP_MIN_BUCKET_COUNT, (uint)BB_DP_MAX_BUCKET_COUNT );
@@ -320,6 +549,15 @@ void DiskPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli  )
     FatalIf( cfg.numBuckets >= 1024, "1024 buckets are not allowed for plots < k33." );
     FatalIf( cfg.numBuckets < 128 && !cfg.bounded, "64 buckets is only allowed for bounded k=32 plots." );
 
+    if( cfg.tmpPrefix )
+    {
+        FatalIf( *cfg.tmpPrefix == 0, "Invalid temp file prefix." );
+        FatalIf( strpbrk( cfg.tmpPrefix, "/\\" ) != nullptr, "The temp file prefix may not contain path separators: '%s'.", cfg.tmpPrefix );
+    }
+
+    FatalIf( cfg.concurrentCount < 1, "The concurrent plot count must be at least 1." );
+    cfg.concurrentPhase1Count = bbclamp<uint32>( cfg.concurrentPhase1Count, 1u, cfg.concurrentCount );
+
     const uint32 sysLogicalCoreCount = SysHost::GetLogicalCPUCount();
 
     if( cfg.ioThreadCount == 0 )
@@ -367,6 +605,16 @@ size_t DiskPlotter::GetRequiredSizeForBuckets( const bool bounded, const uint32
     return GetRequiredSizeForBuckets( bounded, numBuckets, blockSizes[0], blockSizes[1], threadCount );
 }
 
+//-----------------------------------------------------------
+size_t DiskPlotter::GetCoalesceBufferSize( const Config& cfg, const size_t tmp1BlockSize, const size_t tmp2BlockSize )
+{
+    // Only the map files in the temp 1 directories are coalesced
+    if( tmp1BlockSize < DiskBufferQueue::CoalesceMinBlockSize )
+        return 0;
+
+    return DiskBufferQueue::GetCoalesceBufferSize( cfg.coalesceBufferSize, std::max( tmp1BlockSize, tmp2BlockSize ) );
+}
+
 //-----------------------------------------------------------
 size_t DiskPlotter::GetRequiredSizeForBuckets( const bool bounded, const uint32 numBuckets, const size_t fxBlockSize, const size_t pairsBlockSize, const uint32 threadCount )
 {
@@ -383,6 +631,29 @@ size_t DiskPlotter::GetRequiredSizeForBuckets( const bool bounded, const uint32
 }
 
 
+// Returns the prefix for the temp file names of a plotter instance, including the trailing separator.
+// When no prefix was specified, a random one is used.
+//-----------------------------------------------------------
+std::string CreateTmpFilePrefix( const DiskPlotter::Config& cfg )
+{
+    // Debug runs re-use the temp files of a previous run
+    #if _DEBUG && ( BB_DP_DBG_READ_EXISTING_F1 || BB_DP_DBG_SKIP_PHASE_1 || BB_DP_P1_SKIP_TO_TABLE || BB_DP_DBG_SKIP_TO_C_TABLES )
+        if( !cfg.tmpPrefix )
+            return "";
+    #endif
+
+    if( cfg.tmpPrefix )
+        return std::string( cfg.tmpPrefix ) + ".";
+
+    uint32 id = 0;
+    SysHost::Random( (byte*)&id, sizeof( id ) );
+
+    char prefix[16];
+    snprintf( prefix, sizeof( prefix ), "%08x.", id );
+
+    return prefix;
+}
+
 //-----------------------------------------------------------
 size_t ValidateTmpPathAndGetBlockSize( DiskPlotter::Config& cfg )
 {
@@ -448,20 +719,55 @@ Creates plots by making use of a disk to temporarily store and read values.
                       between tables.
 
  -t1, --temp1 <dir> : The temporary directory to use when plotting.
+                      May be specified multiple times (up to 16) to stripe temporary
+                      files across multiple drives, instead of using RAID 0.
+                      All directories must be on file systems with the same block size.
+                      Striping needs io_uring (see --io-depth) for the drives to be
+                      accessed in parallel.
                       *REQUIRED*
 
  -t2, --temp2 <dir> : Specify a secondary temporary directory, which will be used for data
                       that needs to be read/written from constantly.
+                      May be specified multiple times, like --temp1.
                       If nothing is specified, --temp will be used instead.
 
  --no-t1-direct     : Disable direct I/O on the temp 1 directory.
 
  --no-t2-direct     : Disable direct I/O on the temp 2 directory.
 
+ --io-depth <n>     : Maximum number of temp file reads and writes kept in flight
+                      when io_uring is available (Linux only). The default is 64.
+                      Specify 0 to use blocking I/O instead.
+
+ --temp-prefix <name>: Prefix for the names of the temporary files, which allows multiple
+                      plotter processes to share temporary directories.
+                      A random prefix is used if none is specified.
+
+ --concurrent <n>   : Run n plots at the same time. Each plot runs on its own plotter instance,
+                      with its own memory, I/O queue and threads, so the memory
+                      requirements are multiplied by n. The instances' threads start
+                      on different CPUs, and their log lines are prefixed with [1]..[n].
+
+ --concurrent-p1 <n>: The maximum number of concurrent plots which may run Phase 1 at the same time.
+                      The other plots run Phase 2 and 3, or wait for Phase 1.
+                      The default is 1. Only Phase 1 is limited: Phases 2 and 3 are not
+                      scheduled and share the CPUs and temp directories freely, so
+                      you may want to lower the global -t/--threads count.
+
+ --coalesce-buffer <n>: Size of the memory used to coalesce small map writes into large,
+                      block-aligned writes when the temp 1 file system has a block size
+                      of 64KiB or more (ie. RAID arrays). The default is 256MiB.
+
+ --compress-t2      : Bit-pack y and index buckets written to the temp 2 directory,
+                      reducing the amount of data written to it. Not used for
+                      files that are kept in the --cache.
+
  -s, --sizes        : Output the memory requirements for a specific bucket count.
                       To change the bucket count from the default, pass a value to -b
                       before using this argument. You may also pass a value to --temp and --temp2
                       to get file system block-aligned values when using direct IO.
+                      The total includes the --cache, the coalesce buffer and --concurrent
+                      plots, if they are passed before this argument.
 
  --cache <n>        : Size of cache to reserve for I/O. This is memory
                       reserved for files that incur frequent I/O.
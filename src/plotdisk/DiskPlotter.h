@@ -3,6 +3,8 @@
 #include "DiskPlotContext.h"
 #include "plotting/GlobalPlotConfig.h"
 #include "plotting/IPlotter.h"
+#include "threading/Semaphore.h"
+#include <string>
 
 class DiskPlotter : public IPlotter
 {
@@ -29,10 +31,41 @@ public:
     static size_t GetRequiredSizeForBuckets( const bool bounded, const uint32 numBuckets, const char* tmpPath1, const char* tmpPath2, const uint32 threadCount );
     static size_t GetRequiredSizeForBuckets( const bool bounded, const uint32 numBuckets, const size_t fxBlockSize, const size_t pairsBlockSize, const uint32 threadCount );
 
+    // Memory for coalescing temp 1 writes, which is allocated outside of the heap. 0 if they are not coalesced.
+    static size_t GetCoalesceBufferSize( const Config& cfg, size_t tmp1BlockSize, size_t tmp2BlockSize );
+
     static void PrintUsage();
 
+private:
+    // A plot running on one of the concurrent plotter instances
+    struct ConcurrentPlot
+    {
+        DiskPlotter* plotter = nullptr;
+        Thread*      thread  = nullptr;     // Non-null while the plot is running
+        PlotRequest  req     = {};
+        std::string  tmpPrefix;             // Temp file prefix of the plotter instance
+        std::string  logPrefix;             // Prefix for the log lines of the plotter instance
+
+        // The request's buffers are re-used by the caller for the next plot, so we keep our own copies
+        byte         plotId[BB_PLOT_ID_LEN]       = {};
+        byte         memo[BB_PLOT_MEMO_MAX_SIZE]  = {};
+        std::string  outDir;
+        std::string  plotOutPath;
+    };
+
+    void InitConcurrent();
+    void RunConcurrent( const PlotRequest& req );
+    void WaitForConcurrentPlot( ConcurrentPlot& plot );
+
+    static void RunConcurrentPlotThread( ConcurrentPlot* plot );
+
 private:
     DiskPlotContext   _cx  = {};
     Config            _cfg = {};
+
+    // Concurrent plotting
+    ConcurrentPlot*   _concurrentPlots    = nullptr;    // One per plotter instance, when running multiple plots at once
+    uint32            _nextConcurrentPlot = 0;          // Plots are assigned to the instances round-robin
+    Semaphore*        _phase1Budget       = nullptr;    // Limits how many instances run Phase 1 at the same time
 };
 
@@ -58,13 +58,13 @@ struct FpFxGen
 
         const size_t bufferSize  = CDiv( ySize + metaSizeLR, 8 );
 
-        // Hashing
-        uint64 input [5]; // y + L + R
-        uint64 output[4]; // blake3 hashed output
+        // Hashing. Inputs are staged in batches and hashed together in parallel lanes.
+        // Each input is zero-padded to a full blake3 block.
+        uint64 fxInput [BB_FX_HASH_BATCH_SIZE][8] = {}; // y + L + R
+        uint64 fxOutput[BB_FX_HASH_BATCH_SIZE][4];       // blake3 hashed output
+        int64  batchCount = 0;
 
-        blake3_hasher hasher;
-
-        static_assert( bufferSize <= sizeof( input ), "Invalid fx input buffer size." );
+        static_assert( bufferSize <= sizeof( fxInput[0] ), "Invalid fx input buffer size." );
 
         #if _DEBUG
             uint64 prevY    = yIn[pairs[0].left];
@@ -88,7 +88,8 @@ struct FpFxGen
             #endif
 
             // Extract metadata
-            auto& mOut = metaOut[i];
+            auto&   mOut  = metaOut[i];
+            uint64* input = fxInput[batchCount++];
 
             if constexpr( MetaInMulti == 1 )
             {
@@ -146,38 +147,49 @@ struct FpFxGen
                 input[4] = Swap64( r.m1 << 26 );
             }
 
-            // Hash the input
-            blake3_hasher_init( &hasher );
-            blake3_hasher_update( &hasher, input, bufferSize );
-            blake3_hasher_finalize( &hasher, (uint8_t*)output, sizeof( output ) );
-
-            const uint64 f = Swap64( *output ) >> yShift;
-            yOut[i] = (TYOut)f;
-
-            if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
+            // Hash the staged inputs once the batch is full or we've reached the last entry
+            if( batchCount == BB_FX_HASH_BATCH_SIZE || i + 1 == entryCount )
             {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
+                blake3_hash_many_small( (const uint8_t*)fxInput, (size_t)batchCount, bufferSize, (uint8_t*)fxOutput );
 
-                mOut = h0 << ySize | h1 >> 26;
-            }
-            else if constexpr ( MetaOutMulti == 3 )
-            {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
-                const uint64 h2 = Swap64( output[2] );
+                const int64 first = i + 1 - batchCount;
 
-                mOut.m0 = h0 << ySize | h1 >> 26;
-                mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
-            }
-            else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
-            {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
-                const uint64 h2 = Swap64( output[2] );
+                for( int64 j = 0; j < batchCount; j++ )
+                {
+                    const uint64* output = fxOutput[j];
+                    auto&         mOut   = metaOut[first + j];
+
+                    const uint64 f = Swap64( *output ) >> yShift;
+                    yOut[first + j] = (TYOut)f;
+
+                    if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+
+                        mOut = h0 << ySize | h1 >> 26;
+                    }
+                    else if constexpr ( MetaOutMulti == 3 )
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+                        const uint64 h2 = Swap64( output[2] );
+
+                        mOut.m0 = h0 << ySize | h1 >> 26;
+                        mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
+                    }
+                    else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+                        const uint64 h2 = Swap64( output[2] );
+
+                        mOut.m0 = h0 << ySize | h1 >> 26;
+                        mOut.m1 = h1 << 38    | h2 >> 26;
+                    }
+                }
 
-                mOut.m0 = h0 << ySize | h1 >> 26;
-                mOut.m1 = h1 << 38    | h2 >> 26;
+                batchCount = 0;
             }
         }
     }
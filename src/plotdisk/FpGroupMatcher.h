@@ -2,6 +2,7 @@
 #include "DiskPlotContext.h"
 #include "DiskPlotInfo.h"
 #include "threading/ThreadPool.h"
+#include "plotting/matching/KBCMatch.h"
 
 struct FpCrossBucketInfo
 {
@@ -155,8 +156,8 @@ struct FpGroupMatcher
     {
         uint64 pairCount = 0;
 
-        uint8  rMapCounts [kBC];
-        uint16 rMapIndices[kBC];
+        KBCRMap rMap;
+        rMap.Clear();
 
         uint64 groupLStart = startIndex;
         uint64 groupL      = yBuffer[groupLStart] / kBC;
@@ -171,60 +172,14 @@ struct FpGroupMatcher
             if( groupR - groupL == 1 )
             {
                 // Groups are adjacent, calculate matches
-                const uint16 parity           = groupL & 1;
-                const uint64 groupREnd        = groupBoundaries[i+1];
+                const uint64 groupREnd = groupBoundaries[i+1];
 
-                const uint64 groupLRangeStart = groupL * kBC;
-                const uint64 groupRRangeStart = groupR * kBC;
+                pairCount += MatchKBCGroups( rMap, yBuffer, groupL, groupLStart, groupLEnd, groupRStart, groupREnd,
+                                             pairs + pairCount, maxPairs - pairCount );
 
-                ASSERT( groupREnd - groupRStart <= 350 );
-                ASSERT( groupLRangeStart == groupRRangeStart - kBC );
-
-                // Prepare a map of range kBC to store which indices from groupR are used
-                // For now just iterate our bGroup to find the pairs
-
-                // #NOTE: memset(0) works faster on average than keeping a separate a clearing buffer
-                memset( rMapCounts, 0, sizeof( rMapCounts ) );
-
-                for( uint64 iR = groupRStart; iR < groupREnd; iR++ )
-                {
-                    uint64 localRY = yBuffer[iR] - groupRRangeStart;
-                    ASSERT( yBuffer[iR] / kBC == groupR );
-
-                    if( rMapCounts[localRY] == 0 )
-                        rMapIndices[localRY] = (uint16)( iR - groupRStart );
-
-                    rMapCounts[localRY] ++;
-                }
-
-                // For each group L entry
-                for( uint64 iL = groupLStart; iL < groupLEnd; iL++ )
-                {
-                    const uint64 yL     = yBuffer[iL];
-                    const uint64 localL = yL - groupLRangeStart;
-
-                    // Iterate kExtraBitsPow = 1 << kExtraBits = 1 << 6 == 64
-                    // So iterate 64 times for each L entry.
-                    for( int iK = 0; iK < kExtraBitsPow; iK++ )
-                    {
-                        const uint64 targetR = L_targets[parity][localL][iK];
-
-                        for( uint j = 0; j < rMapCounts[targetR]; j++ )
-                        {
-                            const uint64 iR = groupRStart + rMapIndices[targetR] + j;
-                            ASSERT( iL < iR );
-
-                            // Add a new pair
-                            Pair& pair = pairs[pairCount++];
-                            pair.left  = (uint32)iL;
-                            pair.right = (uint32)iR;
-
-                            ASSERT( pairCount <= maxPairs );
-                            if( pairCount == maxPairs )
-                                return pairCount;
-                        }
-                    }
-                }
+                ASSERT( pairCount <= maxPairs );
+                if( pairCount == maxPairs )
+                    return pairCount;
             }
             // Else: Not an adjacent group, skip to next one.
 
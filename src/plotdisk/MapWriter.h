@@ -330,9 +330,13 @@ public:
 
 private:
     //-----------------------------------------------------------
+    // blockSize is the write alignment of the map file set (see DiskBufferQueue::GetWriteAlignment())
     inline void AllocateWriteBuffers( const uint64 maxEntries, IAllocator& allocator, const size_t blockSize  )
     {
-        const size_t writeBufferSize = RoundUpToNextBoundary( CDiv( maxEntries * EntryBitSize, 8 ), (int)blockSize );
+        // Each bucket is padded up to a block, after the left-over bits of the last write,
+        // which on large-block file systems is well over the slack in maxEntries
+        const size_t bucketPadding   = 2 * (size_t)( _numBuckets + ExtraBucket ) * blockSize;
+        const size_t writeBufferSize = RoundUpToNextBoundaryT( (size_t)CDiv( maxEntries * EntryBitSize, 8 ) + bucketPadding, blockSize );
 
         _writebuffers[0] = allocator.AllocT<byte>( writeBufferSize, blockSize );
         _writebuffers[1] = allocator.AllocT<byte>( writeBufferSize, blockSize );
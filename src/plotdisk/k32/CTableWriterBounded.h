@@ -268,7 +268,7 @@ private:
     void AllocIOBuffers( IAllocator& allocator )
     {
         _mapWriter = MapWriter<_numBuckets, false>( _ioQueue, FileId::MAP7, allocator, 
-                                                    _entriesPerBucket, _context.tmp1BlockSize, 
+                                                    _entriesPerBucket, _ioQueue.WriteAlignment( FileId::MAP7 ), 
                                                     _context.fencePool->RequireFence(), _tableIOWait );
 
         const size_t blockSize         = _context.tmp2BlockSize;
@@ -7,10 +7,14 @@
 #include "plotdisk/DiskBufferQueue.h"
 #include "CTableWriterBounded.h"
 #include "plotting/PlotTools.h"
+#include "io/BitPackTransform.h"
 
 #include "F1Bounded.inl"
 #include "FxBounded.inl"
 
+// Stateless, so it is shared by all file sets, and outlives the phase
+static BitPackTransform _tmp2Transform;
+
 //-----------------------------------------------------------
 K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
     : _context  ( context )
@@ -32,12 +36,15 @@ K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
         _ioQueue.InitFileSet( FileId::T6, "t6", 1, tmp1Options, nullptr );
         _ioQueue.InitFileSet( FileId::T7, "t7", 1, tmp1Options, nullptr );
 
-        _ioQueue.InitFileSet( FileId::MAP2, "map2", numBuckets, tmp1Options, nullptr );
-        _ioQueue.InitFileSet( FileId::MAP3, "map3", numBuckets, tmp1Options, nullptr );
-        _ioQueue.InitFileSet( FileId::MAP4, "map4", numBuckets, tmp1Options, nullptr );
-        _ioQueue.InitFileSet( FileId::MAP5, "map5", numBuckets, tmp1Options, nullptr );
-        _ioQueue.InitFileSet( FileId::MAP6, "map6", numBuckets, tmp1Options, nullptr );
-        _ioQueue.InitFileSet( FileId::MAP7, "map7", numBuckets, tmp1Options, nullptr );
+        // Map writes are small and scattered across all buckets, so coalesce them on large-block file systems
+        const FileSetOptions mapOptions = tmp1Options | FileSetOptions::BlockAlign;
+
+        _ioQueue.InitFileSet( FileId::MAP2, "map2", numBuckets, mapOptions, nullptr );
+        _ioQueue.InitFileSet( FileId::MAP3, "map3", numBuckets, mapOptions, nullptr );
+        _ioQueue.InitFileSet( FileId::MAP4, "map4", numBuckets, mapOptions, nullptr );
+        _ioQueue.InitFileSet( FileId::MAP5, "map5", numBuckets, mapOptions, nullptr );
+        _ioQueue.InitFileSet( FileId::MAP6, "map6", numBuckets, mapOptions, nullptr );
+        _ioQueue.InitFileSet( FileId::MAP7, "map7", numBuckets, mapOptions, nullptr );
     }
 
     // Temp2
@@ -114,6 +121,20 @@ K32BoundedPhase1::K32BoundedPhase1( DiskPlotContext& context )
             InitCachableFileSet( FileId::META0, "meta0", numBuckets, opts, data );
             InitCachableFileSet( FileId::META1, "meta1", numBuckets, opts, data );
         }
+
+        // y is packed down to its width, and indices to the gaps between them.
+        // Meta entries are random, so there is nothing to gain from them.
+        if( context.cfg->compressTmp2 )
+        {
+            _ioQueue.SetTransform( FileId::FX0   , _tmp2Transform );
+            _ioQueue.SetTransform( FileId::INDEX0, _tmp2Transform );
+
+            if( !_context.cfg->alternateBuckets )
+            {
+                _ioQueue.SetTransform( FileId::FX1   , _tmp2Transform );
+                _ioQueue.SetTransform( FileId::INDEX1, _tmp2Transform );
+            }
+        }
     }
 }
 
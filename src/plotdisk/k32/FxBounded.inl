@@ -198,14 +198,17 @@ public:
             _mapWriteBuffer = allocator.CAllocSpan<uint64>  ( entriesPerBucket, t1BlockSize );
             ASSERT( (uintptr_t)_mapWriteBuffer.Ptr() / t1BlockSize * t1BlockSize == (uintptr_t)_mapWriteBuffer.Ptr() );
 
+            // Map writes are coalesced by the queue on large-block file systems, so they need not be block-aligned
+            const size_t mapWriteAlignment = DiskBufferQueue::GetWriteAlignment( t1BlockSize, FileSetOptions::BlockAlign );
+
             if( !dryRun )
             {
                 _mapWriter = MapWriter<_numBuckets, false>( _ioQueue, FileId::MAP2 + (FileId)(rTable-2), allocator, 
-                                                            entriesPerBucket, t1BlockSize, _mapWriteFence, _tableIOWait );
+                                                            entriesPerBucket, mapWriteAlignment, _mapWriteFence, _tableIOWait );
             }
             else
             {
-                _mapWriter = MapWriter<_numBuckets, false>( entriesPerBucket, allocator, t1BlockSize );
+                _mapWriter = MapWriter<_numBuckets, false>( entriesPerBucket, allocator, mapWriteAlignment );
             }
         }
         
@@ -1104,13 +1107,14 @@ private:
         // const uint32 id         = self->JobId();
         const uint32 matchCount = (uint32)pairs.Length();
 
-        // Hashing
-        uint64 input [5]; // y + L + R
-        uint64 output[4]; // blake3 hashed output
+        // Hashing. Inputs are staged in batches and hashed together in parallel lanes.
+        // Each input is zero-padded to a full blake3 block.
+        uint64 fxInput [BB_FX_HASH_BATCH_SIZE][8] = {}; // y + L + R
+        uint64 fxOutput[BB_FX_HASH_BATCH_SIZE][4];       // blake3 hashed output
+        uint64 batchCount = 0;
 
-        blake3_hasher hasher;
 
-        static_assert( bufferSize <= sizeof( input ), "Invalid fx input buffer size." );
+        static_assert( bufferSize <= sizeof( fxInput[0] ), "Invalid fx input buffer size." );
 
         #if _DEBUG
             uint64 prevY    = yIn[pairs[0].left];
@@ -1134,7 +1138,8 @@ private:
             #endif
 
             // Extract metadata
-            auto& mOut = metaOut[i];
+            auto&   mOut  = metaOut[i];
+            uint64* input = fxInput[batchCount++];
 
             if constexpr( MetaInMulti == 1 )
             {
@@ -1188,38 +1193,49 @@ private:
                 input[4] = Swap64( r.m1 << 26 );
             }
 
-            // Hash the input
-            blake3_hasher_init( &hasher );
-            blake3_hasher_update( &hasher, input, bufferSize );
-            blake3_hasher_finalize( &hasher, (uint8_t*)output, sizeof( output ) );
+            // Hash the staged inputs once the batch is full or we've reached the last entry
+            if( batchCount == BB_FX_HASH_BATCH_SIZE || (uint64)i + 1 == matchCount )
+            {
+                blake3_hash_many_small( (const uint8_t*)fxInput, batchCount, bufferSize, (uint8_t*)fxOutput );
 
-            const uint64 f = Swap64( *output ) >> yShift;
-            yOut[i] = (TYOut)f;
+                const uint64 first = (uint64)i + 1 - batchCount;
 
-            if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
-            {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
+                for( uint64 j = 0; j < batchCount; j++ )
+                {
+                    const uint64* output = fxOutput[j];
+                    auto&         mOut   = metaOut[first + j];
 
-                mOut = h0 << ySize | h1 >> 26;
-            }
-            else if constexpr ( MetaOutMulti == 3 )
-            {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
-                const uint64 h2 = Swap64( output[2] );
+                    const uint64 f = Swap64( *output ) >> yShift;
+                    yOut[first + j] = (TYOut)f;
 
-                mOut.m0 = h0 << ySize | h1 >> 26;
-                mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
-            }
-            else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
-            {
-                const uint64 h0 = Swap64( output[0] );
-                const uint64 h1 = Swap64( output[1] );
-                const uint64 h2 = Swap64( output[2] );
+                    if constexpr ( MetaOutMulti == 2 && MetaInMulti == 3 )
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+
+                        mOut = h0 << ySize | h1 >> 26;
+                    }
+                    else if constexpr ( MetaOutMulti == 3 )
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+                        const uint64 h2 = Swap64( output[2] );
+
+                        mOut.m0 = h0 << ySize | h1 >> 26;
+                        mOut.m1 = ((h1 << 6) & 0xFFFFFFC0) | h2 >> 58;
+                    }
+                    else if constexpr ( MetaOutMulti == 4 && MetaInMulti != 2 ) // In = 2 is calculated above with L + R
+                    {
+                        const uint64 h0 = Swap64( output[0] );
+                        const uint64 h1 = Swap64( output[1] );
+                        const uint64 h2 = Swap64( output[2] );
+
+                        mOut.m0 = h0 << ySize | h1 >> 26;
+                        mOut.m1 = h1 << 38    | h2 >> 26;
+                    }
+                }
 
-                mOut.m0 = h0 << ySize | h1 >> 26;
-                mOut.m1 = h1 << 38    | h2 >> 26;
+                batchCount = 0;
             }
         }
     }
@@ -6,8 +6,8 @@ void DumpTestProofs( const MemPlotContext& cx, const uint64 f7Index )
 {
     uint32 proof[64];
 
-    const Pair* tables[6] = {
-        cx.t7LRBuffer,
+    const Pairs tables[6] = {
+        {},
         cx.t6LRBuffer,
         cx.t5LRBuffer,
         cx.t4LRBuffer,
@@ -23,12 +23,12 @@ void DumpTestProofs( const MemPlotContext& cx, const uint64 f7Index )
     Log::Line( "T7 [%-2llu] f7  : %llu : 0x%08lx", f7Index, f7, f7 );
     Log::Line( "T7 [%-2llu] L/R : %-8lu | %-8lu", f7Index, f7Pair.left, f7Pair.right );
 
-    const Pair* rPairs[16]; // R table pairs
-    const Pair* lPairs[32]; // L table pairs
+    Pair rPairs[16]; // R table pairs
+    Pair lPairs[32]; // L table pairs
     memset( rPairs, 0, sizeof( rPairs ) );
     memset( lPairs, 0, sizeof( lPairs ) );
 
-    rPairs[0] = &f7Pair;
+    rPairs[0] = f7Pair;
 
     // Get all pairs up to the 2nd table
     for( uint i = 1; i < 6; i++ )
@@ -36,31 +36,31 @@ void DumpTestProofs( const MemPlotContext& cx, const uint64 f7Index )
         const uint32 rCount = 1ul << (i-1);
         const uint32 lCount = 1ul << i;
 
-        const Pair* table = tables[i];
+        const Pairs table = tables[i];
         Log::Line( "Table %d", 7-i );
 
         for( uint r = 0, l = 0; r < rCount; r++ )
         {
-            const Pair* rPair = rPairs[r];
+            const Pair& rPair = rPairs[r];
             
             Log::Line( "T%d [%-2lu] L/R: %-10lu | %-10lu", 7-i, r, 
-                        rPair->left, rPair->right );
+                        rPair.left, rPair.right );
 
-            lPairs[l++] = &table[rPair->left ];
-            lPairs[l++] = &table[rPair->right];
+            lPairs[l++] = GetPackedPair( table, rPair.left  );
+            lPairs[l++] = GetPackedPair( table, rPair.right );
         }
 
         // Copy pairs to rTable
-        memcpy( rPairs, lPairs, sizeof( Pair* ) * lCount );
+        memcpy( rPairs, lPairs, sizeof( Pair ) * lCount );
     }
 
     // Grab all x values pointed by the pairs
     for( uint i = 0, p = 0; i < 32; i++ )
     {
-        const Pair* pair = lPairs[i];
+        const Pair& pair = lPairs[i];
 
-        proof[p++] = t1xTable[pair->left ];
-        proof[p++] = t1xTable[pair->right];
+        proof[p++] = t1xTable[pair.left ];
+        proof[p++] = t1xTable[pair.right];
     }
 
     Log::Line( "Proof x's:" );
@@ -76,11 +76,16 @@ void DumpTestProofs( const MemPlotContext& cx, const uint64 f7Index )
 void WritePhaseTableFiles( MemPlotContext& cx )
 {
     DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE1_FNAME  , cx.entryCount[0], cx.t1XBuffer  );
-    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE2_FNAME  , cx.entryCount[1], cx.t2LRBuffer );
-    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE3_FNAME  , cx.entryCount[2], cx.t3LRBuffer );
-    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE4_FNAME  , cx.entryCount[3], cx.t4LRBuffer );
-    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE5_FNAME  , cx.entryCount[4], cx.t5LRBuffer );
-    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE6_FNAME  , cx.entryCount[5], cx.t6LRBuffer );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE2_FNAME  , cx.entryCount[1], cx.t2LRBuffer.left  );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE2_FNAME ".r", cx.entryCount[1], cx.t2LRBuffer.right );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE3_FNAME  , cx.entryCount[2], cx.t3LRBuffer.left  );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE3_FNAME ".r", cx.entryCount[2], cx.t3LRBuffer.right );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE4_FNAME  , cx.entryCount[3], cx.t4LRBuffer.left  );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE4_FNAME ".r", cx.entryCount[3], cx.t4LRBuffer.right );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE5_FNAME  , cx.entryCount[4], cx.t5LRBuffer.left  );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE5_FNAME ".r", cx.entryCount[4], cx.t5LRBuffer.right );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE6_FNAME  , cx.entryCount[5], cx.t6LRBuffer.left  );
+    DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE6_FNAME ".r", cx.entryCount[5], cx.t6LRBuffer.right );
     DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE7_FNAME  , cx.entryCount[6], cx.t7LRBuffer );
     DbgWriteTableToFile( *cx.threadPool, DBG_P1_TABLE7_Y_FNAME, cx.entryCount[6], cx.t7YBuffer  );
 }
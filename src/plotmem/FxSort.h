@@ -15,7 +15,7 @@ struct MapFxJob
     const TMeta*  metaSrc;
     TMeta*        metaDst;
     const Pair*   pairSrc;
-    Pair*         pairDst;
+    Pairs         pairDst;
 };
 
 struct GenSortKeyJob
@@ -35,14 +35,14 @@ void GenSortKeyThread( GenSortKeyJob* job );
 //-----------------------------------------------------------
 template<size_t MAX_JOBS>
 inline void SortFx(
-    ThreadPool&   pool,    uint64  length,  
+    ThreadPool&   pool,    const uint32 k, uint64  length,  
     uint64*       yBuffer, uint64* yTmp,
     uint32*       sortKey, uint32* sortKeyTmp )
 {
     // Generate a sort key
     GenSortKey<MAX_JOBS>( pool, length, sortKey );
 
-    YSorter sorter( pool );
+    YSorter sorter( pool, k );
     sorter.Sort( length, yBuffer, yTmp, sortKey, sortKeyTmp );
 }
 
@@ -53,7 +53,7 @@ inline void MapFxWithSortKey(
     ThreadPool&   pool,    uint64  length,  
     const uint32* sortKey,
     const TMeta*  metaSrc, TMeta*  metaDst,
-    const Pair*   pairSrc, Pair*   pairDst )
+    const Pair*   pairSrc, Pairs   pairDst )
 {
     // Sort metadata and pairs on y via the sort key
     const uint32 threadCount      = pool.ThreadCount();
@@ -96,12 +96,19 @@ void MapFxThread( MapFxJob<TMeta>* job )
     for( uint64 i = 0; i < length; i++ )
         metaDst[i] = metaSrc[sortKey[i]];
 
-    // Map pairs
+    // Map pairs, packing them as the left index and an offset to the right index
     const Pair*  pairSrc  = job->pairSrc;
-    Pair*        pairDst  = job->pairDst + offset;
+    uint32*      leftDst  = job->pairDst.left  + offset;
+    uint16*      rightDst = job->pairDst.right + offset;
 
     for( uint64 i = 0; i < length; i++ )
-        pairDst[i] = pairSrc[sortKey[i]];
+    {
+        const Pair pair = pairSrc[sortKey[i]];
+        ASSERT( pair.right > pair.left && pair.right - pair.left <= 0xFFFF );
+
+        leftDst [i] = pair.left;
+        rightDst[i] = (uint16)( pair.right - pair.left );
+    }
 }
 
 
@@ -23,12 +23,12 @@ struct LPJob : public SyncedJob
     
     uint64  length;             // R Table length
     uint64  offset;             // Offset in R table to our entries
-    Pair*   rTable;             // R table
+    Pairs   rTable;             // R table (packed), read when pruning
     uint64* lpBuffer;           // Where to store the pruned Pairs as line points
 
     LPJob*  jobs;               // All threads participating in this job
 
-    const byte* markedEntries;  // Marked entries that will not be pruned
+    const uint64* markedEntries;  // Bit field of marked entries that will not be pruned
     
     uint32* map;
 };
@@ -43,7 +43,6 @@ void ProcessTableThread( LPJob* job );
 
 void PruneAndMapThread( LPJob* job );
 void ConverToLinePointThread( LPJob* job );
-void WriteLookupTableThread( LPJob* job );
 
 // Calculates x * (x-1) / 2. Division is done before multiplication.
 inline uint64 GetXEnc( uint64 x );
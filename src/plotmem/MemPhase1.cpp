@@ -3,12 +3,15 @@
 #include "pos/chacha8.h"
 #include "util/Util.h"
 #include "util/Log.h"
+#include "util/BitView.h"
 #include "FxSort.h"
 #include "algorithm/YSort.h"
 #include "SysHost.h"
 #include "plotting/GlobalPlotConfig.h"
 #include "plotmem/LPGen.h"
+#include "plotting/matching/KBCMatch.h"
 #include <cmath>
+#include <numeric>
 
 #include "DbgHelper.h"
 
@@ -38,6 +41,7 @@ struct F1GenJob
     
     const byte* key;
 
+    uint32  k;
     uint32  blockCount;
     uint32  entryCount;
     uint32  x;
@@ -77,6 +81,7 @@ struct FpFxJob
     const Pair*    lrPairs;
     TMetaOut*      outMetaBuffer;
     TYOut*         outYBuffer;
+    uint32         k;
 };
 
 /// Internal Funcs forwards-declares
@@ -89,8 +94,14 @@ void FpPairThread( kBCJob* job );
 template<typename TYOut, typename TMetaIn, typename TMetaOut>
 void ComputeFxJob( FpFxJob<TYOut, TMetaIn, TMetaOut>* job );
 
+template<typename TYOut, typename TMetaIn, typename TMetaOut>
+void ComputeFxJobForK( FpFxJob<TYOut, TMetaIn, TMetaOut>* job );
+
+template<size_t metaKMultiplierIn, size_t metaKMultiplierOut>
+FORCE_INLINE void SerializeFxInput( uint64 y, const uint64* metaData, uint64 input[8], uint64* metaOut );
+
 template<size_t metaKMultiplierIn, size_t metaKMultiplierOut, uint ShiftBits>
-FORCE_INLINE uint64 ComputeFx( uint64 y, uint64* metaData, uint64* metaOut );
+FORCE_INLINE uint64 ComputeFxFromHash( const uint64 output[4], uint64* metaOut );
 
 
 
@@ -164,25 +175,30 @@ uint64 MemPhase1::GenerateF1()
     ///
     /// Prepare jobs
     ///
-    const uint   k                  = _K;
+    const uint   k                  = cx.k;
     const size_t CHACHA_BLOCK_SIZE  = kF1BlockSizeBits / 8;
     const uint   numThreads         = cx.threadCount;
 
+    // Each thread must start generating at a chacha block boundary,
+    // so we distribute the entries in the smallest groups which fill
+    // up whole blocks. For k32 that is 16 entries per block.
     const uint64 totalEntries       = 1ull << k;
-    const uint64 entriesPerBlock    = CHACHA_BLOCK_SIZE / sizeof( uint32 );
-    const uint64 totalBlocks        = totalEntries / entriesPerBlock;
-    const uint64 blocksPerThread    = totalBlocks / numThreads;
-    const uint64 entriesPerThread   = blocksPerThread * entriesPerBlock;
+    const uint64 entriesPerGroup    = kF1BlockSizeBits / std::gcd( (uint64)k, (uint64)kF1BlockSizeBits );
+    const uint64 blocksPerGroup     = entriesPerGroup * k / kF1BlockSizeBits;
+    const uint64 totalGroups        = totalEntries / entriesPerGroup;
+    const uint64 groupsPerThread    = totalGroups / numThreads;
+    const uint64 blocksPerThread    = groupsPerThread * blocksPerGroup;
+    const uint64 entriesPerThread   = groupsPerThread * entriesPerGroup;
 
     const uint64 trailingEntries    = totalEntries - ( entriesPerThread * numThreads );
-    const uint64 trailingBlocks     = CDiv( trailingEntries, entriesPerBlock );
+    const uint64 trailingBlocks     = CDiv( trailingEntries * k, kF1BlockSizeBits );
 
-    ASSERT( entriesPerBlock * sizeof( uint32 ) == CHACHA_BLOCK_SIZE );  // Must fit exactly within a block
+    ASSERT( entriesPerGroup * k == blocksPerGroup * kF1BlockSizeBits );  // Must fit exactly within whole blocks
 
     // Generate all of the y values to a metabuffer first
     byte*   blocks  = (byte*)cx.yBuffer0;
     uint64* yBuffer = cx.yBuffer0;
-    uint32* xBuffer = isCompressed ? (uint32*)cx.t3LRBuffer : cx.t1XBuffer;  // Write to a temp buffer so we can write back as inlined x's into table 2
+    uint32* xBuffer = isCompressed ? cx.t3LRBuffer.left : cx.t1XBuffer;  // Write to a temp buffer so we can write back as inlined x's into table 2
     uint64* yTmp    = cx.metaBuffer1;
     uint32* xTmp    = (uint32*)(yTmp + totalEntries);
 
@@ -204,6 +220,7 @@ uint64 MemPhase1::GenerateF1()
             // job.threadCount = numThreads;
 
             job.key        = key;
+            job.k          = k;
             job.blockCount = (uint32)blocksPerThread;
             job.entryCount = (uint32)entriesPerThread;
             job.x          = (uint32)offset;
@@ -262,7 +279,7 @@ uint64 MemPhase1::GenerateF1()
     Log::Line( "Sorting F1..." );
     auto timeStart = TimerBegin();
 
-    YSorter sorter( *cx.threadPool );
+    YSorter sorter( *cx.threadPool, k );
     sorter.Sort( totalEntries, yTmp, yBuffer, xTmp, xBuffer );
 
     double elapsed = TimerEnd( timeStart );
@@ -328,20 +345,21 @@ uint64 MemPhase1::FpComputeTable( uint64 entryCount,
 
     MemPlotContext& cx  = _context;
 
-    Pair* pairBuffer;
+    // Table 7's pairs are not sorted, they stay in
+    // the unsorted pair buffer, which is table 7's L/R buffer.
+    Pairs pairBuffer = {};
     if      constexpr ( tableId == TableId::Table2 ) pairBuffer = cx.t2LRBuffer;
     else if constexpr ( tableId == TableId::Table3 ) pairBuffer = cx.t3LRBuffer;
     else if constexpr ( tableId == TableId::Table4 ) pairBuffer = cx.t4LRBuffer;
     else if constexpr ( tableId == TableId::Table5 ) pairBuffer = cx.t5LRBuffer;
     else if constexpr ( tableId == TableId::Table6 ) pairBuffer = cx.t6LRBuffer;
-    else if constexpr ( tableId == TableId::Table7 ) pairBuffer = cx.t7LRBuffer;
 
     return FpComputeSingleTable<tableId>( entryCount, pairBuffer, yBuffer, metaBuffer );
 }
 
 
 //-----------------------------------------------------------
-static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pair* pairs )
+static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pairs pairs )
 {
     const uint32 threadCount = cx.threadCount;
 
@@ -351,7 +369,7 @@ static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pair
         uint32          jobCount;
         MemPlotContext* cx;
         uint64          pairCount;
-        const Pair*     pairs;
+        Pairs           pairs;
     };
 
     Job jobs[MAX_THREADS];
@@ -372,7 +390,7 @@ static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pair
         const uint32 id          = self->id;
         const uint32 threadCount = self->jobCount;
         const uint64 pairCount   = self->pairCount;
-        const Pair*  pairs       = self->pairs;
+        const Pairs  pairs       = self->pairs;
 
         const uint32 entryBits = cx.cfg.gCfg->compressedEntryBits;
         const uint32 shift     = 32 - entryBits;
@@ -385,12 +403,12 @@ static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pair
 
         const int64 end = offset + count;
 
-        const uint32* srcTable = (uint32*)cx.t3LRBuffer;
+        const uint32* srcTable = cx.t3LRBuffer.left;
               uint32* dstTable = cx.t1XBuffer;
 
         for( int64 i = offset; i < end; i++ )
         {
-            const Pair p = pairs[i];
+            const Pair p = GetPackedPair( pairs, (uint64)i );
 
             const uint32 x1 = srcTable[p.left ] >> shift;
             const uint32 x2 = srcTable[p.right] >> shift;
@@ -410,7 +428,7 @@ static void InlineTable2( MemPlotContext& cx, const uint64 pairCount, const Pair
 template<TableId tableId>
 uint64 MemPhase1::FpComputeSingleTable(
     uint64 entryCount,
-    Pair*  pairBuffer,
+    Pairs  pairBuffer,
     ReadWriteBuffer<uint64>& yBuffer, 
     ReadWriteBuffer<uint64>& metaBuffer )
 {
@@ -460,7 +478,7 @@ uint64 MemPhase1::FpComputeSingleTable(
     // Special case: Use taable 1's x buffer as input metadata
     if constexpr ( tableId == TableId::Table2 )
     {
-        inMetaBuffer = isCompressed ? (uint64*)cx.t3LRBuffer : (uint64*)cx.t1XBuffer;
+        inMetaBuffer = isCompressed ? (uint64*)cx.t3LRBuffer.left : (uint64*)cx.t1XBuffer;
         ASSERT( metaBuffer.read == cx.metaBuffer0 );
     }
 
@@ -492,10 +510,10 @@ uint64 MemPhase1::FpComputeSingleTable(
 
         // Use table 7's buffers as a temporary buffer
         uint32* sortKey    = cx.t7YBuffer;
-        uint32* sortKeyTmp = (uint32*)( metaBuffer.write + ENTRIES_PER_TABLE ); // Use the output metabuffer for now as 
+        uint32* sortKeyTmp = (uint32*)( metaBuffer.write + ( 1ull << cx.k ) );  // Use the output metabuffer for now as 
                                                                                 // the temporary sortkey buffer.
         SortFx<MAX_THREADS>(
-            *cx.threadPool,        pairCount,
+            *cx.threadPool,        cx.k, pairCount,
             (uint64*)yBuffer.read, yBuffer.write,
             sortKeyTmp,            sortKey
         );
@@ -555,6 +573,7 @@ uint64 MemPhase1::FpComputeSingleTable(
 //-----------------------------------------------------------
 void F1JobThread( F1GenJob* job )
 {
+    const uint32 k          = job->k;
     const uint32 blockCount = job->blockCount;
     const uint32 entryCount = job->entryCount;
     const uint64 x          = job->x;
@@ -563,7 +582,7 @@ void F1JobThread( F1GenJob* job )
     uint64* yBuffer = job->yBuffer;
 
     // Which block are we generating?
-    const uint64 blockIdx = x * _K / kF1BlockSizeBits;
+    const uint64 blockIdx = x * k / kF1BlockSizeBits;
 
     chacha8_ctx chacha;
     ZeroMem( &chacha );
@@ -572,10 +591,24 @@ void F1JobThread( F1GenJob* job )
     chacha8_get_keystream( &chacha, blockIdx, blockCount, (byte*)blocks );
 
     // chacha output is treated as big endian, therefore swap, as required by chiapos
-    for( uint64 i = 0; i < entryCount; i++ )
+    if( k == 32 )
     {
-        const uint64 y = Swap32( blocks[i] );
-        yBuffer[i] = ( y << kExtraBits ) | ( (x+i) >> (_K - kExtraBits) );
+        for( uint64 i = 0; i < entryCount; i++ )
+        {
+            const uint64 y = Swap32( blocks[i] );
+            yBuffer[i] = ( y << kExtraBits ) | ( (x+i) >> (k - kExtraBits) );
+        }
+    }
+    else
+    {
+        // Entries are not byte-aligned, so read them as a big-endian bit stream
+        const size_t blockBits = (size_t)blockCount * kF1BlockSizeBits;
+
+        for( uint64 i = 0; i < entryCount; i++ )
+        {
+            const uint64 y = CPBitReader::Read64( k, (byte*)blocks, i * k, blockBits );
+            yBuffer[i] = ( y << kExtraBits ) | ( (x+i) >> (k - kExtraBits) );
+        }
     }
 
     // Gen the x that generated the y
@@ -868,15 +901,17 @@ uint64 MemPhase1::FpPair( const uint64* yBuffer, kBCJob jobs[MAX_THREADS],
     }
 
     // Sometimes we get more pairs than we support, so cap it.
-    if( pairCount > ENTRIES_PER_TABLE )
+    const uint64 maxEntries = 1ull << cx.k;
+
+    if( pairCount > maxEntries )
     {
-        const uint64 overflowEntries = pairCount - ENTRIES_PER_TABLE;
+        const uint64 overflowEntries = pairCount - maxEntries;
 
         auto& lastJob = jobs[threadCount-1];
         ASSERT( lastJob.pairCount >= overflowEntries );
         lastJob.pairCount -= overflowEntries;
        
-        pairCount = ENTRIES_PER_TABLE;
+        pairCount = maxEntries;
     }
 
     cx.threadPool->RunJob( (JobFunc)[]( void* pdata ) {
@@ -890,7 +925,7 @@ uint64 MemPhase1::FpPair( const uint64* yBuffer, kBCJob jobs[MAX_THREADS],
     Log::Line( "  Finished pairing L/R groups in %.4lf seconds. Created %llu pairs.", elapsed, pairCount );
     Log::Line( "  Average of %.4lf pairs per group.", pairCount / (float64)groupCount );
 
-    ASSERT( pairCount <= ENTRIES_PER_TABLE );
+    ASSERT( pairCount <= maxEntries );
 
     #if DBG_TEST_PAIRS
         DbgTestPairs( pairCount, outPairBuffer, yBuffer );
@@ -910,8 +945,8 @@ void FpPairThread( kBCJob* job )
     Pair*  pairs     = job->pairs;
     uint64 pairCount = 0;
 
-    uint8  rMapCounts [kBC];
-    uint16 rMapIndices[kBC];
+    KBCRMap rMap;
+    rMap.Clear();
 
     uint64 groupLStart = job->startIndex;
     uint64 groupL      = yBuffer[groupLStart] / kBC;
@@ -924,61 +959,14 @@ void FpPairThread( kBCJob* job )
         if( groupR - groupL == 1 )
         {
             // Groups are adjacent, calculate matches
-            const uint16 parity           = groupL & 1;
-            const uint64 groupREnd        = groupBoundaries[i+1];
+            const uint64 groupREnd = groupBoundaries[i+1];
 
-            const uint64 groupLRangeStart = groupL * kBC;
-            const uint64 groupRRangeStart = groupR * kBC;
-            
-            ASSERT( groupREnd - groupRStart <= 350 );
-            ASSERT( groupLRangeStart == groupRRangeStart - kBC );
-
-            // Prepare a map of range kBC to store which indices from groupR are used
-            // For now just iterate our bGroup to find the pairs
-           
-            // #NOTE: memset(0) works faster on average than keeping a separate a clearing buffer
-            memset( rMapCounts, 0, sizeof( rMapCounts ) );
-
-            for( uint64 iR = groupRStart; iR < groupREnd; iR++ )
-            {
-                uint64 localRY = yBuffer[iR] - groupRRangeStart;
-                ASSERT( yBuffer[iR] / kBC == groupR );
+            pairCount += MatchKBCGroups( rMap, yBuffer, groupL, groupLStart, groupRStart, groupRStart, groupREnd,
+                                         pairs + pairCount, maxPairs - pairCount );
 
-                if( rMapCounts[localRY] == 0 )
-                    rMapIndices[localRY] = (uint16)( iR - groupRStart );
-
-                rMapCounts[localRY] ++;
-            }
-
-            // For each group L entry
-            for( uint64 iL = groupLStart; iL < groupRStart; iL++ )
-            {
-                const uint64 yL     = yBuffer[iL];
-                const uint64 localL = yL - groupLRangeStart;
-
-                // Iterate kExtraBitsPow = 1 << kExtraBits = 1 << 6 == 64
-                // So iterate 64 times for each L entry.
-                for( int iK = 0; iK < kExtraBitsPow; iK++ )
-                {
-                    const uint64 targetR = L_targets[parity][localL][iK];
-
-                    for( uint j = 0; j < rMapCounts[targetR]; j++ )
-                    {
-                        const uint64 iR = groupRStart + rMapIndices[targetR] + j;
-
-                        ASSERT( iL < iR );
-
-                        // Add a new pair
-                        Pair& pair = pairs[pairCount++];
-                        pair.left  = (uint32)iL;
-                        pair.right = (uint32)iR;
-                        
-                        ASSERT( pairCount <= maxPairs );
-                        if( pairCount == maxPairs )
-                            goto RETURN;
-                    }
-                }
-            }
+            ASSERT( pairCount <= maxPairs );
+            if( pairCount == maxPairs )
+                break;
         }
         // Else: Not an adjacent group, skip to next one.
 
@@ -987,7 +975,6 @@ void FpPairThread( kBCJob* job )
         groupLStart = groupRStart;
     }
 
-RETURN:
     job->pairCount = pairCount;
 }
 
@@ -1029,13 +1016,17 @@ void MemPhase1::FpComputeFx( const uint64 entryCount, const Pair* lrPairs,
         job.lrPairs       = lrPairs       + offset;
         job.outMetaBuffer = outMetaBuffer + offset;
         job.outYBuffer    = tYOut         + offset;
+        job.k             = cx.k;
     }
 
     // Add trailing entries to the last job
     jobs[threadCount-1].entryCount += trailingEntries;
 
     // Calculate Fx
-    cx.threadPool->RunJob( ComputeFxJob<TYOut, TMetaIn, TMetaOut>, jobs, threadCount );
+    if( cx.k == 32 )
+        cx.threadPool->RunJob( ComputeFxJob<TYOut, TMetaIn, TMetaOut>, jobs, threadCount );
+    else
+        cx.threadPool->RunJob( ComputeFxJobForK<TYOut, TMetaIn, TMetaOut>, jobs, threadCount );
 
     auto elapsed = TimerEnd( timer );
     Log::Line( "  Finished computing Fx in %.4lf seconds.", elapsed );
@@ -1066,6 +1057,16 @@ void ComputeFxJob( FpFxJob<TYOut, TMetaIn, TMetaOut>* job )
     // Intermediate metadata holder
     uint64 lrMetadata[4];
 
+    // Hashing input and output buffers. Inputs are staged in batches and
+    // hashed together in parallel lanes. Each is zero-padded to a full blake3 block.
+    const size_t fxInputSize = CDiv( _K + kExtraBits + _K * metaKMultiplierIn * 2, 8 );
+
+    uint64 fxInput [BB_FX_HASH_BATCH_SIZE][8] = {};
+    uint64 fxOutput[BB_FX_HASH_BATCH_SIZE][4];
+
+    uint64    batchCount = 0;
+    TMetaOut* batchMeta  = outMetaBuffer;
+
     for( uint64 i = 0; i < entryCount; i++ )
     {
         const Pair& pair = lrPairs[i];
@@ -1104,42 +1105,199 @@ void ComputeFxJob( FpFxJob<TYOut, TMetaIn, TMetaOut>* job )
             lrMetadata[3] = meta4R.m1;
         }
 
-        TYOut f = (TYOut)ComputeFx<metaKMultiplierIn, metaKMultiplierOut, extraBitsShift>( y, lrMetadata, (uint64*)outMetaBuffer );
-
-        outYBuffer[i] = f;
+        SerializeFxInput<metaKMultiplierIn, metaKMultiplierOut>( y, lrMetadata, fxInput[batchCount++], (uint64*)outMetaBuffer );
 
         if constexpr( metaKMultiplierOut != 0 )
             outMetaBuffer ++;
+
+        // Hash the staged inputs once the batch is full or we've reached the last entry
+        if( batchCount == BB_FX_HASH_BATCH_SIZE || i + 1 == entryCount )
+        {
+            blake3_hash_many_small( (const uint8_t*)fxInput, batchCount, fxInputSize, (uint8_t*)fxOutput );
+
+            TYOut* yOut = outYBuffer + i + 1 - batchCount;
+
+            for( uint64 j = 0; j < batchCount; j++ )
+            {
+                yOut[j] = (TYOut)ComputeFxFromHash<metaKMultiplierIn, metaKMultiplierOut, extraBitsShift>( fxOutput[j], (uint64*)batchMeta );
+
+                if constexpr( metaKMultiplierOut != 0 )
+                    batchMeta ++;
+            }
+
+            batchCount = 0;
+        }
     }
 }
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wattributes"
 
+///
+/// Fx computation for k values other than 32.
+/// Metadata wider than 64 bits (3 and 4 k multipliers) is stored
+/// as a single 128-bit value, with m0 holding its high 64 bits and m1 its low 64 bits.
+///
 //-----------------------------------------------------------
-template<size_t metaKMultiplierIn, size_t metaKMultiplierOut, uint ShiftBits>
-FORCE_INLINE uint64 ComputeFx( uint64 y, uint64* metaData, uint64* metaOut )
+template<typename TMeta>
+FORCE_INLINE uint128 GetMetaForK( const TMeta* metaBuffer, const uint64 index )
 {
-    static_assert( metaKMultiplierIn != 0, "Invalid metaKMultiplier" );
+    if constexpr ( SizeForMeta<TMeta>::Value <= 2 )
+        return (uint128)metaBuffer[index];
+    else
+    {
+        const Meta4& meta = metaBuffer[index];
+        return ( (uint128)meta.m0 << 64 ) | meta.m1;
+    }
+}
 
-    // Helper consts
-    const uint   k           = _K;
-    const uint32 ySize       = k + kExtraBits;         // = 38
-    const uint32 yShift      = 64 - (k + ShiftBits);   // = 26 or 32
-    const size_t metaSize    = k * metaKMultiplierIn;
-    const size_t metaSizeLR  = metaSize * 2;
+//-----------------------------------------------------------
+template<typename TMeta>
+FORCE_INLINE void SetMetaForK( TMeta& meta, const uint128 value )
+{
+    if constexpr ( SizeForMeta<TMeta>::Value == 1 )
+        meta = (uint32)value;
+    else if constexpr ( SizeForMeta<TMeta>::Value == 2 )
+        meta = (uint64)value;
+    else
+    {
+        meta.m0 = (uint64)( value >> 64 );
+        meta.m1 = (uint64)value;
+    }
+}
+
+// Appends up to 64 bits to a big-endian bit stream, which is stored in native-endian fields
+//-----------------------------------------------------------
+FORCE_INLINE void PackFxBits64( uint64* fields, uint32& position, const uint64 value, const uint32 bitCount )
+{
+    ASSERT( bitCount > 0 && bitCount <= 64 );
+
+    const uint32 fieldIdx = position >> 6;
+    const uint32 freeBits = 64 - ( position & 63 );
+
+    if( bitCount <= freeBits )
+        fields[fieldIdx] |= value << ( freeBits - bitCount );
+    else
+    {
+        const uint32 remainder = bitCount - freeBits;
+
+        fields[fieldIdx  ] |= value >> remainder;
+        fields[fieldIdx+1] |= value << ( 64 - remainder );
+    }
+
+    position += bitCount;
+}
+
+//-----------------------------------------------------------
+FORCE_INLINE void PackFxBits( uint64* fields, uint32& position, const uint128 value, const uint32 bitCount )
+{
+    if( bitCount > 64 )
+    {
+        PackFxBits64( fields, position, (uint64)( value >> 64 ), bitCount - 64 );
+        PackFxBits64( fields, position, (uint64)value, 64 );
+    }
+    else
+        PackFxBits64( fields, position, (uint64)value, bitCount );
+}
+
+//-----------------------------------------------------------
+FORCE_INLINE uint128 ReadFxBits( const uint64 hash[4], const uint32 position, const uint32 bitCount )
+{
+    const byte* bytes = (const byte*)hash;
+
+    if( bitCount > 64 )
+    {
+        const uint32 hiBits = bitCount - 64;
+        const uint64 hi     = CPBitReader::Read64Aligned( hiBits, bytes, position, 256 );
+        const uint64 lo     = CPBitReader::Read64Aligned( 64, bytes, position + hiBits, 256 );
+
+        return ( (uint128)hi << 64 ) | lo;
+    }
+
+    return CPBitReader::Read64Aligned( bitCount, bytes, position, 256 );
+}
+
+//-----------------------------------------------------------
+template<typename TYOut, typename TMetaIn, typename TMetaOut>
+void ComputeFxJobForK( FpFxJob<TYOut, TMetaIn, TMetaOut>* job )
+{
+    const size_t metaKMultiplierIn  = SizeForMeta<TMetaIn >::Value;
+    const size_t metaKMultiplierOut = SizeForMeta<TMetaOut>::Value;
+
+    // When the output metadata is twice the size of the input,
+    // then it is just L + R. Otherwise it is taken from the hash.
+    constexpr bool metaIsLR = metaKMultiplierOut == metaKMultiplierIn * 2;
+
+    const uint32 k            = job->k;
+    const uint32 ySize        = k + kExtraBits;
+    const uint32 yOutSize     = metaKMultiplierOut == 0 ? k : ySize;   // Table 7 outputs k-sized f7 values
+    const uint32 metaInSize   = k * (uint32)metaKMultiplierIn;
+    const uint32 metaOutSize  = k * (uint32)metaKMultiplierOut;
+    const size_t fxInputSize  = CDiv( ySize + metaInSize * 2, 8 );
+
+    const uint64   entryCount    = job->entryCount;
+    const Pair*    lrPairs       = job->lrPairs;
+    const TMetaIn* inMetaBuffer  = job->inMetaBuffer;
+    const uint64*  inYBuffer     = job->inYBuffer;
+    TMetaOut*      outMetaBuffer = job->outMetaBuffer;
+    TYOut*         outYBuffer    = job->outYBuffer;
+
+    uint64 fxInput [BB_FX_HASH_BATCH_SIZE][8];
+    uint64 fxOutput[BB_FX_HASH_BATCH_SIZE][4];
+
+    uint64 batchCount = 0;
+
+    for( uint64 i = 0; i < entryCount; i++ )
+    {
+        const Pair&   pair = lrPairs[i];
+        const uint64  y    = inYBuffer[pair.left];
+        const uint128 l    = GetMetaForK( inMetaBuffer, pair.left  );
+        const uint128 r    = GetMetaForK( inMetaBuffer, pair.right );
 
-    const size_t bufferSize  = CDiv( ySize + metaSizeLR, 8 );
+        // Serialize y, L and R as a big-endian bit stream
+        uint64* input    = fxInput[batchCount++];
+        uint32  position = 0;
 
+        memset( input, 0, sizeof( fxInput[0] ) );
 
-    // Hashing input and output buffers
-    uint64 input [5];       // y + L + R
-    uint64 output[4];       // blake3 hashed output
+        PackFxBits( input, position, y, ySize      );
+        PackFxBits( input, position, l, metaInSize );
+        PackFxBits( input, position, r, metaInSize );
 
-    blake3_hasher hasher;
+        for( uint32 j = 0; j < CDiv( position, 64 ); j++ )
+            input[j] = Swap64( input[j] );
 
+        if constexpr ( metaIsLR )
+            SetMetaForK( outMetaBuffer[i], ( l << metaInSize ) | r );
 
-    // Prepare the input buffer depending on the metadata size
+        // Hash the staged inputs once the batch is full or we've reached the last entry
+        if( batchCount == BB_FX_HASH_BATCH_SIZE || i + 1 == entryCount )
+        {
+            blake3_hash_many_small( (const uint8_t*)fxInput, batchCount, fxInputSize, (uint8_t*)fxOutput );
+
+            const uint64 batchStart = i + 1 - batchCount;
+
+            for( uint64 j = 0; j < batchCount; j++ )
+            {
+                outYBuffer[batchStart+j] = (TYOut)ReadFxBits( fxOutput[j], 0, yOutSize );
+
+                if constexpr ( metaKMultiplierOut != 0 && !metaIsLR )
+                    SetMetaForK( outMetaBuffer[batchStart+j], ReadFxBits( fxOutput[j], ySize, metaOutSize ) );
+            }
+
+            batchCount = 0;
+        }
+    }
+}
+
+//-----------------------------------------------------------
+template<size_t metaKMultiplierIn, size_t metaKMultiplierOut>
+FORCE_INLINE void SerializeFxInput( uint64 y, const uint64* metaData, uint64 input[8], uint64* metaOut )
+{
+    static_assert( metaKMultiplierIn != 0, "Invalid metaKMultiplier" );
+
+    // Prepare the input buffer depending on the metadata size.
+    // Unused trailing words must remain zeroed as they are part of the hashed block.
     if constexpr( metaKMultiplierIn == 1 )
     {
         /**
@@ -1152,8 +1310,8 @@ FORCE_INLINE uint64 ComputeFx( uint64 y, uint64* metaData, uint64* metaOut )
          *    0        1
          */
 
-        const uint64 l = reinterpret_cast<uint32*>( metaData )[0];
-        const uint64 r = reinterpret_cast<uint32*>( metaData )[1];
+        const uint64 l = reinterpret_cast<const uint32*>( metaData )[0];
+        const uint64 r = reinterpret_cast<const uint32*>( metaData )[1];
 
         input[0] = Swap64( y << 26 | l >> 6  );
         input[1] = Swap64( l << 58 | r << 26 );
@@ -1232,12 +1390,16 @@ FORCE_INLINE uint64 ComputeFx( uint64 y, uint64* metaData, uint64* metaOut )
         input[3] = Swap64( r0 << 26 | r1 >> 38 );
         input[4] = Swap64( r1 << 26 );
     }
+}
 
-
-    // Hash the input
-    blake3_hasher_init( &hasher );
-    blake3_hasher_update( &hasher, input, bufferSize );
-    blake3_hasher_finalize( &hasher, (uint8_t*)output, sizeof( output ) );
+//-----------------------------------------------------------
+template<size_t metaKMultiplierIn, size_t metaKMultiplierOut, uint ShiftBits>
+FORCE_INLINE uint64 ComputeFxFromHash( const uint64 output[4], uint64* metaOut )
+{
+    // Helper consts
+    const uint   k           = _K;
+    const uint32 ySize       = k + kExtraBits;         // = 38
+    const uint32 yShift      = 64 - (k + ShiftBits);   // = 26 or 32
 
     uint64 f = Swap64( *output ) >> yShift;
 
@@ -52,7 +52,7 @@ private:
                            ReadWriteBuffer<uint64>& metaBuffer );
 
     template<TableId tableId>
-    uint64 FpComputeSingleTable( uint64 entryCount, Pair* pairBuffer,
+    uint64 FpComputeSingleTable( uint64 entryCount, Pairs pairBuffer,
                                ReadWriteBuffer<uint64>& yBuffer, 
                                ReadWriteBuffer<uint64>& metaBuffer );
 
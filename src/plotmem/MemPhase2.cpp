@@ -1,5 +1,6 @@
 #include "MemPhase2.h"
 #include "DbgHelper.h"
+#include "util/BitField.h"
 
 ///
 /// Job structs
@@ -15,11 +16,10 @@ struct MarkJob
 {
     uint64      startIndex;
     uint64      rightEntryCount;
-    const Pair* rightEntries;
-    const byte* rightMarkedEntries;  // Used in tables <= 5
-    byte*       leftMarkingBuffer;
-
-    uint64      fieldPerMarkingBuffer;
+    const Pair* rightEntries;        // Used in table 6 (table 7's pairs are not packed)
+    Pairs       rightPackedEntries;  // Used in tables <= 5
+    BitField    rightMarkedEntries;  // Used in tables <= 5
+    BitField    leftMarkingBuffer;
 };
 
 ///
@@ -69,14 +69,13 @@ void MemPhase2::Run()
 
 
     // Now mark the rest of the tables
-    const Pair* rTables[7] = {
-        nullptr,
+    const Pairs rTables[6] = {
+        {},
         cx.t2LRBuffer,
         cx.t3LRBuffer,
         cx.t4LRBuffer,
         cx.t5LRBuffer,
-        cx.t6LRBuffer,
-        cx.t7LRBuffer
+        cx.t6LRBuffer
     };
 
     const bool isCompressed = cx.cfg.gCfg->compressionLevel > 0;
@@ -87,9 +86,8 @@ void MemPhase2::Run()
     //        pruning up to table 2 is enough.
     for( uint i = (int)TableId::Table7; i > endTable; i-- )
     {
-        const Pair*  rTable       = rTables[i];
         const uint64 rTableCount  = cx.entryCount[i];
-        byte* lTableMarkingBuffer = (byte*)cx.usedEntries[i-1];
+        uint64* lTableMarkingBuffer = cx.usedEntries[i-1];
 
         Log::Line( "  Prunning table %d...", i );
         auto timer = TimerBegin();
@@ -97,13 +95,13 @@ void MemPhase2::Run()
         if( i == (int)TableId::Table7 )
         {
             // Table 6 which does not have a rightMarkedEntries buffer, as all of table 7's entries are valid
-            MarkTable<false>( rTable, rTableCount, nullptr, lTableMarkingBuffer );
+            MarkTable<false>( cx.t7LRBuffer, {}, rTableCount, nullptr, lTableMarkingBuffer );
         }
         else
         {
-            const byte* rTableMarkedEntries = (byte*)cx.usedEntries[i];
+            const uint64* rTableMarkedEntries = cx.usedEntries[i];
 
-            MarkTable<true>( rTable, rTableCount, rTableMarkedEntries, lTableMarkingBuffer );
+            MarkTable<true>( nullptr, rTables[i], rTableCount, rTableMarkedEntries, lTableMarkingBuffer );
         }
 
         double elapsed = TimerEnd( timer );
@@ -119,10 +117,11 @@ void MemPhase2::ClearMarkingBuffers()
 {
     MemPlotContext& cx = _context;
 
-    const uint64 maxEntries    = 1ull << _K;
-    byte*        markingBuffer = (byte*)cx.yBuffer0;
+    const uint64 maxEntries    = 1ull << cx.k;
+    const uint64 fieldCount    = maxEntries / 64;  // 1 bit per entry
+    uint64*      markingBuffer = cx.yBuffer0;
 
-    const size_t totalSize     = maxEntries * 5;  // We need 5 buffers, for tables 2-6 
+    const size_t totalSize     = fieldCount * sizeof( uint64 ) * 5;  // We need 5 buffers, for tables 2-6 
     const uint   threadCount   = cx.threadCount;
 
     const size_t sizePerThread = totalSize / threadCount;
@@ -132,7 +131,7 @@ void MemPhase2::ClearMarkingBuffers()
     for ( uint64 i = 0; i < threadCount; i++ )
     {
         auto& job  = jobs[i];
-        job.buffer = markingBuffer + i * sizePerThread;
+        job.buffer = (byte*)markingBuffer + i * sizePerThread;
         job.size   = sizePerThread;
     }
 
@@ -145,15 +144,17 @@ void MemPhase2::ClearMarkingBuffers()
     cx.usedEntries[0] = nullptr;    // Table 1 has no need for marked entries
 
     for( uint i = 0; i < 5; i++ )
-        cx.usedEntries[i+1] = markingBuffer + i * maxEntries;
+        cx.usedEntries[i+1] = markingBuffer + i * fieldCount;
 }
 
 //-----------------------------------------------------------
 template<bool HasRightTableMarkingBuffer>
-void MemPhase2::MarkTable( const Pair* rightTable, uint64 rightEntryCount, const byte* rMarkedEntries, byte* lMarkingBuffer )
+void MemPhase2::MarkTable( const Pair* rightTable, const Pairs rightPackedTable, uint64 rightEntryCount, 
+                           const uint64* rMarkedEntries, uint64* lMarkingBuffer )
 {
     MemPlotContext& cx = _context;
 
+    const uint64 maxEntries            = 1ull << cx.k;
     const uint   threadCount           = cx.threadCount;
     const uint64 rightEntriesPerThread = rightEntryCount / threadCount;
 
@@ -166,8 +167,9 @@ void MemPhase2::MarkTable( const Pair* rightTable, uint64 rightEntryCount, const
         job.startIndex         = i * rightEntriesPerThread;
         job.rightEntryCount    = rightEntriesPerThread;
         job.rightEntries       = rightTable;
-        job.rightMarkedEntries = rMarkedEntries;
-        job.leftMarkingBuffer  = lMarkingBuffer;
+        job.rightPackedEntries = rightPackedTable;
+        job.rightMarkedEntries = BitField( (uint64*)rMarkedEntries, rightEntryCount );
+        job.leftMarkingBuffer  = BitField( lMarkingBuffer, maxEntries );
     }
 
     // Add trailing entries to the last job
@@ -191,19 +193,13 @@ void MarkEntriesThread( MarkJob* job )
 
     const Pair* rightEntries = job->rightEntries;
 
-    const byte* rightMarkedEntries = job->rightMarkedEntries;
-    byte* markingBuffer            = job->leftMarkingBuffer;
+    const BitField rightMarkedEntries = job->rightMarkedEntries;
+    BitField       markingBuffer      = job->leftMarkingBuffer;
     
-    // #NOTE: This can easily cause false sharing.
-    //        but since the region of data is so big, the thread acount
-    //        no expected to be so great (maybe max 256?)
-    //        and the data write locations are random, I don't
-    //        think it will cause that many misses.
-    //        In practice this method has been faster than others
-    //        which take false-sharing into account.
-    //        We also only write to the location, we don't care
-    //        about reading it, so we won't have any invalid data.
-    //       This means, thought, that this might not scale linearly, though.
+    // #NOTE: Pairs are sorted on y, so left entries are written at random locations
+    //        and 2 threads may write to the same field at any time.
+    //        Therefore bits are set atomically. Since the region of data is so big
+    //        and the write locations are random, contention on the same field is rare.
 
     for( uint64 i = startIndex; i < endIndex; i++ )
     {
@@ -213,14 +209,21 @@ void MarkEntriesThread( MarkJob* job )
             // in the right marked buffer, then skip it.
             // It did not contribute to the final f7 value,
             // so we don't need to consider it.
-            if( !rightMarkedEntries[i] )
+            if( !rightMarkedEntries.Get( i ) )
                 continue;
-        }
 
-        const Pair& entry = rightEntries[i];
+            const Pair entry = GetPackedPair( job->rightPackedEntries, i );
+
+            markingBuffer.SetAtomic( entry.left  );
+            markingBuffer.SetAtomic( entry.right );
+        }
+        else
+        {
+            const Pair& entry = rightEntries[i];
 
-        markingBuffer[entry.left ] = 1;
-        markingBuffer[entry.right] = 1;
+            markingBuffer.SetAtomic( entry.left  );
+            markingBuffer.SetAtomic( entry.right );
+        }
     }
 }
 
@@ -237,11 +240,11 @@ void DbgCountMarkedEntries( MemPlotContext& cx )
         uint64 originalCount = cx.entryCount[i];
         uint64 markedCount   = 0;
         
-        const byte* markedEntries = cx.usedEntries[i];
+        const BitField markedEntries( cx.usedEntries[i], originalCount );
 
         for( uint64 e = 0; e < originalCount; e++ )
         {
-            if( markedEntries[e] )
+            if( markedEntries.Get( e ) )
                 markedCount++;
         }
         
@@ -259,11 +262,16 @@ void DbgReadPhase1TableFiles( MemPlotContext& cx )
 {
     #if DBG_READ_PHASE_1_TABLES && !DBG_WRITE_PHASE_1_TABLES
         DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE1_FNAME  , cx.entryCount[0], cx.t1XBuffer , true );
-        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE2_FNAME  , cx.entryCount[1], cx.t2LRBuffer, true );
-        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE3_FNAME  , cx.entryCount[2], cx.t3LRBuffer, true );
-        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE4_FNAME  , cx.entryCount[3], cx.t4LRBuffer, true );
-        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE5_FNAME  , cx.entryCount[4], cx.t5LRBuffer, true );
-        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE6_FNAME  , cx.entryCount[5], cx.t6LRBuffer, true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE2_FNAME  , cx.entryCount[1], cx.t2LRBuffer.left , true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE2_FNAME ".r", cx.entryCount[1], cx.t2LRBuffer.right, true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE3_FNAME  , cx.entryCount[2], cx.t3LRBuffer.left , true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE3_FNAME ".r", cx.entryCount[2], cx.t3LRBuffer.right, true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE4_FNAME  , cx.entryCount[3], cx.t4LRBuffer.left , true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE4_FNAME ".r", cx.entryCount[3], cx.t4LRBuffer.right, true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE5_FNAME  , cx.entryCount[4], cx.t5LRBuffer.left , true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE5_FNAME ".r", cx.entryCount[4], cx.t5LRBuffer.right, true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE6_FNAME  , cx.entryCount[5], cx.t6LRBuffer.left , true );
+        DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE6_FNAME ".r", cx.entryCount[5], cx.t6LRBuffer.right, true );
         DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE7_FNAME  , cx.entryCount[6], cx.t7LRBuffer, true );
         DbgReadTableFromFile( *cx.threadPool, DBG_P1_TABLE7_Y_FNAME, cx.entryCount[6], cx.t7YBuffer , true );
     #endif
@@ -272,9 +280,9 @@ void DbgReadPhase1TableFiles( MemPlotContext& cx )
 //-----------------------------------------------------------
 void DbgReadWritePhase2MarkedEntries( MemPlotContext& cx, bool write )
 {
-    const uint64 maxEntries    = 1ull << _K;
-    byte*        markingBuffer = (byte*)cx.yBuffer0;
-    const size_t sizePerTable  = maxEntries;
+    const uint64 maxEntries    = 1ull << cx.k;
+    uint64*      markingBuffer = cx.yBuffer0;
+    const size_t fieldCount    = maxEntries / 64;
 
     const char* fileNames[6] = {
         nullptr,
@@ -289,18 +297,18 @@ void DbgReadWritePhase2MarkedEntries( MemPlotContext& cx, bool write )
 
     for( uint i = 1; i < 6; i++ )
     {
-        cx.usedEntries[i] = markingBuffer + (i-1) * sizePerTable;
+        cx.usedEntries[i] = markingBuffer + (i-1) * fieldCount;
 
         if( write )
         {
-            DbgWriteTableToFile( *cx.threadPool, fileNames[i], maxEntries, cx.usedEntries[i], true );
+            DbgWriteTableToFile( *cx.threadPool, fileNames[i], fieldCount, cx.usedEntries[i], true );
         }
         else
         {
             uint64 entryCount = 0;
           
             DbgReadTableFromFile( *cx.threadPool, fileNames[i], entryCount, cx.usedEntries[i], true );
-            if( entryCount != maxEntries )
+            if( entryCount != fieldCount )
             {
                 Log::Line( "Error: Invalid file. Wrong entry count." );
                 exit( 1 );
@@ -21,7 +21,8 @@ private:
     void ClearMarkingBuffers();
 
     template<bool HasRightTableMarkingBuffer>
-    void MarkTable( const Pair* rightTable, uint64 rightEntryCount, const byte* rMarkedEntries, byte* lMarkingBuffer );
+    void MarkTable( const Pair* rightTable, const Pairs rightPackedTable, uint64 rightEntryCount, 
+                    const uint64* rMarkedEntries, uint64* lMarkingBuffer );
 
 private:
     MemPlotContext& _context;
@@ -2,9 +2,13 @@
 #include "util/Util.h"
 #include "util/Log.h"
 #include "algorithm/RadixSort.h"
+#include "algorithm/HybridRadixSort.h"
+#include "plotting/LinePointBatch.h"
 #include "LPGen.h"
 #include "ParkWriter.h"
 #include <cmath>
+#include <bit>
+#include <mutex>
 
 #include "DbgHelper.h"
 #include "SysHost.h"
@@ -21,14 +25,13 @@ void MemPhase3::Run()
     MemPlotContext& cx = _context;
 
     // These will become the park buffer once processed.
-    Pair* rTables[7] = {
-        nullptr,
+    Pairs rTables[6] = {
+        {},
         cx.t2LRBuffer,
         cx.t3LRBuffer,
         cx.t4LRBuffer,
         cx.t5LRBuffer,
-        cx.t6LRBuffer,
-        cx.t7LRBuffer,
+        cx.t6LRBuffer
     };
 
     // This table will always be used as the left table.
@@ -49,18 +52,27 @@ void MemPhase3::Run()
 
     for( uint i = (uint)startTable; i < (uint)TableId::Table7; i++ )
     {
-        Pair*        rTable       = rTables[i+1];
         const uint64 rTableCount  = cx.entryCount[i+1];
-        const byte*  rUsedEntries = i < (uint)TableId::Table6 ? (byte*)cx.usedEntries[i+1] : nullptr;
 
         Log::Line( "  Compressing tables %u and %u...", i+1, i+2 );
         auto tableTimer = TimerBegin();
         
         uint64 newCount;
         if( i == (uint)TableId::Table6 )
-            newCount = ProcessTable<true> ( lTable, lpBuffer, rTable, rTableCount, rUsedEntries, (TableId)i );
+        {
+            // Table 7 is not pruned, so its pairs are converted to line points in-place,
+            // and the park is written to the LP buffer instead.
+            newCount = ProcessTable<true> ( lTable, (uint64*)cx.t7LRBuffer, (byte*)lpBuffer, {}, 
+                                            rTableCount, nullptr, (TableId)i );
+        }
         else
-            newCount = ProcessTable<false>( lTable, lpBuffer, rTable, rTableCount, rUsedEntries, (TableId)i ); 
+        {
+            const Pairs rTable       = rTables[i+1];
+            const uint64* rUsedEntries = cx.usedEntries[i+1];
+
+            newCount = ProcessTable<false>( lTable, lpBuffer, (byte*)rTable.left, rTable, 
+                                            rTableCount, rUsedEntries, (TableId)i ); 
+        }
 
         double tElapsed = TimerEnd( tableTimer );
         Log::Line( "  Finished compressing tables %u and %u in %.2lf seconds", i+1, i+2, tElapsed );
@@ -71,26 +83,18 @@ void MemPhase3::Run()
 
 //-----------------------------------------------------------
 template<bool IsTable6>
-uint64 MemPhase3::ProcessTable( uint32* lEntries, uint64* lpBuffer, Pair* rTable,
-                                const uint64 rTableCount, const byte* markedEntries, TableId tableId )
+uint64 MemPhase3::ProcessTable( uint32* lEntries, uint64* lpBuffer, byte* parkBuffer, const Pairs rTable,
+                                const uint64 rTableCount, const uint64* markedEntries, TableId tableId )
 {
     auto& cx = _context;
 
+    // Start each thread's entries at a bit field boundary, so that marked entries can be counted per-field
     const uint   threadCount      = cx.threadCount;
-    const uint64 entriesPerThread = rTableCount / threadCount;
+    const uint64 entriesPerThread = rTableCount / threadCount / 64 * 64;
     const uint64 trailingEntries  = rTableCount - ( entriesPerThread * threadCount );
 
-    if constexpr ( IsTable6 )
-    {
-        // ConverToLinePointThread reads fron lpBuffer,
-        // but since we haven't pruned rTable and moved it to lpBuffer,
-        // we need to swap it here, so that we read/write from/to it in ConverToLinePointThread
-        uint64* tmp = (uint64*)rTable;
-        rTable   = (Pair*)lpBuffer;
-        lpBuffer = tmp;
-    }
-
-    uint32* map = (uint32*)cx.metaBuffer1;
+    uint32* map    = (uint32*)cx.metaBuffer1;
+    uint64* lpTmp  = cx.yBuffer1;    // Not used in this phase, other than as a temporary sort buffer
 
     std::atomic<uint> threadSignal = 0;
     std::atomic<uint> releaseLock  = 0;
@@ -105,7 +109,7 @@ uint64 MemPhase3::ProcessTable( uint32* lEntries, uint64* lpBuffer, Pair* rTable
         job.lTable        = lEntries;
         job.length        = entriesPerThread;
         job.offset        = i * entriesPerThread;
-        job.rTable        = (Pair*)rTable;
+        job.rTable        = rTable;
         job.lpBuffer      = lpBuffer;
         job.jobs          = jobs;
 
@@ -135,33 +139,102 @@ uint64 MemPhase3::ProcessTable( uint32* lEntries, uint64* lpBuffer, Pair* rTable
     }
 
 
-    // Sort LinePoints, along with the map
-    RadixSort256::SortWithKey<MAX_THREADS>( *cx.threadPool,
-        lpBuffer, (uint64*)rTable,
-        map,      map + newLength,  // This is meta1, so there's plenty of space to hold both buffers
-        newLength );
-    
+    // Park parameters
+    size_t            parkSize    = CalculateParkSize( tableId, cx.k );
+    uint64            stubBitSize = (cx.k - kStubMinusBits);
+    const FSE_CTable* cTable      = CTables[(int)tableId];
+
+    if( tableId == TableId::Table2 && cx.cfg.gCfg->compressionLevel > 0 )
+    {
+        parkSize    = cx.cfg.gCfg->compressionInfo.tableParkSize;
+        stubBitSize = cx.cfg.gCfg->compressionInfo.stubSizeBits;
+        cTable      = cx.cfg.gCfg->ctable;
+    }
+
+    const uint32 lpSizeBits = (uint32)LinePointSizeBits( cx.k );
 
-    // Write lookup table (map it based on sort key)
+    // Write park for table (re-use rTable for it)
+    // #NOTE: For table 6: The park buffer is meta0.
+    // #TODO: Only aligned if the user asked for it
+    parkBuffer = _context.plotWriter->BlockAlignPtr<byte>( parkBuffer );
+
+    cx.plotWriter->BeginTable( (PlotTable)tableId );
+
+    // Sort LinePoints, along with the map, and stream the sorted buckets out as they complete:
+    // For each bucket, the lookup table is written (map it based on sort key) and all of the
+    // parks that end in it are written and queued to the plot writer, while the next buckets are still sorting.
     // After this step lEntries will contain the new index map into the LP's
-    cx.threadPool->RunJob( WriteLookupTableThread, jobs, threadCount );
+    uint64* sortedLPs = lpTmp;
+    uint32* sortedMap = map + newLength;    // This is meta1, so there's plenty of space to hold both buffers
 
+    // Parks are queued to the plot writer in order, so buckets
+    // which finish early are queued by the bucket that completes them.
+    constexpr uint32 MAX_BUCKETS = 1u << HybridRadixSort::MSD_BITS;
 
-    if constexpr ( IsTable6 )
+    std::mutex writeLock;
+    uint32     nextBucketToWrite = 0;
+    uint64     nextParkToWrite   = 0;
+    bool       bucketWritten [MAX_BUCKETS+1] = {};
+    uint64     bucketParksEnd[MAX_BUCKETS];
+
+    HybridRadixSort::SortWithKeyStreamed<MAX_THREADS>( *cx.threadPool, lpBuffer, sortedLPs, map, sortedMap, newLength, lpSizeBits,
+        [&]( const uint32 bucket, const uint64 start, const uint64 end ) {
+
+        for( uint64 i = start; i < end; i++ )
+            lEntries[sortedMap[i]] = (uint32)i;
+
+        // Parks that end in this bucket
+        const uint64 firstPark = start / kEntriesPerPark;
+        const uint64 endPark   = end   / kEntriesPerPark;
+
+        #if DBG_WRITE_LINE_POINTS
+            // Writing the parks converts their line points to deltas, keep a copy of them in the now unused input buffer
+            memcpy( lpBuffer + firstPark * kEntriesPerPark, sortedLPs + firstPark * kEntriesPerPark,
+                    ( endPark - firstPark ) * kEntriesPerPark * sizeof( uint64 ) );
+        #endif
+
+        for( uint64 park = firstPark; park < endPark; park++ )
+        {
+            WritePark( parkSize, kEntriesPerPark, sortedLPs + park * kEntriesPerPark, parkBuffer + park * parkSize,
+                       stubBitSize, cTable, lpSizeBits );
+        }
+
+        std::lock_guard<std::mutex> lock( writeLock );
+
+        bucketWritten [bucket] = true;
+        bucketParksEnd[bucket] = endPark;
+
+        while( bucketWritten[nextBucketToWrite] )
+        {
+            const uint64 parksEnd = bucketParksEnd[nextBucketToWrite++];
+
+            if( parksEnd > nextParkToWrite )
+            {
+                cx.plotWriter->WriteTableData( parkBuffer + nextParkToWrite * parkSize, ( parksEnd - nextParkToWrite ) * parkSize );
+                nextParkToWrite = parksEnd;
+            }
+        }
+    });
+
+    // Write trailing entries if any
+    const uint64 parkCount       = newLength / kEntriesPerPark;
+    const uint64 trailingLPs     = newLength - parkCount * kEntriesPerPark;
+    ASSERT( nextParkToWrite == parkCount );
+
+    if( trailingLPs )
     {
-        uint32* t7SortTmp       = (uint32*)cx.yBuffer0; // Don't need yBuffer0 at this point, safe to use
-        uint32* lEntriesSortTmp = (uint32*)cx.yBuffer1;
+        uint64* linePoints = sortedLPs + parkCount * kEntriesPerPark;
 
-        // We need to sort on f7 now, with lEntries with
-        // contain now the index into table 6's LinePoints
-        RadixSort256::SortWithKey<MAX_THREADS>( *cx.threadPool,
-            cx.t7YBuffer, t7SortTmp,
-            lEntries,     lEntriesSortTmp,
-            newLength );
+        #if DBG_WRITE_LINE_POINTS
+            memcpy( lpBuffer + parkCount * kEntriesPerPark, linePoints, trailingLPs * sizeof( uint64 ) );
+        #endif
 
-        cx.entryCount[(uint)TableId::Table7] = newLength;
+        WritePark( parkSize, trailingLPs, linePoints, parkBuffer + parkCount * parkSize, stubBitSize, cTable, lpSizeBits );
+        cx.plotWriter->WriteTableData( parkBuffer + parkCount * parkSize, parkSize );
     }
 
+    cx.plotWriter->EndTable();
+
     #if DBG_WRITE_LINE_POINTS
     {
         char filePath[512];
@@ -170,33 +243,20 @@ uint64 MemPhase3::ProcessTable( uint32* lEntries, uint64* lpBuffer, Pair* rTable
     }
     #endif
 
-    // Write park for table (re-use rTable for it)
-    // #NOTE: For table 6: rTable is meta0 here.
-    // #TODO: Only aligned if the user asked for it
-
-
-    byte*  parkBuffer     = _context.plotWriter->BlockAlignPtr<byte>( rTable );
-    // size_t sizeTableParks = WriteParks<MAX_THREADS>( *cx.threadPool, newLength, lpBuffer, parkBuffer, tableId );
-
-    size_t            parkSize    = CalculateParkSize( tableId );
-    uint64            stubBitSize = (_K - kStubMinusBits);
-    const FSE_CTable* cTable      = CTables[(int)tableId];
-
-    if( tableId == TableId::Table2 && cx.cfg.gCfg->compressionLevel > 0 )
+    if constexpr ( IsTable6 )
     {
-        parkSize    = cx.cfg.gCfg->compressionInfo.tableParkSize;
-        stubBitSize = cx.cfg.gCfg->compressionInfo.stubSizeBits;
-        cTable      = cx.cfg.gCfg->ctable;
-    }
+        uint32* t7SortTmp       = (uint32*)cx.yBuffer0; // Don't need yBuffer0 at this point, safe to use
+        uint32* lEntriesSortTmp = (uint32*)cx.yBuffer1; // Sorted line points have already been written to the parks
 
-    size_t sizeTableParks = WriteParks<MAX_THREADS>( *cx.threadPool, newLength, lpBuffer, parkBuffer, parkSize, stubBitSize, cTable );
+        // We need to sort on f7 now, with lEntries with
+        // contain now the index into table 6's LinePoints
+        RadixSort256::SortWithKey<MAX_THREADS>( *cx.threadPool,
+            cx.t7YBuffer, t7SortTmp,
+            lEntries,     lEntriesSortTmp,
+            newLength );
 
-    cx.plotWriter->BeginTable( (PlotTable)tableId );
-    cx.plotWriter->WriteTableData( parkBuffer, sizeTableParks );
-    cx.plotWriter->EndTable();
+        cx.entryCount[(uint)TableId::Table7] = newLength;
 
-    if constexpr ( IsTable6 )
-    {
         #if DBG_WRITE_SORTED_F7_TABLE
         {
             DbgWriteTableToFile( *cx.threadPool, DBG_TABLES_PATH "f7.tmp", newLength, cx.t7YBuffer, true );
@@ -259,24 +319,28 @@ void ProcessTableThread( LPJob* job )
 //-----------------------------------------------------------
 void PruneAndMapThread( LPJob* job )
 {
-    const byte*  markedEntries = job->markedEntries;
-
     uint64       length        = job->length;
 
     const uint64 srcOffset     = job->offset; 
-    const uint64 end           = srcOffset + length;
 
-    Pair* pairs = job->rTable;
+    // Our offset is always at a field boundary
+    ASSERT( ( srcOffset & 63 ) == 0 );
+    const uint64* fields       = job->markedEntries + srcOffset / 64;
+    const uint64  fieldCount   = CDiv( length, 64 );
+    const uint64  lastBits     = length & 63;
+    const uint64  lastMask     = lastBits ? ( 1ull << lastBits ) - 1 : ~0ull;  // Mask out the next thread's entries
 
-    // Scan entries
+    const Pairs pairs = job->rTable;
+
+    // Count marked entries
     {
         uint64 newLength = 0;
 
-        for( uint64 i = srcOffset; i < end; i++ )
-        {
-            if( markedEntries[i] )
-                newLength ++;
-        }
+        for( uint64 i = 0; i + 1 < fieldCount; i++ )
+            newLength += (uint64)std::popcount( fields[i] );
+
+        if( fieldCount )
+            newLength += (uint64)std::popcount( fields[fieldCount-1] & lastMask );
 
         length      = newLength;
         job->length = newLength;
@@ -308,15 +372,25 @@ void PruneAndMapThread( LPJob* job )
 
     uint64 dstI = 0;
 
-    for( uint64 i = srcOffset; i < end; i++ )
+    for( uint64 f = 0; f < fieldCount; f++ )
     {
-        if( !markedEntries[i] )
-            continue;
-        
-        newPairs[dstI] = pairs[i];  // Copy to new location
-        map     [dstI] = (uint32)i; // Map the entry back to its original location
+        uint64 field = fields[f];
+        if( f + 1 == fieldCount )
+            field &= lastMask;
 
-        dstI++; 
+        // Visit only the marked entries in this field
+        const uint64 fieldOffset = srcOffset + f * 64;
+
+        while( field )
+        {
+            const uint64 i = fieldOffset + (uint64)std::countr_zero( field );
+            field &= field - 1;
+
+            newPairs[dstI] = GetPackedPair( pairs, i );  // Unpack to new location
+            map     [dstI] = (uint32)i; // Map the entry back to its original location
+
+            dstI++; 
+        }
     }
 
     ASSERT( dstI == length );
@@ -330,32 +404,6 @@ void ConverToLinePointThread( LPJob* job )
     Pair*         rTable = (Pair*)(job->lpBuffer + job->offset);
     const uint32* lTable = job->lTable;
 
-    for( uint64 i = 0; i < length; i++ )
-    {
-        const Pair* rEntry = &rTable[i];
-        
-        const uint64 x = lTable[rEntry->left ];
-        const uint64 y = lTable[rEntry->right];
-        ASSERT( x || y );
-
-        const uint64 lp = SquareToLinePoint( x, y );
-        ASSERT( lp );
-        *((uint64*)rEntry) = lp;//SquareToLinePoint( x, y );
-    }
-}
-
-//-----------------------------------------------------------
-void WriteLookupTableThread( LPJob* job )
-{
-    const uint64  length = job->length;
-    const uint64  offset = job->offset;
-    const uint64  end    = offset + length;
-
-    const uint32* map    = job->map;
-    uint32*       lookup = job->lTable;
-
-    for( uint64 i = offset; i < end; i++ )
-        lookup[map[i]] = (uint32)i;
+    // Converted in-place, each line point overwrites the pair it was made from
+    PairsToLinePoints( lTable, rTable, length, (uint64*)rTable );
 }
-
-
@@ -12,9 +12,9 @@ public:
 
 private:
     template<bool IsTable6>
-    uint64 ProcessTable( uint32* lEntries, uint64* lpBuffer,
-                         Pair* rTable, const uint64 rTableCount, 
-                         const byte* markedEntries, TableId tableId );
+    uint64 ProcessTable( uint32* lEntries, uint64* lpBuffer, byte* parkBuffer,
+                         const Pairs rTable, const uint64 rTableCount, 
+                         const uint64* markedEntries, TableId tableId );
 
 private:
     MemPlotContext& _context;
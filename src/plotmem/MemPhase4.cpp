@@ -13,9 +13,9 @@ void MemPhase4::Run()
     // Use meta0 to write the final tables to disk
     MemPlotContext& cx = _context;
     
-    // The first 32 GiB of meta0 are used by phase 3 to write the table 6 park,
-    // so we need to offset here to write the rest.
-    cx.p4WriteBuffer = ((byte*)cx.metaBuffer0) + 32ull GB;
+    // The first 2^k * 8 bytes (32 GiB at k32) of meta0 are used by phase 3 
+    // to write the table 6 park, so we need to offset here to write the rest.
+    cx.p4WriteBuffer = ((byte*)cx.metaBuffer0) + ( 1ull << cx.k ) * sizeof( uint64 );
     cx.p4WriteBufferWriter = cx.p4WriteBuffer;
 
     WriteP7();
@@ -39,7 +39,7 @@ void MemPhase4::WriteP7()
     Log::Line( "  Writing P7." );
     auto timer = TimerBegin();
 
-    const size_t sizeWritten = WriteP7Parallel<MAX_THREADS>( *cx.threadPool, entryCount, lTable, p7Buffer );
+    const size_t sizeWritten = WriteP7Parallel<MAX_THREADS>( *cx.threadPool, cx.k, entryCount, lTable, p7Buffer );
     
     cx.p4WriteBufferWriter = ((byte*)p7Buffer) + sizeWritten;
     
@@ -58,13 +58,13 @@ void MemPhase4::WriteC1()
     MemPlotContext& cx = _context;
  
     const uint64 entryCount  = cx.entryCount[(int)TableId::Table7];
-    uint32*      writeBuffer = cx.plotWriter->BlockAlignPtr<uint32>( cx.p4WriteBufferWriter );
+    byte*        writeBuffer = cx.plotWriter->BlockAlignPtr<byte>( cx.p4WriteBufferWriter );
 
     Log::Line( "  Writing C1 table." );
     auto timer = TimerBegin();
 
     const size_t sizeWritten = WriteC12Parallel<MAX_THREADS, kCheckpoint1Interval>( 
-        *cx.threadPool, entryCount, cx.t7YBuffer, writeBuffer );
+        *cx.threadPool, cx.k, entryCount, cx.t7YBuffer, writeBuffer );
 
     cx.p4WriteBufferWriter = ((byte*)writeBuffer) + sizeWritten;
 
@@ -83,13 +83,13 @@ void MemPhase4::WriteC2()
     MemPlotContext& cx = _context;
  
     const uint64 entryCount  = cx.entryCount[(int)TableId::Table7];
-    uint32*      writeBuffer = cx.plotWriter->BlockAlignPtr<uint32>( cx.p4WriteBufferWriter );
+    byte*        writeBuffer = cx.plotWriter->BlockAlignPtr<byte>( cx.p4WriteBufferWriter );
 
     Log::Line( "  Writing C2 table." );
     auto timer = TimerBegin();
 
     const size_t sizeWritten = WriteC12Parallel<MAX_THREADS, kCheckpoint1Interval*kCheckpoint2Interval>( 
-        *cx.threadPool, entryCount, cx.t7YBuffer, writeBuffer );
+        *cx.threadPool, cx.k, entryCount, cx.t7YBuffer, writeBuffer );
 
     cx.p4WriteBufferWriter = ((byte*)writeBuffer) + sizeWritten;
 
@@ -114,7 +114,7 @@ void MemPhase4::WriteC3()
     auto timer = TimerBegin();
 
     const size_t sizeWritten = WriteC3Parallel<MAX_THREADS>( 
-         *cx.threadPool, entryCount, cx.t7YBuffer, writeBuffer );
+         *cx.threadPool, cx.k, entryCount, cx.t7YBuffer, writeBuffer );
 
     cx.p4WriteBufferWriter = ((byte*)writeBuffer) + sizeWritten;
 
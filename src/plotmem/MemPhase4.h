@@ -22,6 +22,7 @@ private:
 
 struct P7Job
 {
+    uint32        k;
     uint64        parkCount;
     const uint32* indices;
     byte*         parkBuffer;
@@ -29,9 +30,10 @@ struct P7Job
 
 struct C12Job
 {
+    uint32        k;
     uint64        length;
     const uint32* f7Entries;
-    uint32*       writeBuffer;
+    byte*         writeBuffer;
 
     #if DEBUG
         uint32 jobIndex;
@@ -43,33 +45,36 @@ struct C3Job
     uint64  parkCount;
     uint32* f7Entries;
     byte*   writeBuffer;
+    size_t  c3Size;
 };
 
 // P7
 template<uint MAX_JOBS>
-size_t WriteP7Parallel( ThreadPool& pool, const uint64 length, 
+size_t WriteP7Parallel( ThreadPool& pool, const uint32 k, const uint64 length, 
                         const uint32* indices, byte* parkBuffer );
 
-void WriteP7Parks( const uint64 parkCount, const uint32* indices, byte* parkBuffer );
-void WriteP7Entries( const uint64 length, const uint32* indices, byte* parkBuffer );
+void WriteP7Parks( const uint32 k, const uint64 parkCount, const uint32* indices, byte* parkBuffer );
+void WriteP7Entries( const uint32 k, const uint64 length, const uint32* indices, byte* parkBuffer );
 
 
 // C1 & C2 tables
-size_t WriteC12Parallel( ThreadPool& pool, const uint64 length, 
-                         const uint32* f7Entries, uint32* parkBuffer );
+// Entries are stored as big-endian k-bit values, left-aligned to CDiv( k, 8 ) bytes.
+template<uint MAX_JOBS, uint CInterval>
+size_t WriteC12Parallel( ThreadPool& pool, const uint32 k, const uint64 length, 
+                         const uint32* f7Entries, byte* parkBuffer );
 
 template<uint CInterval>
-void WriteC12Entries( const uint64 length, const uint32* f7Entries, uint32* c1Buffer );
+void WriteC12Entries( const uint32 k, const uint64 length, const uint32* f7Entries, byte* c1Buffer );
 
 // C3 parks
 uint64 GetC3ParkCount( const uint64 length );
 uint64 GetC3ParkCount( const uint64 length, uint64& outLastParkRemainder );
 
 template<uint MAX_JOBS>
-size_t WriteC3Parallel( ThreadPool& pool, const uint64 length, uint32* f7Entries, byte* c3Buffer );
+size_t WriteC3Parallel( ThreadPool& pool, const uint32 k, const uint64 length, uint32* f7Entries, byte* c3Buffer );
 
-void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer );
-void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer );
+void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer, const size_t c3Size );
+void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer, const size_t c3Size );
 
 
 ///
@@ -79,12 +84,12 @@ void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer );
 //-----------------------------------------------------------
 inline void WriteP7Thread( P7Job* job )
 {
-    WriteP7Parks( job->parkCount, job->indices, job->parkBuffer );
+    WriteP7Parks( job->k, job->parkCount, job->indices, job->parkBuffer );
 }
 
 //-----------------------------------------------------------
 template<uint MAX_JOBS>
-inline size_t WriteP7Parallel( ThreadPool& pool, const uint64 length, const uint32* indices, byte* parkBuffer )
+inline size_t WriteP7Parallel( ThreadPool& pool, const uint32 k, const uint64 length, const uint32* indices, byte* parkBuffer )
 {
     const uint32 threadCount     = std::min( pool.ThreadCount(), MAX_JOBS );
 
@@ -101,13 +106,12 @@ inline size_t WriteP7Parallel( ThreadPool& pool, const uint64 length, const uint
      *        park size buffer, so we don't have to worry about
      *        race conditions where a thread might write to its last field
      *        which is shared with the first thread's field as well.
-     *          33 (K+1) * kEntriesPerPark (2048)
-     *          = 67584 / 8
-     *          = 8448 / 8
-     *          = 1056 64-bit fields
+     *          (K+1) * kEntriesPerPark (2048) / 64
+     *          = (K+1) * 32 64-bit fields
+     *          = 1056 64-bit fields for k32
      */
-    const size_t parkSize = CDiv( (_K + 1) * kEntriesPerPark, 8 );
-    static_assert( parkSize / 8 == 1056 );
+    const size_t parkSize = CalculatePark7Size( k );
+    ASSERT( parkSize % 8 == 0 );
     
     P7Job jobs[MAX_JOBS];
 
@@ -118,6 +122,7 @@ inline size_t WriteP7Parallel( ThreadPool& pool, const uint64 length, const uint
     {
         auto& job = jobs[i];
 
+        job.k          = k;
         job.parkCount  = parksPerThread;
         job.indices    = threadIndices;
         job.parkBuffer = threadParkBuffer;
@@ -140,33 +145,33 @@ inline size_t WriteP7Parallel( ThreadPool& pool, const uint64 length, const uint
     if( trailingEntries )
     {
         memset( threadParkBuffer, 0, parkSize );
-        WriteP7Entries( trailingEntries, threadIndices, threadParkBuffer );
+        WriteP7Entries( k, trailingEntries, threadIndices, threadParkBuffer );
     }
 
     return totalParksWritten * parkSize;
 }
 
 //-----------------------------------------------------------
-inline void WriteP7Parks( const uint64 parkCount, const uint32* indices, byte* parkBuffer )
+inline void WriteP7Parks( const uint32 k, const uint64 parkCount, const uint32* indices, byte* parkBuffer )
 {
-    const size_t parkSize = CDiv( (_K + 1) * kEntriesPerPark, 8 );
+    const size_t parkSize = CalculatePark7Size( k );
 
     for( uint64 i = 0; i < parkCount; i++ )
     {
-        WriteP7Entries( kEntriesPerPark, indices, parkBuffer );
+        WriteP7Entries( k, kEntriesPerPark, indices, parkBuffer );
         indices    += kEntriesPerPark;
         parkBuffer += parkSize;
     }
 }
 
 //-----------------------------------------------------------
-inline void WriteP7Entries( const uint64 length, const uint32* indices, byte* parkBuffer )
+inline void WriteP7Entries( const uint32 k, const uint64 length, const uint32* indices, byte* parkBuffer )
 {
     uint64* fieldWriter = (uint64*)parkBuffer;
     
     // chiapos requires this to have an extra bit for some odd reason.
     // Otherwise we could have copied the buffer as-is.
-    const uint32 bitsPerEntry = _K + 1;
+    const uint32 bitsPerEntry = k + 1;
 
     uint64 field = 0;
     uint32 bits  = 0;
@@ -223,15 +228,16 @@ inline void WriteP7Entries( const uint64 length, const uint32* indices, byte* pa
 template<uint CInterval>
 inline void WriteC12Thread( C12Job* job )
 {
-    WriteC12Entries<CInterval>( job->length, job->f7Entries, job->writeBuffer );
+    WriteC12Entries<CInterval>( job->k, job->length, job->f7Entries, job->writeBuffer );
 }
 
 //-----------------------------------------------------------
 template<uint MAX_JOBS, uint CInterval>
-inline size_t WriteC12Parallel( ThreadPool& pool, const uint64 length, 
-                                const uint32* f7Entries, uint32* parkBuffer )
+inline size_t WriteC12Parallel( ThreadPool& pool, const uint32 k, const uint64 length, 
+                                const uint32* f7Entries, byte* parkBuffer )
 {
     const uint32 threadCount      = std::min( pool.ThreadCount(), MAX_JOBS );
+    const size_t entrySize        = CDiv( k, 8 );
 
     const uint64 parkEntries      = CDiv( length, (int) CInterval );
     const uint64 entriesPerThread = parkEntries / threadCount;
@@ -240,12 +246,13 @@ inline size_t WriteC12Parallel( ThreadPool& pool, const uint64 length,
     C12Job jobs[MAX_JOBS];
 
     const uint32* threadf7Entries = f7Entries;
-    uint32*       parkWriter      = parkBuffer;
+    byte*         parkWriter      = parkBuffer;
 
     for( uint32 i = 0; i < threadCount; i++ )
     {
         auto& job = jobs[i];
         
+        job.k           = k;
         job.length      = entriesPerThread;
         job.f7Entries   = threadf7Entries;
         job.writeBuffer = parkWriter;
@@ -255,14 +262,14 @@ inline size_t WriteC12Parallel( ThreadPool& pool, const uint64 length,
         #endif
         
         threadf7Entries += entriesPerThread * CInterval;
-        parkWriter      += entriesPerThread;
+        parkWriter      += entriesPerThread * entrySize;
     }
 
     pool.RunJob( WriteC12Thread<CInterval>, jobs, threadCount );
 
     // Write trailing entries, if any
     if( trailingEntries )
-        WriteC12Entries<CInterval>( trailingEntries, threadf7Entries, parkWriter );
+        WriteC12Entries<CInterval>( k, trailingEntries, threadf7Entries, parkWriter );
 
 
     if constexpr ( CInterval == kCheckpoint1Interval * kCheckpoint2Interval )
@@ -271,28 +278,33 @@ inline size_t WriteC12Parallel( ThreadPool& pool, const uint64 length,
         //  the C3 pointer by the C2 pointer. This does not work for us
         //  because since we do block-aligned writes we, our C2 size disk-occupied size
         //  will most likely be greater than the actual C2 size. 
-        //  To work around this, we can add a trailing entry with the maximum k32 value size.
-        //  This will force chiapos to stop at that point as the f7 is lesser than max k32 value.
-        //  #IMPORTANT: This means that we can't have any f7's that are 0xFFFFFFFF!.
-        parkWriter[trailingEntries] = 0xFFFFFFFF;
+        //  To work around this, we can add a trailing entry with the maximum k-sized value.
+        //  This will force chiapos to stop at that point as the f7 is lesser than max k value.
+        //  #IMPORTANT: This means that we can't have any f7's that are (1 << k) - 1!.
+        memset( parkWriter + trailingEntries * entrySize, 0xFF, entrySize );
     }
     else
     {
         
         // Write an empty one at the end (compatibility with chiapos)
-        parkWriter[trailingEntries] = 0;
+        memset( parkWriter + trailingEntries * entrySize, 0, entrySize );
     }
 
-    return (parkEntries + 1) * sizeof( uint32 );
+    return (parkEntries + 1) * entrySize;
 }
 
 //-----------------------------------------------------------
 template<uint CInterval>
-inline void WriteC12Entries( const uint64 length, const uint32* f7Entries, uint32* c1Buffer )
+inline void WriteC12Entries( const uint32 k, const uint64 length, const uint32* f7Entries, byte* c1Buffer )
 {
+    const size_t entrySize = CDiv( k, 8 );
+
     uint64 f7Src = 0;
     for( uint64 i = 0; i < length; i++, f7Src += CInterval )
-        c1Buffer[i] = Swap32( f7Entries[f7Src] );
+    {
+        const uint64 f7BE = Swap64( (uint64)f7Entries[f7Src] << ( 64 - k ) );
+        memcpy( c1Buffer + i * entrySize, &f7BE, entrySize );
+    }
 }
 
 
@@ -328,12 +340,12 @@ inline uint64 GetC3ParkCount( const uint64 length )
 //-----------------------------------------------------------
 inline void WriteC3Thread( C3Job* job )
 {
-    WriteC3Parks( job->parkCount, job->f7Entries, job->writeBuffer );
+    WriteC3Parks( job->parkCount, job->f7Entries, job->writeBuffer, job->c3Size );
 }
 
 //-----------------------------------------------------------
 template<uint MAX_JOBS>
-inline size_t WriteC3Parallel( ThreadPool& pool, const uint64 length, uint32* f7Entries, byte* c3Buffer )
+inline size_t WriteC3Parallel( ThreadPool& pool, const uint32 k, const uint64 length, uint32* f7Entries, byte* c3Buffer )
 {
     const uint32 threadCount       = std::min( pool.ThreadCount(), MAX_JOBS );
 
@@ -349,7 +361,7 @@ inline size_t WriteC3Parallel( ThreadPool& pool, const uint64 length, uint32* f7
     const bool   hasTrailingEntries = trailingEntries > 1;
     const uint64 totalParksWritten  = parkCount + ( hasTrailingEntries ? 1 : 0 );
     
-    const size_t c3Size = CalculateC3Size();
+    const size_t c3Size = CalculateC3Size( k );
 
     C3Job jobs[MAX_JOBS];
 
@@ -363,6 +375,7 @@ inline size_t WriteC3Parallel( ThreadPool& pool, const uint64 length, uint32* f7
         job.parkCount   = parksPerThread;
         job.f7Entries   = threadF7Entries;
         job.writeBuffer = threadC3Buffer;
+        job.c3Size      = c3Size;
 
         // Distribute trailing parks accross threads
         if( trailingParks )
@@ -380,19 +393,17 @@ inline size_t WriteC3Parallel( ThreadPool& pool, const uint64 length, uint32* f7
 
     // Write any trailing entries to a park
     if( hasTrailingEntries )
-        WriteC3Park( trailingEntries-1, threadF7Entries, threadC3Buffer );
+        WriteC3Park( trailingEntries-1, threadF7Entries, threadC3Buffer, c3Size );
 
     return totalParksWritten * c3Size;
 }
 
 //-----------------------------------------------------------
-inline void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer )
+inline void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* writeBuffer, const size_t c3Size )
 {
-    const size_t c3Size = CalculateC3Size();
-
     for( uint64 i = 0; i < parkCount; i++ )
     {
-        WriteC3Park( kCheckpoint1Interval-1, f7Entries, writeBuffer );
+        WriteC3Park( kCheckpoint1Interval-1, f7Entries, writeBuffer, c3Size );
 
         f7Entries   += kCheckpoint1Interval;
         writeBuffer += c3Size;
@@ -400,10 +411,8 @@ inline void WriteC3Parks( const uint64 parkCount, uint32* f7Entries, byte* write
 }
 
 //-----------------------------------------------------------
-inline void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer )
+inline void WriteC3Park( const uint64 length, uint32* f7Entries, byte* parkBuffer, const size_t c3Size )
 {
-    const size_t c3Size = CalculateC3Size();
-
     // Re-use f7Entries as the delta buffer. 
     // We won't use f7 entries after this, so we can re-write it.
     byte* deltaWriter = (byte*)f7Entries;
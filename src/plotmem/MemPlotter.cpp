@@ -1,7 +1,10 @@
 #include "MemPlotter.h"
 #include "threading/ThreadPool.h"
 #include "util/Util.h"
+#include "util/CliParser.h"
 #include "util/Log.h"
+#include "threading/MTJob.h"
+#include "util/jobs/MemJobs.h"
 #include "SysHost.h"
 
 #include "MemPhase1.h"
@@ -13,6 +16,14 @@
 void MemPlotter::ParseCLI( const GlobalPlotConfig& gCfg, CliParser& cli )
 {
     _context.cfg.gCfg = &gCfg;
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadSwitch( _context.cfg.numaLocal, "--numa-local" ) )
+            continue;
+        else
+            break;  // Let the caller handle trailing args
+    }
 }
 
 //----------------------------------------------------------
@@ -36,10 +47,31 @@ void MemPlotter::Init()
     }
 
     _context.threadCount = cfg.threadCount;
+    _context.k           = cfg.k;
     
     // Create a thread pool
     _context.threadPool = new ThreadPool( cfg.threadCount, ThreadPool::Mode::Fixed, cfg.disableCpuAffinity );
 
+    if( _context.cfg.numaLocal )
+    {
+        if( !numa )
+        {
+            Log::Line( "Warning: NUMA-local mode requires multiple NUMA nodes. Ignoring it." );
+            _context.cfg.numaLocal = false;
+        }
+        else
+        {
+            Log::Line( "Using NUMA-local table placement across %u nodes.", numa->nodeCount );
+
+            if( cfg.disableCpuAffinity )
+                Log::Line( "Warning: CPU affinity is disabled, threads won't be bound to their table slice's node." );
+            else
+            {
+                BindThreadPoolToNumaNodes( *_context.threadPool, *numa, 0 );
+            }
+        }
+    }
+
     // Allocate buffers
     {
         const size_t totalMemory = SysHost::GetTotalSystemMemory();
@@ -50,46 +82,47 @@ void MemPlotter::Init()
         // YBuffers need to round up to chacha block size, so we just add an extra block always
         const size_t chachaBlockSize  = kF1BlockSizeBits / 8;
 
-        const size_t t1XBuffer   = 16ull GB;
-        const size_t t2LRBuffer  = 32ull GB;
-        const size_t t3LRBuffer  = 32ull GB;
-        const size_t t4LRBuffer  = 32ull GB;
-        const size_t t5LRBuffer  = 32ull GB;
-        const size_t t6LRBuffer  = 32ull GB;
-        const size_t t7LRBuffer  = 32ull GB;
-        const size_t t7YBuffer   = 16ull GB;
-
-        const size_t yBuffer0    = 32ull GB + chachaBlockSize;
-        const size_t yBuffer1    = 32ull GB + chachaBlockSize;
-        const size_t metaBuffer0 = 64ull GB;
-        const size_t metaBuffer1 = 64ull GB;
-
-        const size_t reqMem = 
-            t1XBuffer   +
-            t2LRBuffer  +
-            t3LRBuffer  +
-            t4LRBuffer  +
-            t5LRBuffer  +
-            t6LRBuffer  +
-            t7LRBuffer  +
-            t7YBuffer   +
-            yBuffer0    +
-            yBuffer1    +
-            metaBuffer0 +
-            metaBuffer1;
+        // Each table holds up to 2^k entries
+        const uint64 maxEntries  = 1ull << cfg.k;
+
+        // Tables 2-6 hold packed pairs: A 32-bit left index and a 16-bit right offset
+        const size_t packedPairs = maxEntries * ( sizeof( uint32 ) + sizeof( uint16 ) );
+
+        const size_t t1XBuffer   = maxEntries * sizeof( uint32 );
+        const size_t t2LRBuffer  = packedPairs;
+        const size_t t3LRBuffer  = packedPairs;
+        const size_t t4LRBuffer  = packedPairs;
+        const size_t t5LRBuffer  = packedPairs;
+        const size_t t6LRBuffer  = packedPairs;
+        const size_t t7LRBuffer  = maxEntries * sizeof( Pair );
+        const size_t t7YBuffer   = maxEntries * sizeof( uint32 );
+
+        const size_t yBuffer0    = maxEntries * sizeof( uint64 ) + chachaBlockSize;
+        const size_t yBuffer1    = maxEntries * sizeof( uint64 ) + chachaBlockSize;
+        const size_t metaBuffer0 = maxEntries * sizeof( uint64 ) * 2;
+        const size_t metaBuffer1 = maxEntries * sizeof( uint64 ) * 2;
+
+        const size_t reqMem = GetRequiredMemory( cfg.k );
+        ASSERT( reqMem == t1XBuffer + t2LRBuffer + t3LRBuffer + t4LRBuffer + t5LRBuffer + t6LRBuffer +
+                          t7LRBuffer + t7YBuffer + yBuffer0 + yBuffer1 + metaBuffer0 + metaBuffer1 );
 
         Log::Line( "Memory required: %llu GiB.", reqMem BtoGB );
-        if( availMemory < reqMem  )
+
+        // All buffers are in use during phase 1, so this only completes with swap or overcommit
+        if( totalMemory < reqMem )
+            Log::Line( "Warning: The system only has %llu GiB of memory. Plotting will rely on swap. Consider diskplot or cudaplot instead.",
+                       (llu)( totalMemory BtoGB ) );
+        else if( availMemory < reqMem  )
             Log::Line( "Warning: Not enough memory available. Buffer allocation may fail." );
 
         Log::Line( "Allocating buffers." );
         _context.t1XBuffer   = SafeAlloc<uint32>( t1XBuffer  , warmStart, numa );
 
-        _context.t2LRBuffer  = SafeAlloc<Pair>  ( t2LRBuffer , warmStart, numa );
-        _context.t3LRBuffer  = SafeAlloc<Pair>  ( t3LRBuffer , warmStart, numa );
-        _context.t4LRBuffer  = SafeAlloc<Pair>  ( t4LRBuffer , warmStart, numa );
-        _context.t5LRBuffer  = SafeAlloc<Pair>  ( t5LRBuffer , warmStart, numa );
-        _context.t6LRBuffer  = SafeAlloc<Pair>  ( t6LRBuffer , warmStart, numa );
+        _context.t2LRBuffer  = SafeAllocPairs   ( t2LRBuffer , maxEntries, warmStart, numa );
+        _context.t3LRBuffer  = SafeAllocPairs   ( t3LRBuffer , maxEntries, warmStart, numa );
+        _context.t4LRBuffer  = SafeAllocPairs   ( t4LRBuffer , maxEntries, warmStart, numa );
+        _context.t5LRBuffer  = SafeAllocPairs   ( t5LRBuffer , maxEntries, warmStart, numa );
+        _context.t6LRBuffer  = SafeAllocPairs   ( t6LRBuffer , maxEntries, warmStart, numa );
 
         _context.t7YBuffer   = SafeAlloc<uint32>( t7YBuffer  , warmStart, numa );
         _context.t7LRBuffer  = SafeAlloc<Pair>  ( t7LRBuffer , warmStart, numa );
@@ -107,7 +140,7 @@ void MemPlotter::Init()
         // so we fit as many as we can in it.
         const size_t maxKbcGroups  = yBuffer0 / sizeof( uint32 );
 
-        // Since we use a meta buffer (64GiB) for pairing,
+        // Since we use a meta buffer (64GiB at k32) for pairing,
         // we can just use all its space to fit pairs.
         const size_t maxPairs      = metaBuffer0 / sizeof( Pair );
 
@@ -184,6 +217,10 @@ void MemPlotter::Run( const PlotRequest& request )
         Log::Line( "Finished Phase 4 in %.2lf seconds.", elapsed );
     }
 
+    // All the table pages have been faulted by now
+    if( cx.cfg.numaLocal && cx.plotCount == 0 )
+        ReportNumaPlacement();
+
     // Wait flush writer, if this is the final plot
     _context.plotWriter->EndPlot( true );
 
@@ -220,7 +257,7 @@ void MemPlotter::BeginPlotFile( const PlotRequest& request )
         _context.plotWriter = new PlotWriter();
     
     FatalIf( !_context.plotWriter->BeginPlot( PlotVersion::v2_0, request.outDir, request.plotFileName, 
-              request.plotId, request.memo, request.memoSize, _context.cfg.gCfg->compressionLevel ),
+              request.plotId, request.memo, request.memoSize, _context.cfg.gCfg->compressionLevel, _context.k ),
             "Failed to open plot file with error: %d", _context.plotWriter->GetError() );
 }
 
@@ -231,103 +268,204 @@ void MemPlotter::WaitPlotWriter()
     _context.plotWriter->DumpTables();
 }
 
+//-----------------------------------------------------------
+size_t MemPlotter::GetRequiredMemory( const uint32 k )
+{
+    const uint64 maxEntries      = 1ull << k;
+    const size_t chachaBlockSize = kF1BlockSizeBits / 8;
+
+    return maxEntries * sizeof( uint32 )                                    // Table 1 x
+         + maxEntries * ( sizeof( uint32 ) + sizeof( uint16 ) ) * 5         // Tables 2-6 packed pairs
+         + maxEntries * ( sizeof( Pair ) + sizeof( uint32 ) )               // Table 7 pairs and y
+         + ( maxEntries * sizeof( uint64 ) + chachaBlockSize ) * 2          // y buffers
+         + maxEntries * sizeof( uint64 ) * 2 * 2;                           // Meta buffers
+}
+
 ///
 /// Internal methods
 ///
+//-----------------------------------------------------------
+Pairs MemPlotter::SafeAllocPairs( size_t size, uint64 maxEntries, bool warmStart, const NumaInfo* numa )
+{
+    ASSERT( size >= maxEntries * ( sizeof( uint32 ) + sizeof( uint16 ) ) );
+
+    // Right offsets are stored right after all the left entries
+    Pairs pairs;
+    pairs.left  = (uint32*)AllocBuffer( size );
+    pairs.right = (uint16*)( pairs.left + maxEntries );
+
+    // Place each array on its own, as they are sliced across threads independently
+    const size_t leftSize = maxEntries * sizeof( uint32 );
+
+    PlaceBuffer( pairs.left , leftSize       , numa );
+    PlaceBuffer( pairs.right, size - leftSize, numa );
+
+    if( warmStart )
+        WarmStartBuffer( pairs.left, size );
+
+    return pairs;
+}
+
 //-----------------------------------------------------------
 template<typename T>
 T* MemPlotter::SafeAlloc( size_t size, bool warmStart, const NumaInfo* numa )
+{
+    T* ptr = (T*)AllocBuffer( size );
+
+    PlaceBuffer( ptr, size, numa );
+
+    if( warmStart )
+        WarmStartBuffer( ptr, size );
+
+    return ptr;
+}
+
+//-----------------------------------------------------------
+void* MemPlotter::AllocBuffer( size_t size )
 {
     #if DEBUG || BOUNDS_PROTECTION
     
-        const size_t originalSize = size;
-        const size_t pageSize     = SysHost::GetPageSize();
+        const size_t pageSize = SysHost::GetPageSize();
         size = pageSize * 2 + RoundUpToNextBoundary( size, (int)pageSize );
 
+        // The boundary pages can't be protected in explicit huge pages
+        const bool explicitHugePages = false;
+    #else
+        const bool explicitHugePages = true;
     #endif
 
-    T* ptr = (T*)SysHost::VirtualAlloc( size, false );
+    byte* ptr = (byte*)SysHost::VirtualAlloc( size, false, explicitHugePages );
 
     if( !ptr )
     {
         Fatal( "Error: Failed to allocate required buffers." );
     }
 
-    if( numa )
-    {
-        if( !SysHost::NumaSetMemoryInterleavedMode( ptr, size ) )
-            Log::Error( "Warning: Failed to bind NUMA memory." );
-    }
-
     // Protect memory boundaries
     #if DEBUG || BOUNDS_PROTECTION
     {
-        byte* p = (byte*)ptr;
-        ptr = (T*)(p + pageSize);
+        SysHost::VirtualProtect( ptr, pageSize, VProtect::NoAccess );
+        SysHost::VirtualProtect( ptr + size - pageSize, pageSize, VProtect::NoAccess );
 
-        SysHost::VirtualProtect( p, pageSize, VProtect::NoAccess );
-        SysHost::VirtualProtect( p + size - pageSize, pageSize, VProtect::NoAccess );
+        ptr += pageSize;
     }
     #endif
 
-    // Touch pages to initialize them, if specified
-    if( warmStart )
-    {
-        struct InitJob
-        {
-            byte*  pages;
-            size_t pageSize;
-            uint64 pageCount;
+    return ptr;
+}
 
-            inline static void Run( InitJob* job )
-            {
-                const size_t pageSize = job->pageSize;
+//-----------------------------------------------------------
+void MemPlotter::PlaceBuffer( void* ptr, size_t size, const NumaInfo* numa )
+{
+    if( !numa )
+        return;
 
-                byte*       page = job->pages;
-                const byte* end  = page + job->pageCount * pageSize;
+    if( _context.cfg.numaLocal )
+        AssignPagesToNumaNodes( ptr, size, *numa );
+    else if( !SysHost::NumaSetMemoryInterleavedMode( ptr, size ) )
+        Log::Error( "Warning: Failed to bind NUMA memory." );
+}
 
-                do {
-                    *page = 0;
-                    page += pageSize;
-                    
-                } while ( page < end );
-            }
-        };
+//-----------------------------------------------------------
+void MemPlotter::WarmStartBuffer( void* ptr, size_t size )
+{
+    // Touch pages to initialize them, across all threads
+    FaultMemoryPages::RunJob( *_context.threadPool, _context.threadPool->ThreadCount(), ptr, size );
+}
+
+
+///
+/// NUMA-local mode
+///
+//-----------------------------------------------------------
+void MemPlotter::BindThreadPoolToNumaNodes( ThreadPool& pool, const NumaInfo& numa, const uint32 nodeCpuOffset )
+{
+    // Thread i of n runs on node i * nodeCount / n. Jobs slice tables across threads
+    // in thread order, so this is the node AssignPagesToNumaNodes() places its slice on.
+    AnonMTJob::Run( pool, [&]( AnonMTJob* self ) {
+
+        const uint64 threadCount = self->JobCount();
+        const uint64 id          = self->JobId();
+        const uint64 node        = id * numa.nodeCount / threadCount;
+        const uint64 nodeFirstId = ( node * threadCount + numa.nodeCount - 1 ) / numa.nodeCount;
+
+        const Span<uint> cpus = numa.cpuIds[node];
+        SysHost::SetCurrentThreadAffinityCpuId( cpus[( nodeCpuOffset + id - nodeFirstId ) % cpus.Length()] );
+    });
+}
 
-        #if DEBUG || BOUNDS_PROTECTION
-            size = originalSize;
-        #endif
+//-----------------------------------------------------------
+void MemPlotter::AssignPagesToNumaNodes( void* ptr, const size_t size, const NumaInfo& numa )
+{
+    // Split the buffer into one contiguous range of pages per node, in node order
+    const size_t pageSize  = SysHost::GetPageSize();
+    const uint64 pageCount = CDiv( size, (int)pageSize );
 
-        InitJob jobs[MAX_THREADS];
+    byte* pages = (byte*)ptr;
+    ASSERT( ( (uintptr_t)pages & ( pageSize - 1 ) ) == 0 );
 
-        const uint   threadCount    = _context.threadPool->ThreadCount();
-        const size_t pageSize       = SysHost::GetPageSize();
-        const uint64 pageCount      = CDiv( size, (int)pageSize );
-        const uint64 pagesPerThread = pageCount / threadCount;
+    for( uint32 node = 0; node < numa.nodeCount; node++ )
+    {
+        const uint64 start = pageCount * node       / numa.nodeCount;
+        const uint64 end   = pageCount * ( node+1 ) / numa.nodeCount;
 
-        uint64 numRemainderPages = pageCount - ( pagesPerThread * threadCount );
+        if( end > start )
+            SysHost::NumaAssignPages( pages + start * pageSize, ( end - start ) * pageSize, node );
+    }
 
-        byte* pages = (byte*)ptr;
-        for( uint i = 0; i < threadCount; i++ )
-        {
-            InitJob& job = jobs[i];
+    if( _numaRegionCount < sizeof( _numaRegions ) / sizeof( _numaRegions[0] ) )
+        _numaRegions[_numaRegionCount++] = { pages, size };
+}
 
-            job.pages     = pages;
-            job.pageSize  = pageSize;
-            job.pageCount = pagesPerThread;
+//-----------------------------------------------------------
+void MemPlotter::ReportNumaPlacement()
+{
+    // Sample pages from each node's range and check that the kernel
+    // actually placed them there. Since each thread works on the range of
+    // its own node, this is the share of table traffic that stays node-local.
+    // (The scatter passes of sorts write across all nodes regardless.)
+    const NumaInfo* numa           = SysHost::GetNUMAInfo();
+    const size_t    pageSize       = SysHost::GetPageSize();
+    const uint64    samplesPerNode = 16;
+
+    uint64 localPages  = 0;
+    uint64 remotePages = 0;
+
+    for( uint32 i = 0; i < _numaRegionCount; i++ )
+    {
+        const NumaRegion& region    = _numaRegions[i];
+        const uint64      pageCount = CDiv( region.size, (int)pageSize );
+
+        for( uint32 node = 0; node < numa->nodeCount; node++ )
+        {
+            const uint64 start = pageCount * node       / numa->nodeCount;
+            const uint64 end   = pageCount * ( node+1 ) / numa->nodeCount;
 
-            if( numRemainderPages )
+            // Sample from the middle of evenly-sized intervals, to stay clear of
+            // the tail of the buffers, which may have never been written to.
+            for( uint64 s = 0; s < samplesPerNode && end > start; s++ )
             {
-                job.pageCount ++;
-                numRemainderPages --;
-            }
+                const uint64 page       = start + ( end - start ) * ( s * 2 + 1 ) / ( samplesPerNode * 2 );
+                const int    actualNode = SysHost::NumaGetNodeFromPage( region.ptr + page * pageSize );
+
+                if( actualNode < 0 )
+                    continue;
 
-            pages += pageSize * job.pageCount;
+                if( (uint32)actualNode == node )
+                    localPages++;
+                else
+                    remotePages++;
+            }
         }
+    }
 
-        _context.threadPool->RunJob( InitJob::Run, jobs, threadCount );
+    const uint64 totalPages = localPages + remotePages;
+    if( totalPages == 0 )
+    {
+        Log::Line( "Warning: Could not query the NUMA placement of the table buffers." );
+        return;
     }
 
-    return ptr;
+    Log::Line( "NUMA placement: %.2lf%% of sampled table pages are node-local to their threads (%llu local, %llu remote).",
+        localPages * 100.0 / totalPages, (llu)localPages, (llu)remotePages );
 }
-
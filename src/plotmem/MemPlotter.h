@@ -17,11 +17,25 @@ public:
     void Init() override;
     void Run( const PlotRequest& req ) override;
 
+    // Memory allocated for the plotting buffers at k
+    static size_t GetRequiredMemory( uint32 k );
+
 private:
 
     template<typename T>
     T* SafeAlloc( size_t size, bool warmStart, const NumaInfo* numa );
 
+    Pairs SafeAllocPairs( size_t size, uint64 maxEntries, bool warmStart, const NumaInfo* numa );
+
+    void* AllocBuffer( size_t size );
+    void  PlaceBuffer( void* ptr, size_t size, const NumaInfo* numa );
+    void  WarmStartBuffer( void* ptr, size_t size );
+
+    // NUMA-local mode
+    void BindThreadPoolToNumaNodes( ThreadPool& pool, const NumaInfo& numa, uint32 nodeCpuOffset );
+    void AssignPagesToNumaNodes( void* ptr, size_t size, const NumaInfo& numa );
+    void ReportNumaPlacement();
+
     void BeginPlotFile( const PlotRequest& request );
 
     // Check if the background plot writer finished
@@ -30,4 +44,14 @@ private:
 private:
 
     MemPlotContext _context = {};
+
+    // Buffer ranges placed in NUMA-local mode, to report their placement
+    struct NumaRegion
+    {
+        byte*  ptr;
+        size_t size;
+    };
+
+    NumaRegion _numaRegions[32];
+    uint32     _numaRegionCount = 0;
 };
\ No newline at end of file
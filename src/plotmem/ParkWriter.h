@@ -11,19 +11,23 @@ struct WriteParkJob
     byte*             parkBuffer;     // Buffer into which the parks will be written
     uint64            stubBitSize;
     const FSE_CTable* cTable;
+    uint32            linePointSizeBits;
     // TableId tableId;        // What table are we writing this park to?
 };
 
 // Write parks in parallel
 // Returns the total size written
 template<uint MaxJobs>
-size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoints, byte* parkBuffer, const size_t parkSize, const uint64 stubBitSize, const FSE_CTable* cTable );
+size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoints, byte* parkBuffer, const size_t parkSize, const uint64 stubBitSize, const FSE_CTable* cTable,
+                   uint32 linePointSizeBits = (uint32)LinePointSizeBits( _K ) );
 
 template<uint MaxJobs>
 size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoints, byte* parkBuffer, TableId tableId );
 
 // Write a single park.
-size_t WritePark( const size_t parkSize, const uint64 count, uint64* linePoints, byte* parkBuffer, const uint64 stubBitSize, const FSE_CTable* cTable );
+// The first line point is stored in linePointSizeBits (2k), left-aligned to a byte boundary.
+size_t WritePark( const size_t parkSize, const uint64 count, uint64* linePoints, byte* parkBuffer, const uint64 stubBitSize, const FSE_CTable* cTable,
+                  uint32 linePointSizeBits = (uint32)LinePointSizeBits( _K ) );
 size_t WritePark( const size_t parkSize, const uint64 count, uint64* linePoints, byte* parkBuffer, TableId tableId );
 
 void WriteParkThread( WriteParkJob* job );
@@ -41,7 +45,8 @@ inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoi
 
 //-----------------------------------------------------------
 template<uint MaxJobs>
-inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoints, byte* parkBuffer, const size_t parkSize, const uint64 stubBitSize, const FSE_CTable* cTable )
+inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoints, byte* parkBuffer, const size_t parkSize, const uint64 stubBitSize, const FSE_CTable* cTable,
+                          const uint32 linePointSizeBits )
 {
     const uint   threadCount    = MaxJobs > pool.ThreadCount() ? pool.ThreadCount() : MaxJobs;
     const uint64 parkCount      = length / kEntriesPerPark;
@@ -63,12 +68,13 @@ inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoi
     {
         auto& job = jobs[i];
 
-        job.parkSize    = parkSize;
-        job.parkCount   = parksPerThread;
-        job.linePoints  = threadLinePoints;
-        job.parkBuffer  = threadParkBuffer;
-        job.stubBitSize = stubBitSize;
-        job.cTable      = cTable;
+        job.parkSize          = parkSize;
+        job.parkCount         = parksPerThread;
+        job.linePoints        = threadLinePoints;
+        job.parkBuffer        = threadParkBuffer;
+        job.stubBitSize       = stubBitSize;
+        job.cTable            = cTable;
+        job.linePointSizeBits = linePointSizeBits;
         // job.tableId    = tableId;
 
         // Assign trailer parks accross threads. hehe
@@ -87,7 +93,7 @@ inline size_t WriteParks( ThreadPool& pool, const uint64 length, uint64* linePoi
 
     // Write trailing entries if any
     if( trailingEntries )
-        WritePark( parkSize, trailingEntries, threadLinePoints, threadParkBuffer, stubBitSize, cTable );
+        WritePark( parkSize, trailingEntries, threadLinePoints, threadParkBuffer, stubBitSize, cTable, linePointSizeBits );
 
 
     const size_t sizeWritten = parkSize * ( parkCount + (trailingEntries ? 1 : 0) );
@@ -106,16 +112,23 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
 
 //-----------------------------------------------------------
 inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* linePoints, byte* parkBuffer, 
-                         const uint64 stubBitSize, const FSE_CTable* cTable )
+                         const uint64 stubBitSize, const FSE_CTable* cTable, const uint32 linePointSizeBits )
 {
     ASSERT( count <= kEntriesPerPark );
-
-    uint64* writer = (uint64*)parkBuffer;
+    ASSERT( linePointSizeBits > 0 && linePointSizeBits <= 64 );
 
     // Write the first LinePoint as a full LinePoint
     uint64 prevLinePoint = linePoints[0];
 
-    *writer++ = Swap64( prevLinePoint );
+    const size_t linePointSize = CDiv( linePointSizeBits, 8 );
+    {
+        const uint64 linePointBE = Swap64( prevLinePoint << ( 64 - linePointSizeBits ) );
+        memcpy( parkBuffer, &linePointBE, linePointSize );
+    }
+
+    // The stubs start right after the first line point, which is not 8-byte aligned when k % 4 != 0,
+    // so the stub fields are stored with memcpy.
+    byte* writer = parkBuffer + linePointSize;
 
     // Convert to deltas
     for( uint64 i = 1; i < count; i++ )
@@ -130,7 +143,7 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
     // const uint64 stubBitSize      = (_K - kStubMinusBits);       // For us, it is 29 bits since K = 32
     const size_t stubSectionBytes = CDiv( (kEntriesPerPark - 1) * stubBitSize, 8 );
 
-    byte* deltaBytesWriter = ((byte*)writer) + stubSectionBytes;
+    byte* deltaBytesWriter = writer + stubSectionBytes;
 
     // Write stubs
     {
@@ -156,7 +169,9 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
                 field |= stub >> bits;
 
                 // Store field
-                *writer++ = Swap64( field );
+                const uint64 fieldBE = Swap64( field );
+                memcpy( writer, &fieldBE, sizeof( fieldBE ) );
+                writer += sizeof( fieldBE );
 
                 // Write the remaining stub bits (which may be none) into the next field
                 // if( bits )
@@ -186,7 +201,10 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
 
         // Write any trailing fields
         if( bits > 0 )
-            *writer++ = Swap64( field );
+        {
+            const uint64 fieldBE = Swap64( field );
+            memcpy( writer, &fieldBE, sizeof( fieldBE ) );
+        }
 
         // Zero-out any remaining unused bytes
         const size_t stubUsedBytes  = CDiv( (count - 1) * (size_t)stubBitSize, 8 );
@@ -231,10 +249,11 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
     // Write small deltas
     size_t parkSizeWritten = 0;
     {
-        uint16* deltaSizeWriter = (uint16*)deltaBytesWriter;
+        // Not 2-byte aligned for every k either
+        byte* deltaSizeWriter = deltaBytesWriter;
         deltaBytesWriter += 2;
 
-        const size_t deltasSizeAvailable = parkSize - sizeof( uint64 ) - CDiv( (count - 1) * stubBitSize, 8 );
+        const size_t deltasSizeAvailable = parkSize - linePointSize - CDiv( (count - 1) * stubBitSize, 8 );
 
         size_t deltasSize = FSE_compress_usingCTable( 
                                 deltaBytesWriter, (count-1) * 8,    // We don't use deltasSizeAvailable so we can use the fast-path instead. 
@@ -246,14 +265,16 @@ inline size_t WritePark( const size_t parkSize, const uint64 count, uint64* line
         if( !deltasSize )
         {
             // Deltas were NOT compressed, we have to copy them raw
-            deltasSize       = (count-1);
-            *deltaSizeWriter = (uint16)(deltasSize | 0x8000);
+            deltasSize = (count-1);
+            const uint16 deltaSizeField = (uint16)(deltasSize | 0x8000);
+            memcpy( deltaSizeWriter, &deltaSizeField, sizeof( deltaSizeField ) );
             memcpy( deltaBytesWriter, smallDeltas, count-1 );
         }
         else
         {
             // Deltas were compressed
-            *deltaSizeWriter = (uint16)deltasSize;
+            const uint16 deltaSizeField = (uint16)deltasSize;
+            memcpy( deltaSizeWriter, &deltaSizeField, sizeof( deltaSizeField ) );
         }
 
         deltaBytesWriter += deltasSize;
@@ -279,6 +300,7 @@ inline void WriteParkThread( WriteParkJob* job )
     const uint64  parkCount   = job->parkCount;
     const uint64  stubBitSize = job->stubBitSize;
     const auto*   cTable      = job->cTable;
+    const uint32  lpSizeBits  = job->linePointSizeBits;
     // const TableId tableId   = job->tableId;
 
     uint64* linePoints = job->linePoints;
@@ -286,7 +308,7 @@ inline void WriteParkThread( WriteParkJob* job )
 
     for( uint64 i = 0; i < parkCount; i++ )
     {
-        WritePark( parkSize, kEntriesPerPark, linePoints, parkBuffer, stubBitSize, cTable );
+        WritePark( parkSize, kEntriesPerPark, linePoints, parkBuffer, stubBitSize, cTable, lpSizeBits );
         
         linePoints += kEntriesPerPark;
         parkBuffer += parkSize;
@@ -171,6 +171,28 @@ void DiskBucketBuffer::CmdWriteSlices( const DiskBucketBufferCommand& cmd )
     // Offset to the starting location
     int64 offset = (int64)(c.vertical ? _sliceCapacity * c.bucket : GetBucketRowStride() * c.bucket );
 
+    // Write all slices concurrently, if possible
+    FileIOBatch* batch = _queue->IOBatch();
+    if( batch )
+    {
+        for( uint32 i = 0; i < _bucketCount; i++ )
+        {
+            batch->Write( _file, src, srcStride, offset, i );
+
+            offset += (int64)dstStride;
+            src    += srcStride;
+        }
+
+        uint32 slice;
+        if( !batch->Execute( err, slice ) )
+            Fatal( "Failed to write slice %u on '%s/%s' with error %d.", slice, _queue->Path(), Name(), err );
+
+        // Leave the file where the last sequential write would have
+        FatalIf( !_file.Seek( offset - (int64)dstStride + (int64)srcStride, SeekOrigin::Begin ),
+                    "Failed to seek on '%s/%s' with error %d.", _queue->Path(), Name(), (int32)_file.GetError() );
+        return;
+    }
+
     // Seek to starting location
     for( uint32 i = 0; i < _bucketCount; i++ )
     {
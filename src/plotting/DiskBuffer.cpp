@@ -100,7 +100,21 @@ void DiskBuffer::CmdWrite( const DiskBufferCommand& cmd )
 
     // Write a full block-aligned bucket
     int err = 0;
-    if( !IOJob::WriteToFileUnaligned( _file, _writeBuffers[c.bucket % 2], _alignedBufferSize, err ) )
+
+    FileIOBatch* batch = _queue->IOBatch();
+    if( batch )
+    {
+        // Split into multiple requests in flight
+        const int64 offset = (int64)_file.Position();
+        batch->Write( _file, _writeBuffers[c.bucket % 2], _alignedBufferSize, offset );
+
+        uint32 tag;
+        if( !batch->Execute( err, tag ) || !_file.Seek( offset + (int64)_alignedBufferSize, SeekOrigin::Begin ) )
+        {
+            Fatal( "Failed to write bucket to '%s/%s' with error %d.", _queue->Path(), Name(), err ? err : _file.GetError() );
+        }
+    }
+    else if( !IOJob::WriteToFileUnaligned( _file, _writeBuffers[c.bucket % 2], _alignedBufferSize, err ) )
     {
         Fatal( "Failed to write bucket to '%s/%s' with error %d.", _queue->Path(), Name(), err );
     }
@@ -112,7 +126,21 @@ void DiskBuffer::CmdRead( const DiskBufferCommand& cmd )
 
     // Read a full block-aligned bucket
     int err = 0;
-    if( !IOJob::ReadFromFileUnaligned( _file, _readBuffers[c.bucket % 2], _alignedBufferSize, err ) )
+
+    FileIOBatch* batch = _queue->IOBatch();
+    if( batch )
+    {
+        // Split into multiple requests in flight
+        const int64 offset = (int64)_file.Position();
+        batch->Read( _file, _readBuffers[c.bucket % 2], _alignedBufferSize, offset );
+
+        uint32 tag;
+        if( !batch->Execute( err, tag ) || !_file.Seek( offset + (int64)_alignedBufferSize, SeekOrigin::Begin ) )
+        {
+            Fatal( "Failed to read bucket from '%s/%s' with error %d.", _queue->Path(), Name(), err ? err : _file.GetError() );
+        }
+    }
+    else if( !IOJob::ReadFromFileUnaligned( _file, _readBuffers[c.bucket % 2], _alignedBufferSize, err ) )
     {
         Fatal( "Failed to read bucket from '%s/%s' with error %d.", _queue->Path(), Name(), err );
     }
@@ -4,7 +4,7 @@
 #include "threading/Fence.h"
 #include "plotdisk/jobs/IOJob.h"
 
-DiskQueue::DiskQueue( const char* path )
+DiskQueue::DiskQueue( const char* path, const uint32 ioQueueDepth )
     : Super()
     , _path( path )
 {
@@ -13,6 +13,10 @@ DiskQueue::DiskQueue( const char* path )
     _blockSize = FileStream::GetBlockSizeForPath( path );
     FatalIf( _blockSize < 1, "Failed to obtain file system block size for path '%s'", path );
 
+    // Falls back to blocking I/O if not available
+    if( ioQueueDepth > 0 )
+        _ioBatch.Init( ioQueueDepth );
+
     StartConsumer();
 }
 
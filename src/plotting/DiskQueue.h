@@ -3,6 +3,7 @@
 #include "threading/AutoResetSignal.h"
 #include "util/MPMCQueue.h"
 #include "util/CommandQueue.h"
+#include "io/FileIOBatch.h"
 
 class IStream;
 class Fence;
@@ -101,12 +102,20 @@ class DiskQueue : public MPCommandQueue<DiskQueueCommand, DiskQueueCommand::MAX_
     friend class DiskBucketBuffer;
 
 public:
-    DiskQueue( const char* path );
+    // ioQueueDepth is the number of reads and writes kept in flight with io_uring. 0 disables it.
+    DiskQueue( const char* path, uint32 ioQueueDepth = FileIOBatch::DefaultQueueDepth );
     ~DiskQueue();
 
     inline const char* Path() const { return _path.c_str(); }
     inline size_t      BlockSize() const { return _blockSize; }
 
+    // 0 if I/O is blocking
+    inline uint32      IOQueueDepth() const { return _ioBatch.IsValid() ? _ioBatch.QueueDepth() : 0; }
+
+    // Batch to keep reads and writes in flight with, or nullptr if I/O is blocking.
+    // Must only be used from the consumer thread, while handling a command.
+    inline FileIOBatch* IOBatch() { return _ioBatch.IsValid() ? &_ioBatch : nullptr; }
+
 protected:
     void ProcessCommands( const Span<DiskQueueCommand> items ) override;
 
@@ -117,5 +126,6 @@ private:
 private:
     std::string _path;          // Storage directory
     size_t      _blockSize = 0; // File system block size at path
+    FileIOBatch _ioBatch;       // Used by the consumer thread to keep slice reads/writes in flight, if io_uring is available
 };
 
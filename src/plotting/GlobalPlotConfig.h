@@ -12,6 +12,7 @@ struct GlobalPlotConfig
 {
     uint32 threadCount   = 0;
     uint32 plotCount     = 1;
+    uint32 k             = 32;     // Plot size. Only the ram plotter supports values other than 32.
 
     const char* plotIdStr    = nullptr;
     const char* plotMemoStr  = nullptr;
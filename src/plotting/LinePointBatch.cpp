@@ -0,0 +1,66 @@
+#include "LinePointBatch.h"
+
+typedef void (*PairsToLinePointsFunc)( const uint32* lTable, const Pair* pairs, uint64 count, uint64* outLinePoints );
+typedef void (*LinePointsToSquaresFunc)( const uint64* linePoints, uint64 count, BackPtr* outSquares );
+
+struct LinePointBatchImpl
+{
+    const char*             name;
+    PairsToLinePointsFunc   toLinePoints;
+    LinePointsToSquaresFunc toSquares;
+};
+
+//-----------------------------------------------------------
+static const LinePointBatchImpl& GetImpl()
+{
+    static const LinePointBatchImpl impl = []() -> LinePointBatchImpl {
+        #if BB_CPU_IS_X86
+            if( CpuSupportsAVX512F() )
+                return { "avx512", PairsToLinePointsAVX512, LinePointsToSquaresAVX512 };
+            if( CpuSupportsAVX2() )
+                return { "avx2", PairsToLinePointsAVX2, LinePointsToSquaresAVX2 };
+        #endif
+        return { "scalar", PairsToLinePointsScalar, LinePointsToSquaresScalar };
+    }();
+
+    return impl;
+}
+
+//-----------------------------------------------------------
+const char* GetLinePointBatchImplName()
+{
+    return GetImpl().name;
+}
+
+//-----------------------------------------------------------
+void PairsToLinePoints( const uint32* lTable, const Pair* pairs, const uint64 count, uint64* outLinePoints )
+{
+    GetImpl().toLinePoints( lTable, pairs, count, outLinePoints );
+}
+
+//-----------------------------------------------------------
+void LinePointsToSquares( const uint64* linePoints, const uint64 count, BackPtr* outSquares )
+{
+    GetImpl().toSquares( linePoints, count, outSquares );
+}
+
+//-----------------------------------------------------------
+void PairsToLinePointsScalar( const uint32* lTable, const Pair* pairs, const uint64 count, uint64* outLinePoints )
+{
+    for( uint64 i = 0; i < count; i++ )
+    {
+        const Pair   p = pairs[i];
+        const uint64 x = lTable[p.left ];
+        const uint64 y = lTable[p.right];
+
+        ASSERT( x || y );
+        outLinePoints[i] = SquareToLinePoint( x, y );
+    }
+}
+
+//-----------------------------------------------------------
+void LinePointsToSquaresScalar( const uint64* linePoints, const uint64 count, BackPtr* outSquares )
+{
+    for( uint64 i = 0; i < count; i++ )
+        outSquares[i] = LinePointToSquare64( linePoints[i] );
+}
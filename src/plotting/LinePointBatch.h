@@ -0,0 +1,35 @@
+#pragma once
+
+#include "plotting/PlotTypes.h"
+#include "plotmem/LPGen.h"
+#include "util/CpuFeatures.h"
+
+///
+/// Batched line point conversions for k <= 32, where all table positions are below 2^32.
+/// Results are identical to converting each entry with SquareToLinePoint and LinePointToSquare64.
+/// The exported functions use the widest SIMD implementation supported by the CPU.
+///
+
+// outLinePoints[i] = SquareToLinePoint( lTable[pairs[i].left], lTable[pairs[i].right] )
+// outLinePoints may be the same buffer as pairs, to convert them in-place.
+void PairsToLinePoints( const uint32* lTable, const Pair* pairs, uint64 count, uint64* outLinePoints );
+
+// outSquares[i] = LinePointToSquare64( linePoints[i] )
+// Line points must be below GetXEnc( 2^32 ), that is, their x must fit in 32 bits.
+void LinePointsToSquares( const uint64* linePoints, uint64 count, BackPtr* outSquares );
+
+// Name of the implementation selected by the functions above
+const char* GetLinePointBatchImplName();
+
+// Scalar implementations, which convert one entry at a time
+void PairsToLinePointsScalar( const uint32* lTable, const Pair* pairs, uint64 count, uint64* outLinePoints );
+void LinePointsToSquaresScalar( const uint64* linePoints, uint64 count, BackPtr* outSquares );
+
+#if BB_CPU_IS_X86
+// Must only be called if the CPU supports the instruction set
+void PairsToLinePointsAVX2  ( const uint32* lTable, const Pair* pairs, uint64 count, uint64* outLinePoints );
+void PairsToLinePointsAVX512( const uint32* lTable, const Pair* pairs, uint64 count, uint64* outLinePoints );
+
+void LinePointsToSquaresAVX2  ( const uint64* linePoints, uint64 count, BackPtr* outSquares );
+void LinePointsToSquaresAVX512( const uint64* linePoints, uint64 count, BackPtr* outSquares );
+#endif
@@ -0,0 +1,122 @@
+#include "LinePointBatch.h"
+#include <immintrin.h>
+
+// x * (x-1) / 2 for x < 2^32. The 64-bit product can't overflow, so the division can come last.
+// For x = 0, the low 32 bits of x-1 are multiplied by 0, so the result is 0, like GetXEnc.
+//-----------------------------------------------------------
+static inline __m256i GetXEncAVX2( const __m256i x )
+{
+    const __m256i xm1 = _mm256_sub_epi64( x, _mm256_set1_epi64x( 1 ) );
+    return _mm256_srli_epi64( _mm256_mul_epu32( x, xm1 ), 1 );
+}
+
+//-----------------------------------------------------------
+static inline __m256i PairsToLinePointsVec( const uint32* lTable, const Pair* pairs )
+{
+    const __m256i p  = _mm256_loadu_si256( (const __m256i*)pairs );
+    const __m256i li = _mm256_and_si256( p, _mm256_set1_epi64x( 0xFFFFFFFF ) );
+    const __m256i ri = _mm256_srli_epi64( p, 32 );
+
+    // 64-bit indices, as table positions may not fit in a signed 32-bit gather index
+    const __m256i x = _mm256_cvtepu32_epi64( _mm256_i64gather_epi32( (const int*)lTable, li, 4 ) );
+    const __m256i y = _mm256_cvtepu32_epi64( _mm256_i64gather_epi32( (const int*)lTable, ri, 4 ) );
+
+    // Signed compares are fine, since values are below 2^32
+    const __m256i yGreater = _mm256_cmpgt_epi64( y, x );
+    const __m256i hi       = _mm256_blendv_epi8( x, y, yGreater );
+    const __m256i lo       = _mm256_blendv_epi8( y, x, yGreater );
+
+    return _mm256_add_epi64( GetXEncAVX2( hi ), lo );
+}
+
+//-----------------------------------------------------------
+void PairsToLinePointsAVX2( const uint32* lTable, const Pair* pairs, const uint64 count, uint64* outLinePoints )
+{
+    uint64 i = 0;
+
+    for( ; i + 4 <= count; i += 4 )
+        _mm256_storeu_si256( (__m256i*)( outLinePoints + i ), PairsToLinePointsVec( lTable, pairs + i ) );
+
+    PairsToLinePointsScalar( lTable, pairs + i, count - i, outLinePoints + i );
+}
+
+// Converts values below 2^63 to double, rounding to nearest like a scalar conversion would.
+// The high and low 32 bits are placed in the mantissas of 2^84 and 2^52, which are then subtracted.
+//-----------------------------------------------------------
+static inline __m256d U64ToDoubleAVX2( const __m256i v )
+{
+    const __m256i hi = _mm256_or_si256( _mm256_srli_epi64( v, 32 ), _mm256_set1_epi64x( 0x4530000000000000ll ) );
+    const __m256i lo = _mm256_blend_epi32( _mm256_set1_epi64x( 0x4330000000000000ll ), v, 0x55 );
+
+    const __m256d hiD = _mm256_sub_pd( _mm256_castsi256_pd( hi ), _mm256_set1_pd( 19342813118337666422669312.0 ) );    // 2^84 + 2^52
+    return _mm256_add_pd( hiD, _mm256_castsi256_pd( lo ) );
+}
+
+// x is the largest value for which x * (x-1) / 2 <= lp, which is floor( ( 1 + sqrt( 1 + 8 * lp ) ) / 2 ).
+// The double precision estimate is at most 1 off, and is corrected with exact integer arithmetic.
+//-----------------------------------------------------------
+static inline void LinePointsToSquaresVec( const __m256i lp, __m256i& outX, __m256i& outY )
+{
+    const __m256d one    = _mm256_set1_pd( 1.0 );
+    const __m256d magic  = _mm256_set1_pd( 4503599627370496.0 );  // 2^52
+    const __m256i oneI   = _mm256_set1_epi64x( 1 );
+
+    __m256d xd = _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( U64ToDoubleAVX2( lp ), _mm256_set1_pd( 8.0 ) ), one ) );
+    xd = _mm256_floor_pd( _mm256_mul_pd( _mm256_add_pd( xd, one ), _mm256_set1_pd( 0.5 ) ) );
+    xd = _mm256_min_pd( xd, _mm256_set1_pd( 4294967295.0 ) );
+
+    // Integer bits of the estimate. Adding 2^52 places it at the bottom of the mantissa.
+    __m256i x = _mm256_xor_si256( _mm256_castpd_si256( _mm256_add_pd( xd, magic ) ), _mm256_castpd_si256( magic ) );
+    __m256i e = GetXEncAVX2( x );
+
+    // Too high: GetXEnc( x-1 ) = GetXEnc( x ) - ( x-1 )
+    const __m256i tooHigh = _mm256_cmpgt_epi64( e, lp );
+    x = _mm256_add_epi64( x, tooHigh );
+    e = _mm256_sub_epi64( e, _mm256_and_si256( x, tooHigh ) );
+
+    // Too low: GetXEnc( x+1 ) = GetXEnc( x ) + x
+    const __m256i eNext   = _mm256_add_epi64( e, x );
+    const __m256i tooLow  = _mm256_xor_si256( _mm256_cmpgt_epi64( eNext, lp ), _mm256_set1_epi64x( -1 ) );
+    x = _mm256_add_epi64( x, _mm256_and_si256( oneI, tooLow ) );
+    e = _mm256_blendv_epi8( e, eNext, tooLow );
+
+    outX = x;
+    outY = _mm256_sub_epi64( lp, e );
+}
+
+//-----------------------------------------------------------
+static inline void StoreSquaresAVX2( BackPtr* out, const __m256i x, const __m256i y )
+{
+    const __m256i lo = _mm256_unpacklo_epi64( x, y );   // x0 y0 x2 y2
+    const __m256i hi = _mm256_unpackhi_epi64( x, y );   // x1 y1 x3 y3
+
+    _mm256_storeu_si256( (__m256i*)out    , _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+    _mm256_storeu_si256( (__m256i*)out + 1, _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+//-----------------------------------------------------------
+void LinePointsToSquaresAVX2( const uint64* linePoints, const uint64 count, BackPtr* outSquares )
+{
+    uint64 i = 0;
+    __m256i x, y;
+
+    for( ; i + 4 <= count; i += 4 )
+    {
+        LinePointsToSquaresVec( _mm256_loadu_si256( (const __m256i*)( linePoints + i ) ), x, y );
+        StoreSquaresAVX2( outSquares + i, x, y );
+    }
+
+    const uint64 remainder = count - i;
+    if( remainder )
+    {
+        uint64  lps    [4] = {};
+        BackPtr squares[4];
+
+        memcpy( lps, linePoints + i, remainder * sizeof( uint64 ) );
+
+        LinePointsToSquaresVec( _mm256_loadu_si256( (const __m256i*)lps ), x, y );
+        StoreSquaresAVX2( squares, x, y );
+
+        memcpy( outSquares + i, squares, remainder * sizeof( BackPtr ) );
+    }
+}
@@ -0,0 +1,99 @@
+#include "LinePointBatch.h"
+#include <immintrin.h>
+
+// Same as the AVX2 kernels, with 8 lanes, and with unsigned compares and masks available.
+
+// The unmasked forms of some AVX-512 intrinsics pass an undefined vector as their source,
+// which GCC 12 reports as maybe-uninitialized. The all-lanes, zero-masked forms compile to the same instructions.
+static constexpr __mmask8 AllLanes = (__mmask8)0xFF;
+
+//-----------------------------------------------------------
+static inline __m512i GetXEncAVX512( const __m512i x )
+{
+    const __m512i xm1 = _mm512_sub_epi64( x, _mm512_set1_epi64( 1 ) );
+    return _mm512_maskz_srli_epi64( AllLanes, _mm512_maskz_mul_epu32( AllLanes, x, xm1 ), 1 );
+}
+
+//-----------------------------------------------------------
+void PairsToLinePointsAVX512( const uint32* lTable, const Pair* pairs, const uint64 count, uint64* outLinePoints )
+{
+    const __m512i lo32 = _mm512_set1_epi64( 0xFFFFFFFF );
+
+    uint64 i = 0;
+
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m512i p  = _mm512_loadu_si512( pairs + i );
+        const __m512i li = _mm512_and_si512( p, lo32 );
+        const __m512i ri = _mm512_maskz_srli_epi64( AllLanes, p, 32 );
+
+        const __m512i x = _mm512_maskz_cvtepu32_epi64( AllLanes, _mm512_mask_i64gather_epi32( _mm256_setzero_si256(), AllLanes, li, lTable, 4 ) );
+        const __m512i y = _mm512_maskz_cvtepu32_epi64( AllLanes, _mm512_mask_i64gather_epi32( _mm256_setzero_si256(), AllLanes, ri, lTable, 4 ) );
+
+        const __m512i lp = _mm512_add_epi64( GetXEncAVX512( _mm512_maskz_max_epu64( AllLanes, x, y ) ), _mm512_maskz_min_epu64( AllLanes, x, y ) );
+        _mm512_storeu_si512( outLinePoints + i, lp );
+    }
+
+    PairsToLinePointsScalar( lTable, pairs + i, count - i, outLinePoints + i );
+}
+
+//-----------------------------------------------------------
+static inline __m512d U64ToDoubleAVX512( const __m512i v )
+{
+    const __m512i hi = _mm512_or_si512( _mm512_maskz_srli_epi64( AllLanes, v, 32 ), _mm512_set1_epi64( 0x4530000000000000ll ) );
+    const __m512i lo = _mm512_mask_blend_epi32( 0x5555, _mm512_set1_epi64( 0x4330000000000000ll ), v );
+
+    const __m512d hiD = _mm512_sub_pd( _mm512_castsi512_pd( hi ), _mm512_set1_pd( 19342813118337666422669312.0 ) );    // 2^84 + 2^52
+    return _mm512_add_pd( hiD, _mm512_castsi512_pd( lo ) );
+}
+
+//-----------------------------------------------------------
+static inline void LinePointsToSquaresVec( const __m512i lp, __m512i& outX, __m512i& outY )
+{
+    const __m512d one   = _mm512_set1_pd( 1.0 );
+    const __m512d magic = _mm512_set1_pd( 4503599627370496.0 );   // 2^52
+    const __m512i oneI  = _mm512_set1_epi64( 1 );
+
+    __m512d xd = _mm512_maskz_sqrt_pd( AllLanes, _mm512_add_pd( _mm512_mul_pd( U64ToDoubleAVX512( lp ), _mm512_set1_pd( 8.0 ) ), one ) );
+    xd = _mm512_maskz_roundscale_pd( AllLanes, _mm512_mul_pd( _mm512_add_pd( xd, one ), _mm512_set1_pd( 0.5 ) ), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC );
+    xd = _mm512_maskz_min_pd( AllLanes, xd, _mm512_set1_pd( 4294967295.0 ) );
+
+    __m512i x = _mm512_xor_si512( _mm512_castpd_si512( _mm512_add_pd( xd, magic ) ), _mm512_castpd_si512( magic ) );
+    __m512i e = GetXEncAVX512( x );
+
+    const __mmask8 tooHigh = _mm512_cmpgt_epu64_mask( e, lp );
+    x = _mm512_mask_sub_epi64( x, tooHigh, x, oneI );
+    e = _mm512_mask_sub_epi64( e, tooHigh, e, x );
+
+    const __m512i  eNext  = _mm512_add_epi64( e, x );
+    const __mmask8 tooLow = _mm512_cmple_epu64_mask( eNext, lp );
+    x = _mm512_mask_add_epi64( x, tooLow, x, oneI );
+    e = _mm512_mask_mov_epi64( e, tooLow, eNext );
+
+    outX = x;
+    outY = _mm512_sub_epi64( lp, e );
+}
+
+//-----------------------------------------------------------
+void LinePointsToSquaresAVX512( const uint64* linePoints, const uint64 count, BackPtr* outSquares )
+{
+    const __m512i loIdx = _mm512_set_epi64( 11, 3, 10, 2, 9, 1, 8, 0 );
+    const __m512i hiIdx = _mm512_set_epi64( 15, 7, 14, 6, 13, 5, 12, 4 );
+
+    for( uint64 i = 0; i < count; i += 8 )
+    {
+        const uint64   remainder = std::min<uint64>( count - i, 8 );
+        const __mmask8 loadMask  = (__mmask8)( ( 1u << remainder ) - 1 );
+
+        __m512i x, y;
+        LinePointsToSquaresVec( _mm512_maskz_loadu_epi64( loadMask, linePoints + i ), x, y );
+
+        // Each output vector holds 4 squares
+        const uint32   words     = (uint32)remainder * 2;
+        const __mmask8 storeLo   = (__mmask8)( ( 1u << std::min( words, 8u ) ) - 1 );
+        const __mmask8 storeHi   = (__mmask8)( ( 1u << ( words > 8 ? words - 8 : 0 ) ) - 1 );
+
+        _mm512_mask_storeu_epi64( outSquares + i    , storeLo, _mm512_permutex2var_epi64( x, loIdx, y ) );
+        _mm512_mask_storeu_epi64( outSquares + i + 4, storeHi, _mm512_permutex2var_epi64( x, hiIdx, y ) );
+    }
+}
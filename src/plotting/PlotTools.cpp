@@ -5,32 +5,31 @@
 #define PLOT_FILE_DATE_LEN (sizeof("2021-08-05-18-55-")-1)
 
 //-----------------------------------------------------------
-void PlotTools::GenPlotFileName( const byte plotId[BB_PLOT_ID_LEN], char outPlotFileName[BB_COMPRESSED_PLOT_FILE_LEN_TMP], const uint32 compressionLevel )
+void PlotTools::GenPlotFileName( const byte plotId[BB_PLOT_ID_LEN], char outPlotFileName[BB_COMPRESSED_PLOT_FILE_LEN_TMP], 
+                                 const uint32 compressionLevel, const uint32 k )
 {
     ASSERT( plotId );
     ASSERT( outPlotFileName );
+    ASSERT( k >= BB_CHIA_K_MIN_VALUE && k < 100 );  // The file name length assumes a 2-digit k
 
     time_t     now = time( nullptr );
     struct tm* t   = localtime( &now ); ASSERT( t );
     
     const bool isCompressed = compressionLevel > 0;
 
-    const char classicFormat[]    = "plot-k32-";
-    const char compressedFormat[] = "plot-k32-c%02u-";
+    const char classicFormat[]    = "plot-k%u-";
+    const char compressedFormat[] = "plot-k%u-c%02u-";
     const char dateFormat[]       = "%Y-%m-%d-%H-%M-";
 
     size_t bufferLength = isCompressed ? BB_COMPRESSED_PLOT_FILE_LEN : BB_PLOT_FILE_LEN;
-    size_t prefixLength = sizeof( classicFormat ) - 1;
 
-    if( isCompressed )
-    {
-        int l = snprintf( outPlotFileName, bufferLength, compressedFormat, compressionLevel );
-        FatalIf( l <= 0, "Failed to prepare plot file name." );
-        prefixLength = (size_t)l;
-    }
-    else
-        memcpy( outPlotFileName, classicFormat, sizeof( classicFormat ) - 1 );
-    
+    const int l = isCompressed ? 
+        snprintf( outPlotFileName, bufferLength, compressedFormat, k, compressionLevel ) :
+        snprintf( outPlotFileName, bufferLength, classicFormat, k );
+    FatalIf( l <= 0, "Failed to prepare plot file name." );
+
+    const size_t prefixLength = (size_t)l;
+
     outPlotFileName += prefixLength;
     bufferLength    -= prefixLength;
 
@@ -52,11 +52,11 @@ void PlotWriter::EnablePlotChecking( PlotChecker& checker )
 //-----------------------------------------------------------
 bool PlotWriter::BeginPlot( PlotVersion version, 
     const char* plotFileDir, const char* plotFileName, const byte plotId[32],
-    const byte* plotMemo, const uint16 plotMemoSize, const uint32 compressionLevel )
+    const byte* plotMemo, const uint16 plotMemoSize, const uint32 compressionLevel, const uint32 k )
 {
     _readyToPlotSignal.Wait();
 
-    const bool r = BeginPlotInternal( version, plotFileDir, plotFileName, plotId, plotMemo, plotMemoSize, compressionLevel );
+    const bool r = BeginPlotInternal( version, plotFileDir, plotFileName, plotId, plotMemo, plotMemoSize, compressionLevel, k );
 
     if( !r )
         _readyToPlotSignal.Signal();
@@ -79,7 +79,7 @@ bool PlotWriter::BeginPlot( PlotVersion version,
 bool PlotWriter::BeginPlotInternal( PlotVersion version,
         const char* plotFileDir, const char* plotFileName, const byte plotId[32],
         const byte* plotMemo, const uint16 plotMemoSize,
-        int32 compressionLevel )
+        int32 compressionLevel, const uint32 k )
 {
     if( _dummyMode ) return true;
 
@@ -96,6 +96,7 @@ bool PlotWriter::BeginPlotInternal( PlotVersion version,
         return false;
 
     ASSERT( compressionLevel >= 0 && compressionLevel <= 9 );
+    ASSERT( k >= BB_CHIA_K_MIN_VALUE && k <= BB_CHIA_K_MAX_VALUE );
 
     if( compressionLevel > 0 && version < PlotVersion::v2_0 )
         return false;
@@ -195,7 +196,7 @@ bool PlotWriter::BeginPlotInternal( PlotVersion version,
         headerWriter += 32;
 
         // K
-        *headerWriter++ = (byte)_K;
+        *headerWriter++ = (byte)k;
 
         // Format description
         *((uint16*)headerWriter) = Swap16( (uint16)(sizeof( kFormatDescription ) - 1) );
@@ -227,7 +228,7 @@ bool PlotWriter::BeginPlotInternal( PlotVersion version,
         headerWriter += 32;
 
         // K
-        *headerWriter++ = (byte)_K;
+        *headerWriter++ = (byte)k;
 
         // Memo
         *((uint16*)headerWriter) = Swap16( plotMemoSize );
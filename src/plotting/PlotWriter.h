@@ -92,7 +92,7 @@ public:
     // Begins writing a new plot. Any previous plot must have finished before calling this
     bool BeginPlot( PlotVersion version, 
         const char* plotFileDir, const char* plotFileName, const byte plotId[32],
-        const byte* plotMemo, const uint16 plotMemoSize, uint32 compressionLevel = 0 );
+        const byte* plotMemo, const uint16 plotMemoSize, uint32 compressionLevel = 0, uint32 k = 32 );
 
     // bool BeginCompressedPlot( PlotVersion version, 
     //     const char* plotFileDir, const char* plotFileName, const byte plotId[32],
@@ -160,7 +160,7 @@ private:
     bool BeginPlotInternal( PlotVersion version,
         const char* plotFileDir, const char* plotFileName, const byte plotId[32],
         const byte* plotMemo, const uint16 plotMemoSize,
-        int32 compressionLevel );
+        int32 compressionLevel, uint32 k );
 
     bool CheckPlot();
 
@@ -0,0 +1,91 @@
+#include "KBCMatch.h"
+
+using namespace KBCMatchInternal;
+
+typedef uint64 (*MatchKBCGroupsFunc)( KBCRMap& rmap, const uint64* yBuffer, uint64 groupL,
+                                      uint64 lStart, uint64 lEnd, uint64 rStart, uint64 rEnd,
+                                      Pair* pairs, uint64 maxPairs, uint32 pairOffset, bool* outOverflowed );
+
+//-----------------------------------------------------------
+static MatchKBCGroupsFunc GetMatchFunc()
+{
+    static const MatchKBCGroupsFunc func = []() -> MatchKBCGroupsFunc {
+        #if BB_CPU_IS_X86
+            if( CpuSupportsAVX2() )
+                return MatchKBCGroupsAVX2;
+        #endif
+        return MatchKBCGroupsScalar;
+    }();
+
+    return func;
+}
+
+//-----------------------------------------------------------
+const char* GetKBCMatchImplName()
+{
+    #if BB_CPU_IS_X86
+        if( GetMatchFunc() == MatchKBCGroupsAVX2 )
+            return "avx2";
+    #endif
+    return "scalar";
+}
+
+//-----------------------------------------------------------
+uint64 MatchKBCGroups( KBCRMap& rmap, const uint64* yBuffer, const uint64 groupL,
+                       const uint64 lStart, const uint64 lEnd, const uint64 rStart, const uint64 rEnd,
+                       Pair* pairs, const uint64 maxPairs, const uint32 pairOffset, bool* outOverflowed )
+{
+    return GetMatchFunc()( rmap, yBuffer, groupL, lStart, lEnd, rStart, rEnd, pairs, maxPairs, pairOffset, outOverflowed );
+}
+
+//-----------------------------------------------------------
+uint64 MatchKBCGroupsScalar( KBCRMap& rmap, const uint64* yBuffer, const uint64 groupL,
+                             const uint64 lStart, const uint64 lEnd, const uint64 rStart, const uint64 rEnd,
+                             Pair* pairs, const uint64 maxPairs, const uint32 pairOffset, bool* outOverflowed )
+{
+    const uint32 parity      = (uint32)( groupL & 1 );
+    const uint64 lRangeStart = groupL * kBC;
+    const uint64 rRangeStart = lRangeStart + kBC;
+
+    BuildRMap( rmap, yBuffer, rStart, rEnd, rRangeStart );
+
+    uint64 pairCount  = 0;
+    bool   overflowed = false;
+
+    // For each group L entry
+    for( uint64 iL = lStart; iL < lEnd; iL++ )
+    {
+        const uint64 localL = yBuffer[iL] - lRangeStart;
+
+        // Iterate kExtraBitsPow = 1 << kExtraBits = 1 << 6 == 64
+        // So iterate 64 times for each L entry.
+        for( int iK = 0; iK < kExtraBitsPow; iK++ )
+        {
+            const uint16 targetR = L_targets[parity][localL][iK];
+
+            for( uint32 j = 0; j < rmap.counts[targetR]; j++ )
+            {
+                if( pairCount == maxPairs )
+                {
+                    overflowed = true;
+                    goto DONE;
+                }
+
+                const uint64 iR = rStart + rmap.indices[targetR] + j;
+                ASSERT( iL < iR );
+
+                Pair& pair = pairs[pairCount++];
+                pair.left  = (uint32)iL + pairOffset;
+                pair.right = (uint32)iR + pairOffset;
+            }
+        }
+    }
+
+DONE:
+    ClearRMap( rmap, yBuffer, rStart, rEnd, rRangeStart );
+
+    if( outOverflowed )
+        *outOverflowed = overflowed;
+
+    return pairCount;
+}
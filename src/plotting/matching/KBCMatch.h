@@ -0,0 +1,154 @@
+#pragma once
+
+#include "ChiaConsts.h"
+#include "plotting/PlotTypes.h"
+#include "util/CpuFeatures.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Entry counts are padded so that 32-bit gathers at any target index stay in bounds
+#define BB_KBC_RMAP_COUNT_SIZE ( ( kBC + 63 ) & ~63 )
+
+// Map of the y % kBC values of a right-side kBC group.
+// counts[v] holds how many R entries have the local value v, and
+// indices[v] the offset from the start of the group of the first one.
+// The map must be cleared with Clear() before its first use.
+// After that, the matching functions leave it cleared on return.
+struct KBCRMap
+{
+    alignas( 64 ) uint8  counts [BB_KBC_RMAP_COUNT_SIZE];
+    alignas( 64 ) uint16 indices[kBC];
+
+    inline void Clear() { memset( counts, 0, sizeof( counts ) ); }
+};
+
+// Finds all matches between the entries of a kBC group L in [lStart, lEnd) and
+// the entries of the adjacent group R (groupL+1) in [rStart, rEnd) in a sorted y buffer.
+// Pairs are written as indices into the y buffer plus pairOffset, ordered by
+// L entry and then by L_targets offset, the same as the reference matcher.
+// Returns the number of pairs written, which is at most maxPairs.
+// If outOverflowed is given, it is set to whether matches were dropped because maxPairs was reached.
+uint64 MatchKBCGroups( KBCRMap& rmap, const uint64* yBuffer, uint64 groupL,
+                       uint64 lStart, uint64 lEnd, uint64 rStart, uint64 rEnd,
+                       Pair* pairs, uint64 maxPairs, uint32 pairOffset = 0, bool* outOverflowed = nullptr );
+
+// Reference implementation which tests every L_targets entry one at a time.
+uint64 MatchKBCGroupsScalar( KBCRMap& rmap, const uint64* yBuffer, uint64 groupL,
+                             uint64 lStart, uint64 lEnd, uint64 rStart, uint64 rEnd,
+                             Pair* pairs, uint64 maxPairs, uint32 pairOffset = 0, bool* outOverflowed = nullptr );
+
+#if BB_CPU_IS_X86
+// Probes all 64 targets of an L entry with gathers into the R map.
+// Must only be called if the CPU supports AVX2.
+uint64 MatchKBCGroupsAVX2( KBCRMap& rmap, const uint64* yBuffer, uint64 groupL,
+                           uint64 lStart, uint64 lEnd, uint64 rStart, uint64 rEnd,
+                           Pair* pairs, uint64 maxPairs, uint32 pairOffset = 0, bool* outOverflowed = nullptr );
+#endif
+
+// Name of the implementation selected by MatchKBCGroups
+const char* GetKBCMatchImplName();
+
+
+namespace KBCMatchInternal
+{
+    //-----------------------------------------------------------
+    inline uint32 CountTrailingZeros( const uint64 v )
+    {
+        #if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64( &index, v );
+            return (uint32)index;
+        #else
+            return (uint32)__builtin_ctzll( v );
+        #endif
+    }
+
+    //-----------------------------------------------------------
+    inline void BuildRMap( KBCRMap& rmap, const uint64* yBuffer, const uint64 rStart, const uint64 rEnd, const uint64 rRangeStart )
+    {
+        ASSERT( rEnd - rStart <= 350 );
+
+        for( uint64 iR = rStart; iR < rEnd; iR++ )
+        {
+            const uint64 localRY = yBuffer[iR] - rRangeStart;
+            ASSERT( localRY < kBC );
+
+            if( rmap.counts[localRY] == 0 )
+                rmap.indices[localRY] = (uint16)( iR - rStart );
+
+            rmap.counts[localRY] ++;
+        }
+    }
+
+    // Only the entries that were set need clearing, which is cheaper than a memset of the whole map
+    //-----------------------------------------------------------
+    inline void ClearRMap( KBCRMap& rmap, const uint64* yBuffer, const uint64 rStart, const uint64 rEnd, const uint64 rRangeStart )
+    {
+        for( uint64 iR = rStart; iR < rEnd; iR++ )
+            rmap.counts[yBuffer[iR] - rRangeStart] = 0;
+    }
+
+    // Matches using a function which returns a bit mask of the
+    // L_targets offsets which hit a non-empty R map entry.
+    //-----------------------------------------------------------
+    template<typename TGetTargetMask>
+    inline uint64 MatchGroups( KBCRMap& rmap, const uint64* yBuffer, const uint64 groupL,
+                               const uint64 lStart, const uint64 lEnd, const uint64 rStart, const uint64 rEnd,
+                               Pair* pairs, const uint64 maxPairs, const uint32 pairOffset, bool* outOverflowed,
+                               TGetTargetMask GetTargetMask )
+    {
+        const uint32 parity      = (uint32)( groupL & 1 );
+        const uint64 lRangeStart = groupL * kBC;
+        const uint64 rRangeStart = lRangeStart + kBC;
+
+        BuildRMap( rmap, yBuffer, rStart, rEnd, rRangeStart );
+
+        uint64 pairCount  = 0;
+        bool   overflowed = false;
+
+        for( uint64 iL = lStart; iL < lEnd; iL++ )
+        {
+            const uint64  localL  = yBuffer[iL] - lRangeStart;
+            const uint16* targets = L_targets[parity][localL];
+            ASSERT( localL < kBC );
+
+            // Bits are visited in ascending order, so pairs are emitted in L_targets order
+            uint64 mask = GetTargetMask( rmap.counts, targets );
+
+            while( mask )
+            {
+                const uint32 iK = CountTrailingZeros( mask );
+                mask &= mask - 1;
+
+                const uint16 targetR = targets[iK];
+                const uint32 count   = rmap.counts[targetR];
+                const uint64 rIndex  = rStart + rmap.indices[targetR];
+
+                for( uint32 j = 0; j < count; j++ )
+                {
+                    if( pairCount == maxPairs )
+                    {
+                        overflowed = true;
+                        goto DONE;
+                    }
+
+                    ASSERT( iL < rIndex + j );
+
+                    Pair& pair = pairs[pairCount++];
+                    pair.left  = (uint32)iL + pairOffset;
+                    pair.right = (uint32)( rIndex + j ) + pairOffset;
+                }
+            }
+        }
+
+    DONE:
+        ClearRMap( rmap, yBuffer, rStart, rEnd, rRangeStart );
+
+        if( outOverflowed )
+            *outOverflowed = overflowed;
+
+        return pairCount;
+    }
+}
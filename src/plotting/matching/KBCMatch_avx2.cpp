@@ -0,0 +1,39 @@
+#include "KBCMatch.h"
+#include <immintrin.h>
+
+// Returns a bit mask of the 64 target offsets of an L entry whose R map count is not 0.
+// Targets are widened to 32-bit lanes and used to gather the counts 8 at a time.
+// The gathers read 4 bytes at each count, which is why the count map is padded.
+//-----------------------------------------------------------
+static inline uint64 GetTargetMaskAVX2( const uint8* counts, const uint16* targets )
+{
+    const __m256i byteMask = _mm256_set1_epi32( 0xFF );
+    const __m256i zero     = _mm256_setzero_si256();
+
+    uint64 mask = 0;
+
+    for( uint32 i = 0; i < kExtraBitsPow; i += 8 )
+    {
+        const __m256i idx    = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)( targets + i ) ) );
+        const __m256i cnt    = _mm256_and_si256( _mm256_i32gather_epi32( (const int*)counts, idx, 1 ), byteMask );
+        const __m256i empty  = _mm256_cmpeq_epi32( cnt, zero );
+        const uint32  hits   = ~(uint32)_mm256_movemask_ps( _mm256_castsi256_ps( empty ) ) & 0xFF;
+
+        mask |= (uint64)hits << i;
+    }
+
+    return mask;
+}
+
+//-----------------------------------------------------------
+uint64 MatchKBCGroupsAVX2( KBCRMap& rmap, const uint64* yBuffer, const uint64 groupL,
+                           const uint64 lStart, const uint64 lEnd, const uint64 rStart, const uint64 rEnd,
+                           Pair* pairs, const uint64 maxPairs, const uint32 pairOffset, bool* outOverflowed )
+{
+    static_assert( kExtraBitsPow == 64, "The target mask must fit in 64 bits." );
+
+    return KBCMatchInternal::MatchGroups( rmap, yBuffer, groupL, lStart, lEnd, rStart, rEnd, pairs, maxPairs, pairOffset, outOverflowed,
+        []( const uint8* counts, const uint16* targets ) {
+            return GetTargetMaskAVX2( counts, targets );
+        });
+}
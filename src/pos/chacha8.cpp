@@ -1,4 +1,6 @@
 #include "chacha8.h"
+#include "chacha8_impl.h"
+#include "util/CpuFeatures.h"
 
 #define U32TO32_LITTLE(v) (v)
 #define U8TO32_LITTLE(p) (*(const uint32_t *)(p))
@@ -54,7 +56,7 @@ void chacha8_keysetup(struct chacha8_ctx *x, const uint8_t *k, uint32_t kbits, c
     }
 }
 
-void chacha8_get_keystream(const struct chacha8_ctx *x, uint64_t pos, uint32_t n_blocks, uint8_t *c)
+void chacha8_get_keystream_portable(const struct chacha8_ctx *x, uint64_t pos, uint32_t n_blocks, uint8_t *c)
 {
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j0, j1, j2, j3, j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
@@ -147,3 +149,50 @@ void chacha8_get_keystream(const struct chacha8_ctx *x, uint64_t pos, uint32_t n
         c += 64;
     }
 }
+
+const char* chacha8_get_impl_name()
+{
+#if CHACHA8_IS_X86
+    if (CpuSupportsAVX512F())
+        return "avx512";
+    if (CpuSupportsAVX2())
+        return "avx2";
+    return "sse2";
+#else
+    return "portable";
+#endif
+}
+
+void chacha8_get_keystream(const struct chacha8_ctx *x, uint64_t pos, uint32_t n_blocks, uint8_t *c)
+{
+#if CHACHA8_IS_X86
+    // Process as many blocks as possible with the widest kernel available,
+    // then finish the remainder with narrower ones.
+    if (CpuSupportsAVX512F()) {
+        const uint32_t count = n_blocks & ~15u;
+        if (count) {
+            chacha8_get_keystream_avx512(x->input, pos, count, c);
+            pos += count; c += (size_t)count * 64; n_blocks -= count;
+        }
+    }
+
+    if (CpuSupportsAVX2()) {
+        const uint32_t count = n_blocks & ~7u;
+        if (count) {
+            chacha8_get_keystream_avx2(x->input, pos, count, c);
+            pos += count; c += (size_t)count * 64; n_blocks -= count;
+        }
+    }
+
+    {
+        const uint32_t count = n_blocks & ~3u;
+        if (count) {
+            chacha8_get_keystream_sse2(x->input, pos, count, c);
+            pos += count; c += (size_t)count * 64; n_blocks -= count;
+        }
+    }
+#endif
+
+    if (n_blocks)
+        chacha8_get_keystream_portable(x, pos, n_blocks, c);
+}
@@ -12,12 +12,23 @@ extern "C" {
 #endif
 
 void chacha8_keysetup(struct chacha8_ctx *x, const uint8_t *k, uint32_t kbits, const uint8_t *iv);
+// Selects the widest SIMD implementation supported by the CPU at runtime
 void chacha8_get_keystream(
     const struct chacha8_ctx *x,
     uint64_t pos,
     uint32_t n_blocks,
     uint8_t *c);
 
+// Scalar, one block at a time implementation
+void chacha8_get_keystream_portable(
+    const struct chacha8_ctx *x,
+    uint64_t pos,
+    uint32_t n_blocks,
+    uint8_t *c);
+
+// Name of the implementation selected by chacha8_get_keystream
+const char* chacha8_get_impl_name();
+
 
 void chacha8_get_keystream_cuda(
     const uint32_t* input,
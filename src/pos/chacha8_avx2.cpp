@@ -0,0 +1,100 @@
+#include "chacha8_impl.h"
+#include <immintrin.h>
+
+#define DEGREE 8
+
+CHACHA8_INLINE __m256i rotl( const __m256i v, const int n )
+{
+    return _mm256_or_si256( _mm256_slli_epi32( v, n ), _mm256_srli_epi32( v, 32 - n ) );
+}
+
+// 16 and 8-bit rotations are byte shuffles
+CHACHA8_INLINE __m256i rotl16( const __m256i v )
+{
+    return _mm256_shuffle_epi8( v, _mm256_set_epi8( 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                                    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2 ) );
+}
+
+CHACHA8_INLINE __m256i rotl8( const __m256i v )
+{
+    return _mm256_shuffle_epi8( v, _mm256_set_epi8( 14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                                    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3 ) );
+}
+
+#define QUARTERROUND(a, b, c, d)                                         \
+    a = _mm256_add_epi32( a, b ); d = rotl16( _mm256_xor_si256( d, a ) );    \
+    c = _mm256_add_epi32( c, d ); b = rotl( _mm256_xor_si256( b, c ), 12 );  \
+    a = _mm256_add_epi32( a, b ); d = rotl8( _mm256_xor_si256( d, a ) );     \
+    c = _mm256_add_epi32( c, d ); b = rotl( _mm256_xor_si256( b, c ), 7 )
+
+// Transposes 4 words of 8 blocks. Each 128-bit lane of out[i] holds 4 consecutive 
+// words of block i (low lane) and block i+4 (high lane).
+CHACHA8_INLINE void transpose4( const __m256i w0, const __m256i w1, const __m256i w2, const __m256i w3, __m256i out[4] )
+{
+    const __m256i t0 = _mm256_unpacklo_epi32( w0, w1 );
+    const __m256i t1 = _mm256_unpackhi_epi32( w0, w1 );
+    const __m256i t2 = _mm256_unpacklo_epi32( w2, w3 );
+    const __m256i t3 = _mm256_unpackhi_epi32( w2, w3 );
+
+    out[0] = _mm256_unpacklo_epi64( t0, t2 );
+    out[1] = _mm256_unpackhi_epi64( t0, t2 );
+    out[2] = _mm256_unpacklo_epi64( t1, t3 );
+    out[3] = _mm256_unpackhi_epi64( t1, t3 );
+}
+
+void chacha8_get_keystream_avx2( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c )
+{
+    __m256i j[16];
+
+    for( int i = 0; i < 16; i++ )
+        j[i] = _mm256_set1_epi32( (int)input[i] );
+
+    for( ; n_blocks >= DEGREE; n_blocks -= DEGREE, pos += DEGREE, c += DEGREE * 64 )
+    {
+        uint32_t lo[DEGREE], hi[DEGREE];
+        for( int i = 0; i < DEGREE; i++ )
+        {
+            lo[i] = (uint32_t)(pos + i);
+            hi[i] = (uint32_t)((pos + i) >> 32);
+        }
+
+        j[12] = _mm256_loadu_si256( (const __m256i*)lo );
+        j[13] = _mm256_loadu_si256( (const __m256i*)hi );
+
+        __m256i x[16];
+        for( int i = 0; i < 16; i++ )
+            x[i] = j[i];
+
+        for( int i = 8; i > 0; i -= 2 )
+        {
+            QUARTERROUND( x[0], x[4], x[8] , x[12] );
+            QUARTERROUND( x[1], x[5], x[9] , x[13] );
+            QUARTERROUND( x[2], x[6], x[10], x[14] );
+            QUARTERROUND( x[3], x[7], x[11], x[15] );
+            QUARTERROUND( x[0], x[5], x[10], x[15] );
+            QUARTERROUND( x[1], x[6], x[11], x[12] );
+            QUARTERROUND( x[2], x[7], x[8] , x[13] );
+            QUARTERROUND( x[3], x[4], x[9] , x[14] );
+        }
+
+        for( int i = 0; i < 16; i++ )
+            x[i] = _mm256_add_epi32( x[i], j[i] );
+
+        __m256i g[4][4];
+        transpose4( x[0] , x[1] , x[2] , x[3] , g[0] );
+        transpose4( x[4] , x[5] , x[6] , x[7] , g[1] );
+        transpose4( x[8] , x[9] , x[10], x[11], g[2] );
+        transpose4( x[12], x[13], x[14], x[15], g[3] );
+
+        for( int b = 0; b < 4; b++ )
+        {
+            uint8_t *lo_block = c + b * 64;
+            uint8_t *hi_block = c + (b + 4) * 64;
+
+            _mm256_storeu_si256( (__m256i*)(lo_block + 0 ), _mm256_permute2x128_si256( g[0][b], g[1][b], 0x20 ) );
+            _mm256_storeu_si256( (__m256i*)(lo_block + 32), _mm256_permute2x128_si256( g[2][b], g[3][b], 0x20 ) );
+            _mm256_storeu_si256( (__m256i*)(hi_block + 0 ), _mm256_permute2x128_si256( g[0][b], g[1][b], 0x31 ) );
+            _mm256_storeu_si256( (__m256i*)(hi_block + 32), _mm256_permute2x128_si256( g[2][b], g[3][b], 0x31 ) );
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include "chacha8_impl.h"
+#include <immintrin.h>
+
+#define DEGREE 16
+
+// The unmasked forms of some AVX-512 intrinsics pass _mm512_undefined_epi32() as their source,
+// which GCC 12 reports as maybe-uninitialized. The all-lanes, zero-masked forms compile to the same instructions.
+#define ALL_LANES_32 ((__mmask16)0xFFFF)
+#define ALL_LANES_64 ((__mmask8)0xFF)
+
+#define QUARTERROUND(a, b, c, d)                                                   \
+    a = _mm512_add_epi32( a, b ); d = _mm512_maskz_rol_epi32( ALL_LANES_32, _mm512_xor_si512( d, a ), 16 ); \
+    c = _mm512_add_epi32( c, d ); b = _mm512_maskz_rol_epi32( ALL_LANES_32, _mm512_xor_si512( b, c ), 12 ); \
+    a = _mm512_add_epi32( a, b ); d = _mm512_maskz_rol_epi32( ALL_LANES_32, _mm512_xor_si512( d, a ), 8  ); \
+    c = _mm512_add_epi32( c, d ); b = _mm512_maskz_rol_epi32( ALL_LANES_32, _mm512_xor_si512( b, c ), 7  )
+
+// Transposes 4 words of 16 blocks. The 128-bit lanes of out[i] hold 4 consecutive
+// words of blocks i, i+4, i+8 and i+12.
+CHACHA8_INLINE void transpose4( const __m512i w0, const __m512i w1, const __m512i w2, const __m512i w3, __m512i out[4] )
+{
+    const __m512i t0 = _mm512_maskz_unpacklo_epi32( ALL_LANES_32, w0, w1 );
+    const __m512i t1 = _mm512_maskz_unpackhi_epi32( ALL_LANES_32, w0, w1 );
+    const __m512i t2 = _mm512_maskz_unpacklo_epi32( ALL_LANES_32, w2, w3 );
+    const __m512i t3 = _mm512_maskz_unpackhi_epi32( ALL_LANES_32, w2, w3 );
+
+    out[0] = _mm512_maskz_unpacklo_epi64( ALL_LANES_64, t0, t2 );
+    out[1] = _mm512_maskz_unpackhi_epi64( ALL_LANES_64, t0, t2 );
+    out[2] = _mm512_maskz_unpacklo_epi64( ALL_LANES_64, t1, t3 );
+    out[3] = _mm512_maskz_unpackhi_epi64( ALL_LANES_64, t1, t3 );
+}
+
+void chacha8_get_keystream_avx512( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c )
+{
+    __m512i j[16];
+
+    for( int i = 0; i < 16; i++ )
+        j[i] = _mm512_set1_epi32( (int)input[i] );
+
+    for( ; n_blocks >= DEGREE; n_blocks -= DEGREE, pos += DEGREE, c += DEGREE * 64 )
+    {
+        uint32_t lo[DEGREE], hi[DEGREE];
+        for( int i = 0; i < DEGREE; i++ )
+        {
+            lo[i] = (uint32_t)(pos + i);
+            hi[i] = (uint32_t)((pos + i) >> 32);
+        }
+
+        j[12] = _mm512_loadu_si512( lo );
+        j[13] = _mm512_loadu_si512( hi );
+
+        __m512i x[16];
+        for( int i = 0; i < 16; i++ )
+            x[i] = j[i];
+
+        for( int i = 8; i > 0; i -= 2 )
+        {
+            QUARTERROUND( x[0], x[4], x[8] , x[12] );
+            QUARTERROUND( x[1], x[5], x[9] , x[13] );
+            QUARTERROUND( x[2], x[6], x[10], x[14] );
+            QUARTERROUND( x[3], x[7], x[11], x[15] );
+            QUARTERROUND( x[0], x[5], x[10], x[15] );
+            QUARTERROUND( x[1], x[6], x[11], x[12] );
+            QUARTERROUND( x[2], x[7], x[8] , x[13] );
+            QUARTERROUND( x[3], x[4], x[9] , x[14] );
+        }
+
+        for( int i = 0; i < 16; i++ )
+            x[i] = _mm512_add_epi32( x[i], j[i] );
+
+        __m512i g[4][4];
+        transpose4( x[0] , x[1] , x[2] , x[3] , g[0] );
+        transpose4( x[4] , x[5] , x[6] , x[7] , g[1] );
+        transpose4( x[8] , x[9] , x[10], x[11], g[2] );
+        transpose4( x[12], x[13], x[14], x[15], g[3] );
+
+        for( int b = 0; b < 4; b++ )
+        {
+            // Gather the 128-bit lanes of each block from the 4 word groups
+            const __m512i a0 = _mm512_maskz_shuffle_i32x4( ALL_LANES_32, g[0][b], g[1][b], 0x44 );
+            const __m512i a1 = _mm512_maskz_shuffle_i32x4( ALL_LANES_32, g[2][b], g[3][b], 0x44 );
+            const __m512i b0 = _mm512_maskz_shuffle_i32x4( ALL_LANES_32, g[0][b], g[1][b], 0xEE );
+            const __m512i b1 = _mm512_maskz_shuffle_i32x4( ALL_LANES_32, g[2][b], g[3][b], 0xEE );
+
+            _mm512_storeu_si512( c + (b + 0 ) * 64, _mm512_maskz_shuffle_i32x4( ALL_LANES_32, a0, a1, 0x88 ) );
+            _mm512_storeu_si512( c + (b + 4 ) * 64, _mm512_maskz_shuffle_i32x4( ALL_LANES_32, a0, a1, 0xDD ) );
+            _mm512_storeu_si512( c + (b + 8 ) * 64, _mm512_maskz_shuffle_i32x4( ALL_LANES_32, b0, b1, 0x88 ) );
+            _mm512_storeu_si512( c + (b + 12) * 64, _mm512_maskz_shuffle_i32x4( ALL_LANES_32, b0, b1, 0xDD ) );
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef SRC_CHACHA8_IMPL_H_
+#define SRC_CHACHA8_IMPL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CHACHA8_IS_X86 1
+#endif
+
+#if defined(_MSC_VER)
+    #define CHACHA8_INLINE static __forceinline
+#else
+    #define CHACHA8_INLINE static inline __attribute__((always_inline))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Multi-block keystream kernels.
+// Each processes blocks in parallel lanes (4, 8 and 16 blocks respectively),
+// n_blocks must be a multiple of the lane count.
+#if CHACHA8_IS_X86
+void chacha8_get_keystream_sse2( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c );
+void chacha8_get_keystream_avx2( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c );
+void chacha8_get_keystream_avx512( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c );
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CHACHA8_IMPL_H_
@@ -0,0 +1,69 @@
+#include "chacha8_impl.h"
+#include <emmintrin.h>
+
+#define DEGREE 4
+
+CHACHA8_INLINE __m128i rotl( const __m128i v, const int n )
+{
+    return _mm_or_si128( _mm_slli_epi32( v, n ), _mm_srli_epi32( v, 32 - n ) );
+}
+
+#define QUARTERROUND(a, b, c, d)                                  \
+    a = _mm_add_epi32( a, b ); d = rotl( _mm_xor_si128( d, a ), 16 ); \
+    c = _mm_add_epi32( c, d ); b = rotl( _mm_xor_si128( b, c ), 12 ); \
+    a = _mm_add_epi32( a, b ); d = rotl( _mm_xor_si128( d, a ), 8  ); \
+    c = _mm_add_epi32( c, d ); b = rotl( _mm_xor_si128( b, c ), 7  )
+
+// Transposes 4 words of 4 blocks so that each vector holds 4 consecutive words of a single block
+CHACHA8_INLINE void transpose_store( const __m128i w0, const __m128i w1, const __m128i w2, const __m128i w3, uint8_t *c )
+{
+    const __m128i t0 = _mm_unpacklo_epi32( w0, w1 );
+    const __m128i t1 = _mm_unpackhi_epi32( w0, w1 );
+    const __m128i t2 = _mm_unpacklo_epi32( w2, w3 );
+    const __m128i t3 = _mm_unpackhi_epi32( w2, w3 );
+
+    _mm_storeu_si128( (__m128i*)(c + 0*64), _mm_unpacklo_epi64( t0, t2 ) );
+    _mm_storeu_si128( (__m128i*)(c + 1*64), _mm_unpackhi_epi64( t0, t2 ) );
+    _mm_storeu_si128( (__m128i*)(c + 2*64), _mm_unpacklo_epi64( t1, t3 ) );
+    _mm_storeu_si128( (__m128i*)(c + 3*64), _mm_unpackhi_epi64( t1, t3 ) );
+}
+
+void chacha8_get_keystream_sse2( const uint32_t input[16], uint64_t pos, uint32_t n_blocks, uint8_t *c )
+{
+    __m128i j[16];
+
+    for( int i = 0; i < 16; i++ )
+        j[i] = _mm_set1_epi32( (int)input[i] );
+
+    for( ; n_blocks >= DEGREE; n_blocks -= DEGREE, pos += DEGREE, c += DEGREE * 64 )
+    {
+        j[12] = _mm_setr_epi32( (int)(uint32_t)(pos+0), (int)(uint32_t)(pos+1), 
+                                (int)(uint32_t)(pos+2), (int)(uint32_t)(pos+3) );
+        j[13] = _mm_setr_epi32( (int)(uint32_t)((pos+0) >> 32), (int)(uint32_t)((pos+1) >> 32), 
+                                (int)(uint32_t)((pos+2) >> 32), (int)(uint32_t)((pos+3) >> 32) );
+
+        __m128i x[16];
+        for( int i = 0; i < 16; i++ )
+            x[i] = j[i];
+
+        for( int i = 8; i > 0; i -= 2 )
+        {
+            QUARTERROUND( x[0], x[4], x[8] , x[12] );
+            QUARTERROUND( x[1], x[5], x[9] , x[13] );
+            QUARTERROUND( x[2], x[6], x[10], x[14] );
+            QUARTERROUND( x[3], x[7], x[11], x[15] );
+            QUARTERROUND( x[0], x[5], x[10], x[15] );
+            QUARTERROUND( x[1], x[6], x[11], x[12] );
+            QUARTERROUND( x[2], x[7], x[8] , x[13] );
+            QUARTERROUND( x[3], x[4], x[9] , x[14] );
+        }
+
+        for( int i = 0; i < 16; i++ )
+            x[i] = _mm_add_epi32( x[i], j[i] );
+
+        transpose_store( x[0] , x[1] , x[2] , x[3] , c + 0  );
+        transpose_store( x[4] , x[5] , x[6] , x[7] , c + 16 );
+        transpose_store( x[8] , x[9] , x[10], x[11], c + 32 );
+        transpose_store( x[12], x[13], x[14], x[15], c + 48 );
+    }
+}
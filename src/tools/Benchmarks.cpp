@@ -0,0 +1,476 @@
+#include "plotting/GlobalPlotConfig.h"
+#include "util/CliParser.h"
+#include "util/Log.h"
+#include "util/Util.h"
+#include "threading/ThreadPool.h"
+#include "algorithm/RadixSort.h"
+#include "algorithm/HybridRadixSort.h"
+#include "plotting/matching/KBCMatch.h"
+#include "plotting/LinePointBatch.h"
+#include "SysHost.h"
+#include "ChiaConsts.h"
+#include <random>
+#include <algorithm>
+#include "pos/chacha8.h"
+#include "b3/blake3.h"
+
+void BenchPrintUsage();
+
+struct BenchConfig
+{
+    size_t size        = 64ull MB;   // Working set size in bytes
+    uint32 passes      = 3;
+    uint32 threadCount = 1;          // For multi-threaded benchmarks
+};
+
+struct Benchmark
+{
+    const char* name;
+    const char* description;
+    void (*run)( const BenchConfig& cfg );
+};
+
+static void BenchChaCha8( const BenchConfig& cfg );
+static void BenchBlake3( const BenchConfig& cfg );
+static void BenchSort( const BenchConfig& cfg );
+static void BenchMatch( const BenchConfig& cfg );
+static void BenchLinePoint( const BenchConfig& cfg );
+
+static const Benchmark BENCHMARKS[] = {
+    { "chacha8"  , "ChaCha8 F1 keystream generation. SIMD multi-block vs. portable.", BenchChaCha8   },
+    { "blake3"   , "BLAKE3 Fx hashing. Batched multi-lane vs. per-entry hasher."    , BenchBlake3    },
+    { "sort"     , "Keyed y sort. Cache-blocked hybrid radix sort vs. RadixSort256." , BenchSort      },
+    { "match"    , "kBC group matching. SIMD target probing vs. scalar."              , BenchMatch     },
+    { "linepoint", "Line point conversion in both directions. SIMD vs. scalar."       , BenchLinePoint },
+};
+
+
+//-----------------------------------------------------------
+void BenchMain( GlobalPlotConfig& gCfg, CliParser& cli )
+{
+    BenchConfig cfg;
+    const char* benchName = nullptr;
+
+    const uint32 maxThreads = SysHost::GetLogicalCPUCount();
+    cfg.threadCount = gCfg.threadCount == 0 ? maxThreads : std::min( gCfg.threadCount, maxThreads );
+
+    while( cli.HasArgs() )
+    {
+        if( cli.ReadSize( cfg.size, "-s", "--size" ) )
+        {
+            FatalIf( cfg.size < 1, "Size must be > 0." );
+        }
+        else if( cli.ReadU32( cfg.passes, "-p", "--passes" ) )
+        {
+            if( cfg.passes < 1 ) cfg.passes = 1;
+            continue;
+        }
+        else if( cli.ArgConsume( "-h", "--help" ) )
+        {
+            BenchPrintUsage();
+            exit( 0 );
+        }
+        else if( cli.IsLastArg() )
+        {
+            benchName = cli.ArgConsume();
+        }
+        else
+        {
+            Fatal( "Unexpected argument '%s'.", cli.Arg() );
+        }
+    }
+
+    FatalIf( benchName == nullptr, "Expected a benchmark name as the last argument." );
+
+    for( const Benchmark& bench : BENCHMARKS )
+    {
+        if( strcmp( bench.name, benchName ) == 0 )
+        {
+            Log::Line( "[%s] %s", bench.name, bench.description );
+            bench.run( cfg );
+            exit( 0 );
+        }
+    }
+
+    Fatal( "Unknown benchmark '%s'.", benchName );
+}
+
+//-----------------------------------------------------------
+template<typename TSetup, typename TFunc>
+static double BenchPasses( const char* label, const BenchConfig& cfg, const size_t bytesPerPass, TSetup&& setup, TFunc&& func )
+{
+    double best = std::numeric_limits<double>::max();
+
+    for( uint32 pass = 0; pass < cfg.passes; pass++ )
+    {
+        // Not timed
+        setup();
+
+        const auto timer = TimerBegin();
+        func();
+        best = std::min( best, TicksToSeconds( TimerEndTicks( timer ) ) );
+    }
+
+    Log::Line( " %-12s: %8.3lf ms @ %8.2lf MiB/s", label, best * 1000.0, bytesPerPass / best BtoMB );
+    return best;
+}
+
+//-----------------------------------------------------------
+template<typename TFunc>
+static double BenchPasses( const char* label, const BenchConfig& cfg, const size_t bytesPerPass, TFunc&& func )
+{
+    return BenchPasses( label, cfg, bytesPerPass, [](){}, func );
+}
+
+
+///
+/// ChaCha8
+///
+//-----------------------------------------------------------
+void BenchChaCha8( const BenchConfig& cfg )
+{
+    const uint32 blockCount = (uint32)std::max<size_t>( 1, cfg.size / 64 );
+    const size_t size       = (size_t)blockCount * 64;
+
+    byte* simdOut     = bbvirtalloc<byte>( size );
+    byte* portableOut = bbvirtalloc<byte>( size );
+
+    byte key[32] = { 1 };
+    for( uint32 i = 1; i < sizeof( key ); i++ )
+        key[i] = (byte)( i * 31 );
+
+    chacha8_ctx chacha;
+    chacha8_keysetup( &chacha, key, 256, NULL );
+
+    // Start at a position that wraps the 32-bit block counter to validate carry handling
+    const uint64 startBlock = 0xFFFFFFFFull - 5;
+
+    Log::Line( " Blocks: %u ( %.2lf MiB ) | SIMD implementation: %s", blockCount, (double)size BtoMB, chacha8_get_impl_name() );
+
+    const double portable = BenchPasses( "portable", cfg, size, [&]() {
+        chacha8_get_keystream_portable( &chacha, startBlock, blockCount, portableOut );
+    });
+
+    const double simd = BenchPasses( chacha8_get_impl_name(), cfg, size, [&]() {
+        chacha8_get_keystream( &chacha, startBlock, blockCount, simdOut );
+    });
+
+    FatalIf( memcmp( simdOut, portableOut, size ) != 0, "SIMD keystream does not match the portable keystream." );
+
+    Log::Line( " Speedup     : %.2lfx", portable / simd );
+
+    bbvirtfree( simdOut );
+    bbvirtfree( portableOut );
+}
+
+///
+/// BLAKE3
+///
+//-----------------------------------------------------------
+void BenchBlake3( const BenchConfig& cfg )
+{
+    // Largest Fx input: y + L + R with 128-bit metadata
+    const size_t inputSize  = CDiv( _K + kExtraBits + _K * 4 * 2, 8 );
+    const size_t entryCount = std::max<size_t>( 1, cfg.size / BLAKE3_BLOCK_LEN );
+
+    byte* inputs      = bbvirtalloc<byte>( entryCount * BLAKE3_BLOCK_LEN );
+    byte* batchedOut  = bbvirtalloc<byte>( entryCount * BLAKE3_OUT_LEN );
+    byte* hasherOut   = bbvirtalloc<byte>( entryCount * BLAKE3_OUT_LEN );
+
+    memset( inputs, 0, entryCount * BLAKE3_BLOCK_LEN );
+    for( size_t i = 0; i < entryCount; i++ )
+        for( size_t j = 0; j < inputSize; j++ )
+            inputs[i * BLAKE3_BLOCK_LEN + j] = (byte)( i * 7 + j * 13 );
+
+    Log::Line( " Entries: %llu ( %llu bytes each )", (llu)entryCount, (llu)inputSize );
+
+    const size_t hashedBytes = entryCount * inputSize;
+
+    const double hasher = BenchPasses( "hasher", cfg, hashedBytes, [&]() {
+        for( size_t i = 0; i < entryCount; i++ )
+        {
+            blake3_hasher h;
+            blake3_hasher_init    ( &h );
+            blake3_hasher_update  ( &h, inputs + i * BLAKE3_BLOCK_LEN, inputSize );
+            blake3_hasher_finalize( &h, hasherOut + i * BLAKE3_OUT_LEN, BLAKE3_OUT_LEN );
+        }
+    });
+
+    const double batched = BenchPasses( "batched", cfg, hashedBytes, [&]() {
+        blake3_hash_many_small( inputs, entryCount, inputSize, batchedOut );
+    });
+
+    FatalIf( memcmp( batchedOut, hasherOut, entryCount * BLAKE3_OUT_LEN ) != 0, "Batched BLAKE3 output does not match the hasher output." );
+
+    Log::Line( " Speedup     : %.2lfx", hasher / batched );
+
+    bbvirtfree( inputs );
+    bbvirtfree( batchedOut );
+    bbvirtfree( hasherOut );
+}
+
+///
+/// Sort
+///
+//-----------------------------------------------------------
+void BenchSort( const BenchConfig& cfg )
+{
+    // y values with a sort key, as sorted by phase 1
+    const uint32 yBits      = _K + kExtraBits;
+    const size_t entrySize  = sizeof( uint64 ) + sizeof( uint32 );
+    const uint64 entryCount = std::max<uint64>( 1, cfg.size / entrySize );
+
+    uint64* yInput     = bbcvirtalloc<uint64>( entryCount );
+    uint64* yBuffer    = bbcvirtalloc<uint64>( entryCount );
+    uint64* yTmp       = bbcvirtalloc<uint64>( entryCount );
+    uint64* yRef       = bbcvirtalloc<uint64>( entryCount );
+    uint32* keyBuffer  = bbcvirtalloc<uint32>( entryCount );
+    uint32* keyTmp     = bbcvirtalloc<uint32>( entryCount );
+    uint32* keyRef     = bbcvirtalloc<uint32>( entryCount );
+
+    std::mt19937_64 rng( 0xB1ADE );
+    for( uint64 i = 0; i < entryCount; i++ )
+        yInput[i] = rng() & ( ( 1ull << yBits ) - 1 );
+
+    ThreadPool pool( cfg.threadCount );
+
+    Log::Line( " Entries: %llu ( %.2lf MiB ) | Threads: %u", (llu)entryCount, (double)( entryCount * entrySize ) BtoMB, cfg.threadCount );
+
+    auto setup = [&]() {
+        memcpy( yBuffer, yInput, sizeof( uint64 ) * entryCount );
+        for( uint64 i = 0; i < entryCount; i++ )
+            keyBuffer[i] = (uint32)i;
+    };
+
+    // 5 passes, so the result ends up in the tmp buffers
+    const double radix256 = BenchPasses( "radix256", cfg, entryCount * entrySize, setup, [&]() {
+        RadixSort256::SortYWithKey<MAX_THREADS>( pool, yBuffer, yTmp, keyBuffer, keyTmp, entryCount );
+    });
+
+    memcpy( yRef  , yTmp  , sizeof( uint64 ) * entryCount );
+    memcpy( keyRef, keyTmp, sizeof( uint32 ) * entryCount );
+
+    const double hybrid = BenchPasses( "hybrid", cfg, entryCount * entrySize, setup, [&]() {
+        HybridRadixSort::SortWithKey<MAX_THREADS>( pool, yBuffer, yTmp, keyBuffer, keyTmp, entryCount, yBits );
+    });
+
+    FatalIf( memcmp( yTmp  , yRef  , sizeof( uint64 ) * entryCount ) != 0, "Hybrid sort y values do not match RadixSort256." );
+    FatalIf( memcmp( keyTmp, keyRef, sizeof( uint32 ) * entryCount ) != 0, "Hybrid sort keys do not match RadixSort256." );
+
+    Log::Line( " Speedup     : %.2lfx", radix256 / hybrid );
+
+    bbvirtfree( yInput    );
+    bbvirtfree( yBuffer   );
+    bbvirtfree( yTmp      );
+    bbvirtfree( yRef      );
+    bbvirtfree( keyBuffer );
+    bbvirtfree( keyTmp    );
+    bbvirtfree( keyRef    );
+}
+
+
+///
+/// Match
+///
+//-----------------------------------------------------------
+template<typename TMatchFunc>
+static uint64 MatchAllGroups( KBCRMap& rMap, const uint64* yBuffer, const uint32* groupBoundaries, const uint32 groupCount,
+                              Pair* pairs, const uint64 maxPairs, TMatchFunc match )
+{
+    uint64 pairCount = 0;
+
+    for( uint32 i = 0; i + 2 < groupCount && pairCount < maxPairs; i++ )
+    {
+        const uint64 groupL = yBuffer[groupBoundaries[i]]   / kBC;
+        const uint64 groupR = yBuffer[groupBoundaries[i+1]] / kBC;
+
+        if( groupR - groupL == 1 )
+        {
+            pairCount += match( rMap, yBuffer, groupL, groupBoundaries[i], groupBoundaries[i+1],
+                                groupBoundaries[i+1], groupBoundaries[i+2], pairs + pairCount, maxPairs - pairCount, 0, nullptr );
+        }
+    }
+
+    return pairCount;
+}
+
+//-----------------------------------------------------------
+void BenchMatch( const BenchConfig& cfg )
+{
+    LoadLTargets();
+
+    // Sorted y values with the same density as a table: 1 entry per 2^kExtraBits values
+    const uint64 entryCount = std::max<uint64>( 4, std::min<uint64>( cfg.size / sizeof( uint64 ), 0xFFFFFFFFull / 4 ) );
+    const uint64 maxPairs   = entryCount * 2;
+
+    uint64* yBuffer         = bbcvirtalloc<uint64>( entryCount );
+    uint32* groupBoundaries = bbcvirtalloc<uint32>( entryCount + 1 );
+    Pair*   simdPairs       = bbcvirtalloc<Pair>  ( maxPairs );
+    Pair*   scalarPairs     = bbcvirtalloc<Pair>  ( maxPairs );
+
+    std::mt19937_64 rng( 0xB1ADE );
+    for( uint64 i = 0; i < entryCount; i++ )
+        yBuffer[i] = rng() % ( entryCount << kExtraBits );
+
+    std::sort( yBuffer, yBuffer + entryCount );
+
+    uint32 groupCount = 0;
+    groupBoundaries[groupCount++] = 0;
+
+    for( uint64 i = 1; i < entryCount; i++ )
+        if( yBuffer[i] / kBC != yBuffer[i-1] / kBC )
+            groupBoundaries[groupCount++] = (uint32)i;
+
+    groupBoundaries[groupCount++] = (uint32)entryCount;
+
+    KBCRMap* rMap = bbcvirtalloc<KBCRMap>( 1 );
+    rMap->Clear();
+
+    Log::Line( " Entries: %llu | Groups: %u | SIMD implementation: %s", (llu)entryCount, groupCount - 1, GetKBCMatchImplName() );
+
+    uint64 scalarCount = 0, simdCount = 0;
+
+    const double scalar = BenchPasses( "scalar", cfg, entryCount * sizeof( uint64 ), [&]() {
+        scalarCount = MatchAllGroups( *rMap, yBuffer, groupBoundaries, groupCount, scalarPairs, maxPairs, MatchKBCGroupsScalar );
+    });
+
+    const double simd = BenchPasses( GetKBCMatchImplName(), cfg, entryCount * sizeof( uint64 ), [&]() {
+        simdCount = MatchAllGroups( *rMap, yBuffer, groupBoundaries, groupCount, simdPairs, maxPairs, MatchKBCGroups );
+    });
+
+    Log::Line( " Pairs       : %llu", (llu)scalarCount );
+
+    FatalIf( simdCount != scalarCount, "SIMD matcher found %llu pairs, but the scalar matcher found %llu.", (llu)simdCount, (llu)scalarCount );
+    FatalIf( memcmp( simdPairs, scalarPairs, sizeof( Pair ) * scalarCount ) != 0, "SIMD matcher pairs do not match the scalar matcher." );
+
+    // Pairs must also match when the output buffer fills up part way through a group
+    const uint64 truncatedCount = MatchAllGroups( *rMap, yBuffer, groupBoundaries, groupCount, simdPairs, scalarCount / 2 + 1, MatchKBCGroups );
+    FatalIf( truncatedCount != std::min( scalarCount, scalarCount / 2 + 1 ) ||
+             memcmp( simdPairs, scalarPairs, sizeof( Pair ) * truncatedCount ) != 0,
+             "SIMD matcher pairs do not match the scalar matcher when the output is full." );
+
+    Log::Line( " Speedup     : %.2lfx", scalar / simd );
+
+    bbvirtfree( yBuffer );
+    bbvirtfree( groupBoundaries );
+    bbvirtfree( simdPairs );
+    bbvirtfree( scalarPairs );
+    bbvirtfree( rMap );
+}
+
+
+///
+/// Line points
+///
+//-----------------------------------------------------------
+void BenchLinePoint( const BenchConfig& cfg )
+{
+    // Not a multiple of the SIMD width, so that the tails are converted too
+    const uint64 entryCount = std::max<uint64>( 16, cfg.size / sizeof( Pair ) ) | 7;
+
+    uint32*  lTable        = bbcvirtalloc<uint32> ( entryCount );
+    Pair*    pairs         = bbcvirtalloc<Pair>   ( entryCount );
+    uint64*  scalarLPs     = bbcvirtalloc<uint64> ( entryCount );
+    uint64*  simdLPs       = bbcvirtalloc<uint64> ( entryCount );
+    BackPtr* scalarSquares = bbcvirtalloc<BackPtr>( entryCount );
+    BackPtr* simdSquares   = bbcvirtalloc<BackPtr>( entryCount + 1 );
+
+    // Values are below 2^32-1, so that only the edge cases below reach the top of the line point range
+    std::mt19937_64 rng( 0xB1ADE );
+    for( uint64 i = 0; i < entryCount; i++ )
+    {
+        lTable[i] = (uint32)( rng() % 0xFFFFFFFFull );
+        pairs [i] = { (uint32)( 4 + rng() % ( entryCount - 4 ) ), (uint32)( 4 + rng() % ( entryCount - 4 ) ) };
+    }
+
+    lTable[0] = 0;
+    lTable[1] = 1;
+    lTable[2] = 0xFFFFFFFF;
+    lTable[3] = 0xFFFFFFFE;
+
+    const Pair edgePairs[] = { { 2, 3 }, { 3, 2 }, { 2, 0 }, { 0, 2 }, { 1, 0 }, { 0, 1 }, { 2, 1 }, { 3, 3 } };
+    memcpy( pairs, edgePairs, sizeof( edgePairs ) );
+
+    Log::Line( " Entries: %llu | SIMD implementation: %s", (llu)entryCount, GetLinePointBatchImplName() );
+
+    const size_t bytesPerPass = entryCount * sizeof( Pair );
+
+    Log::Line( " Pairs to line points:" );
+    const double scalarToLP = BenchPasses( "scalar", cfg, bytesPerPass, [&]() {
+        PairsToLinePointsScalar( lTable, pairs, entryCount, scalarLPs );
+    });
+
+    const double simdToLP = BenchPasses( GetLinePointBatchImplName(), cfg, bytesPerPass, [&]() {
+        PairsToLinePoints( lTable, pairs, entryCount, simdLPs );
+    });
+
+    FatalIf( memcmp( simdLPs, scalarLPs, sizeof( uint64 ) * entryCount ) != 0, "SIMD line points do not match the scalar line points." );
+
+    Log::Line( " Line points to squares:" );
+    const double scalarToSq = BenchPasses( "scalar", cfg, bytesPerPass, [&]() {
+        LinePointsToSquaresScalar( scalarLPs, entryCount, scalarSquares );
+    });
+
+    simdSquares[entryCount] = { 0xB1ADE, 0xB1ADE };
+
+    const double simdToSq = BenchPasses( GetLinePointBatchImplName(), cfg, bytesPerPass, [&]() {
+        LinePointsToSquares( scalarLPs, entryCount, simdSquares );
+    });
+
+    FatalIf( memcmp( simdSquares, scalarSquares, sizeof( BackPtr ) * entryCount ) != 0, "SIMD squares do not match the scalar squares." );
+    FatalIf( simdSquares[entryCount].x != 0xB1ADE || simdSquares[entryCount].y != 0xB1ADE, "SIMD squares were written out of bounds." );
+
+    // Each square must also be the sorted pair it was made from.
+    // Equal values are the exception, as ( x, x ) encodes the same line point as ( x+1, 0 ).
+    for( uint64 i = 0; i < entryCount; i++ )
+    {
+        const uint64 x = lTable[pairs[i].left ];
+        const uint64 y = lTable[pairs[i].right];
+
+        if( x == y )
+            continue;
+
+        FatalIf( scalarSquares[i].x != std::max( x, y ) || scalarSquares[i].y != std::min( x, y ),
+                 "Line point %llu did not convert back to its square.", (llu)i );
+    }
+
+    Log::Line( " Speedup     : %.2lfx to line points, %.2lfx to squares", scalarToLP / simdToLP, scalarToSq / simdToSq );
+
+    bbvirtfree( lTable );
+    bbvirtfree( pairs );
+    bbvirtfree( scalarLPs );
+    bbvirtfree( simdLPs );
+    bbvirtfree( scalarSquares );
+    bbvirtfree( simdSquares );
+}
+
+
+//-----------------------------------------------------------
+static const char* USAGE = R"(bench [OPTIONS] <benchmark>
+
+Runs a microbenchmark of a plotting kernel.
+Kernels are single-threaded, unless noted otherwise.
+
+[BENCHMARKS]
+ chacha8            : ChaCha8 F1 keystream generation. SIMD multi-block vs. portable.
+ blake3             : BLAKE3 Fx hashing. Batched multi-lane vs. per-entry hasher.
+ sort               : Keyed y sort. Cache-blocked hybrid radix sort vs. RadixSort256.
+                      Uses the global thread count (-t).
+ match              : kBC group matching. SIMD target probing vs. scalar.
+ linepoint          : Line point conversion in both directions. SIMD vs. scalar.
+
+[OPTIONS]
+ -s, --size <size>  : Size of the working set. By default it is 64MiB.
+                      Ex: 512MB 1GB 4GB
+
+ -p, --passes <n>   : The number of passes to perform. The fastest pass is reported.
+                      By default it is 3.
+
+ -h, --help         : Print this help message and exit.
+)";
+
+//-----------------------------------------------------------
+void BenchPrintUsage()
+{
+    Log::Line( USAGE );
+}
@@ -91,7 +91,10 @@ public:
     //-----------------------------------------------------------
     void PerformPlotCheck( const char* plotPath, PlotCheckResult& result )
     {
-        FilePlot plot;
+        FilePlot   filePlot;
+        MMapPlot   mmapPlot;
+        IPlotFile& plot = _cfg.useMMap ? (IPlotFile&)mmapPlot : (IPlotFile&)filePlot;
+
         if( !plot.Open( plotPath ) )
         {
             std::stringstream err; err << "Failed to open plot file at '" << plotPath << "' with error " << plot.GetError() << ".";
@@ -111,6 +114,9 @@ public:
         else
             reader.ConfigDecompressor( threadCount, _cfg.disableCpuAffinity, 0, useGpu, (int)_cfg.gpuIndex );
 
+        // Issue the park reads of each proof table level concurrently
+        reader.ConfigProofFetch( threadCount );
+
         const uint32 k = plot.K();
 
         byte AlignAs(8) seed[BB_PLOT_ID_LEN] = {};
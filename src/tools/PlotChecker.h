@@ -16,6 +16,8 @@ struct PlotCheckerConfig
     bool        deletePlots     = false;    // If true, plots that fail to fetch proofs, or are below a threshold, will be deleted
     double      deleteThreshold = 0.0;      // If proofs received to proof request ratio is below this, the plot will be deleted
 
+    bool        useMMap         = false;    // If true, the plot is memory-mapped instead of read through file I/O
+
     struct GreenReaperContext* grContext = nullptr;
 };
 
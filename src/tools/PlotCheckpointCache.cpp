@@ -0,0 +1,458 @@
+#include "PlotCheckpointCache.h"
+#include "PlotReader.h"
+#include "util/BitView.h"
+#include "plotdisk/jobs/IOJob.h"
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <cstdio>
+
+namespace {
+
+    // Header of a checkpoint sidecar index file.
+    // It is followed by the unpacked C2 entries and then the raw C1 table bytes.
+    struct SidecarHeader
+    {
+        byte   magic[4];
+        uint32 version;
+        byte   plotId[BB_PLOT_ID_LEN];
+        uint32 k;
+        uint32 _reserved;
+        uint64 c1TableSize;
+        uint64 c2TableSize;
+        uint64 c1ByteCount;
+        uint64 c2EntryCount;
+    };
+
+    static const byte   SIDECAR_MAGIC[4] = { 'B', 'B', 'C', 'P' };
+    static const uint32 SIDECAR_VERSION  = 3;   // v3: C2 entries come first, so that C1 segments can be read alone
+
+    // Either the C2 checkpoints of a plot, or one of its C1 segments
+    struct CacheEntry
+    {
+        std::string                 key;
+        size_t                      size;
+        sptr<const PlotCheckpoints> c2;
+        sptr<const PlotC1Segment>   c1;
+    };
+
+    typedef std::list<CacheEntry> LRUList;
+
+    struct CacheState
+    {
+        std::mutex                                         lock;
+        LRUList                                            lru;     // Most recently used first
+        std::unordered_map<std::string, LRUList::iterator> entries;
+        size_t                                             budget    = PlotCheckpointCache::DEFAULT_MEMORY_BUDGET;
+        size_t                                             used      = 0;
+        std::string                                        sidecarDir;
+        PlotCheckpointCacheStats                           stats     = {};
+    };
+
+    static CacheState _cache;
+
+    inline std::string PlotIdKey( const byte plotId[BB_PLOT_ID_LEN] )
+    {
+        return std::string( (const char*)plotId, BB_PLOT_ID_LEN );
+    }
+
+    inline std::string C1SegmentKey( const byte plotId[BB_PLOT_ID_LEN], const uint64 c2Index )
+    {
+        return PlotIdKey( plotId ) + std::string( (const char*)&c2Index, sizeof( c2Index ) );
+    }
+
+    // Evict least recently used entries until we're within budget.
+    // Must be called with the cache lock held.
+    void EvictToBudget()
+    {
+        while( _cache.used > _cache.budget && !_cache.lru.empty() )
+        {
+            const CacheEntry& last = _cache.lru.back();
+
+            _cache.used -= last.size;
+            _cache.entries.erase( last.key );
+            _cache.lru.pop_back();
+        }
+    }
+
+    // Returns the entry for the key, moved to the front of the LRU list, or nullptr.
+    // Must be called with the cache lock held.
+    const CacheEntry* FindEntry( const std::string& key )
+    {
+        auto it = _cache.entries.find( key );
+        if( it == _cache.entries.end() )
+            return nullptr;
+
+        _cache.lru.splice( _cache.lru.begin(), _cache.lru, it->second );
+        return &*it->second;
+    }
+
+    void InsertEntry( CacheEntry&& entry )
+    {
+        std::lock_guard<std::mutex> lock( _cache.lock );
+
+        if( entry.size > _cache.budget )
+            return;
+
+        // If another thread loaded the same entry concurrently, the last insertion wins
+        auto it = _cache.entries.find( entry.key );
+        if( it != _cache.entries.end() )
+        {
+            _cache.used -= it->second->size;
+            _cache.lru.erase( it->second );
+            _cache.entries.erase( it );
+        }
+
+        _cache.used += entry.size;
+        _cache.lru.push_front( std::move( entry ) );
+        _cache.entries[_cache.lru.front().key] = _cache.lru.begin();
+
+        EvictToBudget();
+    }
+
+    void AddMiss( uint64& counter, const uint64 bytesRead )
+    {
+        std::lock_guard<std::mutex> lock( _cache.lock );
+        counter++;
+        _cache.stats.bytesRead += bytesRead;
+    }
+}
+
+//-----------------------------------------------------------
+sptr<const PlotCheckpoints> PlotCheckpointCache::Acquire( IPlotFile& plot )
+{
+    sptr<const PlotCheckpoints> checkpoints = Find( plot.PlotId() );
+    if( checkpoints )
+        return checkpoints;
+
+    // Load it outside of the lock so that other readers are not stalled on I/O
+    std::string sidecarPath = GetSidecarPath( plot.PlotId() );
+
+    sptr<PlotCheckpoints> loaded;
+    if( !sidecarPath.empty() )
+        loaded = LoadFromSidecar( plot, sidecarPath );
+
+    if( !loaded )
+    {
+        loaded = LoadFromPlot( plot );
+        if( !loaded )
+            return nullptr;
+
+        // Building the index reads the whole C1 table once
+        if( !sidecarPath.empty() )
+        {
+            if( WriteSidecar( plot, *loaded, sidecarPath ) )
+                loaded->sidecarPath = sidecarPath;
+            else
+                Log::Error( "Warning: Failed to write checkpoint index to '%s'.", sidecarPath.c_str() );
+        }
+    }
+
+    AddMiss( _cache.stats.c2Misses, loaded->c2TableSize );
+
+    checkpoints = loaded;
+    InsertEntry( { PlotIdKey( checkpoints->plotId ), checkpoints->MemorySize(), checkpoints, nullptr } );
+
+    return checkpoints;
+}
+
+//-----------------------------------------------------------
+sptr<const PlotC1Segment> PlotCheckpointCache::AcquireC1Segment( IPlotFile& plot, const PlotCheckpoints& checkpoints, const uint64 c2Index )
+{
+    const std::string key = C1SegmentKey( checkpoints.plotId, c2Index );
+    {
+        std::lock_guard<std::mutex> lock( _cache.lock );
+
+        const CacheEntry* entry = FindEntry( key );
+        if( entry )
+        {
+            _cache.stats.c1Hits++;
+            return entry->c1;
+        }
+    }
+
+    sptr<PlotC1Segment> segment = std::make_shared<PlotC1Segment>();
+    memcpy( segment->plotId, checkpoints.plotId, BB_PLOT_ID_LEN );
+    segment->c2Index = c2Index;
+
+    if( !ReadC1Segment( plot, checkpoints, *segment ) )
+        return nullptr;
+
+    AddMiss( _cache.stats.c1Misses, segment->c1Bytes.size() );
+    InsertEntry( { key, segment->MemorySize(), nullptr, segment } );
+
+    return segment;
+}
+
+//-----------------------------------------------------------
+sptr<const PlotCheckpoints> PlotCheckpointCache::Find( const byte plotId[BB_PLOT_ID_LEN] )
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+
+    const CacheEntry* entry = FindEntry( PlotIdKey( plotId ) );
+    if( !entry )
+        return nullptr;
+
+    _cache.stats.c2Hits++;
+    return entry->c2;
+}
+
+//-----------------------------------------------------------
+void PlotCheckpointCache::SetMemoryBudget( const size_t budget )
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+    _cache.budget = budget;
+    EvictToBudget();
+}
+
+//-----------------------------------------------------------
+size_t PlotCheckpointCache::GetMemoryBudget()
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+    return _cache.budget;
+}
+
+//-----------------------------------------------------------
+size_t PlotCheckpointCache::GetMemoryUsed()
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+    return _cache.used;
+}
+
+//-----------------------------------------------------------
+PlotCheckpointCacheStats PlotCheckpointCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+
+    PlotCheckpointCacheStats stats = _cache.stats;
+    stats.memoryUsed   = _cache.used;
+    stats.memoryBudget = _cache.budget;
+    return stats;
+}
+
+//-----------------------------------------------------------
+void PlotCheckpointCache::LogStats()
+{
+    const PlotCheckpointCacheStats stats = GetStats();
+
+    Log::Line( "Checkpoint cache: C2 %llu hits / %llu misses, C1 %llu hits / %llu misses, %.2lf MiB read, %.2lf / %.2lf MiB used.",
+        (llu)stats.c2Hits, (llu)stats.c2Misses, (llu)stats.c1Hits, (llu)stats.c1Misses,
+        (double)stats.bytesRead BtoMB, (double)stats.memoryUsed BtoMB, (double)stats.memoryBudget BtoMB );
+}
+
+//-----------------------------------------------------------
+void PlotCheckpointCache::SetSidecarDirectory( const char* path )
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+    _cache.sidecarDir = path ? path : "";
+}
+
+//-----------------------------------------------------------
+void PlotCheckpointCache::Clear()
+{
+    std::lock_guard<std::mutex> lock( _cache.lock );
+    _cache.entries.clear();
+    _cache.lru.clear();
+    _cache.used  = 0;
+    _cache.stats = {};
+}
+
+//-----------------------------------------------------------
+std::string PlotCheckpointCache::GetSidecarPath( const byte plotId[BB_PLOT_ID_LEN] )
+{
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock( _cache.lock );
+        dir = _cache.sidecarDir;
+    }
+
+    if( dir.empty() )
+        return dir;
+
+    if( dir.back() != '/' && dir.back() != '\\' )
+        dir += '/';
+
+    return dir + BytesToHexStdString( plotId, BB_PLOT_ID_LEN ) + ".bbcp";
+}
+
+//-----------------------------------------------------------
+sptr<PlotCheckpoints> PlotCheckpointCache::LoadFromPlot( IPlotFile& plot )
+{
+    const size_t c1Size = plot.TableSize( PlotTable::C1 );
+    const size_t c2Size = plot.TableSize( PlotTable::C2 );
+    if( c1Size == 0 || c2Size == 0 )
+        return nullptr;
+
+    const size_t f7ByteSize   = CDiv( plot.K(), 8 );
+    const uint64 c2MaxEntries = c2Size / f7ByteSize;
+    if( c2MaxEntries < 1 )
+        return nullptr;
+
+    sptr<PlotCheckpoints> cp = std::make_shared<PlotCheckpoints>();
+    memcpy( cp->plotId, plot.PlotId(), BB_PLOT_ID_LEN );
+    cp->k           = plot.K();
+    cp->c1TableSize = c1Size;
+    cp->c2TableSize = c2Size;
+
+    // C1 is loaded a segment at a time, when it is needed
+    std::vector<byte> c2Bytes( c2Size );
+    if( !plot.Seek( SeekOrigin::Begin, (int64)plot.TableAddress( PlotTable::C2 ) ) )
+        return nullptr;
+
+    if( plot.Read( c2Size, c2Bytes.data() ) != (ssize_t)c2Size )
+        return nullptr;
+
+    const size_t f7BitCount = f7ByteSize * 8;
+    CPBitReader reader( c2Bytes.data(), c2Size * 8 );
+
+    cp->c2Entries.reserve( c2MaxEntries );
+
+    uint64 prevF7 = 0;
+    for( uint64 i = 0; i < c2MaxEntries; i++ )
+    {
+        // Entries are left-aligned to their byte size
+        const uint64 f7 = reader.Read64( (uint32)f7BitCount ) >> ( f7BitCount - plot.K() );
+
+        // Short circuit if we encounter an unsorted/out-of-order c2 entry
+        if( f7 < prevF7 )
+            break;
+
+        cp->c2Entries.push_back( f7 );
+        prevF7 = f7;
+    }
+
+    return cp;
+}
+
+//-----------------------------------------------------------
+bool PlotCheckpointCache::ReadC1Segment( IPlotFile& plot, const PlotCheckpoints& cp, PlotC1Segment& segment )
+{
+    const size_t f7SizeBytes  = CDiv( cp.k, 8 );
+    const uint64 segmentSize  = (uint64)kCheckpoint2Interval * f7SizeBytes;
+    const uint64 offset       = segment.c2Index * segmentSize;
+
+    if( offset >= cp.c1TableSize )
+        return false;
+
+    const size_t size = (size_t)std::min( segmentSize, cp.c1TableSize - offset );
+    segment.c1Bytes.resize( size );
+
+    // The index file is preferred, as it may be on faster storage than the plot
+    if( !cp.sidecarPath.empty() )
+    {
+        const uint64 sidecarOffset = sizeof( SidecarHeader ) + cp.c2Entries.size() * sizeof( uint64 ) + offset;
+
+        FileStream file;
+        int err = 0;
+
+        if( file.Open( cp.sidecarPath.c_str(), FileMode::Open, FileAccess::Read ) &&
+            file.Seek( (int64)sidecarOffset, SeekOrigin::Begin ) &&
+            IOJob::ReadFromFileUnaligned( file, segment.c1Bytes.data(), size, err ) )
+            return true;
+    }
+
+    const uint64 address = plot.TableAddress( PlotTable::C1 ) + offset;
+
+    const byte* view = plot.View( address, size );
+    if( view )
+    {
+        memcpy( segment.c1Bytes.data(), view, size );
+        return true;
+    }
+
+    if( plot.ReadAt( address, size, segment.c1Bytes.data() ) != (ssize_t)size )
+    {
+        Log::Error( "Failed to read C1 entries: %d", plot.GetError() );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------
+sptr<PlotCheckpoints> PlotCheckpointCache::LoadFromSidecar( IPlotFile& plot, const std::string& path )
+{
+    FileStream file;
+    if( !file.Open( path.c_str(), FileMode::Open, FileAccess::Read ) )
+        return nullptr;
+
+    int err = 0;
+
+    SidecarHeader header = {};
+    if( !IOJob::ReadFromFileUnaligned( file, &header, sizeof( header ), err ) )
+        return nullptr;
+
+    // Ensure the index still describes this plot
+    if( memcmp( header.magic, SIDECAR_MAGIC, sizeof( SIDECAR_MAGIC ) ) != 0 ||
+        header.version     != SIDECAR_VERSION                                ||
+        memcmp( header.plotId, plot.PlotId(), BB_PLOT_ID_LEN ) != 0         ||
+        header.k           != plot.K()                                       ||
+        header.c1TableSize != plot.TableSize( PlotTable::C1 )               ||
+        header.c2TableSize != plot.TableSize( PlotTable::C2 )               ||
+        header.c1ByteCount != header.c1TableSize                             ||
+        header.c2EntryCount > header.c2TableSize )
+        return nullptr;
+
+    sptr<PlotCheckpoints> cp = std::make_shared<PlotCheckpoints>();
+    memcpy( cp->plotId, header.plotId, BB_PLOT_ID_LEN );
+    cp->k           = header.k;
+    cp->c1TableSize = header.c1TableSize;
+    cp->c2TableSize = header.c2TableSize;
+    cp->sidecarPath = path;
+    cp->c2Entries.resize( header.c2EntryCount );
+
+    if( !IOJob::ReadFromFileUnaligned( file, cp->c2Entries.data(), cp->c2Entries.size() * sizeof( uint64 ), err ) )
+        return nullptr;
+
+    return cp;
+}
+
+//-----------------------------------------------------------
+bool PlotCheckpointCache::WriteSidecar( IPlotFile& plot, const PlotCheckpoints& cp, const std::string& path )
+{
+    std::vector<byte> c1Bytes( cp.c1TableSize );
+    if( plot.ReadAt( plot.TableAddress( PlotTable::C1 ), c1Bytes.size(), c1Bytes.data() ) != (ssize_t)c1Bytes.size() )
+        return false;
+
+    // Write to a temporary file first so that a partially-written index is never picked up
+    const std::string tmpPath = path + ".tmp";
+
+    {
+        FileStream file;
+        if( !file.Open( tmpPath.c_str(), FileMode::Create, FileAccess::Write ) )
+            return false;
+
+        SidecarHeader header = {};
+        memcpy( header.magic, SIDECAR_MAGIC, sizeof( SIDECAR_MAGIC ) );
+        memcpy( header.plotId, cp.plotId, BB_PLOT_ID_LEN );
+        header.version      = SIDECAR_VERSION;
+        header.k            = cp.k;
+        header.c1TableSize  = cp.c1TableSize;
+        header.c2TableSize  = cp.c2TableSize;
+        header.c1ByteCount  = c1Bytes.size();
+        header.c2EntryCount = cp.c2Entries.size();
+
+        int err = 0;
+        if( !IOJob::WriteToFileUnaligned( file, &header, sizeof( header ), err ) ||
+            !IOJob::WriteToFileUnaligned( file, cp.c2Entries.data(), cp.c2Entries.size() * sizeof( uint64 ), err ) ||
+            !IOJob::WriteToFileUnaligned( file, c1Bytes.data(), c1Bytes.size(), err ) )
+        {
+            file.Close();
+            remove( tmpPath.c_str() );
+            return false;
+        }
+    }
+
+    if( rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    {
+        // Windows won't replace an existing file on rename
+        remove( path.c_str() );
+        if( rename( tmpPath.c_str(), path.c_str() ) != 0 )
+        {
+            remove( tmpPath.c_str() );
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "ChiaConsts.h"
+#include <vector>
+#include <string>
+
+class IPlotFile;
+
+// C2 checkpoint table of a plot, which locates the C1 entries
+// to scan for a given f7, and from those, the C3 park holding it.
+struct PlotCheckpoints
+{
+    byte                plotId[BB_PLOT_ID_LEN];
+    uint32              k;
+    uint64              c1TableSize;    // Size of the C1 table in the plot, in bytes
+    uint64              c2TableSize;    // Size of the C2 table in the plot, in bytes
+    std::vector<uint64> c2Entries;      // Unpacked C2 entries, up to the first out-of-order entry
+    std::string         sidecarPath;    // Index file holding the C1 table as well, if the C2 entries were loaded from it
+
+    inline size_t MemorySize() const
+    {
+        return sizeof( PlotCheckpoints ) + c2Entries.size() * sizeof( uint64 ) + sidecarPath.size();
+    }
+};
+
+// The C1 entries of a single C2 interval, as they are stored in the plot:
+// kCheckpoint2Interval entries, or less for the last interval.
+struct PlotC1Segment
+{
+    byte              plotId[BB_PLOT_ID_LEN];
+    uint64            c2Index;
+    std::vector<byte> c1Bytes;
+
+    inline size_t MemorySize() const
+    {
+        return sizeof( PlotC1Segment ) + c1Bytes.size();
+    }
+};
+
+struct PlotCheckpointCacheStats
+{
+    uint64 c2Hits;
+    uint64 c2Misses;
+    uint64 c1Hits;
+    uint64 c1Misses;
+    uint64 bytesRead;       // Read from plots and index files to satisfy misses
+    size_t memoryUsed;
+    size_t memoryBudget;
+};
+
+// Process-wide, memory-bounded LRU cache of plot checkpoint tables keyed by plot id,
+// so that readers created for a plot that was seen before don't re-read them from the plot.
+// C2 tables are small and cached whole. C1 entries are cached per C2 interval, as they are looked up,
+// so a miss reads the same C1 slice as an uncached f7 lookup does.
+// Optionally, checkpoints are persisted as sidecar index files in a directory,
+// which are used to satisfy cache misses before falling back to reading the plot.
+class PlotCheckpointCache
+{
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 MiB;
+
+    // Returns the C2 checkpoints for the plot, loading them if they were not already cached.
+    // Returns nullptr if the checkpoints could not be read from the plot.
+    static sptr<const PlotCheckpoints> Acquire( IPlotFile& plot );
+
+    // Returns the C1 entries of the C2 interval c2Index, loading them if they were not already cached.
+    // Returns nullptr if they could not be read.
+    static sptr<const PlotC1Segment> AcquireC1Segment( IPlotFile& plot, const PlotCheckpoints& checkpoints, uint64 c2Index );
+
+    // Returns the cached C2 checkpoints for the plot id, or nullptr if they are not cached.
+    static sptr<const PlotCheckpoints> Find( const byte plotId[BB_PLOT_ID_LEN] );
+
+    // Maximum amount of memory used by cached checkpoints.
+    // Least recently used entries are evicted when over budget. 0 disables caching.
+    static void   SetMemoryBudget( size_t budget );
+    static size_t GetMemoryBudget();
+    static size_t GetMemoryUsed();
+
+    static PlotCheckpointCacheStats GetStats();
+    static void                     LogStats();
+
+    // Directory where sidecar index files are stored.
+    // nullptr or an empty string disables them.
+    static void SetSidecarDirectory( const char* path );
+
+    static void Clear();
+
+private:
+    static sptr<PlotCheckpoints> LoadFromPlot( IPlotFile& plot );
+    static sptr<PlotCheckpoints> LoadFromSidecar( IPlotFile& plot, const std::string& path );
+    static bool                  WriteSidecar( IPlotFile& plot, const PlotCheckpoints& checkpoints, const std::string& path );
+    static std::string           GetSidecarPath( const byte plotId[BB_PLOT_ID_LEN] );
+
+    static bool ReadC1Segment( IPlotFile& plot, const PlotCheckpoints& checkpoints, PlotC1Segment& segment );
+};
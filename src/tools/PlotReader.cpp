@@ -1,14 +1,69 @@
 #include "PlotReader.h"
+#include "PlotCheckpointCache.h"
 #include "ChiaConsts.h"
 #include "util/BitView.h"
 #include "plotting/PlotTools.h"
 #include "plotting/CTables.h"
 #include "plotting/DTables.h"
 #include "plotmem/LPGen.h"
+#include "plotting/LinePointBatch.h"
 #include "plotting/Compression.h"
 #include "harvesting/GreenReaper.h"
 #include "BLS.h"
 #include "plotdisk/jobs/IOJob.h"
+#include "threading/MTJob.h"
+
+#if PLATFORM_IS_WINDOWS
+    #include <Windows.h>
+#else
+    #include <signal.h>
+    #include <sys/mman.h>
+#endif
+
+// Returns a context borrowed from a pool when going out of scope
+struct GRContextLease
+{
+    GRContextPool*      pool    = nullptr;
+    GreenReaperContext* context = nullptr;
+
+    inline ~GRContextLease()
+    {
+        if( pool && context )
+            grReleaseContext( pool, context );
+    }
+};
+
+// Converts the line points of a proof level to back pointers, written as y, x index pairs.
+// 64-bit line points are converted as a batch, the 128-bit ones are converted one at a time.
+//-----------------------------------------------------------
+static void LinePointsToBackPtrs( const bool use64BitLP, const uint128* lps, const uint32 count, uint64* outBackPtrs )
+{
+    ASSERT( count <= BB_PLOT_PROOF_X_COUNT / 2 );
+
+    BackPtr ptrs[BB_PLOT_PROOF_X_COUNT / 2];
+
+    if( use64BitLP )
+    {
+        uint64 lps64[BB_PLOT_PROOF_X_COUNT / 2];
+
+        for( uint32 i = 0; i < count; i++ )
+            lps64[i] = (uint64)lps[i];
+
+        LinePointsToSquares( lps64, count, ptrs );
+    }
+    else
+    {
+        for( uint32 i = 0; i < count; i++ )
+            ptrs[i] = LinePointToSquare( lps[i] );
+    }
+
+    for( uint32 i = 0; i < count; i++ )
+    {
+        ASSERT( ptrs[i].x > ptrs[i].y );
+        outBackPtrs[i*2+0] = ptrs[i].y;
+        outBackPtrs[i*2+1] = ptrs[i].x;
+    }
+}
 
 ///
 /// Plot Reader
@@ -18,11 +73,18 @@
 PlotReader::PlotReader( IPlotFile& plot )
     : _plot( plot )
 {
-    const size_t largestParkSize           = RoundUpToNextBoundaryT( CalculateParkSize( TableId::Table1, plot.K() ), sizeof( uint64 ) * 2 );
-    const size_t maxDecompressedDeltasSize = RoundUpToNextBoundaryT( (size_t)0x7FFF, sizeof( uint64 ) );
-
-    _parkBuffer   = bbmalloc<uint64>( largestParkSize );
-    _deltasBuffer = bbmalloc<byte>  ( maxDecompressedDeltasSize );
+    // Whole parks are read at once, so ensure the buffer fits the park of any stored table.
+    // C3 parks of k < 20 store a byte per entry, which makes them larger than the line point parks.
+    const size_t largestParkSize = std::max( { CalculateParkSize( TableId::Table1, plot.K() ),
+                                               GetParkSizeForTable( GetLowestStoredTable() ),
+                                               CalculateC3Size( plot.K() ),
+                                               CalculatePark7Size( plot.K() ) } );
+
+    _parkBufferSize   = RoundUpToNextBoundaryT( largestParkSize, sizeof( uint64 ) * 2 );
+    _deltasBufferSize = RoundUpToNextBoundaryT( (size_t)0x7FFF, sizeof( uint64 ) );
+
+    _parkBuffer   = bbmalloc<uint64>( _parkBufferSize );
+    _deltasBuffer = bbmalloc<byte>  ( _deltasBufferSize );
 }
 
 //-----------------------------------------------------------
@@ -31,11 +93,9 @@ PlotReader::~PlotReader()
     free( _parkBuffer );    _parkBuffer = nullptr;
     free( _deltasBuffer );  _deltasBuffer = nullptr;
 
-    bbvirtfreebounded( _c1Buffer );
+    ConfigProofFetch( 0 );
 
-    if( _c2Entries.Ptr() )
-        delete[] _c2Entries.values;
-    _c2Entries = {};
+    _checkpoints = nullptr;
 
     bbvirtfreebounded_span( _c3Buffer );
 
@@ -154,7 +214,7 @@ int64 PlotReader::ReadC3Park( uint64 parkIndex, uint64* f7Buffer )
 {
     const uint32 k              = _plot.K();
     const size_t f7SizeBytes    = CDiv( k, 8 );
-    const size_t c3ParkSize     = CalculateC3Size();
+    const size_t c3ParkSize     = CalculateC3Size( k );
     const uint64 c1Address      = _plot.TableAddress( PlotTable::C1 );
     const uint64 c3Address      = _plot.TableAddress( PlotTable::C3 );
     const size_t c1TableSize    = _plot.TableSize( PlotTable::C1 );
@@ -168,12 +228,15 @@ int64 PlotReader::ReadC3Park( uint64 parkIndex, uint64* f7Buffer )
         return -1;
 
     // First we need to read the root F7 entry for the park,  which is in the C1 table.
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)c1EntryAddress ) )
-        return -1;
-
     uint64 c1 = 0;
-    if( _plot.Read( f7SizeBytes, &c1 ) != (ssize_t)f7SizeBytes )
-        return -1;
+    {
+        const byte* c1Bytes = ReadPlotBytes( c1EntryAddress, f7SizeBytes, &c1 );
+        if( !c1Bytes )
+            return -1;
+
+        if( c1Bytes != (byte*)&c1 )
+            memcpy( &c1, c1Bytes, f7SizeBytes );
+    }
 
     c1 = Swap64( c1 ) >> ( 64 - k );
 
@@ -186,26 +249,22 @@ int64 PlotReader::ReadC3Park( uint64 parkIndex, uint64* f7Buffer )
         return 1;
     }
 
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)parkAddress ) )
+    // Read the whole park, prefixed by the size of the compressed C3 deltas
+    const byte* parkBytes = ReadPlotBytes( parkAddress, c3ParkSize, _parkBuffer );
+    if( !parkBytes )
         return -1;
 
-    // Read the size of the compressed C3 deltas
     uint16 compressedSize = 0;
-    if( _plot.Read( sizeof( uint16 ), &compressedSize ) != (ssize_t)sizeof( uint16 ) )
-        return -1;
+    memcpy( &compressedSize, parkBytes, sizeof( uint16 ) );
 
     compressedSize = Swap16( compressedSize );
-    if( compressedSize > c3ParkSize )
-        return -1;
-
-    // memset( _parkBuffer, 0, _parkBufferSize );
-    if( _plot.Read( c3ParkSize - sizeof( uint16 ), _parkBuffer ) != c3ParkSize - sizeof( uint16 ) )
+    if( compressedSize > c3ParkSize - sizeof( uint16 ) )
         return -1;
 
     // Now we can read the f7 deltas from the C3 park
     const size_t deltaCount = FSE_decompress_usingDTable( 
                                 _deltasBuffer, kCheckpoint1Interval, 
-                                _parkBuffer, compressedSize, 
+                                parkBytes + sizeof( uint16 ), compressedSize, 
                                 (const FSE_DTable*)DTable_C3 );
 
     if( FSE_isError( deltaCount ) )
@@ -277,13 +336,11 @@ bool PlotReader::LoadP7Park( uint64 parkIndex )
 
     const uint64 parkAddress = p7TableAddress + parkIndex * parkSizeBytes;
 
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)parkAddress ) )
+    const byte* parkBytes = ReadPlotBytes( parkAddress, parkSizeBytes, _parkBuffer );
+    if( !parkBytes )
         return false;
 
-    if( _plot.Read( parkSizeBytes, _parkBuffer ) != (ssize_t)parkSizeBytes )
-        return false;
-
-    CPBitReader parkReader( (byte*)_parkBuffer, parkSizeBytes * 8 );
+    CPBitReader parkReader( parkBytes, parkSizeBytes * 8 );
 
     for( uint32 i = 0; i < kEntriesPerPark; i++ )
         _park7Entries[i] = parkReader.Read64( p7EntrySize );
@@ -296,6 +353,15 @@ bool PlotReader::LoadP7Park( uint64 parkIndex )
 bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex, 
                                        CPBitReader& outStubs, byte*& outDeltas, 
                                        uint128& outBaseLinePoint, uint64& outDeltaCounts )
+{
+    return ReadLPParkComponents( table, parkIndex, outStubs, outDeltas, outBaseLinePoint, outDeltaCounts, _parkBuffer, _deltasBuffer );
+}
+
+//-----------------------------------------------------------
+bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex, 
+                                       CPBitReader& outStubs, byte*& outDeltas, 
+                                       uint128& outBaseLinePoint, uint64& outDeltaCounts,
+                                       uint64* parkBuffer, byte* deltaBuffer )
 {
     outDeltaCounts = 0;
 
@@ -314,17 +380,18 @@ bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex,
         return false;
     
     const size_t parkAddress    = tableAddress + parkIndex * parkSize;
-    
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)parkAddress ) )
+
+    // Read the whole park with a single read
+    const byte* parkBytes = ReadPlotBytes( parkAddress, parkSize, parkBuffer );
+    if( !parkBytes )
         return false;
 
     // Read base full line point
     uint128 baseLinePoint;
     {
+        // The bit reader requires the line point to be 64-bit aligned
         uint64 baseLPBytes[CDiv(LinePointSizeBytes( 50 ), sizeof(uint64))] = { 0 };
-
-        if( _plot.Read( lpSizeBytes, baseLPBytes ) != (ssize_t)lpSizeBytes )
-            return false;
+        memcpy( baseLPBytes, parkBytes, lpSizeBytes );
 
         const size_t lpSizeBits = (uint32)LinePointSizeBits( k );
 
@@ -332,26 +399,23 @@ bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex,
         baseLinePoint = lpReader.Read128Aligned( (uint32)lpSizeBits );
     }
 
-    // Read stubs
+    // Stubs
     const size_t stubsSizeBytes = GetLPStubByteSize( table );
-    uint64* stubsBuffer = _parkBuffer;
+    const byte*  stubsBuffer    = parkBytes + lpSizeBytes;
 
-    if( _plot.Read( stubsSizeBytes, stubsBuffer ) != (ssize_t)stubsSizeBytes )
-        return false;
-
-    // Read deltas
-    const size_t maxDeltasSizeBytes = GetParkDeltasSectionMaxSize( (TableId)table );
-    byte* compressedDeltaBuffer = ((byte*)_parkBuffer) + RoundUpToNextBoundary( stubsSizeBytes, sizeof( uint64 ) );
-    byte* deltaBuffer           = _deltasBuffer;
+    // Deltas
+    const size_t deltasOffset = lpSizeBytes + stubsSizeBytes;
 
     uint16 compressedDeltasSize = 0;
-    if( _plot.Read( 2, &compressedDeltasSize ) != 2 )
-        return false;
+    memcpy( &compressedDeltasSize, parkBytes + deltasOffset, sizeof( uint16 ) );
 
     // Don't support uncompressed deltas
     if( compressedDeltasSize & 0x8000 )
         return false;
 
+    if( compressedDeltasSize > parkSize - deltasOffset - sizeof( uint16 ) )
+        return false;
+
     size_t deltaCount = 0;
 
     // #TODO: Investigate this, but we should not support uncompressed deltas
@@ -359,30 +423,23 @@ bool PlotReader::ReadLPParkComponents( TableId table, uint64 parkIndex,
     // {
     //     // Uncompressed
     //     compressedDeltasSize &= 0x7fff;
-    //     if( _plot.Read( compressedDeltasSize, compressedDeltaBuffer ) != compressedDeltasSize )
-    //         return false;
-
     //     deltaCount = compressedDeltasSize;
     // }
     // else
     {
-        // Compressed deltas
-        if( _plot.Read( compressedDeltasSize, compressedDeltaBuffer ) != compressedDeltasSize )
-            return false;
-
         // Decompress deltas
         const FSE_DTable* dTable = GetDTableForTable( table );
 
         deltaCount = FSE_decompress_usingDTable( 
                         deltaBuffer, kEntriesPerPark - 1, 
-                        compressedDeltaBuffer, compressedDeltasSize, 
+                        parkBytes + deltasOffset + sizeof( uint16 ), compressedDeltasSize, 
                         dTable );
 
         if( FSE_isError( deltaCount ) )
             return false;
     }
     
-    outStubs         = CPBitReader( (byte*)stubsBuffer, RoundUpToNextBoundary( stubsSizeBytes * 8, 64 ) );
+    outStubs         = CPBitReader( stubsBuffer, RoundUpToNextBoundary( stubsSizeBytes * 8, 64 ) );
     outBaseLinePoint = baseLinePoint;
     outDeltas        = deltaBuffer;
     outDeltaCounts   = deltaCount;
@@ -500,6 +557,12 @@ size_t PlotReader::GetParkDeltasSectionMaxSize( const TableId table ) const
 // #TODO: Add 64-bit outLinePoint (templatize)
 //-----------------------------------------------------------
 bool PlotReader::ReadLP( TableId table, uint64 index, uint128& outLinePoint )
+{
+    return ReadLP( table, index, outLinePoint, _parkBuffer, _deltasBuffer );
+}
+
+//-----------------------------------------------------------
+bool PlotReader::ReadLP( TableId table, uint64 index, uint128& outLinePoint, uint64* parkBuffer, byte* deltasBuffer )
 {
     outLinePoint = 0;
 
@@ -510,7 +573,7 @@ bool PlotReader::ReadLP( TableId table, uint64 index, uint128& outLinePoint )
 
     const uint64 parkIndex  = index / kEntriesPerPark;
 
-    if( !ReadLPParkComponents( table, parkIndex, stubReader, deltaBuffer, baseLinePoint, deltaCount ) )
+    if( !ReadLPParkComponents( table, parkIndex, stubReader, deltaBuffer, baseLinePoint, deltaCount, parkBuffer, deltasBuffer ) )
         return false;
 
     const uint64 lpLocalIdx = index - parkIndex * kEntriesPerPark;
@@ -549,16 +612,20 @@ bool PlotReader::FetchProofFromP7Entry( uint64 p7Entry, uint64 proof[32] )
 //-----------------------------------------------------------
 uint64 PlotReader::GetP7IndicesForF7( const uint64 f7, uint64& outStartT6Index )
 {
-    if( !LoadC2Entries() )
+    if( !LoadCheckpoints() )
+        return 0;
+
+    const std::vector<uint64>& c2Entries = _checkpoints->c2Entries;
+    if( c2Entries.empty() )
         return 0;
 
     uint64 c2Index = 0;
 
     for( uint64 i = 0; ; )
     {
-        const uint64 c2 = _c2Entries[i];
+        const uint64 c2 = c2Entries[i];
 
-        if( c2 > f7 || ++i >= _c2Entries.Length() )
+        if( c2 > f7 || ++i >= c2Entries.size() )
         {
             if( c2Index > 0 ) c2Index--;
             break;
@@ -569,46 +636,35 @@ uint64 PlotReader::GetP7IndicesForF7( const uint64 f7, uint64& outStartT6Index )
 
     const uint64 c1StartIndex = c2Index * kCheckpoint2Interval;
 
-    const uint32 k              = _plot.K();
-    const size_t f7SizeBytes    = CDiv( k, 8 );
-    const size_t f7BitCount     = f7SizeBytes * 8;
-    const uint64 c1TableAddress = _plot.TableAddress( PlotTable::C1 );
-    const size_t c1TableSize    = _plot.TableSize( PlotTable::C1 );
-    const uint64 c1TableEnd     = c1TableAddress + c1TableSize;
-    const uint64 c1EntryAddress = c1TableAddress + c1StartIndex * f7SizeBytes;
+    const uint32 k             = _plot.K();
+    const size_t f7SizeBytes   = CDiv( k, 8 );
+    const size_t f7BitCount    = f7SizeBytes * 8;
+    const uint64 c1EntryOffset = c1StartIndex * f7SizeBytes;
 
+    if( c1EntryOffset >= _checkpoints->c1TableSize )
+        return {};
 
-    const uint64 c1EndAddress = std::min( c1EntryAddress + ( kCheckpoint1Interval * f7SizeBytes ), c1TableEnd );
+    // The C1 entries of this C2 interval
+    static_assert( kCheckpoint1Interval == kCheckpoint2Interval );
+    const sptr<const PlotC1Segment> c1Segment = PlotCheckpointCache::AcquireC1Segment( _plot, *_checkpoints, c2Index );
+    if( !c1Segment )
+        return {};
 
-    const size_t readSize     = c1EndAddress - c1EntryAddress;
+    const size_t readSize     = c1Segment->c1Bytes.size();
     const uint64 c1EntryCount = readSize / f7SizeBytes;
 
     if( c1EntryCount < 1 )
         return {};
 
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)c1EntryAddress ) )
-    {
-        Log::Error( "Seek to C1 address failed: %d", _plot.GetError() );
-        return {};
-    }
-
     // Read C1 entries until we find one equal or larger than the f7 we're looking for
-    if( !_c1Buffer )
-        _c1Buffer = bbcvirtallocbounded<byte>( kCheckpoint1Interval * f7SizeBytes );
-    
-    if( _plot.Read( readSize, _c1Buffer ) != (ssize_t)readSize )
-    {
-        Log::Error( "Failed to read C1 entries: %d", _plot.GetError() );
-        return {};
-    }
-
-    CPBitReader reader( _c1Buffer, readSize * 8 );
+    CPBitReader reader( c1Segment->c1Bytes.data(), readSize * 8 );
     uint64 c3Park = c1StartIndex;
     uint64 c1     = 0;
 
     for( uint64 i = 0; ; )
     {
-        c1 = reader.Read64( (uint32)f7BitCount );
+        // Entries are left-aligned to their byte size
+        c1 = reader.Read64( (uint32)f7BitCount ) >> ( f7BitCount - k );
 
         if( c1 >= f7 || ++i >= c1EntryCount )
         {
@@ -619,9 +675,9 @@ uint64 PlotReader::GetP7IndicesForF7( const uint64 f7, uint64& outStartT6Index )
         c3Park++;
     }
 
-    const uint64 parkCount = c1 == f7 && c3Park > 0 ? 2 : 1; // If we got the same c1 as f7, then the previous
-                                                             // needs to be read as well because we may have duplicate f7s
-                                                             // in the previous park's last entries.
+    // If we got the same c1 as f7, then the f7 starts the park after c3Park, which must be read as well.
+    // c3Park itself is still read, because we may have duplicate f7s in its last entries.
+    const uint64 parkCount = c1 == f7 && c3Park + 1 < GetC3ParkCount() ? 2 : 1;
         
     if( _c3Buffer.Ptr() == nullptr )
     {
@@ -629,6 +685,9 @@ uint64 PlotReader::GetP7IndicesForF7( const uint64 f7, uint64& outStartT6Index )
         _c3Buffer.length = kCheckpoint1Interval * 2;
     }
 
+    const size_t c3ParkSize = CalculateC3Size( k );
+    _plot.Prefetch( _plot.TableAddress( PlotTable::C3 ) + c3Park * c3ParkSize, parkCount * c3ParkSize );
+
     int64 c3Count = ReadC3Park( c3Park, _c3Buffer.Ptr() );
     if( c3Count < 0)
         return {};
@@ -687,19 +746,27 @@ ProofFetchResult PlotReader::FetchProof( const uint64 t6LPIndex, uint64 fullProo
 
         const bool use64BitLP = table < TableId::Table6 && _plot.K() <= 32;
 
-        for( uint32 i = 0, dst = 0; i < lookupCount; i++, dst += 2 )
-        {
-            const uint64 idx = lpIdxSrc[i];
+        // All parks needed for this table are known up front, so let them be brought in at once
+        PrefetchLPParks( table, lpIdxSrc, lookupCount );
 
-            uint128 lp = 0;
-            if( !ReadLP( table, idx, lp ) )
+        if( _fetchPool && lookupCount > 1 )
+        {
+            // Fan out the park reads of this level and decode them concurrently
+            if( !FetchLevelParallel( table, lpIdxSrc, lpIdxDst, lookupCount ) )
                 return ProofFetchResult::Error;
+        }
+        else
+        {
+            uint128 lps[BB_PLOT_PROOF_X_COUNT / 2];
 
-            const BackPtr ptr = use64BitLP ? LinePointToSquare64( (uint64)lp ) : LinePointToSquare( lp );
+            for( uint32 i = 0; i < lookupCount; i++ )
+            {
+                lps[i] = 0;
+                if( !ReadLP( table, lpIdxSrc[i], lps[i] ) )
+                    return ProofFetchResult::Error;
+            }
 
-            ASSERT( ptr.x > ptr.y );
-            lpIdxDst[dst+0] = ptr.y;
-            lpIdxDst[dst+1] = ptr.x;
+            LinePointsToBackPtrs( use64BitLP, lps, lookupCount, lpIdxDst );
         }
 
         lookupCount <<= 1;
@@ -719,10 +786,78 @@ ProofFetchResult PlotReader::FetchProof( const uint64 t6LPIndex, uint64 fullProo
     return ProofFetchResult::OK;
 }
 
+//-----------------------------------------------------------
+bool PlotReader::FetchLevelParallel( const TableId table, const uint64* lpIndices, uint64* outBackPtrs, const uint32 lookupCount )
+{
+    ASSERT( _fetchPool );
+    ASSERT( lookupCount <= BB_PLOT_PROOF_X_COUNT );
+
+    const bool   use64BitLP  = table < TableId::Table6 && _plot.K() <= 32;
+    const uint32 threadCount = std::min( lookupCount, _fetchPool->ThreadCount() );
+
+    std::atomic<bool> failed = false;
+
+    AnonMTJob::Run( *_fetchPool, threadCount, [&]( AnonMTJob* self ) {
+
+        uint32 count, offset, _;
+        GetThreadOffsets( self, lookupCount, count, offset, _ );
+
+        uint64* parkBuffer   = _fetchParkBuffers  [self->JobId()];
+        byte*   deltasBuffer = _fetchDeltasBuffers[self->JobId()];
+
+        uint128 lps[BB_PLOT_PROOF_X_COUNT / 2];
+
+        for( uint32 i = 0; i < count; i++ )
+        {
+            lps[i] = 0;
+            if( !ReadLP( table, lpIndices[offset+i], lps[i], parkBuffer, deltasBuffer ) )
+            {
+                failed.store( true, std::memory_order_relaxed );
+                return;
+            }
+        }
+
+        LinePointsToBackPtrs( use64BitLP, lps, count, outBackPtrs + offset * 2 );
+    });
+
+    return !failed.load( std::memory_order_relaxed );
+}
+
+//-----------------------------------------------------------
+void PlotReader::ConfigProofFetch( uint32 threadCount )
+{
+    threadCount = std::min( threadCount, (uint32)BB_PLOT_PROOF_X_COUNT / 2 );
+
+    for( uint32 i = 0; i < _fetchThreadCount; i++ )
+    {
+        free( _fetchParkBuffers[i] );
+        free( _fetchDeltasBuffers[i] );
+    }
+    _fetchThreadCount = 0;
+
+    if( _fetchPool )
+        delete _fetchPool;
+    _fetchPool = nullptr;
+
+    if( threadCount < 2 )
+        return;
+
+    // I/O bound, so don't pin threads to CPUs
+    _fetchPool        = new ThreadPool( threadCount, ThreadPool::Mode::Fixed, true );
+    _fetchThreadCount = threadCount;
+
+    for( uint32 i = 0; i < threadCount; i++ )
+    {
+        _fetchParkBuffers[i]   = bbmalloc<uint64>( _parkBufferSize );
+        _fetchDeltasBuffers[i] = bbmalloc<byte>  ( _deltasBufferSize );
+    }
+}
+
 //-----------------------------------------------------------
 ProofFetchResult PlotReader::DecompressProof( const uint64 compressedProof[BB_PLOT_PROOF_X_COUNT], uint64 fullProofXs[BB_PLOT_PROOF_X_COUNT] )
 {
-    GreenReaperContext* gr = GetGRContext();
+    GRContextLease      lease;
+    GreenReaperContext* gr = GetGRContext( lease );
     if( !gr )
         return ProofFetchResult::Error;
 
@@ -757,10 +892,11 @@ ProofFetchResult PlotReader::FetchQualityXsForP7Entry(
     const bool    isCompressed = _plot.CompressionLevel() > 0;
     const TableId endTable     = GetLowestStoredTable();
 
+    GRContextLease      lease;
     GreenReaperContext* gr = nullptr;
     if( isCompressed )
     {
-        gr = GetGRContext();
+        gr = GetGRContext( lease );
         if( !gr )
             return ProofFetchResult::Error;
     }
@@ -877,56 +1013,36 @@ ProofFetchResult PlotReader::FetchQualityForP7Entry(
 }
 
 //-----------------------------------------------------------
-bool PlotReader::LoadC2Entries()
+void PlotReader::PrefetchLPParks( const TableId table, const uint64* lpIndices, const uint32 count )
 {
-    if( _c2Entries.Ptr() )
-        return true;
-
-    const size_t c2Size = _plot.TableSize( PlotTable::C2 );
-    if( c2Size == 0 )
-        return false;
-
-    const size_t f7ByteSize = CDiv( _plot.K(), 8 );
-
-    const uint64 c2MaxEntries = c2Size / f7ByteSize;
-    if( c2MaxEntries < 1 )
-        return false;
+    const uint64 tableAddress = _plot.TableAddress( (PlotTable)table );
+    const size_t parkSize     = GetParkSizeForTable( table );
 
-    if( !_plot.Seek( SeekOrigin::Begin, (int64)_plot.TableAddress( PlotTable::C2 ) ) )
-        return false;
-
-   
-    byte* buffer = bbvirtallocbounded<byte>( c2Size );
-
-    if( _plot.Read( c2Size, buffer ) != (ssize_t)c2Size )
-    {
-        bbvirtfreebounded( buffer );
-        return false;
-    }
-
-    _c2Entries = Span<uint64>( new uint64[c2MaxEntries], c2MaxEntries );
+    for( uint32 i = 0; i < count; i++ )
+        _plot.Prefetch( tableAddress + lpIndices[i] / kEntriesPerPark * parkSize, parkSize );
+}
 
-    const size_t f7BitCount = f7ByteSize * 8;
-    CPBitReader reader( buffer, c2Size * 8 );
+//-----------------------------------------------------------
+const byte* PlotReader::ReadPlotBytes( const uint64 address, const size_t size, void* buffer )
+{
+    const byte* view = _plot.View( address, size );
+    if( view )
+        return view;
 
-    uint64 prevF7 = 0;
-    uint64 i;
-    for( i = 0; i < c2MaxEntries; i++ )
-    {
-        const uint64 f7 = reader.Read64( (uint32)f7BitCount );
-        
-        // Short circuit if we encounter an unsorted/out-of-order c2 entry
-        if( f7 < prevF7 )
-            break;
+    if( _plot.ReadAt( address, size, buffer ) != (ssize_t)size )
+        return nullptr;
 
-        _c2Entries[i] = f7;
-        prevF7 = f7;
-    }
+    return (byte*)buffer;
+}
 
-    _c2Entries.length = i;
+//-----------------------------------------------------------
+bool PlotReader::LoadCheckpoints()
+{
+    if( _checkpoints )
+        return true;
 
-    bbvirtfreebounded( buffer );
-    return true;
+    _checkpoints = PlotCheckpointCache::Acquire( _plot );
+    return _checkpoints != nullptr;
 }
 
 //-----------------------------------------------------------
@@ -941,6 +1057,22 @@ void PlotReader::AssignDecompressionContext( struct GreenReaperContext* context
     
     _grContext     = context;
     _ownsGrContext = false;
+    _grPool        = nullptr;
+}
+
+//-----------------------------------------------------------
+void PlotReader::AssignDecompressionContextPool( struct GRContextPool* pool )
+{
+    ASSERT( pool );
+    if( !pool )
+        return;
+
+    if( _grContext && _ownsGrContext )
+        grDestroyContext( _grContext );
+
+    _grContext     = nullptr;
+    _ownsGrContext = false;
+    _grPool        = pool;
 }
 
 //-----------------------------------------------------------
@@ -951,6 +1083,7 @@ void PlotReader::ConfigDecompressor( const uint32 threadCount, const bool disabl
 
     _grContext     = nullptr;
     _ownsGrContext = true;
+    _grPool        = nullptr;
 
     GreenReaperConfig cfg = {};
     cfg.apiVersion         = GR_API_VERSION;
@@ -965,6 +1098,17 @@ void PlotReader::ConfigDecompressor( const uint32 threadCount, const bool disabl
     ASSERT( result == GRResult_OK );
 }
 
+//-----------------------------------------------------------
+GreenReaperContext* PlotReader::GetGRContext( GRContextLease& lease )
+{
+    if( !_grPool )
+        return GetGRContext();
+
+    lease.pool    = _grPool;
+    lease.context = grAcquireContext( _grPool, GR_TRUE );
+    return lease.context;
+}
+
 //-----------------------------------------------------------
 GreenReaperContext* PlotReader::GetGRContext()
 {
@@ -1200,12 +1344,32 @@ ssize_t MemoryPlot::Read( size_t size, void* buffer )
     return (ssize_t)size;
 }
 
+//-----------------------------------------------------------
+ssize_t MemoryPlot::ReadAt( const uint64 address, const size_t size, void* buffer )
+{
+    const byte* src = View( address, size );
+    if( !src )
+        return -1;
+
+    memcpy( buffer, src, size );
+    return (ssize_t)size;
+}
+
 //-----------------------------------------------------------
 int MemoryPlot::GetError() 
 {
     return _err;
 }
 
+//-----------------------------------------------------------
+const byte* MemoryPlot::View( const uint64 address, const size_t size )
+{
+    if( address > _bytes.length || size > _bytes.length - address )
+        return nullptr;
+
+    return _bytes.values + address;
+}
+
 
 
 ///
@@ -1294,9 +1458,433 @@ bool FilePlot::Seek( SeekOrigin origin, int64 offset )
     return _file.Seek( offset, origin );
 }
 
+//-----------------------------------------------------------
+ssize_t FilePlot::ReadAt( const uint64 address, const size_t size, void* buffer )
+{
+    byte*  dst       = (byte*)buffer;
+    size_t remainder = size;
+    uint64 offset    = address;
+
+    while( remainder )
+    {
+        const ssize_t read = _file.ReadAt( dst, remainder, (int64)offset );
+        if( read < 1 )
+        {
+            Log::Error( "Failed to read from plot with error %d", _file.GetError() );
+            return -1;
+        }
+
+        remainder -= (size_t)read;
+        offset    += (uint64)read;
+        dst       += read;
+    }
+
+    return (ssize_t)size;
+}
+
 //-----------------------------------------------------------
 int FilePlot::GetError()
 {
     return _file.GetError();
 }
 
+
+
+///
+/// MMapPlot
+///
+#if !PLATFORM_IS_WINDOWS
+
+// Mapped plots, so that a SIGBUS raised by one that was truncated can be recovered from.
+// The handler can't take locks, so the mappings are kept in a fixed table of atomics.
+// Slots are only claimed and released under the lock.
+struct MMapGuardSlot
+{
+    std::atomic<uintptr_t> start = 0;
+    std::atomic<uintptr_t> end   = 0;
+    std::atomic<bool>      lost  = false;
+};
+
+static constexpr uint32     MMAP_GUARD_MAX_SLOTS = 16384;
+static MMapGuardSlot        _mmapGuardSlots[MMAP_GUARD_MAX_SLOTS];
+static std::atomic<uint32>  _mmapGuardSlotCount  = 0;     // High water mark of used slots
+static std::mutex           _mmapGuardLock;
+static struct sigaction     _prevBusAction       = {};
+static size_t               _mmapGuardPageSize   = 0;
+
+//-----------------------------------------------------------
+static void MMapBusHandler( int sig, siginfo_t* info, void* context )
+{
+    const uintptr_t address   = (uintptr_t)info->si_addr;
+    const uint32    slotCount = _mmapGuardSlotCount.load( std::memory_order_acquire );
+
+    for( uint32 i = 0; i < slotCount; i++ )
+    {
+        MMapGuardSlot& slot = _mmapGuardSlots[i];
+
+        if( address < slot.start.load( std::memory_order_acquire ) || address >= slot.end.load( std::memory_order_acquire ) )
+            continue;
+
+        // Replace the page that is no longer backed by the file with zeros, so that the faulting read can complete
+        void* page = (void*)( address & ~( (uintptr_t)_mmapGuardPageSize - 1 ) );
+
+        if( mmap( page, _mmapGuardPageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0 ) == MAP_FAILED )
+            break;
+
+        slot.lost.store( true, std::memory_order_release );
+        return;
+    }
+
+    // Not one of ours
+    if( _prevBusAction.sa_flags & SA_SIGINFO )
+    {
+        _prevBusAction.sa_sigaction( sig, info, context );
+    }
+    else if( _prevBusAction.sa_handler != SIG_DFL && _prevBusAction.sa_handler != SIG_IGN )
+    {
+        _prevBusAction.sa_handler( sig );
+    }
+    else
+    {
+        // Let the faulting instruction raise it again with the default action
+        signal( SIGBUS, SIG_DFL );
+    }
+}
+
+//-----------------------------------------------------------
+static int32 MMapGuardRegister( const byte* bytes, const size_t size )
+{
+    std::lock_guard<std::mutex> lock( _mmapGuardLock );
+
+    static bool installed = false;
+    if( !installed )
+    {
+        _mmapGuardPageSize = SysHost::GetPageSize();
+
+        struct sigaction action = {};
+        action.sa_sigaction = MMapBusHandler;
+        action.sa_flags     = SA_SIGINFO | SA_RESTART;
+        sigemptyset( &action.sa_mask );
+
+        if( sigaction( SIGBUS, &action, &_prevBusAction ) != 0 )
+            return -1;
+
+        installed = true;
+    }
+
+    const uint32 slotCount = _mmapGuardSlotCount.load( std::memory_order_relaxed );
+
+    uint32 i = 0;
+    while( i < slotCount && _mmapGuardSlots[i].start.load( std::memory_order_relaxed ) != 0 )
+        i++;
+
+    if( i == MMAP_GUARD_MAX_SLOTS )
+        return -1;
+
+    MMapGuardSlot& slot = _mmapGuardSlots[i];
+    slot.lost .store( false, std::memory_order_relaxed );
+    slot.end  .store( (uintptr_t)bytes + size, std::memory_order_relaxed );
+    slot.start.store( (uintptr_t)bytes, std::memory_order_release );
+
+    if( i == slotCount )
+        _mmapGuardSlotCount.store( slotCount + 1, std::memory_order_release );
+
+    return (int32)i;
+}
+
+//-----------------------------------------------------------
+static void MMapGuardUnregister( const int32 slotIndex )
+{
+    std::lock_guard<std::mutex> lock( _mmapGuardLock );
+
+    MMapGuardSlot& slot = _mmapGuardSlots[slotIndex];
+    slot.start.store( 0, std::memory_order_release );
+    slot.end  .store( 0, std::memory_order_release );
+}
+
+#endif // !PLATFORM_IS_WINDOWS
+
+//-----------------------------------------------------------
+MMapPlot::MMapPlot()
+{}
+
+//-----------------------------------------------------------
+MMapPlot::MMapPlot( const MMapPlot& file )
+{
+    if( file.IsOpen() )
+        Open( file._plotPath.c_str() );
+}
+
+//-----------------------------------------------------------
+MMapPlot::~MMapPlot()
+{
+    Close();
+}
+
+//-----------------------------------------------------------
+bool MMapPlot::Open( const char* path )
+{
+    ASSERT( path );
+    if( !path )
+        return false;
+
+    if( IsOpen() )
+        return false;
+
+    _err      = 0;
+    _position = 0;
+
+    // The mapping stays valid after the file is closed, but we keep it open
+    // to read from it instead if the plot is truncated while mapped.
+    FileStream& file = _file;
+    if( !file.Open( path, FileMode::Open, FileAccess::Read ) )
+    {
+        _err = file.GetError();
+        return false;
+    }
+
+    const ssize_t plotSize = file.Size();
+    if( plotSize <= 0 )
+    {
+        if( plotSize < 0 )
+            _err = file.GetError();
+        else
+            _err = -1;  // #TODO: Assign an actual user error.
+        file.Close();
+        return false;
+    }
+
+    #if PLATFORM_IS_WINDOWS
+        HANDLE mapping = CreateFileMappingW( (HANDLE)file.Id(), NULL, PAGE_READONLY, 0, 0, NULL );
+        if( mapping == NULL )
+        {
+            _err = (int)GetLastError();
+            return false;
+        }
+
+        void* bytes = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+        if( bytes == NULL )
+            _err = (int)GetLastError();
+
+        // The view keeps a reference to the mapping object
+        CloseHandle( mapping );
+
+        if( bytes == NULL )
+        {
+            file.Close();
+            return false;
+        }
+    #else
+        void* bytes = mmap( nullptr, (size_t)plotSize, PROT_READ, MAP_SHARED, (int)file.Id(), 0 );
+        if( bytes == MAP_FAILED )
+        {
+            _err = errno;
+            file.Close();
+            return false;
+        }
+
+        // Proof and quality lookups jump between parks all over the plot,
+        // so don't let the kernel waste I/O on read-ahead.
+        madvise( bytes, (size_t)plotSize, MADV_RANDOM );
+
+        _guardSlot = MMapGuardRegister( (byte*)bytes, (size_t)plotSize );
+        if( _guardSlot < 0 )
+            Log::Error( "Warning: Could not guard the mapping of plot '%s'. Truncating it while open will crash.", path );
+    #endif
+
+    _bytes = (byte*)bytes;
+    _size  = (size_t)plotSize;
+
+    // Read the header
+    int headerError = 0;
+    if( !ReadHeader( headerError ) )
+    {
+        if( headerError )
+            _err = headerError;
+
+        if( _err == 0 )
+            _err = -1; // #TODO: Set generic plot header read error
+
+        Close();
+        return false;
+    }
+
+    _position = 0;
+    _plotPath = path;
+    return true;
+}
+
+//-----------------------------------------------------------
+void MMapPlot::Close()
+{
+    if( !_bytes )
+        return;
+
+    #if PLATFORM_IS_WINDOWS
+        UnmapViewOfFile( _bytes );
+    #else
+        if( _guardSlot >= 0 )
+            MMapGuardUnregister( _guardSlot );
+
+        munmap( _bytes, _size );
+    #endif
+
+    _file.Close();
+
+    _bytes     = nullptr;
+    _size      = 0;
+    _position  = 0;
+    _guardSlot = -1;
+}
+
+//-----------------------------------------------------------
+bool MMapPlot::IsOpen() const
+{
+    return _bytes != nullptr;
+}
+
+//-----------------------------------------------------------
+bool MMapPlot::IsMappingLost() const
+{
+    #if PLATFORM_IS_WINDOWS
+        return false;
+    #else
+        return _guardSlot >= 0 && _mmapGuardSlots[_guardSlot].lost.load( std::memory_order_acquire );
+    #endif
+}
+
+//-----------------------------------------------------------
+size_t MMapPlot::PlotSize() const
+{
+    return _size;
+}
+
+//-----------------------------------------------------------
+bool MMapPlot::Seek( SeekOrigin origin, int64 offset )
+{
+    ssize_t absPosition = 0;
+
+    switch( origin )
+    {
+        case SeekOrigin::Begin:
+            absPosition = offset;
+            break;
+
+        case SeekOrigin::Current:
+            absPosition = _position + offset;
+            break;
+
+        case SeekOrigin::End:
+            absPosition = (ssize_t)_size + offset;
+            break;
+    
+        default:
+            _err =  -1;     // #TODO: Set proper user error.
+            return false;
+    }
+
+    if( absPosition < 0 || absPosition > (ssize_t)_size )
+    {
+        _err =  -1;     // #TODO: Set proper user error.
+        return false;
+    }
+
+    _position = absPosition;
+    return true;
+}
+
+//-----------------------------------------------------------
+ssize_t MMapPlot::Read( size_t size, void* buffer )
+{
+    if( size < 1 || !buffer )
+        return 0;
+
+    const size_t endPos = (size_t)_position + size;
+
+    if( endPos > _size )
+    {
+        _err = -1; // #TODO: Set proper user error
+        return 0;
+    }
+
+    if( ReadAt( (uint64)_position, size, buffer ) != (ssize_t)size )
+        return 0;
+
+    _position = (ssize_t)endPos;
+
+    return (ssize_t)size;
+}
+
+//-----------------------------------------------------------
+ssize_t MMapPlot::ReadAt( const uint64 address, const size_t size, void* buffer )
+{
+    if( address > _size || size > _size - address )
+        return -1;
+
+    if( !IsMappingLost() )
+    {
+        memcpy( buffer, _bytes + address, size );
+
+        // Zero pages were substituted while copying
+        if( !IsMappingLost() )
+            return (ssize_t)size;
+    }
+
+    byte*  dst       = (byte*)buffer;
+    size_t remainder = size;
+    uint64 offset    = address;
+
+    while( remainder )
+    {
+        const ssize_t read = _file.ReadAt( dst, remainder, (int64)offset );
+        if( read < 1 )
+        {
+            _err = read < 0 ? _file.GetError() : -1;    // #TODO: Set proper user error for a truncated plot
+            return -1;
+        }
+
+        remainder -= (size_t)read;
+        offset    += (uint64)read;
+        dst       += read;
+    }
+
+    return (ssize_t)size;
+}
+
+//-----------------------------------------------------------
+int MMapPlot::GetError()
+{
+    return _err;
+}
+
+//-----------------------------------------------------------
+const byte* MMapPlot::View( const uint64 address, const size_t size )
+{
+    // Have the caller read through ReadAt() instead
+    if( address > _size || size > _size - address || IsMappingLost() )
+        return nullptr;
+
+    return _bytes + address;
+}
+
+//-----------------------------------------------------------
+void MMapPlot::Prefetch( const uint64 address, const size_t size )
+{
+    if( address >= _size || size == 0 || IsMappingLost() )
+        return;
+
+    const size_t end = (size_t)std::min( (uint64)_size, address + size );
+
+    #if PLATFORM_IS_WINDOWS
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = _bytes + address;
+        range.NumberOfBytes  = end - address;
+        PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+    #else
+        // madvise() requires a page-aligned start address
+        const uintptr_t pageSize = (uintptr_t)SysHost::GetPageSize();
+        const uintptr_t start    = ((uintptr_t)(_bytes + address)) & ~(pageSize - 1);
+
+        madvise( (void*)start, (uintptr_t)(_bytes + end) - start, MADV_WILLNEED );
+    #endif
+}
@@ -112,9 +112,21 @@ public:
     // whatever the underlying implementation may be.
     virtual bool Seek( SeekOrigin origin, int64 offset ) = 0;
 
+    // Read data at an absolute plot address without using or updating the Seek() position.
+    // Implementations must support concurrent calls from multiple threads.
+    virtual ssize_t ReadAt( uint64 address, size_t size, void* buffer ) = 0;
+
     // Get last error ocurred
     virtual int GetError() = 0;
 
+    // Returns a read-only pointer to the plot bytes at the specified address,
+    // or nullptr if the implementation does not keep the plot addressable in memory,
+    // in which case the caller must fall back to Seek() and Read().
+    virtual const byte* View( uint64 address, size_t size ) { (void)address; (void)size; return nullptr; }
+
+    // Hint that the specified region is about to be read.
+    virtual void Prefetch( uint64 address, size_t size ) { (void)address; (void)size; }
+
 protected:
 
     // Implementors can call this to load the header
@@ -141,8 +153,12 @@ public:
 
     bool Seek( SeekOrigin origin, int64 offset ) override;
 
+    ssize_t ReadAt( uint64 address, size_t size, void* buffer ) override;
+
     int GetError() override;
 
+    const byte* View( uint64 address, size_t size ) override;
+
 private:
     Span<byte>  _bytes;  // Plot bytes
     int         _err      = 0;
@@ -166,6 +182,8 @@ public:
 
     bool Seek( SeekOrigin origin, int64 offset ) override;
 
+    ssize_t ReadAt( uint64 address, size_t size, void* buffer ) override;
+
     int GetError() override;
 
 private:
@@ -173,6 +191,58 @@ private:
     std::string _plotPath = "";
 };
 
+// Maps the plot file read-only into the address space.
+// Parks are served as zero-copy views into the mapping. The mapping is
+// advised for random access, since P7, C3 and line point park lookups
+// are scattered across the plot, and the parks of a proof can be
+// prefetched ahead of reading them.
+//
+// Deleting the plot while it is mapped is safe: its pages stay readable until it is closed.
+// Truncating it is not: on POSIX systems, touching mapped pages past the new end of the file raises SIGBUS.
+// Such faults are caught while the plot is open. The pages that faulted read as zeros,
+// and all further reads fall back to pread(), which fails past the new end of the file.
+// So a proof or quality being read while the plot is truncated may come back invalid, but does not crash.
+// Windows does not allow truncating a mapped file.
+class MMapPlot : public IPlotFile
+{
+public:
+    MMapPlot();
+    MMapPlot( const MMapPlot& file );
+    ~MMapPlot();
+
+    bool Open( const char* path ) override;
+    bool IsOpen() const override;
+
+    size_t PlotSize() const override;
+
+    ssize_t Read( size_t size, void* buffer ) override;
+
+    bool Seek( SeekOrigin origin, int64 offset ) override;
+
+    ssize_t ReadAt( uint64 address, size_t size, void* buffer ) override;
+
+    int GetError() override;
+
+    const byte* View( uint64 address, size_t size ) override;
+
+    void Prefetch( uint64 address, size_t size ) override;
+
+    // True if the plot was truncated while mapped, in which case reads go through the file instead
+    bool IsMappingLost() const;
+
+private:
+    void Close();
+
+private:
+    byte*       _bytes     = nullptr;   // Mapped plot bytes
+    size_t      _size      = 0;
+    ssize_t     _position  = 0;
+    int         _err       = 0;
+    int32       _guardSlot = -1;        // Slot registered with the SIGBUS handler
+    FileStream  _file;                  // Kept open to read from when the mapping is lost
+    std::string _plotPath  = "";
+};
+
 class PlotReader
 {
 public:
@@ -242,8 +312,16 @@ public:
     // Takes ownership of a decompression context
     void AssignDecompressionContext( struct GreenReaperContext* context );
 
+    // Borrow a decompression context from the pool for each request that needs one,
+    // instead of owning a context. The pool must outlive the reader.
+    void AssignDecompressionContextPool( struct GRContextPool* pool );
+
     void ConfigDecompressor( uint32 threadCount, bool disableCPUAffinity, uint32 cpuOffset = 0, bool useGpu = false, int gpuIndex = -1 );
 
+    // Use threadCount threads to read and decode the parks of each table level of a full proof concurrently.
+    // The plot must support concurrent reads. A count below 2 fetches proofs on the calling thread only.
+    void ConfigProofFetch( uint32 threadCount );
+
     inline void ConfigGpuDecompressor( uint32 threadCount, bool disableCPUAffinity, uint32 cpuOffset = 0 )
     {
         ConfigDecompressor( threadCount, disableCPUAffinity, cpuOffset, true );
@@ -258,26 +336,55 @@ private:
                                CPBitReader& outStubs, byte*& outDeltas, 
                                uint128& outBaseLinePoint, uint64& outDeltaCounts );
 
+    bool ReadLPParkComponents( TableId table, uint64 parkIndex, 
+                               CPBitReader& outStubs, byte*& outDeltas, 
+                               uint128& outBaseLinePoint, uint64& outDeltaCounts,
+                               uint64* parkBuffer, byte* deltasBuffer );
+
+    bool ReadLP( TableId table, uint64 index, uint128& outLinePoint, uint64* parkBuffer, byte* deltasBuffer );
+
+    // Read the line points of one table level and write their back pointers to outBackPtrs
+    bool FetchLevelParallel( TableId table, const uint64* lpIndices, uint64* outBackPtrs, uint32 lookupCount );
+
     bool LoadP7Park( uint64 parkIndex );
 
-    bool LoadC2Entries();
+    // Acquire the C1 and C2 checkpoint tables from the shared checkpoint cache
+    bool LoadCheckpoints();
+
+    // Returns a pointer to size bytes at the plot address. This is a zero-copy
+    // view when the plot supports it, otherwise the bytes are read into buffer.
+    // Returns nullptr on failure.
+    const byte* ReadPlotBytes( uint64 address, size_t size, void* buffer );
+
+    void PrefetchLPParks( TableId table, const uint64* lpIndices, uint32 count );
 
     struct GreenReaperContext* GetGRContext();
 
+    // Same as above, but when using a context pool, the context is held by the lease until it goes out of scope
+    struct GreenReaperContext* GetGRContext( struct GRContextLease& lease );
+
 private:
     IPlotFile& _plot;
     uint32     _version;
 
-    // size_t  _parkBufferSize;
+    size_t       _parkBufferSize;
+    size_t       _deltasBufferSize;
     uint64*      _parkBuffer;           // Buffer for loading compressed park data.
     byte*        _deltasBuffer;         // Buffer for decompressing deltas in parks that have delta. 
 
-    byte*        _c1Buffer = nullptr;
-    Span<uint64> _c2Entries;
     Span<uint64> _c3Buffer;
 
+    sptr<const struct PlotCheckpoints> _checkpoints;    // C2 table, shared with other readers of the same plot
+
     struct GreenReaperContext* _grContext     = nullptr;    // Used for decompressing
     bool                       _ownsGrContext = true;
+    struct GRContextPool*      _grPool        = nullptr;    // If set, contexts are borrowed from it per request
+
+    // Level-parallel proof fetching
+    class ThreadPool* _fetchPool        = nullptr;
+    uint32            _fetchThreadCount = 0;
+    uint64*           _fetchParkBuffers  [BB_PLOT_PROOF_X_COUNT/2] = {};
+    byte*             _fetchDeltasBuffers[BB_PLOT_PROOF_X_COUNT/2] = {};
 
     int64  _park7Index = -1;
     uint64 _park7Entries[kEntriesPerPark];
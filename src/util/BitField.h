@@ -1,5 +1,9 @@
 #pragma once
 
+#if _WIN32
+    #include <intrin.h>
+#endif
+
 
 ///
 /// Unsafe use: It does not do any bounds checking.
@@ -47,6 +51,22 @@ public:
         fields[fieldIdx] = field | (1ull << lShift);
     }
 
+    //-----------------------------------------------------------
+    // Safe to use when multiple threads may be setting bits in the same field
+    inline void SetAtomic( uint64 index )
+    {
+        ASSERT( index < _length );
+
+        const uint64 fieldIdx = index >> 6;
+        const uint64 bit      = 1ull << (uint32)(index - (fieldIdx << 6));
+
+    #if _WIN32
+        _InterlockedOr64( (volatile long long*)&_fields[fieldIdx], (long long)bit );
+    #else
+        __atomic_fetch_or( &_fields[fieldIdx], bit, __ATOMIC_RELAXED );
+    #endif
+    }
+
     //-----------------------------------------------------------
     inline void SetBit( uint64 index, const uint64 bit )
     {
@@ -574,8 +574,10 @@ public:
     {
         ASSERT( sizeBits <= BitSize );
 
+        ASSERT( sizeBits > 0 );
+
         const uint64 startField = bitOffset >> 6; // div 64
-        const uint64 endField   = ( startField * 64 + sizeBits ) >> 6; // div 64
+        const uint64 endField   = ( bitOffset + sizeBits - 1 ) >> 6; // div 64, field holding the last bit
         const uint64 fieldCount = ( endField - startField ) + 1;
 
         bytesBE += startField * sizeof( uint64 );
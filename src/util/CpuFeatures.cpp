@@ -0,0 +1,104 @@
+#include "CpuFeatures.h"
+
+#if BB_CPU_IS_X86 && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+    enum CpuFeature : uint32
+    {
+        CPU_AVX2     = 1 << 0,
+        CPU_AVX512F  = 1 << 1,
+        CPU_AVX512VL = 1 << 2,
+    };
+
+#if BB_CPU_IS_X86
+    //-----------------------------------------------------------
+    void CpuId( uint32 out[4], const uint32 id, const uint32 sid )
+    {
+    #if defined(_MSC_VER)
+        __cpuidex( (int*)out, (int)id, (int)sid );
+    #else
+        __asm__ __volatile__( "cpuid\n"
+                              : "=a"(out[0]), "=b"(out[1]), "=c"(out[2]), "=d"(out[3])
+                              : "a"(id), "c"(sid) );
+    #endif
+    }
+
+    //-----------------------------------------------------------
+    uint64 XGetBV()
+    {
+    #if defined(_MSC_VER)
+        return _xgetbv( 0 );
+    #else
+        uint32 eax = 0, edx = 0;
+        __asm__ __volatile__( "xgetbv\n" : "=a"(eax), "=d"(edx) : "c"(0) );
+        return ( (uint64)edx << 32 ) | eax;
+    #endif
+    }
+#endif
+
+    //-----------------------------------------------------------
+    uint32 DetectFeatures()
+    {
+        uint32 features = 0;
+
+    #if BB_CPU_IS_X86
+        uint32 regs[4] = { 0 };
+
+        CpuId( regs, 0, 0 );
+        const uint32 maxId = regs[0];
+
+        CpuId( regs, 1, 0 );
+        if( ( regs[2] & ( 1u << 27 ) ) && maxId >= 7 )    // OSXSAVE
+        {
+            const uint64 mask = XGetBV();
+
+            if( ( mask & 6 ) == 6 )                         // SSE and AVX states
+            {
+                CpuId( regs, 7, 0 );
+
+                if( regs[1] & ( 1u << 5 ) )
+                    features |= CPU_AVX2;
+
+                if( ( mask & 224 ) == 224 )                 // Opmask, ZMM_Hi256, Hi16_Zmm
+                {
+                    if( regs[1] & ( 1u << 16 ) )
+                        features |= CPU_AVX512F;
+
+                    if( regs[1] & ( 1u << 31 ) )
+                        features |= CPU_AVX512VL;
+                }
+            }
+        }
+    #endif
+
+        return features;
+    }
+
+    //-----------------------------------------------------------
+    uint32 GetFeatures()
+    {
+        static const uint32 features = DetectFeatures();
+        return features;
+    }
+}
+
+//-----------------------------------------------------------
+bool CpuSupportsAVX2()
+{
+    return ( GetFeatures() & CPU_AVX2 ) != 0;
+}
+
+//-----------------------------------------------------------
+bool CpuSupportsAVX512F()
+{
+    return ( GetFeatures() & CPU_AVX512F ) != 0;
+}
+
+//-----------------------------------------------------------
+bool CpuSupportsAVX512VL()
+{
+    return ( GetFeatures() & CPU_AVX512VL ) != 0;
+}
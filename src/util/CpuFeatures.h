@@ -0,0 +1,24 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define BB_CPU_IS_X86 1
+#endif
+
+#if !defined(__cplusplus)
+    #include <stdbool.h>
+#endif
+
+// Instruction set extensions supported by the CPU and enabled by the OS, detected once at runtime.
+// Used to select the SIMD kernels which are compiled for instruction sets beyond the build's baseline.
+// Also callable from the C kernels' dispatchers.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool CpuSupportsAVX2();
+bool CpuSupportsAVX512F();
+bool CpuSupportsAVX512VL();
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,10 @@ FILE* Log::_errStream = nullptr;
 
 bool Log::_verbose = false;
 
+thread_local const char* Log::_threadPrefix = nullptr;
+thread_local bool        Log::_outMidLine   = false;
+thread_local bool        Log::_errMidLine   = false;
+
 // #if DBG_LOG_ENABLE
     std::atomic<int> _dbglock = 0;
 // #endif
@@ -74,6 +78,12 @@ void Log::Line( const char* msg, ... )
 //-----------------------------------------------------------
 void Log::Write( const char* msg, va_list args )
 {
+    if( _threadPrefix )
+    {
+        WritePrefixed( GetOutStream(), _outMidLine, false, msg, args );
+        return;
+    }
+
     vfprintf( GetOutStream(), msg, args );
 
 #if _DEBUG && defined( _WIN32 )
@@ -84,6 +94,12 @@ void Log::Write( const char* msg, va_list args )
 //-----------------------------------------------------------
 void Log::WriteLine( const char* msg, va_list args )
 {
+    if( _threadPrefix )
+    {
+        WritePrefixed( GetOutStream(), _outMidLine, true, msg, args );
+        return;
+    }
+
     FILE* stream = GetOutStream();
     vfprintf( stream, msg, args );
     fputc( '\n', stream );
@@ -114,6 +130,12 @@ void Log::WriteError( const char* msg, ... )
 //-----------------------------------------------------------
 void Log::Error( const char* msg, va_list args )
 {
+    if( _threadPrefix )
+    {
+        WritePrefixed( GetErrStream(), _errMidLine, true, msg, args );
+        return;
+    }
+
     WriteError( msg, args );
     fputc( '\n', GetErrStream() );
 }
@@ -121,6 +143,12 @@ void Log::Error( const char* msg, va_list args )
 //-----------------------------------------------------------
 void Log::WriteError( const char* msg, va_list args )
 {
+    if( _threadPrefix )
+    {
+        WritePrefixed( GetErrStream(), _errMidLine, false, msg, args );
+        return;
+    }
+
     vfprintf( GetErrStream(), msg, args );
     
 #if _DEBUG && defined( _WIN32 )
@@ -128,6 +156,30 @@ void Log::WriteError( const char* msg, va_list args )
 #endif
 }
 
+// Lines are written with a single call, so that the ones from other prefixed threads don't cut into them
+//-----------------------------------------------------------
+void Log::WritePrefixed( FILE* stream, bool& midLine, const bool newLine, const char* msg, va_list args )
+{
+    const int BUF_SIZE = 1024;
+    char buffer[BUF_SIZE];
+
+    int length = 0;
+    if( !midLine )
+        length = std::min( snprintf( buffer, BUF_SIZE, "%s", _threadPrefix ), BUF_SIZE-2 );
+
+    const int count = vsnprintf( buffer + length, (size_t)( BUF_SIZE - 1 - length ), msg, args );
+    length = std::min( length + std::max( count, 0 ), BUF_SIZE-2 );
+
+    if( newLine )
+        buffer[length++] = '\n';
+
+    if( length < 1 )
+        return;
+
+    midLine = buffer[length-1] != '\n';
+    fwrite( buffer, 1, (size_t)length, stream );
+}
+
 //-----------------------------------------------------------
 void Log::Verbose( const char* msg, ...  )
 {
@@ -18,6 +18,10 @@ public:
     static void WriteError( const char* msg, va_list args );
 
     inline static void SetVerbose( bool enabled ) { _verbose = enabled; }
+
+    // Prefix the lines logged by the calling thread, ie. to tell apart concurrent plots. nullptr clears it.
+    // The prefix string must outlive its use.
+    inline static void SetThreadPrefix( const char* prefix ) { _threadPrefix = prefix; }
     
     static void Verbose( const char* msg, ...  );
     static void VerboseWrite( const char* msg, ...  );
@@ -44,7 +48,13 @@ private:
     static FILE* GetOutStream();
     static FILE* GetErrStream();
 
+    static void WritePrefixed( FILE* stream, bool& midLine, bool newLine, const char* msg, va_list args );
+
 private:
     static FILE* _outStream;
     static FILE* _errStream;
+
+    static thread_local const char* _threadPrefix;
+    static thread_local bool        _outMidLine;    // The thread's last output did not end a line, so it gets no prefix
+    static thread_local bool        _errMidLine;
 };
\ No newline at end of file
@@ -304,7 +304,7 @@ inline void* bb_try_virt_alloc_bounded( size_t size )
     const size_t pageSize = SysHost::GetPageSize();
     size = RoundUpToNextBoundaryT<size_t>( size, pageSize ) + pageSize * 2;
 
-    auto* ptr = (byte*)bb_try_virt_alloc( size );
+    auto* ptr = (byte*)SysHost::VirtualAlloc( size, false, false );
     if( !ptr )
         return nullptr;
 
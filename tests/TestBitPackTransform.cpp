@@ -0,0 +1,101 @@
+#include "TestUtil.h"
+#include "io/BitPackTransform.h"
+#include <random>
+
+// Entry counts which don't fill the last packed field, so that entries straddle field boundaries
+static const uint32 bpEntryCounts[] = { 2, 3, 63, 1001, 4097 };
+
+static size_t RoundTrip( const std::vector<uint32>& entries, size_t dataSize );
+
+//-----------------------------------------------------------
+TEST_CASE( "bit-pack-transform", "[unit-core]" )
+{
+    std::mt19937 rng( GetEnvU32( "bb_bitpack_seed", 0xB17 ) );
+
+    for( const uint32 count : bpEntryCounts )
+    {
+        std::vector<uint32> entries( count );
+
+        // Values of every width, the widest one setting the top bit
+        for( uint32 bits = 0; bits <= 32; bits++ )
+        {
+            const uint32 mask = bits ? 0xFFFFFFFFu >> ( 32 - bits ) : 0;
+
+            for( uint32& e : entries )
+                e = (uint32)rng() & mask;
+            entries[rng() % count] = mask;
+
+            const size_t encodedSize = RoundTrip( entries, count * sizeof( uint32 ) );
+
+            // Packing must pay off for the header and the rounding to whole fields
+            if( bits <= 16 && count >= 63 )
+                ENSURE( encodedSize > 0 );
+            if( bits == 32 )
+                ENSURE( encodedSize == 0 );
+        }
+
+        // Increasing values, packed as the deltas between them
+        for( uint32 gapBits = 0; gapBits < 24; gapBits++ )
+        {
+            uint32 value = (uint32)rng();
+            for( uint32& e : entries )
+            {
+                e      = value;
+                value += gapBits ? (uint32)rng() >> ( 32 - gapBits ) : 0;
+            }
+
+            const size_t encodedSize = RoundTrip( entries, count * sizeof( uint32 ) );
+            if( gapBits <= 16 && count >= 63 )
+                ENSURE( encodedSize > 0 );
+        }
+
+        // Zero bits per entry: All the same value, zero or not
+        for( const uint32 value : { 0u, 0xDEADBEEFu } )
+        {
+            std::fill( entries.begin(), entries.end(), value );
+            const size_t encodedSize = RoundTrip( entries, count * sizeof( uint32 ) );
+
+            if( count >= 63 )
+                ENSURE( encodedSize > 0 );
+        }
+
+        // Padding past the data, which is stored raw, including a partial entry
+        for( const size_t paddingSize : { (size_t)1, (size_t)13, (size_t)64 } )
+        {
+            if( paddingSize >= count * sizeof( uint32 ) )
+                continue;
+
+            for( uint32& e : entries )
+                e = (uint32)rng() & 0xFFFFF;
+
+            RoundTrip( entries, count * sizeof( uint32 ) - paddingSize );
+        }
+    }
+}
+
+// Encodes and decodes the entries and ensures they match. Returns the encoded size, 0 if stored raw.
+//-----------------------------------------------------------
+size_t RoundTrip( const std::vector<uint32>& entries, const size_t dataSize )
+{
+    const size_t size = entries.size() * sizeof( uint32 );
+
+    // Encoded data is read back padded to the block size
+    const size_t paddedSize = RoundUpToNextBoundaryT<size_t>( size, 4096 );
+
+    std::vector<uint64> encoded( paddedSize / sizeof( uint64 ), 0xCDCDCDCDCDCDCDCDull );
+    std::vector<uint32> decoded( entries.size() + 1, 0xCDCDCDCD );
+
+    BitPackTransform transform;
+    const size_t encodedSize = transform.Encode( entries.data(), size, dataSize, encoded.data() );
+
+    ENSURE( encodedSize < size );
+    if( encodedSize == 0 )
+        return 0;
+
+    transform.Decode( encoded.data(), paddedSize, decoded.data(), size );
+
+    ENSURE( memcmp( decoded.data(), entries.data(), size ) == 0 );
+    ENSURE( decoded.back() == 0xCDCDCDCD );     // Nothing written past the size
+
+    return encodedSize;
+}
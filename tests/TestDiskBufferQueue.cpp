@@ -0,0 +1,433 @@
+#include "TestUtil.h"
+#include "plotdisk/DiskBufferQueue.h"
+#include "io/BitPackTransform.h"
+#include "threading/Fence.h"
+#include "threading/Thread.h"
+#include "util/VirtualAllocator.h"
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+constexpr uint32 dbqBucketCount = 16;
+constexpr size_t dbqHeapSize    = 64 MiB;
+
+static const struct { FileSetOptions options; bool interleaved; } dbqCases[] = {
+    { FileSetOptions::Interleaved                             , true  },
+    { FileSetOptions::Interleaved | FileSetOptions::DirectIO  , true  },
+    { FileSetOptions::Alternating                             , false },
+    { FileSetOptions::Alternating | FileSetOptions::DirectIO  , true  },
+};
+
+// The queue's dispatch thread can't be stopped, so queues are never deleted
+static DiskBufferQueue* CreateQueue( const std::vector<std::string>& dirs1, const std::vector<std::string>& dirs2, uint32 ioDepth, byte** outHeap = nullptr,
+                                     size_t coalesceBufferSize = DiskBufferQueue::DefaultCoalesceBufferSize );
+static std::vector<std::string> CreateDirs( const char* name, uint32 count );
+static void Sync( DiskBufferQueue& queue );
+static uint32 CountBucketFiles( const std::vector<std::string>& dirs, const char* name, uint32 bucket );
+static std::vector<uint32> WriteAndReadBuckets( FileSetOptions options, bool interleaved, uint32 ioDepth, uint32 seed, IIOTransform* transform = nullptr );
+
+//-----------------------------------------------------------
+TEST_CASE( "disk-buffer-queue-transform", "[disk-queue]" )
+{
+    BitPackTransform transform;
+
+    uint32 seed = GetEnvU32( "bb_queue_seed", 7 );
+
+    // Bit-packed buckets (--compress-t2) must read back the same as plain ones
+    for( auto& c : dbqCases )
+    {
+        const std::vector<uint32> plain   = WriteAndReadBuckets( c.options, c.interleaved, 0 , seed );
+        const std::vector<uint32> packed  = WriteAndReadBuckets( c.options, c.interleaved, 0 , seed, &transform );
+        const std::vector<uint32> batched = WriteAndReadBuckets( c.options, c.interleaved, 64, seed, &transform );
+
+        ENSURE( !plain.empty() );
+        ENSURE( plain == packed );
+        ENSURE( plain == batched );
+        seed++;
+    }
+}
+
+//-----------------------------------------------------------
+TEST_CASE( "disk-buffer-queue-io-depth", "[disk-queue]" )
+{
+    uint32 seed = GetEnvU32( "bb_queue_seed", 7 );
+
+    // Blocking I/O and batched io_uring I/O must read back the same bytes
+    for( auto& c : dbqCases )
+    {
+        const std::vector<uint32> blocking = WriteAndReadBuckets( c.options, c.interleaved, 0 , seed );
+        const std::vector<uint32> batched  = WriteAndReadBuckets( c.options, c.interleaved, 64, seed );
+
+        ENSURE( !blocking.empty() );
+        ENSURE( blocking == batched );
+        seed++;
+    }
+}
+
+// Map chunks are not block-aligned. On file systems with large blocks they are staged and written in whole extents,
+// which must produce the same files as aligned writes of the same data.
+//-----------------------------------------------------------
+TEST_CASE( "disk-buffer-queue-coalesce", "[disk-queue]" )
+{
+    constexpr size_t blockSize    = 64 KiB;
+    constexpr size_t maxChunkSize = 160 KiB;
+    constexpr uint32 roundCount   = 16;
+
+    // Pretend the temp directory has RAID-sized blocks
+    FileStream::TestBlockSize = blockSize;
+
+    const std::vector<std::string> dirs = CreateDirs( "coalesce", 1 );
+
+    // The smallest arena (2 extents), so that extents are evicted while staging partial blocks,
+    // which are then read back when their file is written to again
+    DiskBufferQueue& queue = *CreateQueue( dirs, {}, 0, nullptr, 0 );
+
+    struct { FileId id; const char* name; FileSetOptions options; } sets[] = {
+        { FileId::MAP2, "map2", FileSetOptions::BlockAlign },
+        { FileId::MAP3, "map3", FileSetOptions::BlockAlign | FileSetOptions::DirectIO },
+    };
+
+    std::mt19937_64 rng( GetEnvU32( "bb_queue_seed", 7 ) );
+
+    for( auto& set : sets )
+    {
+        ENSURE( queue.InitFileSet( set.id, set.name, dbqBucketCount, set.options, nullptr ) );
+        ENSURE( queue.BlockSize( set.id ) == blockSize );
+        ENSURE( DiskBufferQueue::GetWriteAlignment( blockSize, set.options ) == sizeof( uint64 ) );
+
+        // Chunks of whole entries, as map writes are
+        std::vector<uint32> chunkSizes[dbqBucketCount];
+        std::vector<byte>   expected  [dbqBucketCount];
+
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+        {
+            size_t total = 0;
+            for( uint32 r = 0; r < roundCount; r++ )
+            {
+                chunkSizes[b].push_back( (uint32)( 1 + rng() % ( maxChunkSize / sizeof( uint64 ) ) ) * sizeof( uint64 ) );
+                total += chunkSizes[b].back();
+            }
+
+            expected[b].resize( RoundUpToNextBoundaryT( total, blockSize ) );
+            for( size_t i = 0; i < total; i++ )
+                expected[b][i] = (byte)rng();
+        }
+
+        // Alternate between the buckets, so that extents are shared
+        size_t offsets[dbqBucketCount] = {};
+        for( uint32 r = 0; r < roundCount; r++ )
+        {
+            for( uint32 b = 0; b < dbqBucketCount; b++ )
+            {
+                queue.WriteFile( set.id, b, expected[b].data() + offsets[b], chunkSizes[b][r] );
+                offsets[b] += chunkSizes[b][r];
+            }
+            queue.CommitCommands();
+        }
+
+        // Seeking flushes the staged writes
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+            queue.SeekFile( set.id, b, 0, SeekOrigin::Begin );
+        Sync( queue );
+
+        // The files hold the chunks back to back, the last block padded with zeros
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+        {
+            const std::string path = dirs[0] + "test_" + set.name + "_" + std::to_string( b ) + ".tmp";
+            ENSURE( std::filesystem::file_size( path ) == expected[b].size() );
+
+            FileStream file;
+            ENSURE( file.Open( path.c_str(), FileMode::Open, FileAccess::Read ) );
+
+            std::vector<byte> actual( expected[b].size() );
+            ENSURE( file.Read( actual.data(), actual.size() ) == (ssize_t)actual.size() );
+            ENSURE( memcmp( actual.data(), expected[b].data(), actual.size() ) == 0 );
+        }
+    }
+
+    FileStream::TestBlockSize = 0;
+}
+
+//-----------------------------------------------------------
+TEST_CASE( "disk-buffer-queue-work-dirs", "[disk-queue]" )
+{
+    const std::vector<std::string> dirs1 = CreateDirs( "t1", 3 );
+    const std::vector<std::string> dirs2 = CreateDirs( "t2", 2 );
+
+    DiskBufferQueue& queue = *CreateQueue( dirs1, dirs2, 0 );
+
+    struct { FileId id; const char* name; FileSetOptions options; const std::vector<std::string>& dirs; } sets[] = {
+        { FileId::FX0   , "fx"   , FileSetOptions::None    , dirs1 },
+        { FileId::INDEX0, "index", FileSetOptions::UseTemp2, dirs2 },
+    };
+
+    for( auto& set : sets )
+    {
+        ENSURE( queue.InitFileSet( set.id, set.name, dbqBucketCount, set.options, nullptr ) );
+
+        // Each bucket file goes into exactly one directory, and all of the directories are used
+        std::vector<uint32> filesPerDir( set.dirs.size() );
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+        {
+            ENSURE( CountBucketFiles( set.dirs, set.name, b ) == 1 );
+
+            for( size_t d = 0; d < set.dirs.size(); d++ )
+                filesPerDir[d] += CountBucketFiles( { set.dirs[d] }, set.name, b );
+        }
+
+        for( const uint32 count : filesPerDir )
+            ENSURE( count > 0 );
+    }
+
+    // Deleting single files or whole sets must find each file where it was created
+    for( uint32 b = 0; b < dbqBucketCount; b++ )
+        queue.DeleteFile( FileId::FX0, b );
+
+    queue.DeleteBucket( FileId::INDEX0 );
+    Sync( queue );
+
+    // The files are deleted on another thread
+    auto anyFileLeft = [&]() {
+        for( auto& set : sets )
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+            if( CountBucketFiles( set.dirs, set.name, b ) )
+                return true;
+        return false;
+    };
+
+    for( uint32 i = 0; i < 500 && anyFileLeft(); i++ )
+        Thread::Sleep( 10 );
+
+    ENSURE( !anyFileLeft() );
+}
+
+// Aggregate write bandwidth of interleaved bucket writes, which go to a single file each, over 1 to N temp directories.
+// Set bb_queue_bw_dirs to a comma-separated list of directories on different drives to measure them.
+//-----------------------------------------------------------
+TEST_CASE( "disk-buffer-queue-dir-bandwidth", "[disk-queue]" )
+{
+    constexpr size_t sliceSize = 256 KiB;
+    constexpr size_t writeSize   = sliceSize * dbqBucketCount;
+    constexpr uint32 bufferCount = 4;
+
+    const uint32 totalSize = GetEnvU32( "bb_queue_bw_mib", 128 );
+
+    std::vector<std::string> dirs;
+    for( std::stringstream list( GetEnv( "bb_queue_bw_dirs", "" ) ); list.good(); )
+    {
+        std::string dir;
+        std::getline( list, dir, ',' );
+
+        if( !dir.empty() )
+            dirs.push_back( dir + "/" );
+    }
+
+    if( dirs.empty() )
+        dirs = CreateDirs( "bandwidth", 4 );
+
+    for( size_t dirCount = 1; dirCount <= dirs.size(); dirCount++ )
+    {
+        const std::vector<std::string> runDirs( dirs.begin(), dirs.begin() + (ptrdiff_t)dirCount );
+
+        byte* heap = nullptr;
+        DiskBufferQueue& queue = *CreateQueue( runDirs, {}, 64, &heap );
+
+        const std::string name = "bw" + std::to_string( dirCount );
+        ENSURE( queue.InitFileSet( FileId::FX0, name.c_str(), dbqBucketCount, FileSetOptions::Interleaved | FileSetOptions::DirectIO, nullptr ) );
+
+        uint32 counts[dbqBucketCount];
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+            counts[b] = (uint32)( sliceSize / sizeof( uint32 ) );
+
+        memset( heap, 0xA5, writeSize * bufferCount );
+
+        // Like the plotter's heap buffers, a buffer is written to again once its previous write signalled
+        const uint32 writeCount = (uint32)( (size_t)totalSize MiB / writeSize );
+        Fence fence;
+
+        const auto timer = TimerBegin();
+
+        for( uint32 i = 0; i < writeCount; i++ )
+        {
+            if( i >= bufferCount )
+                fence.Wait( i - bufferCount + 1 );
+
+            queue.WriteBucketElementsT<uint32>( FileId::FX0, true, (uint32*)( heap + i % bufferCount * writeSize ), counts, counts );
+            queue.SignalFence( fence, i + 1 );
+            queue.CommitCommands();
+        }
+
+        fence.Wait( writeCount );
+        const double elapsed = TimerEnd( timer );
+
+        Log::Line( "%llu temp dir(s): Wrote %.2lf MiB in %.2lf seconds: %.2lf MiB/s.", (llu)dirCount,
+            (double)writeCount * writeSize BtoMB, elapsed, (double)writeCount * writeSize BtoMB / elapsed );
+
+        // Every bucket file got its share
+        size_t sizeWritten = 0;
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+        {
+            ENSURE( CountBucketFiles( runDirs, name.c_str(), b ) == 1 );
+
+            for( auto& dir : runDirs )
+            {
+                const std::string path = dir + "test_" + name + "_" + std::to_string( b ) + ".tmp";
+                if( std::filesystem::exists( path ) )
+                    sizeWritten += std::filesystem::file_size( path );
+            }
+        }
+
+        ENSURE( sizeWritten == writeCount * writeSize );
+
+        queue.DeleteBucket( FileId::FX0 );
+        Sync( queue );
+    }
+}
+
+//-----------------------------------------------------------
+DiskBufferQueue* CreateQueue( const std::vector<std::string>& dirs1, const std::vector<std::string>& dirs2, const uint32 ioDepth, byte** outHeap,
+                              const size_t coalesceBufferSize )
+{
+    std::vector<const char*> paths1, paths2;
+    for( auto& dir : dirs1 ) paths1.push_back( dir.c_str() );
+    for( auto& dir : dirs2 ) paths2.push_back( dir.c_str() );
+
+    byte* heap = bbvirtalloc<byte>( dbqHeapSize );
+    if( outHeap )
+        *outHeap = heap;
+
+    return new DiskBufferQueue( Span<const char*>( paths1.data(), paths1.size() ), Span<const char*>( paths2.data(), paths2.size() ),
+                                dirs1[0].c_str(), heap, dbqHeapSize, 1, -1, ioDepth, "test_", coalesceBufferSize );
+}
+
+//-----------------------------------------------------------
+std::vector<std::string> CreateDirs( const char* name, const uint32 count )
+{
+    const std::string root = std::string( GetEnv( "bb_queue_path", "/tmp/bb-queue-test" ) ) + "/" + name;
+
+    std::filesystem::remove_all( root );
+
+    std::vector<std::string> dirs;
+    for( uint32 i = 0; i < count; i++ )
+    {
+        dirs.push_back( root + "/" + std::to_string( i ) + "/" );
+        std::filesystem::create_directories( dirs.back() );
+    }
+
+    return dirs;
+}
+
+//-----------------------------------------------------------
+void Sync( DiskBufferQueue& queue )
+{
+    Fence fence;
+    queue.SignalFence( fence );
+    queue.CommitCommands();
+    fence.Wait();
+}
+
+//-----------------------------------------------------------
+uint32 CountBucketFiles( const std::vector<std::string>& dirs, const char* name, const uint32 bucket )
+{
+    const std::string fileName = std::string( "test_" ) + name + "_" + std::to_string( bucket ) + ".tmp";
+
+    uint32 count = 0;
+    for( auto& dir : dirs )
+        count += std::filesystem::exists( dir + fileName ) ? 1 : 0;
+
+    return count;
+}
+
+// Writes random bucket slices over 2 work dirs and returns everything read back, bucket by bucket.
+// The buffers are in the queue's heap, so they are registered with io_uring.
+//-----------------------------------------------------------
+std::vector<uint32> WriteAndReadBuckets( const FileSetOptions options, const bool interleaved, const uint32 ioDepth, const uint32 seed, IIOTransform* transform )
+{
+    constexpr uint32 entriesPerBlock = 4096 / sizeof( uint32 );
+    constexpr size_t maxSliceSize    = 8 * 4096;
+    constexpr size_t readOffset      = 32 MiB;
+
+    const std::string name = "depth" + std::to_string( ioDepth );
+    const std::vector<std::string> dirs = CreateDirs( name.c_str(), 2 );
+
+    byte* heap = nullptr;
+    DiskBufferQueue& queue = *CreateQueue( dirs, {}, ioDepth, &heap );
+    Log::Line( "I/O queue depth: %u", queue.IOQueueDepth() );
+
+    FileSetInitData data = {};
+    data.maxSliceSize = maxSliceSize;
+    ENSURE( queue.InitFileSet( FileId::FX0, "fx", dbqBucketCount, options, &data ) );
+
+    // Alternating file sets read back from a fixed offset per slice, so the files must already have that size
+    memset( heap, 0, maxSliceSize * ( dbqBucketCount + 2 ) );
+    for( uint32 b = 0; b < dbqBucketCount; b++ )
+        queue.WriteFile( FileId::FX0, b, heap, maxSliceSize * ( dbqBucketCount + 2 ) );
+    queue.SeekBucket( FileId::FX0, 0, SeekOrigin::Begin );
+    Sync( queue );
+
+    // Whole files can't be written through transforms
+    if( transform )
+        queue.SetTransform( FileId::FX0, *transform );
+
+    // Odd slice sizes. Like the plotter does, each slice starts with the partial last block
+    // of the previous slice of the same bucket, and its write is padded to the block size.
+    std::mt19937 rng( seed );
+    uint32* writeBuffer = (uint32*)heap;
+    uint32  carry[dbqBucketCount] = {};
+
+    std::vector<uint32> expected[dbqBucketCount];
+
+    for( uint32 r = 0; r < dbqBucketCount; r++ )
+    {
+        uint32 writeCounts[dbqBucketCount];
+        uint32 sliceCounts[dbqBucketCount];
+        uint32 sliceStarts[dbqBucketCount];
+        uint32 total = 0;
+
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+        {
+            sliceStarts[b] = total + carry[b];
+            sliceCounts[b] = rng() % 5 == 0 ? 0 : rng() % ( 7 * entriesPerBlock );
+            writeCounts[b] = RoundUpToNextBoundaryT( carry[b] + sliceCounts[b], entriesPerBlock );
+            carry[b]       = ( carry[b] + sliceCounts[b] ) % entriesPerBlock;
+            total += writeCounts[b];
+        }
+
+        // Narrower entries get bit-packed by transforms, constant ones down to 0 bits
+        const uint32 shift = r % 4 * 6;
+        const uint32 fill  = (uint32)rng();
+
+        for( uint32 i = 0; i < total; i++ )
+            writeBuffer[i] = r % 8 == 7 ? fill : (uint32)rng() >> shift;
+
+        // The carried over part was already read with the previous slice
+        for( uint32 b = 0; b < dbqBucketCount; b++ )
+            expected[b].insert( expected[b].end(), writeBuffer + sliceStarts[b], writeBuffer + sliceStarts[b] + sliceCounts[b] );
+
+        queue.WriteBucketElementsT<uint32>( FileId::FX0, interleaved, writeBuffer, writeCounts, sliceCounts );
+        Sync( queue );
+    }
+
+    if( !IsFlagSet( options, FileSetOptions::Alternating ) )
+        queue.SeekBucket( FileId::FX0, 0, SeekOrigin::Begin );
+
+    std::vector<uint32> entries;
+    uint32* readBuffer = (uint32*)( heap + readOffset );
+
+    for( uint32 b = 0; b < dbqBucketCount; b++ )
+    {
+        Span<uint32> bucket( readBuffer, ( dbqHeapSize - readOffset ) / sizeof( uint32 ) );
+        queue.ReadBucketElementsT( FileId::FX0, interleaved, bucket );
+        Sync( queue );
+
+        ENSURE( bucket.Length() == expected[b].size() );
+        ENSURE( memcmp( bucket.Ptr(), expected[b].data(), expected[b].size() * sizeof( uint32 ) ) == 0 );
+
+        entries.insert( entries.end(), bucket.Ptr(), bucket.Ptr() + bucket.Length() );
+    }
+
+    if( transform )
+        ENSURE( queue.TransformedStoredSize() < queue.TransformedWriteSize() );
+
+    return entries;
+}
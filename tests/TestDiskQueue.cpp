@@ -8,18 +8,40 @@ constexpr uint32 bucketCount      = 64;
 constexpr uint32 entriesPerBucket = 1 << 16;
 constexpr uint32 entriesPerSlice  = entriesPerBucket / bucketCount;
 
+// Blocking I/O and io_uring must read back the same data
+static const uint32 ioQueueDepths[] = { 0, 64 };
+
 static void WriteBucketSlices( DiskBucketBuffer* buf, uint32 bucket, uint32 mask, Span<size_t> sliceSizes );
+static void TestDiskSlices( const char* tempPath, uint32 ioQueueDepth );
+static void TestDiskBuckets( const char* tempPath, uint32 ioQueueDepth );
 
 //-----------------------------------------------------------
 TEST_CASE( "disk-slices", "[disk-queue]" )
 {
     const char* tempPath = GetEnv( "bb_queue_path", "/Users/harito/.sandbox/plot" );
 
-    DiskQueue queue( tempPath );
+    for( const uint32 ioQueueDepth : ioQueueDepths )
+        TestDiskSlices( tempPath, ioQueueDepth );
+}
+
+//-----------------------------------------------------------
+TEST_CASE( "disk-buckets", "[disk-queue]" )
+{
+    const char* tempPath = GetEnv( "bb_queue_path", "/Users/harito/.sandbox/plot" );
+
+    for( const uint32 ioQueueDepth : ioQueueDepths )
+        TestDiskBuckets( tempPath, ioQueueDepth );
+}
+
+//-----------------------------------------------------------
+void TestDiskSlices( const char* tempPath, const uint32 ioQueueDepth )
+{
+    DiskQueue queue( tempPath, ioQueueDepth );
+    Log::Line( "I/O queue depth: %u", queue.IOQueueDepth() );
 
     auto buf = std::unique_ptr<DiskBucketBuffer>( DiskBucketBuffer::Create( 
         queue, "slices.tmp", bucketCount, sizeof( uint32 ) * entriesPerSlice,
-        FileMode::Create, FileAccess::ReadWrite ) );
+        FileMode::Create, FileAccess::ReadWrite, FileFlags::LargeFile | FileFlags::NoBuffering ) );
 
     ENSURE( buf.get() );
 
@@ -96,15 +118,15 @@ TEST_CASE( "disk-slices", "[disk-queue]" )
 }
 
 //-----------------------------------------------------------
-TEST_CASE( "disk-buckets", "[disk-queue]" )
+void TestDiskBuckets( const char* tempPath, const uint32 ioQueueDepth )
 {
-    const char* tempPath = GetEnv( "bb_queue_path", "/Users/harito/.sandbox/plot" );
-    DiskQueue queue( tempPath );
+    DiskQueue queue( tempPath, ioQueueDepth );
+    Log::Line( "I/O queue depth: %u", queue.IOQueueDepth() );
 
     auto buffer = std::unique_ptr<DiskBuffer>( DiskBuffer::Create( 
         queue, "bucket.tmp",
         bucketCount, sizeof( uint32 ) * entriesPerBucket,
-        FileMode::Create, FileAccess::ReadWrite ) );
+        FileMode::Create, FileAccess::ReadWrite, FileFlags::LargeFile | FileFlags::NoBuffering ) );
 
     ENSURE( buffer );
     {
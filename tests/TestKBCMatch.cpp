@@ -0,0 +1,110 @@
+#include "TestUtil.h"
+#include "plotting/matching/KBCMatch.h"
+#include "ChiaConsts.h"
+#include <random>
+#include <algorithm>
+
+// Sorted y values with the same density as a table: 1 entry per 2^kExtraBits values
+constexpr uint64 kbcEntryCount = 1ull << 18;
+constexpr uint64 kbcMaxPairs   = kbcEntryCount * 2;
+
+using MatchKBCGroupsFunc = uint64(*)( KBCRMap&, const uint64*, uint64, uint64, uint64, uint64, uint64, Pair*, uint64, uint32, bool* );
+
+static uint64 MatchAllGroups( KBCRMap& rMap, const std::vector<uint64>& yBuffer, const std::vector<uint32>& groupBoundaries,
+                              Pair* pairs, uint64 maxPairs, uint32 pairOffset, MatchKBCGroupsFunc match, bool& outOverflowed );
+
+//-----------------------------------------------------------
+TEST_CASE( "kbc-match-simd", "[unit-core]" )
+{
+    #if BB_CPU_IS_X86
+    if( !CpuSupportsAVX2() )
+    {
+        Log::Line( "Skipping: AVX2 is not supported by this CPU." );
+        return;
+    }
+
+    LoadLTargets();
+
+    std::mt19937_64 rng( GetEnvU32( "bb_kbc_seed", 0xB1ADE ) );
+
+    std::vector<uint64> yBuffer( kbcEntryCount );
+    for( uint64 i = 0; i < kbcEntryCount; i++ )
+        yBuffer[i] = rng() % ( kbcEntryCount << kExtraBits );
+
+    std::sort( yBuffer.begin(), yBuffer.end() );
+
+    std::vector<uint32> groupBoundaries;
+    groupBoundaries.push_back( 0 );
+
+    for( uint64 i = 1; i < kbcEntryCount; i++ )
+        if( yBuffer[i] / kBC != yBuffer[i-1] / kBC )
+            groupBoundaries.push_back( (uint32)i );
+
+    groupBoundaries.push_back( (uint32)kbcEntryCount );
+
+    auto rMap = std::make_unique<KBCRMap>();
+    rMap->Clear();
+
+    std::vector<Pair> scalarPairs( kbcMaxPairs );
+    std::vector<Pair> simdPairs  ( kbcMaxPairs );
+
+    const uint32 pairOffset = 12345;
+
+    bool scalarOverflowed = true, simdOverflowed = true;
+    const uint64 scalarCount = MatchAllGroups( *rMap, yBuffer, groupBoundaries, scalarPairs.data(), kbcMaxPairs, pairOffset, MatchKBCGroupsScalar, scalarOverflowed );
+    const uint64 simdCount   = MatchAllGroups( *rMap, yBuffer, groupBoundaries, simdPairs.data()  , kbcMaxPairs, pairOffset, MatchKBCGroupsAVX2  , simdOverflowed   );
+
+    Log::Line( "Groups: %llu | Pairs: %llu", (llu)groupBoundaries.size() - 1, (llu)scalarCount );
+
+    ENSURE( scalarCount > 0 );
+    ENSURE( simdCount == scalarCount );
+    ENSURE( !scalarOverflowed );
+    ENSURE( !simdOverflowed );
+    ENSURE( memcmp( simdPairs.data(), scalarPairs.data(), sizeof( Pair ) * scalarCount ) == 0 );
+
+    // A buffer of exactly the pair count fills up without overflowing
+    ENSURE( MatchAllGroups( *rMap, yBuffer, groupBoundaries, simdPairs.data(), scalarCount, pairOffset, MatchKBCGroupsAVX2, simdOverflowed ) == scalarCount );
+    ENSURE( !simdOverflowed );
+
+    // Output filling up part way through a group: both stop at the same pair and report the overflow
+    const uint64 truncatedMax = scalarCount / 2 + 1;
+
+    const uint64 scalarTruncated = MatchAllGroups( *rMap, yBuffer, groupBoundaries, scalarPairs.data(), truncatedMax, pairOffset, MatchKBCGroupsScalar, scalarOverflowed );
+    const uint64 simdTruncated   = MatchAllGroups( *rMap, yBuffer, groupBoundaries, simdPairs.data()  , truncatedMax, pairOffset, MatchKBCGroupsAVX2  , simdOverflowed   );
+
+    ENSURE( scalarTruncated == truncatedMax );
+    ENSURE( simdTruncated   == truncatedMax );
+    ENSURE( scalarOverflowed );
+    ENSURE( simdOverflowed );
+    ENSURE( memcmp( simdPairs.data(), scalarPairs.data(), sizeof( Pair ) * truncatedMax ) == 0 );
+
+    // The matchers must leave the R map cleared
+    for( uint32 i = 0; i < BB_KBC_RMAP_COUNT_SIZE; i++ )
+        ENSURE( rMap->counts[i] == 0 );
+    #else
+        Log::Line( "Skipping: No SIMD matcher on this platform." );
+    #endif
+}
+
+//-----------------------------------------------------------
+uint64 MatchAllGroups( KBCRMap& rMap, const std::vector<uint64>& yBuffer, const std::vector<uint32>& groupBoundaries,
+                       Pair* pairs, const uint64 maxPairs, const uint32 pairOffset, MatchKBCGroupsFunc match, bool& outOverflowed )
+{
+    uint64 pairCount = 0;
+    outOverflowed = false;
+
+    for( size_t i = 0; i + 2 < groupBoundaries.size() && !outOverflowed; i++ )
+    {
+        const uint64 groupL = yBuffer[groupBoundaries[i]]   / kBC;
+        const uint64 groupR = yBuffer[groupBoundaries[i+1]] / kBC;
+
+        if( groupR - groupL == 1 )
+        {
+            pairCount += match( rMap, yBuffer.data(), groupL, groupBoundaries[i], groupBoundaries[i+1],
+                                groupBoundaries[i+1], groupBoundaries[i+2], pairs + pairCount, maxPairs - pairCount,
+                                pairOffset, &outOverflowed );
+        }
+    }
+
+    return pairCount;
+}
@@ -0,0 +1,130 @@
+#include "TestUtil.h"
+#include "plotting/LinePointBatch.h"
+#include <random>
+
+// Odd count so that every SIMD implementation runs its tail path
+constexpr uint64 lpEntryCount = 64 * 1024 + 13;
+
+using PairsToLinePointsFunc   = void(*)( const uint32*, const Pair*, uint64, uint64* );
+using LinePointsToSquaresFunc = void(*)( const uint64*, uint64, BackPtr* );
+
+struct LinePointImpl
+{
+    const char*             name;
+    bool                    supported;
+    PairsToLinePointsFunc   toLinePoints;
+    LinePointsToSquaresFunc toSquares;
+};
+
+static void GenerateInput( std::vector<uint32>& lTable, std::vector<Pair>& pairs );
+static void ValidateImpl( const LinePointImpl& impl, const std::vector<uint32>& lTable, const std::vector<Pair>& pairs,
+                          const std::vector<uint64>& refLinePoints );
+
+//-----------------------------------------------------------
+TEST_CASE( "line-point-batch", "[unit-core]" )
+{
+    std::vector<uint32> lTable;
+    std::vector<Pair>   pairs;
+    GenerateInput( lTable, pairs );
+
+    // Reference, one entry at a time
+    std::vector<uint64> refLinePoints( pairs.size() );
+    for( size_t i = 0; i < pairs.size(); i++ )
+        refLinePoints[i] = SquareToLinePoint( lTable[pairs[i].left], lTable[pairs[i].right] );
+
+    const LinePointImpl impls[] = {
+        { "scalar", true, PairsToLinePointsScalar, LinePointsToSquaresScalar },
+    #if BB_CPU_IS_X86
+        { "avx2"  , CpuSupportsAVX2()   , PairsToLinePointsAVX2  , LinePointsToSquaresAVX2   },
+        { "avx512", CpuSupportsAVX512F(), PairsToLinePointsAVX512, LinePointsToSquaresAVX512 },
+    #endif
+        { "dispatch", true, PairsToLinePoints, LinePointsToSquares }
+    };
+
+    Log::Line( "Selected implementation: %s", GetLinePointBatchImplName() );
+
+    for( const LinePointImpl& impl : impls )
+    {
+        if( !impl.supported )
+        {
+            Log::Line( "Skipping unsupported implementation %s", impl.name );
+            continue;
+        }
+
+        Log::Line( "Validating %s", impl.name );
+        ValidateImpl( impl, lTable, pairs, refLinePoints );
+    }
+}
+
+//-----------------------------------------------------------
+void ValidateImpl( const LinePointImpl& impl, const std::vector<uint32>& lTable, const std::vector<Pair>& pairs,
+                   const std::vector<uint64>& refLinePoints )
+{
+    // Every length up to a couple of vectors, then the whole table
+    const uint64 counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, lpEntryCount };
+
+    for( const uint64 count : counts )
+    {
+        std::vector<uint64> linePoints( count + 1, 0xA5A5A5A5A5A5A5A5ull );
+        impl.toLinePoints( lTable.data(), pairs.data(), count, linePoints.data() );
+
+        for( uint64 i = 0; i < count; i++ )
+            ENSURE( linePoints[i] == refLinePoints[i] );
+
+        // Must not write past the end
+        ENSURE( linePoints[count] == 0xA5A5A5A5A5A5A5A5ull );
+
+        std::vector<BackPtr> squares( count + 1, BackPtr{ 0xA5A5A5A5A5A5A5A5ull, 0xA5A5A5A5A5A5A5A5ull } );
+        impl.toSquares( refLinePoints.data(), count, squares.data() );
+
+        for( uint64 i = 0; i < count; i++ )
+        {
+            const BackPtr ref = LinePointToSquare64( refLinePoints[i] );
+            ENSURE( squares[i].x == ref.x );
+            ENSURE( squares[i].y == ref.y );
+        }
+
+        ENSURE( squares[count].x == 0xA5A5A5A5A5A5A5A5ull );
+        ENSURE( squares[count].y == 0xA5A5A5A5A5A5A5A5ull );
+    }
+
+    // In-place conversion
+    {
+        std::vector<Pair> inPlace( pairs.begin(), pairs.end() );
+        impl.toLinePoints( lTable.data(), inPlace.data(), lpEntryCount, (uint64*)inPlace.data() );
+
+        for( uint64 i = 0; i < lpEntryCount; i++ )
+            ENSURE( ((uint64*)inPlace.data())[i] == refLinePoints[i] );
+    }
+}
+
+//-----------------------------------------------------------
+void GenerateInput( std::vector<uint32>& lTable, std::vector<Pair>& pairs )
+{
+    std::mt19937_64 rng( 0x6c696e65706f696eull );
+
+    lTable.resize( lpEntryCount );
+    for( uint64 i = 0; i < lpEntryCount; i++ )
+        lTable[i] = (uint32)rng();
+
+    // Edge values, which exercise the largest line points and the float estimate's rounding
+    lTable[0] = 0;
+    lTable[1] = 1;
+    lTable[2] = 0xFFFFFFFF;
+    lTable[3] = 0xFFFFFFFE;
+    lTable[4] = 0x80000000;
+    lTable[5] = 0x7FFFFFFF;
+
+    pairs.resize( lpEntryCount );
+    for( uint64 i = 0; i < lpEntryCount; i++ )
+    {
+        pairs[i].left  = (uint32)( rng() % lpEntryCount );
+        pairs[i].right = (uint32)( rng() % lpEntryCount );
+    }
+
+    // All combinations of the edge values at the start, so the short counts cover them.
+    // Except for 0xFFFFFFFF with itself, which encodes to GetXEnc( 2^32 ), beyond the supported range.
+    for( uint32 l = 0; l < 6; l++ )
+    for( uint32 r = 0; r < 6; r++ )
+        pairs[l * 6 + r] = ( l == 2 && r == 2 ) ? Pair{ 2, 3 } : Pair{ l, r };
+}
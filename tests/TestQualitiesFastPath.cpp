@@ -0,0 +1,259 @@
+#include "TestUtil.h"
+#include "harvesting/GreenReaper.h"
+#include "harvesting/GreenReaperInternal.h"
+#include "plotting/matching/KBCMatch.h"
+#include "plotdisk/FpFxGen.h"
+#include "plotmem/LPGen.h"
+#include "pos/chacha8.h"
+#include <random>
+#include <algorithm>
+
+// Contiguous x's searched for table 3 matches. Entries this dense give ~2^18 table 2 entries and a handful of table 3 matches.
+constexpr uint32 qfSearchXCount = 1u << 25;
+
+struct QualitiesXs { uint64 xs[4]; };
+
+static std::vector<QualitiesXs> FindTable3Matches( const byte plotId[BB_PLOT_ID_LEN], uint32 xStart );
+static GRResult FetchQualities( GreenReaperContext* cx, GRCompressedQualitiesRequest& req, bool fastPath );
+
+//-----------------------------------------------------------
+TEST_CASE( "qualities-fast-path", "[unit-core]" )
+{
+    const uint32 threadCount  = std::min( GetEnvU32( "bb_thread_count", 4 ), SysHost::GetLogicalCPUCount() );
+    const uint32 randomCount  = GetEnvU32( "bb_request_count", 16 );
+
+    LoadLTargets();
+
+    GreenReaperConfig cfg = {};
+    cfg.apiVersion  = GR_API_VERSION;
+    cfg.threadCount = threadCount;
+
+    GreenReaperContext* cx = nullptr;
+    ENSURE( grCreateContext( &cx, &cfg, sizeof( cfg ) ) == GRResult_OK );
+
+    std::mt19937_64 rng( GetEnvU32( "bb_qualities_seed", 0x9AA1 ) );
+
+    byte plotId   [BB_PLOT_ID_LEN];
+    byte challenge[32];
+    for( uint32 i = 0; i < sizeof( plotId ); i++ )
+        plotId[i] = (byte)rng();
+    for( uint32 i = 0; i < sizeof( challenge ); i++ )
+        challenge[i] = (byte)rng();
+
+    // The x's of real table 3 entries, as a compressed plot would store them in table 3's line points
+    const std::vector<QualitiesXs> matches = FindTable3Matches( plotId, (uint32)rng() & ~( qfSearchXCount - 1 ) );
+    Log::Line( "Found %llu table 3 matches.", (llu)matches.size() );
+    ENSURE( !matches.empty() );
+
+    for( uint32 cLevel = 1; cLevel <= GR_QUALITIES_FAST_PATH_MAX_LEVEL; cLevel++ )
+    {
+        const uint32 xGroupShift = 32 - ( 17 - cLevel );
+
+        auto makeRequest = [&]( const uint64 xGroups[4] ) {
+
+            const uint128 lp = SquareToLinePoint128( SquareToLinePoint( xGroups[0], xGroups[1] ),
+                                                     SquareToLinePoint( xGroups[2], xGroups[3] ) );
+            GRCompressedQualitiesRequest req = {};
+            req.plotId            = plotId;
+            req.challenge         = challenge;
+            req.compressionLevel  = cLevel;
+            req.xLinePoints[0].hi = (uint64)( lp >> 64 );
+            req.xLinePoints[0].lo = (uint64)lp;
+            return req;
+        };
+
+        grTestQualitiesFastPathHits = 0;
+        uint32 okCount = 0;
+
+        // Both paths must select the same qualities
+        for( const QualitiesXs& m : matches )
+        {
+            uint64 xGroups[4];
+            for( uint32 i = 0; i < 4; i++ )
+                xGroups[i] = m.xs[i] >> xGroupShift;
+
+            // Groups of 0 mean the proof might have been dropped, which skips the fast path
+            if( !xGroups[0] || !xGroups[1] || !xGroups[2] || !xGroups[3] )
+                continue;
+
+            GRCompressedQualitiesRequest req     = makeRequest( xGroups );
+            GRCompressedQualitiesRequest fullReq = req;
+
+            const GRResult r     = FetchQualities( cx, req    , true  );
+            const GRResult rFull = FetchQualities( cx, fullReq, false );
+
+            ENSURE( r == rFull );
+            if( r != GRResult_OK )
+                continue;
+
+            ENSURE( req.x1 == fullReq.x1 );
+            ENSURE( req.x2 == fullReq.x2 );
+
+            // And they must be 2 of the matched x's
+            const uint64* xsEnd = m.xs + 4;
+            ENSURE( std::find( m.xs, xsEnd, req.x1 ) != xsEnd );
+            ENSURE( std::find( m.xs, xsEnd, req.x2 ) != xsEnd );
+
+            okCount++;
+        }
+
+        // Random groups most likely have no table 3 match. The fast path falls back and both must fail the same way.
+        for( uint32 i = 0; i < randomCount; i++ )
+        {
+            uint64 xGroups[4];
+            for( uint32 j = 0; j < 4; j++ )
+                xGroups[j] = 1 + rng() % ( ( 1ull << ( 32 - xGroupShift ) ) - 1 );
+
+            GRCompressedQualitiesRequest req     = makeRequest( xGroups );
+            GRCompressedQualitiesRequest fullReq = req;
+
+            const GRResult r     = FetchQualities( cx, req    , true  );
+            const GRResult rFull = FetchQualities( cx, fullReq, false );
+
+            ENSURE( r == rFull );
+            if( r == GRResult_OK )
+            {
+                ENSURE( req.x1 == fullReq.x1 );
+                ENSURE( req.x2 == fullReq.x2 );
+            }
+        }
+
+        Log::Line( "C%u: %u / %llu matches with qualities, %llu from the fast path.",
+            cLevel, okCount, (llu)matches.size(), (llu)grTestQualitiesFastPathHits );
+
+        ENSURE( okCount > 0 );
+        ENSURE( grTestQualitiesFastPathHits > 0 );
+    }
+
+    grDestroyContext( cx );
+}
+
+//-----------------------------------------------------------
+GRResult FetchQualities( GreenReaperContext* cx, GRCompressedQualitiesRequest& req, const bool fastPath )
+{
+    grTestDisableQualitiesFastPath = !fastPath;
+    const GRResult r = grGetFetchQualitiesXPair( cx, &req );
+    grTestDisableQualitiesFastPath = false;
+
+    return r;
+}
+
+//-----------------------------------------------------------
+template<typename TMeta>
+static void SortByY( std::vector<uint64>& y, std::vector<TMeta>& meta )
+{
+    std::vector<uint32> order( y.size() );
+    for( uint32 i = 0; i < (uint32)order.size(); i++ )
+        order[i] = i;
+
+    std::sort( order.begin(), order.end(), [&]( const uint32 a, const uint32 b ) { return y[a] < y[b]; } );
+
+    std::vector<uint64> ySorted   ( y.size() );
+    std::vector<TMeta>  metaSorted( y.size() );
+    for( size_t i = 0; i < order.size(); i++ )
+    {
+        ySorted   [i] = y   [order[i]];
+        metaSorted[i] = meta[order[i]];
+    }
+
+    y.swap( ySorted );
+    meta.swap( metaSorted );
+}
+
+//-----------------------------------------------------------
+static std::vector<Pair> MatchSortedY( const std::vector<uint64>& y )
+{
+    auto rMap = std::make_unique<KBCRMap>();
+    rMap->Clear();
+
+    std::vector<Pair> pairs( y.size() * 2 );
+    uint64 pairCount = 0;
+
+    uint32 groupStart = 0;
+    while( groupStart < y.size() )
+    {
+        const uint64 groupL = y[groupStart] / kBC;
+
+        uint32 rStart = groupStart;
+        while( rStart < y.size() && y[rStart] / kBC == groupL )
+            rStart++;
+
+        uint32 rEnd = rStart;
+        while( rEnd < y.size() && y[rEnd] / kBC == groupL + 1 )
+            rEnd++;
+
+        if( rEnd > rStart )
+        {
+            bool overflowed = false;
+            pairCount += MatchKBCGroupsScalar( *rMap, y.data(), groupL, groupStart, rStart, rStart, rEnd,
+                                               pairs.data() + pairCount, pairs.size() - pairCount, 0, &overflowed );
+            ENSURE( !overflowed );
+        }
+
+        groupStart = rStart;
+    }
+
+    pairs.resize( pairCount );
+    return pairs;
+}
+
+// Same as plotting tables 1 to 3, but only for the x's in [xStart, xStart + qfSearchXCount)
+//-----------------------------------------------------------
+std::vector<QualitiesXs> FindTable3Matches( const byte plotId[BB_PLOT_ID_LEN], const uint32 xStart )
+{
+    const uint32 f1EntriesPerBlock = kF1BlockSize / sizeof( uint32 );
+
+    std::vector<uint64> y ( qfSearchXCount );
+    std::vector<uint32> xs( qfSearchXCount );
+    {
+        byte key[32] = { 1 };
+        memcpy( key+1, plotId, 31 );
+
+        chacha8_ctx chacha;
+        chacha8_keysetup( &chacha, key, 256, NULL );
+
+        std::vector<uint32> blocks( qfSearchXCount );
+        chacha8_get_keystream( &chacha, xStart / f1EntriesPerBlock, qfSearchXCount / f1EntriesPerBlock, (byte*)blocks.data() );
+
+        // The 38-bit y and the x's offset fit in a single sort key
+        static_assert( kExtraBits + 32 + 25 <= 64 && qfSearchXCount == 1u << 25 );
+
+        for( uint32 i = 0; i < qfSearchXCount; i++ )
+        {
+            const uint32 x = xStart + i;
+            y[i] = ( ( ( (uint64)Swap32( blocks[i] ) << kExtraBits ) | ( x >> ( 32 - kExtraBits ) ) ) << 25 ) | i;
+        }
+
+        std::sort( y.begin(), y.end() );
+
+        for( uint32 i = 0; i < qfSearchXCount; i++ )
+        {
+            xs[i] = xStart + (uint32)( y[i] & ( qfSearchXCount - 1 ) );
+            y [i] >>= 25;
+        }
+    }
+
+    // Table 2
+    std::vector<uint64> t2Y;
+    std::vector<uint64> t2Meta;
+    {
+        const std::vector<Pair> pairs = MatchSortedY( y );
+
+        t2Y   .resize( pairs.size() );
+        t2Meta.resize( pairs.size() );
+        FpFxGen<TableId::Table2>::ComputeFx( (int64)pairs.size(), pairs.data(), y.data(), xs.data(), t2Y.data(), t2Meta.data(), 0 );
+    }
+
+    SortByY( t2Y, t2Meta );
+
+    // Table 3. Its pairs' metadata is the x's.
+    std::vector<QualitiesXs> matches;
+    for( const Pair& pair : MatchSortedY( t2Y ) )
+    {
+        const uint64 l = t2Meta[pair.left ];
+        const uint64 r = t2Meta[pair.right];
+        matches.push_back( { { l >> 32, l & 0xFFFFFFFF, r >> 32, r & 0xFFFFFFFF } } );
+    }
+
+    return matches;
+}
@@ -0,0 +1,274 @@
+#include "TestUtil.h"
+#include "PlotContext.h"
+#include "plotmem/MemPlotter.h"
+#include "plotting/GlobalPlotConfig.h"
+#include "plotting/PlotTools.h"
+#include "plotting/PlotValidation.h"
+#include "tools/PlotReader.h"
+#include "tools/PlotCheckpointCache.h"
+#include "util/CliParser.h"
+
+static std::string CreatePlot( GlobalPlotConfig& gCfg, uint32 k );
+static uint64 ValidateProofs( FilePlot& plotFile );
+
+//-----------------------------------------------------------
+TEST_CASE( "small-k-plot", "[plots]" )
+{
+    const char*  outDir = GetEnv( "bb_plot_path", "/tmp/" );
+    const uint32 kStart = std::max( GetEnvU32( "bb_k"    , 18 ), (uint32)BB_CHIA_K_MIN_VALUE );
+    const uint32 kEnd   = std::min( GetEnvU32( "bb_k_end", 22 ), 31u );
+
+    GlobalPlotConfig gCfg = {};
+    gCfg.threadCount  = std::min( GetEnvU32( "bb_thread_count", 8 ), SysHost::GetLogicalCPUCount() );
+    gCfg.outputFolder = outDir;
+
+    // Odd k values exercise line points and stubs which are not byte-aligned
+    for( uint32 k = kStart; k <= kEnd; k++ )
+    {
+        Log::Line( "[k%u]", k );
+
+        const std::string plotPath = CreatePlot( gCfg, k );
+
+        {
+            FilePlot plotFile;
+            ENSURE( plotFile.Open( plotPath.c_str() ) );
+            ENSURE( plotFile.K() == k );
+
+            const uint64 failCount = ValidateProofs( plotFile );
+            Log::Line( " Failed proofs: %llu", (llu)failCount );
+            ENSURE( failCount == 0 );
+        }
+
+        remove( plotPath.c_str() );
+    }
+}
+
+// Truncating a mapped plot must not crash the reader
+//-----------------------------------------------------------
+TEST_CASE( "mmap-plot-truncated", "[plots]" )
+{
+    #if PLATFORM_IS_WINDOWS
+        Log::Line( "Skipping: Mapped files can't be truncated on Windows." );
+    #else
+    GlobalPlotConfig gCfg = {};
+    gCfg.threadCount  = std::min( GetEnvU32( "bb_thread_count", 8 ), SysHost::GetLogicalCPUCount() );
+    gCfg.outputFolder = GetEnv( "bb_plot_path", "/tmp/" );
+
+    const std::string plotPath = CreatePlot( gCfg, 18 );
+
+    MMapPlot plot;
+    ENSURE( plot.Open( plotPath.c_str() ) );
+
+    const uint64 c3Address = plot.TableAddress( PlotTable::C3 );
+    const size_t c3Size    = plot.TableSize( PlotTable::C3 );
+    ENSURE( c3Size > 0 );
+
+    std::vector<byte> before( c3Size ), after( c3Size );
+    ENSURE( plot.ReadAt( c3Address, c3Size, before.data() ) == (ssize_t)c3Size );
+
+    // Cut the plot in the middle of C3
+    const uint64 newSize = c3Address + c3Size / 2;
+    ENSURE( truncate( plotPath.c_str(), (off_t)newSize ) == 0 );
+
+    // Touching the truncated pages directly, as a view would, reads zeros
+    const size_t       pageSize = SysHost::GetPageSize();
+    const uint64       lostPage = RoundUpToNextBoundaryT<uint64>( newSize, pageSize );
+    const volatile byte* view   = plot.View( lostPage, 1 );
+    ENSURE( view );
+    ENSURE( *view == 0 );
+    ENSURE( plot.IsMappingLost() );
+
+    // From then on nothing is served from the mapping
+    ENSURE( plot.View( c3Address, 1 ) == nullptr );
+
+    // The part that is still in the file reads the same, the rest fails
+    const size_t keptSize = (size_t)( newSize - c3Address );
+    ENSURE( plot.ReadAt( c3Address, keptSize, after.data() ) == (ssize_t)keptSize );
+    ENSURE( memcmp( before.data(), after.data(), keptSize ) == 0 );
+    ENSURE( plot.ReadAt( c3Address, c3Size, after.data() ) == -1 );
+
+    // Reading through the plot reader doesn't crash either
+    {
+        PlotReader reader( plot );
+        uint64* f7Entries = bbcalloc<uint64>( kCheckpoint1Interval );
+
+        for( uint64 c3Park = 0; c3Park < reader.GetC3ParkCount(); c3Park++ )
+            reader.ReadC3Park( c3Park, f7Entries );
+
+        free( f7Entries );
+    }
+
+    remove( plotPath.c_str() );
+    #endif
+}
+
+// f7 lookups go through the checkpoint cache: C2 once per plot, C1 once per C2 interval
+//-----------------------------------------------------------
+TEST_CASE( "plot-checkpoint-cache", "[plots]" )
+{
+    GlobalPlotConfig gCfg = {};
+    gCfg.threadCount  = std::min( GetEnvU32( "bb_thread_count", 8 ), SysHost::GetLogicalCPUCount() );
+    gCfg.outputFolder = GetEnv( "bb_plot_path", "/tmp/" );
+
+    const std::string plotPath = CreatePlot( gCfg, 18 );
+
+    FilePlot plotFile;
+    ENSURE( plotFile.Open( plotPath.c_str() ) );
+
+    uint64* f7Entries = bbcalloc<uint64>( kCheckpoint1Interval );
+
+    // Every f7 must be found at or before its own index, as the first of its duplicates
+    auto lookupF7s = [&]( PlotReader& reader ) {
+        
+        for( uint64 c3Park = 0; c3Park < reader.GetC3ParkCount(); c3Park++ )
+        {
+            const int64 entryCount = reader.ReadC3Park( c3Park, f7Entries );
+            ENSURE( entryCount > 0 );
+
+            for( uint64 e = 0; e < (uint64)entryCount; e += 97 )
+            {
+                const uint64 f7Idx = c3Park * kCheckpoint1Interval + e;
+
+                uint64 p7Idx = 0;
+                ENSURE( reader.GetP7IndicesForF7( f7Entries[e], p7Idx ) > 0 );
+                ENSURE( p7Idx <= f7Idx );
+                ENSURE( p7Idx + kCheckpoint1Interval > f7Idx );
+            }
+        }
+    };
+
+    for( const size_t budget : { PlotCheckpointCache::DEFAULT_MEMORY_BUDGET, (size_t)0 } )
+    {
+        PlotCheckpointCache::Clear();
+        PlotCheckpointCache::SetMemoryBudget( budget );
+
+        // A second reader of the same plot finds what the first one loaded
+        for( uint32 i = 0; i < 2; i++ )
+        {
+            PlotReader reader( plotFile );
+            lookupF7s( reader );
+        }
+
+        const PlotCheckpointCacheStats stats = PlotCheckpointCache::GetStats();
+        PlotCheckpointCache::LogStats();
+
+        // k18 fits in a single C2 interval
+        if( budget )
+        {
+            ENSURE( stats.c2Misses == 1 );
+            ENSURE( stats.c2Hits   == 1 );
+            ENSURE( stats.c1Misses == 1 );
+            ENSURE( stats.c1Hits   >  0 );
+            ENSURE( stats.memoryUsed > 0 );
+            ENSURE( stats.memoryUsed <= budget );
+        }
+        else
+        {
+            ENSURE( stats.c2Misses == 2 );
+            ENSURE( stats.c1Hits   == 0 );
+            ENSURE( stats.c1Misses >  1 );
+            ENSURE( stats.memoryUsed == 0 );
+        }
+    }
+
+    PlotCheckpointCache::Clear();
+    PlotCheckpointCache::SetMemoryBudget( PlotCheckpointCache::DEFAULT_MEMORY_BUDGET );
+
+    free( f7Entries );
+    remove( plotPath.c_str() );
+}
+
+//-----------------------------------------------------------
+std::string CreatePlot( GlobalPlotConfig& gCfg, const uint32 k )
+{
+    const char* outDir = gCfg.outputFolder;
+    gCfg.k = k;
+
+    MemPlotter plotter;
+    {
+        CliParser cli( 0, nullptr );
+        plotter.ParseCLI( gCfg, cli );
+    }
+    plotter.Init();
+
+    byte plotId[BB_PLOT_ID_LEN];
+    byte memo  [BB_PLOT_MEMO_MAX_SIZE] = {};
+    for( uint32 i = 0; i < BB_PLOT_ID_LEN; i++ )
+        plotId[i] = (byte)( i * 31 + k );
+
+    char plotFileName[BB_COMPRESSED_PLOT_FILE_LEN_TMP+1] = {};
+    PlotTools::GenPlotFileName( plotId, plotFileName, 0, k );
+
+    PlotRequest req = {};
+    req.plotId       = plotId;
+    req.memo         = memo;
+    req.memoSize     = 128;
+    req.outDir       = outDir;
+    req.plotFileName = plotFileName;
+    req.isFirstPlot  = true;
+    req.IsFinalPlot  = true;
+
+    plotter.Run( req );
+
+    // The writer renames the plot once it is complete
+    std::string plotPath = std::string( outDir ) + plotFileName;
+    plotPath.resize( plotPath.length() - 4 );   // .tmp
+
+    return plotPath;
+}
+
+// Same as the validate command: fetch the proof for an f7 and check that it hashes back to it.
+// A full validation decodes a park per line point, so only evenly spaced f7s are checked by default.
+//-----------------------------------------------------------
+uint64 ValidateProofs( FilePlot& plotFile )
+{
+    PlotReader reader( plotFile );
+
+    const uint32 k           = plotFile.K();
+    const uint64 c3ParkCount = reader.GetC3ParkCount();
+    const uint64 stride      = std::max( reader.GetMaxF7EntryCount() / std::max( GetEnvU32( "bb_proof_count", 4096 ), 1u ), (uint64)1 );
+
+    uint64* f7Entries = bbcalloc<uint64>( kCheckpoint1Interval );
+    uint64* p7Entries = bbcalloc<uint64>( kEntriesPerPark );
+
+    int64  curP7Park  = -1;
+    uint64 f7Count    = 0;
+    uint64 failCount  = 0;
+
+    uint64 fullProofXs[BB_PLOT_PROOF_X_COUNT];
+
+    for( uint64 c3Park = 0; c3Park < c3ParkCount; c3Park++ )
+    {
+        const int64 entryCount = reader.ReadC3Park( c3Park, f7Entries );
+        ENSURE( entryCount > 0 );
+
+        for( uint64 e = 0; e < (uint64)entryCount; e++ )
+        {
+            const uint64 f7Idx  = c3Park * kCheckpoint1Interval + e;
+            const uint64 p7Park = f7Idx / kEntriesPerPark;
+
+            if( f7Idx % stride != 0 && e + 1 != (uint64)entryCount )
+                continue;
+
+            if( (int64)p7Park != curP7Park )
+            {
+                ENSURE( reader.ReadP7Entries( p7Park, p7Entries ) );
+                curP7Park = (int64)p7Park;
+            }
+
+            uint64 f7 = 0;
+            if( reader.FetchProof( p7Entries[f7Idx - p7Park * kEntriesPerPark], fullProofXs ) != ProofFetchResult::OK ||
+                !ValidateFullProof( k, plotFile.PlotId(), fullProofXs, f7 ) || f7 != f7Entries[e] )
+                failCount++;
+
+            f7Count++;
+        }
+    }
+
+    Log::Line( " Validated %llu proofs.", (llu)f7Count );
+    ENSURE( f7Count > 0 );
+
+    free( f7Entries );
+    free( p7Entries );
+    return failCount;
+}